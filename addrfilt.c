@@ -42,6 +42,9 @@
 /* Define the table size */
 #define TABLE_SIZE (1UL<<NBITS)
 
+/* Maximum number of levels in the IPv6 table */
+#define MAX_DEPTH (128 / NBITS)
+
 typedef enum {DENY, ALLOW, AS_PARENT} State;
 
 typedef struct _TableNode {
@@ -83,6 +86,19 @@ get_subnet(uint32_t *addr, unsigned int where)
 
 /* ================================================== */
 
+static void
+put_subnet(uint32_t *addr, unsigned int where, uint32_t subnet)
+{
+  int off;
+
+  off = where / 32;
+  where %= 32;
+
+  addr[off] |= subnet << (32 - NBITS - where);
+}
+
+/* ================================================== */
+
 ADF_AuthTable
 ADF_CreateTable(void)
 {
@@ -293,6 +309,134 @@ ADF_DenyAll(ADF_AuthTable table,
 
 /* ================================================== */
 
+static int
+compare_subnets(const void *a, const void *b)
+{
+  const ADF_Subnet *s1 = a, *s2 = b;
+  int r;
+
+  if (s1->ip.family != s2->ip.family)
+    return s1->ip.family - s2->ip.family;
+
+  if (s1->ip.family == IPADDR_INET4) {
+    if (s1->ip.addr.in4 != s2->ip.addr.in4)
+      return s1->ip.addr.in4 < s2->ip.addr.in4 ? -1 : 1;
+  } else {
+    r = memcmp(s1->ip.addr.in6, s2->ip.addr.in6, sizeof (s1->ip.addr.in6));
+    if (r)
+      return r;
+  }
+
+  return s1->subnet_bits - s2->subnet_bits;
+}
+
+/* ================================================== */
+
+static int
+check_subnet(ADF_Subnet *subnet)
+{
+  switch (subnet->ip.family) {
+    case IPADDR_INET4:
+      return subnet->subnet_bits >= 0 && subnet->subnet_bits <= 32;
+    case IPADDR_INET6:
+      return subnet->subnet_bits >= 0 && subnet->subnet_bits <= 128;
+    default:
+      return 0;
+  }
+}
+
+/* ================================================== */
+/* Set the state of sorted subnets from one address family.  As consecutive
+   subnets are likely to share a prefix, the path of nodes visited for the
+   previous subnet is saved and the descent continues from the deepest node
+   which is common to both subnets. */
+
+static void
+set_sorted_subnets(TableNode *start_node, ADF_Subnet *subnets, int n_subnets,
+                   State new_state)
+{
+  TableNode *path[MAX_DEPTH + 1], *node;
+  uint32_t ip[4], prev_ip[4], subnet;
+  int i, j, N, depth, path_len, full_levels, ip_len;
+
+  path[0] = start_node;
+  path_len = 1;
+  memset(prev_ip, 0, sizeof (prev_ip));
+
+  for (i = 0; i < n_subnets; i++) {
+    if (subnets[i].ip.family == IPADDR_INET4) {
+      ip[0] = subnets[i].ip.addr.in4;
+      ip_len = 1;
+    } else {
+      split_ip6(&subnets[i].ip, ip);
+      ip_len = 4;
+    }
+
+    full_levels = subnets[i].subnet_bits / NBITS;
+    assert(full_levels <= 32 * ip_len / NBITS);
+
+    /* Reuse the part of the path shared with the previous subnet */
+    for (depth = 0; depth + 1 < path_len && depth < full_levels &&
+         get_subnet(ip, depth * NBITS) == get_subnet(prev_ip, depth * NBITS);
+         depth++)
+      ;
+
+    node = path[depth];
+
+    while (depth < full_levels) {
+      open_node(node);
+      node = &node->extended[get_subnet(ip, depth * NBITS)];
+      path[++depth] = node;
+    }
+
+    path_len = depth + 1;
+
+    if (subnets[i].subnet_bits % NBITS == 0) {
+      node->state = new_state;
+    } else {
+      /* Have to set multiple entries */
+      N = 1 << (NBITS - subnets[i].subnet_bits % NBITS);
+      subnet = get_subnet(ip, full_levels * NBITS) & ~(N - 1);
+      assert(subnet + N <= TABLE_SIZE);
+
+      open_node(node);
+      for (j = 0; j < N; j++)
+        node->extended[subnet + j].state = new_state;
+    }
+
+    memcpy(prev_ip, ip, sizeof (prev_ip));
+  }
+}
+
+/* ================================================== */
+
+ADF_Status
+ADF_AddSubnets(ADF_AuthTable table, ADF_Subnet *subnets, int n_subnets, int allow)
+{
+  int i, n_subnets4;
+
+  for (i = 0; i < n_subnets; i++) {
+    if (!check_subnet(&subnets[i]))
+      return ADF_BADSUBNET;
+  }
+
+  /* Sort the subnets by family, address and length, which puts all IPv4
+     subnets before IPv6 subnets and shorter prefixes before longer ones */
+  qsort(subnets, n_subnets, sizeof (subnets[0]), compare_subnets);
+
+  for (n_subnets4 = 0; n_subnets4 < n_subnets &&
+       subnets[n_subnets4].ip.family == IPADDR_INET4; n_subnets4++)
+    ;
+
+  set_sorted_subnets(&table->base4, subnets, n_subnets4, allow ? ALLOW : DENY);
+  set_sorted_subnets(&table->base6, subnets + n_subnets4, n_subnets - n_subnets4,
+                     allow ? ALLOW : DENY);
+
+  return ADF_SUCCESS;
+}
+
+/* ================================================== */
+
 void
 ADF_DestroyTable(ADF_AuthTable table)
 {
@@ -401,3 +545,76 @@ ADF_IsAnyAllowed(ADF_AuthTable table, int family)
       return 0;
   }
 }
+
+/* ================================================== */
+
+static void
+get_rules(TableNode *node, State parent, int family, uint32_t *addr, int bits,
+          ADF_Rule *rules, int max_rules, int *n_rules)
+{
+  uint32_t child_addr[4];
+  State state;
+  ADF_Rule *rule;
+  int i;
+
+  state = node->state != AS_PARENT ? node->state : parent;
+
+  /* Rules of more specific subnets need to be checked first */
+  if (node->extended) {
+    for (i = 0; i < TABLE_SIZE; i++) {
+      memcpy(child_addr, addr, sizeof (child_addr));
+      put_subnet(child_addr, bits, i);
+      get_rules(&node->extended[i], state, family, child_addr, bits + NBITS,
+                rules, max_rules, n_rules);
+    }
+  }
+
+  /* Skip rules which don't change the result of the parent rule */
+  if (state == parent)
+    return;
+
+  if (*n_rules < max_rules) {
+    rule = &rules[*n_rules];
+    rule->subnet.ip.family = family;
+    if (family == IPADDR_INET4) {
+      rule->subnet.ip.addr.in4 = addr[0];
+    } else {
+      for (i = 0; i < 16; i++)
+        rule->subnet.ip.addr.in6[i] = addr[i / 4] >> (24 - i % 4 * 8);
+    }
+    rule->subnet.subnet_bits = bits;
+    rule->allow = state == ALLOW;
+  }
+
+  (*n_rules)++;
+}
+
+/* ================================================== */
+
+int
+ADF_GetRules(ADF_AuthTable table, int family, ADF_Rule *rules, int max_rules,
+             int *default_allow)
+{
+  uint32_t addr[4] = {0, 0, 0, 0};
+  TableNode *node;
+  State state;
+  int n_rules = 0;
+
+  switch (family) {
+    case IPADDR_INET4:
+      node = &table->base4;
+      break;
+    case IPADDR_INET6:
+      node = &table->base6;
+      break;
+    default:
+      return -1;
+  }
+
+  state = node->state != AS_PARENT ? node->state : DENY;
+  *default_allow = state == ALLOW;
+
+  get_rules(node, state, family, addr, 0, rules, max_rules, &n_rules);
+
+  return n_rules <= max_rules ? n_rules : -1;
+}
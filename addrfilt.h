@@ -35,6 +35,16 @@ typedef enum {
   ADF_SUCCESS,
   ADF_BADSUBNET
 } ADF_Status;
+
+typedef struct {
+  IPAddr ip;
+  int subnet_bits;
+} ADF_Subnet;
+
+typedef struct {
+  ADF_Subnet subnet;
+  int allow;
+} ADF_Rule;
   
 
 /* Create a new table.  The default rule is deny for everything */
@@ -64,6 +74,15 @@ extern ADF_Status ADF_DenyAll(ADF_AuthTable table,
                               IPAddr *ip,
                               int subnet_bits);
 
+/* Allow (or deny) anything in the supplied subnets, EXCEPT for any more
+   specific subnets that are already defined.  The array is sorted in place
+   and the subnets are added in one pass.  If any of the subnets is invalid,
+   the table is not modified. */
+extern ADF_Status ADF_AddSubnets(ADF_AuthTable table,
+                                 ADF_Subnet *subnets,
+                                 int n_subnets,
+                                 int allow);
+
 /* Clear up the table */
 extern void ADF_DestroyTable(ADF_AuthTable table);
 
@@ -77,4 +96,12 @@ extern int ADF_IsAllowed(ADF_AuthTable table,
 extern int ADF_IsAnyAllowed(ADF_AuthTable table,
                             int family);
 
+/* Get a list of rules equivalent to the table for a given family.  The
+   rules are ordered from the most specific subnets, i.e. the first matching
+   rule decides, and default_allow applies to addresses not matching any
+   rule.  Return the number of rules, or -1 if there are more than
+   max_rules rules or the family is not supported. */
+extern int ADF_GetRules(ADF_AuthTable table, int family, ADF_Rule *rules,
+                        int max_rules, int *default_allow);
+
 #endif /* GOT_ADDRFILT_H */
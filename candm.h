@@ -99,7 +99,21 @@
 #define REQ_ADD_PEER2 59
 #define REQ_ADD_SERVER3 60
 #define REQ_ADD_PEER3 61
-#define N_REQUEST_TYPES 62
+#define REQ_RELOAD_ACCESS 62
+#define REQ_SOURCE_RECORDS 63
+#define REQ_SUBSCRIBE 64
+#define REQ_SCHED_STATS 65
+#define REQ_HWCLOCK_STATS 66
+#define REQ_SYS_STATS 67
+#define REQ_SLOT_STATS 68
+#define REQ_MONITOR_DATA 69
+#define REQ_DEL_SOURCES 70
+#define REQ_RELOAD_CONFIG 71
+#define REQ_STARTUP_STATS 72
+#define REQ_KEY_STATS 73
+#define REQ_SIGND_STATS 74
+#define REQ_SERVER_STATS2 75
+#define N_REQUEST_TYPES 76
 
 /* Structure used to exchange timespecs independent of time_t size */
 typedef struct {
@@ -252,6 +266,7 @@ typedef struct {
 #define REQ_ADDSRC_TRUST 0x20
 #define REQ_ADDSRC_REQUIRE 0x40
 #define REQ_ADDSRC_INTERLEAVED 0x80
+#define REQ_ADDSRC_MONITOR 0x100
 
 typedef struct {
   IPAddr ip_addr;
@@ -282,6 +297,12 @@ typedef struct {
   int32_t EOR;
 } REQ_Del_Source;
 
+typedef struct {
+  IPAddr mask;
+  IPAddr address;
+  int32_t EOR;
+} REQ_Del_Sources;
+
 typedef struct {
   Float dfreq;
   int32_t EOR;
@@ -331,6 +352,52 @@ typedef struct {
   int32_t EOR;
 } REQ_NTPData;
 
+typedef struct {
+  uint32_t first_index;
+  uint32_t n_records;
+  int32_t EOR;
+} REQ_SourceRecords;
+
+#define REQ_SUBSCRIBE_TRACKING 0x1
+#define REQ_SUBSCRIBE_MEASUREMENTS 0x2
+#define REQ_SUBSCRIBE_SELECTION 0x4
+#define REQ_SUBSCRIBE_SERVERSTATS 0x8
+#define REQ_SUBSCRIBE_ALL 0xf
+
+typedef struct {
+  uint32_t events;
+  uint32_t stats_interval;
+  int32_t EOR;
+} REQ_Subscribe;
+
+typedef struct {
+  uint32_t index;
+  int32_t EOR;
+} REQ_SchedStats;
+
+typedef struct {
+  uint32_t index;
+  int32_t EOR;
+} REQ_HwClockStats;
+
+typedef struct {
+  uint32_t index;
+  int32_t EOR;
+} REQ_SlotStats;
+
+#define MAX_MONITOR_SOURCES 8
+
+typedef struct {
+  uint32_t first_index;
+  uint32_t n_sources;
+  int32_t EOR;
+} REQ_MonitorData;
+
+typedef struct {
+  uint32_t index;
+  int32_t EOR;
+} REQ_KeyStats;
+
 /* ================================================== */
 
 #define PKT_TYPE_CMD_REQUEST 1
@@ -369,7 +436,9 @@ typedef struct {
    Version 6 (no authentication) : changed format of client accesses by index
    (using new request/reply types) and manual timestamp, new fields and flags
    in NTP source request and report, new commands: ntpdata, refresh,
-   serverstats
+   serverstats, reload access, source records, subscribe, schedstats,
+   hwclockstats, sysstats, slotstats, monitordata, delete with subnet,
+   reload config, startupstats, keystats, signdstats
  */
 
 #define PROTO_VERSION_NUMBER 6
@@ -425,6 +494,7 @@ typedef struct {
     REQ_Ac_Check ac_check;
     REQ_NTP_Source ntp_source;
     REQ_Del_Source del_source;
+    REQ_Del_Sources del_sources;
     REQ_Dfreq dfreq;
     REQ_Doffset doffset;
     REQ_Sourcestats sourcestats;
@@ -433,6 +503,13 @@ typedef struct {
     REQ_ReselectDistance reselect_distance;
     REQ_SmoothTime smoothtime;
     REQ_NTPData ntp_data;
+    REQ_SourceRecords source_records;
+    REQ_Subscribe subscribe;
+    REQ_SchedStats sched_stats;
+    REQ_HwClockStats hwclock_stats;
+    REQ_SlotStats slot_stats;
+    REQ_MonitorData monitor_data;
+    REQ_KeyStats key_stats;
   } data; /* Command specific parameters */
 
   /* Padding used to prevent traffic amplification.  It only defines the
@@ -468,7 +545,18 @@ typedef struct {
 #define RPY_CLIENT_ACCESSES_BY_INDEX2 15
 #define RPY_NTP_DATA 16
 #define RPY_MANUAL_TIMESTAMP2 17
-#define N_REPLY_TYPES 18
+#define RPY_SOURCE_RECORDS 18
+#define RPY_EVENT 19
+#define RPY_SCHED_STATS 20
+#define RPY_HWCLOCK_STATS 21
+#define RPY_SYS_STATS 22
+#define RPY_SLOT_STATS 23
+#define RPY_MONITOR_DATA 24
+#define RPY_STARTUP_STATS 25
+#define RPY_KEY_STATS 26
+#define RPY_SIGND_STATS 27
+#define RPY_SERVER_STATS2 28
+#define N_REPLY_TYPES 29
 
 /* Status codes */
 #define STT_SUCCESS 0
@@ -613,6 +701,22 @@ typedef struct {
   int32_t EOR;
 } RPY_ServerStats;
 
+typedef struct {
+  uint32_t ntp_hits;
+  uint32_t cmd_hits;
+  uint32_t ntp_drops;
+  uint32_t cmd_drops;
+  uint32_t log_drops;
+  uint32_t ntp_interleaved_hits;
+  uint32_t ntp_interleaved_misses;
+  uint32_t ntp_timestamps;
+  uint32_t log_records_ipv4;
+  uint32_t log_records_ipv4_size;
+  uint32_t log_records_ipv6;
+  uint32_t log_records_ipv6_size;
+  int32_t EOR;
+} RPY_ServerStats2;
+
 #define MAX_MANUAL_LIST_SAMPLES 16
 
 typedef struct {
@@ -683,6 +787,230 @@ typedef struct {
   int32_t EOR;
 } RPY_NTPData;
 
+/* Maximum number of records in the source records reply.  The request has
+   no padding, the reply is larger than the request and it is allowed only
+   over the Unix domain socket. */
+#define MAX_SOURCE_RECORDS 64
+
+typedef struct {
+  IPAddr ip_addr;
+  uint32_t ref_id;
+  int16_t poll;
+  uint16_t stratum;
+  uint16_t state;
+  uint16_t mode;
+  uint16_t flags;
+  uint16_t reachability;
+  uint32_t since_sample;
+  Float orig_latest_meas;
+  Float latest_meas;
+  Float latest_meas_err;
+  uint32_t n_samples;
+  uint32_t n_runs;
+  uint32_t span_seconds;
+  Float sd;
+  Float resid_freq_ppm;
+  Float skew_ppm;
+  Float est_offset;
+  Float est_offset_err;
+} RPY_SourceRecord;
+
+typedef struct {
+  uint32_t n_sources;      /* how many sources there are in the daemon */
+  uint32_t first_index;    /* index of the first record in the following array */
+  uint32_t n_records;      /* the number of valid entries in the following array */
+  RPY_SourceRecord records[MAX_SOURCE_RECORDS];
+  int32_t EOR;
+} RPY_SourceRecords;
+
+#define RPY_EVT_TRACKING 1
+#define RPY_EVT_MEASUREMENT 2
+#define RPY_EVT_SELECTION 3
+#define RPY_EVT_SERVERSTATS 4
+
+typedef struct {
+  uint32_t ref_id;
+  IPAddr ip_addr;
+  uint16_t stratum;
+  uint16_t leap_status;
+  Timespec ref_time;
+  Float last_offset;
+  Float rms_offset;
+  Float freq_ppm;
+  Float resid_freq_ppm;
+  Float skew_ppm;
+  Float root_delay;
+  Float root_dispersion;
+} RPY_EventTracking;
+
+typedef struct {
+  uint32_t ref_id;
+  IPAddr ip_addr;
+  uint16_t stratum;
+  uint16_t pad;
+  Timespec sample_time;
+  Float offset;
+  Float peer_delay;
+  Float peer_dispersion;
+} RPY_EventMeasurement;
+
+typedef struct {
+  uint32_t ref_id;
+  IPAddr ip_addr;
+} RPY_EventSelection;
+
+typedef struct {
+  uint32_t ntp_hits;
+  uint32_t cmd_hits;
+  uint32_t ntp_drops;
+  uint32_t cmd_drops;
+  uint32_t log_drops;
+} RPY_EventServerStats;
+
+/* Record pushed to subscribed clients.  The sequence number is
+   incremented with each generated record and the dropped field counts
+   records which could not be sent to the client since the last record
+   that was sent. */
+typedef struct {
+  uint32_t sequence;
+  uint32_t dropped;
+  uint16_t type;
+  uint16_t pad;
+  union {
+    RPY_EventTracking tracking;
+    RPY_EventMeasurement measurement;
+    RPY_EventSelection selection;
+    RPY_EventServerStats server_stats;
+  } data;
+  int32_t EOR;
+} RPY_Event;
+
+#define RPY_SCHED_LAG 0
+#define RPY_SCHED_TIMEOUT 1
+#define RPY_SCHED_FILE 2
+
+#define RPY_SCHED_HISTOGRAM_BUCKETS 24
+
+typedef struct {
+  uint32_t n_records;
+  int8_t name[32];
+  uint16_t type;
+  uint16_t pad;
+  uint32_t calls;
+  Float total_time;
+  Float max_time;
+  uint32_t histogram[RPY_SCHED_HISTOGRAM_BUCKETS];
+  int32_t EOR;
+} RPY_SchedStats;
+
+typedef struct {
+  uint32_t n_records;
+  int8_t name[16];
+  uint32_t n_samples;
+  uint32_t n_samples_total;
+  uint32_t n_resets;
+  uint32_t phc_readings;
+  Float separation;
+  Float frequency;
+  Float last_error;
+  Float rms_error;
+  Float phc_read_time;
+  Float phc_read_max;
+  Float phc_error;
+  int32_t EOR;
+} RPY_HwClockStats;
+
+#define RPY_SYS_STATS_FLAG_HELPER 0x1
+
+typedef struct {
+  uint32_t adjtimex_calls;
+  uint32_t flags;
+  uint32_t helper_channel_requests;
+  uint32_t helper_socket_requests;
+  Float adjtimex_last_time;
+  Float adjtimex_mean_time;
+  Float adjtimex_max_time;
+  int32_t EOR;
+} RPY_SysStats;
+
+typedef struct {
+  uint32_t n_records;
+  uint8_t name[16];
+  uint32_t timeouts;
+  uint32_t scheduled;
+  uint32_t delayed;
+  Float slot;
+  Float load;
+  Float mean_delay;
+  Float max_delay;
+  int32_t EOR;
+} RPY_SlotStats;
+
+typedef struct {
+  IPAddr ip_addr;
+  uint16_t stratum;
+  int16_t poll;
+  uint16_t reachability;
+  uint16_t samples;
+  uint32_t since_sample;
+  Float offset;
+  Float delay;
+  Float min_delay_offset;
+  Float min_delay;
+} RPY_MonitorData_Source;
+
+typedef struct {
+  uint32_t n_indices;
+  uint32_t next_index;
+  uint32_t n_sources;
+  RPY_MonitorData_Source sources[MAX_MONITOR_SOURCES];
+  int32_t EOR;
+} RPY_MonitorData;
+
+#define RPY_STARTUP_STATS_FLAG_COMPLETE 0x1
+#define RPY_STARTUP_STATS_FLAG_FASTSTART 0x2
+
+typedef struct {
+  uint32_t flags;
+  Float config_time;
+  Float init_time;
+  Float rtc_time;
+  Float initstepslew_time;
+  Float resolving_time;
+  Float dumps_time;
+  Float total_time;
+  int32_t EOR;
+} RPY_StartupStats;
+
+#define RPY_KEY_HISTOGRAM_BUCKETS 24
+
+typedef struct {
+  uint32_t n_records;
+  uint32_t key_id;
+  uint32_t samples;
+  Float auth_delay;
+  Float mean_delay;
+  Float max_delay;
+  uint32_t histogram[RPY_KEY_HISTOGRAM_BUCKETS];
+  int32_t EOR;
+} RPY_KeyStats;
+
+typedef struct {
+  uint32_t connections;
+  uint32_t open_connections;
+  uint32_t queue_length;
+  uint32_t max_queue_length;
+  uint32_t peak_queue_length;
+  uint32_t requests;
+  uint32_t successes;
+  uint32_t failures;
+  uint32_t drops;
+  uint32_t queued;
+  Float median_delay;
+  Float p99_delay;
+  int32_t EOR;
+} RPY_SigndStats;
+
 typedef struct {
   uint8_t version;
   uint8_t pkt_type;
@@ -712,6 +1040,17 @@ typedef struct {
     RPY_Activity activity;
     RPY_Smoothing smoothing;
     RPY_NTPData ntp_data;
+    RPY_SourceRecords source_records;
+    RPY_Event event;
+    RPY_SchedStats sched_stats;
+    RPY_HwClockStats hwclock_stats;
+    RPY_SysStats sys_stats;
+    RPY_SlotStats slot_stats;
+    RPY_MonitorData monitor_data;
+    RPY_StartupStats startup_stats;
+    RPY_KeyStats key_stats;
+    RPY_SigndStats signd_stats;
+    RPY_ServerStats2 server_stats2;
   } data; /* Reply specific parameters */
 
 } CMD_Reply;
@@ -1109,6 +1109,7 @@ process_cmd_add_server_or_peer(CMD_Request *msg, char *line)
           (data.params.auto_offline ? REQ_ADDSRC_AUTOOFFLINE : 0) |
           (data.params.iburst ? REQ_ADDSRC_IBURST : 0) |
           (data.params.interleaved ? REQ_ADDSRC_INTERLEAVED : 0) |
+          (data.params.monitor ? REQ_ADDSRC_MONITOR : 0) |
           (data.params.sel_options & SRC_SELECT_PREFER ? REQ_ADDSRC_PREFER : 0) |
           (data.params.sel_options & SRC_SELECT_NOSELECT ? REQ_ADDSRC_NOSELECT : 0) |
           (data.params.sel_options & SRC_SELECT_TRUST ? REQ_ADDSRC_TRUST : 0) |
@@ -1148,12 +1149,22 @@ process_cmd_delete(CMD_Request *msg, char *line)
 {
   char *hostname;
   int ok = 0;
-  IPAddr address;
+  IPAddr address, mask;
 
-  msg->command = htons(REQ_DEL_SOURCE);
   hostname = line;
   CPS_SplitWord(line);
 
+  if (strchr(hostname, '/')) {
+    if (!read_mask_address(hostname, &mask, &address))
+      return 0;
+    UTI_IPHostToNetwork(&mask, &msg->data.del_sources.mask);
+    UTI_IPHostToNetwork(&address, &msg->data.del_sources.address);
+    msg->command = htons(REQ_DEL_SOURCES);
+    return 1;
+  }
+
+  msg->command = htons(REQ_DEL_SOURCE);
+
   if (!*hostname) {
     LOG(LOGS_ERR, "Invalid syntax for address");
     ok = 0;
@@ -1195,9 +1206,12 @@ give_help(void)
     "NTP sources:\0\0"
     "activity\0Check how many NTP sources are online/offline\0"
     "ntpdata [<address>]\0Display information about last valid measurement\0"
+    "monitordata\0Display measurements of monitored sources\0"
+    "hwclocks\0Display statistics of HW timestamping clocks\0"
     "add server <address> [options]\0Add new NTP server\0"
     "add peer <address> [options]\0Add new NTP peer\0"
     "delete <address>\0Remove server or peer\0"
+    "delete <subnet>\0Remove servers and peers in subnet\0"
     "burst <n-good>/<n-max> [<mask>/<address>]\0Start rapid set of measurements\0"
     "maxdelay <address> <delay>\0Modify maximum valid sample delay\0"
     "maxdelayratio <address> <ratio>\0Modify maximum valid delay/minimum ratio\0"
@@ -1224,12 +1238,16 @@ give_help(void)
     "allow all [<subnet>]\0Allow access to subnet and all children\0"
     "deny [<subnet>]\0Deny access to subnet as a default\0"
     "deny all [<subnet>]\0Deny access to subnet and all children\0"
+    "reload access\0Re-read allowfile and denyfile subnet files\0"
+    "reload config\0Re-read sources, access, keys and ratelimit\0"
     "local [options]\0Serve time even when not synchronised\0"
     "local off\0Don't serve time when not synchronised\0"
     "smoothtime reset|activate\0Reset/activate time smoothing\0"
     "smoothing\0Display current time smoothing state\0"
     "\0\0"
     "Monitoring access:\0\0"
+    "monitor [<event>...]\0Print tracking, measurement, selection and\0"
+    "\0server statistics events as they happen\0"
     "cmdaccheck <address>\0Check whether address is allowed\0"
     "cmdallow [<subnet>]\0Allow access to subnet as a default\0"
     "cmdallow all [<subnet>]\0Allow access to subnet and all children\0"
@@ -1245,6 +1263,12 @@ give_help(void)
     "cyclelogs\0Close and re-open log files\0"
     "dump\0Dump all measurements to save files\0"
     "rekey\0Re-read keys from key file\0"
+    "keystats\0Display authentication delays of keys\0"
+    "schedstats\0Display execution time statistics of handlers\0"
+    "signdstats\0Display statistics of MS-SNTP signing requests\0"
+    "sysstats\0Display statistics of clock adjustment calls\0"
+    "slotstats\0Display occupancy of transmission slots\0"
+    "startupstats\0Display duration of daemon initialisation\0"
     "\0\0"
     "Client commands:\0\0"
     "dns -n|+n\0Disable/enable resolving IP addresses to hostnames\0"
@@ -1274,14 +1298,15 @@ command_name_generator(const char *text, int state)
   const char *name, *names[] = {
     "accheck", "activity", "add peer", "add server", "allow", "burst",
     "clients", "cmdaccheck", "cmdallow", "cmddeny", "cyclelogs", "delete",
-    "deny", "dns", "dump", "exit", "help", "keygen", "local", "makestep",
+    "deny", "dns", "dump", "exit", "help", "hwclocks", "keygen", "keystats", "local", "makestep",
     "manual on", "manual off", "manual delete", "manual list", "manual reset",
     "maxdelay", "maxdelaydevratio", "maxdelayratio", "maxpoll",
-    "maxupdateskew", "minpoll", "minstratum", "ntpdata", "offline", "online",
-    "polltarget", "quit", "refresh", "rekey", "reselect", "reselectdist",
-    "retries", "rtcdata", "serverstats", "settime", "smoothing", "smoothtime",
-    "sources", "sources -v", "sourcestats", "sourcestats -v", "timeout",
-    "tracking", "trimrtc", "waitsync", "writertc",
+    "maxupdateskew", "minpoll", "minstratum", "monitor", "monitordata", "ntpdata",
+    "offline",
+    "online", "polltarget", "quit", "refresh", "rekey", "reload access",
+    "reload config", "reselect", "reselectdist", "retries", "rtcdata", "schedstats", "serverstats", "settime",
+    "signdstats", "slotstats", "smoothing", "smoothtime", "sources", "sources -v", "sourcestats",
+    "sourcestats -v", "startupstats", "sysstats", "timeout", "tracking", "trimrtc", "waitsync", "writertc",
     NULL
   };
   static int list_index, len;
@@ -1316,6 +1341,67 @@ static int max_retries = 2;
 static int initial_timeout = 1000;
 static int proto_version = PROTO_VERSION_NUMBER;
 
+/* Complete the header of a new attempt of the request with a new random
+   sequence number and return the length of the packet */
+
+static int
+prepare_request(CMD_Request *request, int attempt, int version)
+{
+  int command_length, padding_length;
+
+  request->pkt_type = PKT_TYPE_CMD_REQUEST;
+  request->res1 = 0;
+  request->res2 = 0;
+  request->pad1 = 0;
+  request->pad2 = 0;
+
+  UTI_GetRandomBytes(&request->sequence, sizeof (request->sequence));
+  request->attempt = htons(attempt);
+  request->version = version;
+  command_length = PKL_CommandLength(request);
+  padding_length = PKL_CommandPaddingLength(request);
+  assert(command_length > 0 && command_length > padding_length);
+
+  /* Zero the padding to not send any uninitialized data */
+  memset(((char *)request) + command_length - padding_length, 0, padding_length);
+
+  return command_length;
+}
+
+/* ================================================== */
+/* Check whether a received packet is a valid reply to the request */
+
+static int
+check_reply(CMD_Request *request, CMD_Reply *reply, int read_length, int version)
+{
+  int expected_length;
+
+  if (read_length >= offsetof(CMD_Reply, data)) {
+    expected_length = PKL_ReplyLength(reply);
+  } else {
+    expected_length = 0;
+  }
+
+  if (read_length < expected_length || expected_length < offsetof(CMD_Reply, data))
+    return 0;
+
+  if (reply->sequence != request->sequence)
+    return 0;
+
+  if ((reply->version != version &&
+       !(reply->version >= PROTO_VERSION_MISMATCH_COMPAT_CLIENT &&
+         ntohs(reply->status) == STT_BADPKTVERSION)) ||
+      (reply->pkt_type != PKT_TYPE_CMD_REPLY) ||
+      (reply->res1 != 0) ||
+      (reply->res2 != 0) ||
+      (reply->command != request->command))
+    return 0;
+
+  return 1;
+}
+
+/* ================================================== */
+
 /* This is the core protocol module.  Complete particular fields in
    the outgoing packet, send it, wait for a response, handle retries,
    etc.  Returns a Boolean indicating whether the protocol was
@@ -1324,25 +1410,15 @@ static int proto_version = PROTO_VERSION_NUMBER;
 static int
 submit_request(CMD_Request *request, CMD_Reply *reply)
 {
-  int bad_length, bad_sequence, bad_header;
   int select_status;
   int recv_status;
-  int read_length;
-  int expected_length;
   int command_length;
-  int padding_length;
   struct timespec ts_now, ts_start;
   struct timeval tv;
   int n_attempts, new_attempt;
   double timeout;
   fd_set rdfd;
 
-  request->pkt_type = PKT_TYPE_CMD_REQUEST;
-  request->res1 = 0;
-  request->res2 = 0;
-  request->pad1 = 0;
-  request->pad2 = 0;
-
   n_attempts = 0;
   new_attempt = 1;
 
@@ -1358,18 +1434,10 @@ submit_request(CMD_Request *request, CMD_Reply *reply)
 
       UTI_TimevalToTimespec(&tv, &ts_start);
 
-      UTI_GetRandomBytes(&request->sequence, sizeof (request->sequence));
-      request->attempt = htons(n_attempts);
-      request->version = proto_version;
-      command_length = PKL_CommandLength(request);
-      padding_length = PKL_CommandPaddingLength(request);
-      assert(command_length > 0 && command_length > padding_length);
+      command_length = prepare_request(request, n_attempts, proto_version);
 
       n_attempts++;
 
-      /* Zero the padding to not send any uninitialized data */
-      memset(((char *)request) + command_length - padding_length, 0, padding_length);
-
       if (sock_fd < 0) {
         DEBUG_LOG("No socket to send request");
         return 0;
@@ -1425,39 +1493,10 @@ submit_request(CMD_Request *request, CMD_Reply *reply)
         new_attempt = 1;
       } else {
         DEBUG_LOG("Received %d bytes", recv_status);
-        
-        read_length = recv_status;
-        if (read_length >= offsetof(CMD_Reply, data)) {
-          expected_length = PKL_ReplyLength(reply);
-        } else {
-          expected_length = 0;
-        }
 
-        bad_length = (read_length < expected_length ||
-                      expected_length < offsetof(CMD_Reply, data));
-        
-        if (!bad_length) {
-          bad_sequence = reply->sequence != request->sequence;
-        } else {
-          bad_sequence = 0;
-        }
-        
-        if (bad_length || bad_sequence) {
-          continue;
-        }
-        
-        bad_header = ((reply->version != proto_version &&
-                       !(reply->version >= PROTO_VERSION_MISMATCH_COMPAT_CLIENT &&
-                         ntohs(reply->status) == STT_BADPKTVERSION)) ||
-                      (reply->pkt_type != PKT_TYPE_CMD_REPLY) ||
-                      (reply->res1 != 0) ||
-                      (reply->res2 != 0) ||
-                      (reply->command != request->command));
-        
-        if (bad_header) {
+        if (!check_reply(request, reply, recv_status, proto_version))
           continue;
-        }
-        
+
 #if PROTO_VERSION_NUMBER == 6
         /* Protocol version 5 is similar to 6 except there is no padding.
            If a version 5 reply with STT_BADPKTVERSION is received,
@@ -1486,6 +1525,57 @@ submit_request(CMD_Request *request, CMD_Reply *reply)
 
 /* ================================================== */
 
+static const char *
+get_status_message(int status)
+{
+  switch (status) {
+    case STT_SUCCESS:
+      return "200 OK";
+    case STT_ACCESSALLOWED:
+      return "208 Access allowed";
+    case STT_ACCESSDENIED:
+      return "209 Access denied";
+    case STT_FAILED:
+      return "500 Failure";
+    case STT_UNAUTH:
+      return "501 Not authorised";
+    case STT_INVALID:
+      return "502 Invalid command";
+    case STT_NOSUCHSOURCE:
+      return "503 No such source";
+    case STT_INVALIDTS:
+      return "504 Duplicate or stale logon detected";
+    case STT_NOTENABLED:
+      return "505 Facility not enabled in daemon";
+    case STT_BADSUBNET:
+      return "507 Bad subnet";
+    case STT_NOHOSTACCESS:
+      return "510 No command access from this host";
+    case STT_SOURCEALREADYKNOWN:
+      return "511 Source already present";
+    case STT_TOOMANYSOURCES:
+      return "512 Too many sources present";
+    case STT_NORTC:
+      return "513 RTC driver not running";
+    case STT_BADRTCFILE:
+      return "514 Can't write RTC parameters";
+    case STT_INVALIDAF:
+      return "515 Invalid address family";
+    case STT_BADSAMPLE:
+      return "516 Sample index out of range";
+    case STT_BADPKTVERSION:
+      return "517 Protocol version mismatch";
+    case STT_BADPKTLENGTH:
+      return "518 Packet length mismatch";
+    case STT_INACTIVE:
+      return "519 Client logging is not active in the daemon";
+    default:
+      return "520 Got unexpected error from daemon";
+  }
+}
+
+/* ================================================== */
+
 static int
 request_reply(CMD_Request *request, CMD_Reply *reply, int requested_reply, int verbose)
 {
@@ -1501,73 +1591,8 @@ request_reply(CMD_Request *request, CMD_Reply *reply, int requested_reply, int v
 
   status = ntohs(reply->status);
         
-  if (verbose || status != STT_SUCCESS) {
-    switch (status) {
-      case STT_SUCCESS:
-        printf("200 OK");
-        break;
-      case STT_ACCESSALLOWED:
-        printf("208 Access allowed");
-        break;
-      case STT_ACCESSDENIED:
-        printf("209 Access denied");
-        break;
-      case STT_FAILED:
-        printf("500 Failure");
-        break;
-      case STT_UNAUTH:
-        printf("501 Not authorised");
-        break;
-      case STT_INVALID:
-        printf("502 Invalid command");
-        break;
-      case STT_NOSUCHSOURCE:
-        printf("503 No such source");
-        break;
-      case STT_INVALIDTS:
-        printf("504 Duplicate or stale logon detected");
-        break;
-      case STT_NOTENABLED:
-        printf("505 Facility not enabled in daemon");
-        break;
-      case STT_BADSUBNET:
-        printf("507 Bad subnet");
-        break;
-      case STT_NOHOSTACCESS:
-        printf("510 No command access from this host");
-        break;
-      case STT_SOURCEALREADYKNOWN:
-        printf("511 Source already present");
-        break;
-      case STT_TOOMANYSOURCES:
-        printf("512 Too many sources present");
-        break;
-      case STT_NORTC:
-        printf("513 RTC driver not running");
-        break;
-      case STT_BADRTCFILE:
-        printf("514 Can't write RTC parameters");
-        break;
-      case STT_INVALIDAF:
-        printf("515 Invalid address family");
-        break;
-      case STT_BADSAMPLE:
-        printf("516 Sample index out of range");
-        break;
-      case STT_BADPKTVERSION:
-        printf("517 Protocol version mismatch");
-        break;
-      case STT_BADPKTLENGTH:
-        printf("518 Packet length mismatch");
-        break;
-      case STT_INACTIVE:
-        printf("519 Client logging is not active in the daemon");
-        break;
-      default:
-        printf("520 Got unexpected error from daemon");
-    }
-    printf("\n");
-  }
+  if (verbose || status != STT_SUCCESS)
+    printf("%s\n", get_status_message(status));
   
   if (status != STT_SUCCESS &&
       status != STT_ACCESSALLOWED && status != STT_ACCESSDENIED) {
@@ -2020,6 +2045,87 @@ check_for_verbose_flag(char *line)
 
 /* ================================================== */
 
+/* Fetch the source data and statistics of all sources using the bulk
+   request, which is supported only over the Unix domain socket.  Return 0
+   if the daemon didn't accept the request and the sources need to be
+   requested one by one. */
+
+static int
+get_source_records(uint32_t *n_sources, ARR_Instance *records)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t i, n_records;
+
+  *records = ARR_CreateInstance(sizeof (RPY_SourceRecord));
+
+  do {
+    request.command = htons(REQ_SOURCE_RECORDS);
+    request.data.source_records.first_index = htonl(ARR_GetSize(*records));
+    request.data.source_records.n_records = htonl(MAX_SOURCE_RECORDS);
+
+    if (!submit_request(&request, &reply) ||
+        ntohs(reply.status) != STT_SUCCESS ||
+        ntohs(reply.reply) != RPY_SOURCE_RECORDS) {
+      ARR_DestroyInstance(*records);
+      *records = NULL;
+      return 0;
+    }
+
+    *n_sources = ntohl(reply.data.source_records.n_sources);
+    n_records = ntohl(reply.data.source_records.n_records);
+
+    for (i = 0; i < n_records; i++)
+      ARR_AppendElement(*records, &reply.data.source_records.records[i]);
+  } while (n_records > 0 && ARR_GetSize(*records) < *n_sources);
+
+  /* The number of sources might have changed between the requests */
+  *n_sources = ARR_GetSize(*records);
+
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+get_source_data_from_record(RPY_SourceRecord *record, RPY_Source_Data *data)
+{
+  data->ip_addr = record->ip_addr;
+  data->poll = record->poll;
+  data->stratum = record->stratum;
+  data->state = record->state;
+  data->mode = record->mode;
+  data->flags = record->flags;
+  data->reachability = record->reachability;
+  data->since_sample = record->since_sample;
+  data->orig_latest_meas = record->orig_latest_meas;
+  data->latest_meas = record->latest_meas;
+  data->latest_meas_err = record->latest_meas_err;
+}
+
+/* ================================================== */
+
+static void
+get_sourcestats_from_record(RPY_SourceRecord *record, RPY_Sourcestats *stats)
+{
+  stats->ref_id = record->ref_id;
+  stats->ip_addr = record->ip_addr;
+
+  /* Reference clocks don't have an address in the statistics */
+  if (ntohs(record->mode) == RPY_SD_MD_REF)
+    stats->ip_addr.family = htons(IPADDR_UNSPEC);
+  stats->n_samples = record->n_samples;
+  stats->n_runs = record->n_runs;
+  stats->span_seconds = record->span_seconds;
+  stats->sd = record->sd;
+  stats->resid_freq_ppm = record->resid_freq_ppm;
+  stats->skew_ppm = record->skew_ppm;
+  stats->est_offset = record->est_offset;
+  stats->est_offset_err = record->est_offset_err;
+}
+
+/* ================================================== */
+
 static int
 process_cmd_sources(char *line)
 {
@@ -2028,16 +2134,20 @@ process_cmd_sources(char *line)
   IPAddr ip_addr;
   uint32_t i, mode, n_sources;
   char name[50], mode_ch, state_ch;
+  ARR_Instance records;
   int verbose;
 
   /* Check whether to output verbose headers */
   verbose = check_for_verbose_flag(line);
   
-  request.command = htons(REQ_N_SOURCES);
-  if (!request_reply(&request, &reply, RPY_N_SOURCES, 0))
-    return 0;
+  if (!get_source_records(&n_sources, &records)) {
+    request.command = htons(REQ_N_SOURCES);
+    if (!request_reply(&request, &reply, RPY_N_SOURCES, 0))
+      return 0;
+
+    n_sources = ntohl(reply.data.n_sources.n_sources);
+  }
 
-  n_sources = ntohl(reply.data.n_sources.n_sources);
   print_info_field("210 Number of sources = %lu\n", (unsigned long)n_sources);
 
   if (verbose) {
@@ -2057,10 +2167,14 @@ process_cmd_sources(char *line)
   /*           "MS NNNNNNNNNNNNNNNNNNNNNNNNNNN  SS  PP   RRR  RRRR  SSSSSSS[SSSSSSS] +/- SSSSSS" */
 
   for (i = 0; i < n_sources; i++) {
-    request.command = htons(REQ_SOURCE_DATA);
-    request.data.source_data.index = htonl(i);
-    if (!request_reply(&request, &reply, RPY_SOURCE_DATA, 0))
-      return 0;
+    if (records) {
+      get_source_data_from_record(ARR_GetElement(records, i), &reply.data.source_data);
+    } else {
+      request.command = htons(REQ_SOURCE_DATA);
+      request.data.source_data.index = htonl(i);
+      if (!request_reply(&request, &reply, RPY_SOURCE_DATA, 0))
+        return 0;
+    }
 
     mode = ntohs(reply.data.source_data.mode);
     UTI_IPNetworkToHost(&reply.data.source_data.ip_addr, &ip_addr);
@@ -2122,6 +2236,9 @@ process_cmd_sources(char *line)
                  REPORT_END);
   }
 
+  if (records)
+    ARR_DestroyInstance(records);
+
   return 1;
 }
 
@@ -2136,14 +2253,18 @@ process_cmd_sourcestats(char *line)
   int verbose = 0;
   char name[50];
   IPAddr ip_addr;
+  ARR_Instance records;
 
   verbose = check_for_verbose_flag(line);
 
-  request.command = htons(REQ_N_SOURCES);
-  if (!request_reply(&request, &reply, RPY_N_SOURCES, 0))
-    return 0;
+  if (!get_source_records(&n_sources, &records)) {
+    request.command = htons(REQ_N_SOURCES);
+    if (!request_reply(&request, &reply, RPY_N_SOURCES, 0))
+      return 0;
+
+    n_sources = ntohl(reply.data.n_sources.n_sources);
+  }
 
-  n_sources = ntohl(reply.data.n_sources.n_sources);
   print_info_field("210 Number of sources = %lu\n", (unsigned long)n_sources);
 
   if (verbose) {
@@ -2163,10 +2284,14 @@ process_cmd_sourcestats(char *line)
   /*           "NNNNNNNNNNNNNNNNNNNNNNNNN  NP  NR  SSSS FFFFFFFFFF SSSSSSSSSS  SSSSSSS  SSSSSS" */
 
   for (i = 0; i < n_sources; i++) {
-    request.command = htons(REQ_SOURCESTATS);
-    request.data.source_data.index = htonl(i);
-    if (!request_reply(&request, &reply, RPY_SOURCESTATS, 0))
-      return 0;
+    if (records) {
+      get_sourcestats_from_record(ARR_GetElement(records, i), &reply.data.sourcestats);
+    } else {
+      request.command = htons(REQ_SOURCESTATS);
+      request.data.source_data.index = htonl(i);
+      if (!request_reply(&request, &reply, RPY_SOURCESTATS, 0))
+        return 0;
+    }
 
     UTI_IPNetworkToHost(&reply.data.sourcestats.ip_addr, &ip_addr);
     format_name(name, sizeof (name), 25, ip_addr.family == IPADDR_UNSPEC,
@@ -2184,32 +2309,29 @@ process_cmd_sourcestats(char *line)
                  REPORT_END);
   }
 
+  if (records)
+    ARR_DestroyInstance(records);
+
   return 1;
 }
 
 /* ================================================== */
 
-static int
-process_cmd_tracking(char *line)
+static void
+print_tracking(CMD_Reply *reply)
 {
-  CMD_Request request;
-  CMD_Reply reply;
   IPAddr ip_addr;
   uint32_t ref_id;
   char name[50];
   struct timespec ref_time;
-  
-  request.command = htons(REQ_TRACKING);
-  if (!request_reply(&request, &reply, RPY_TRACKING, 0))
-    return 0;
 
-  ref_id = ntohl(reply.data.tracking.ref_id);
+  ref_id = ntohl(reply->data.tracking.ref_id);
 
-  UTI_IPNetworkToHost(&reply.data.tracking.ip_addr, &ip_addr);
+  UTI_IPNetworkToHost(&reply->data.tracking.ip_addr, &ip_addr);
   format_name(name, sizeof (name), sizeof (name),
               ip_addr.family == IPADDR_UNSPEC, ref_id, &ip_addr);
 
-  UTI_TimespecNetworkToHost(&reply.data.tracking.ref_time, &ref_time);
+  UTI_TimespecNetworkToHost(&reply->data.tracking.ref_time, &ref_time);
 
   print_report("Reference ID    : %R (%s)\n"
                "Stratum         : %u\n"
@@ -2225,18 +2347,170 @@ process_cmd_tracking(char *line)
                "Update interval : %.1f seconds\n"
                "Leap status     : %L\n",
                (unsigned long)ref_id, name,
-               ntohs(reply.data.tracking.stratum),
+               ntohs(reply->data.tracking.stratum),
                &ref_time,
-               UTI_FloatNetworkToHost(reply.data.tracking.current_correction),
-               UTI_FloatNetworkToHost(reply.data.tracking.last_offset),
-               UTI_FloatNetworkToHost(reply.data.tracking.rms_offset),
-               UTI_FloatNetworkToHost(reply.data.tracking.freq_ppm),
-               UTI_FloatNetworkToHost(reply.data.tracking.resid_freq_ppm),
-               UTI_FloatNetworkToHost(reply.data.tracking.skew_ppm),
-               UTI_FloatNetworkToHost(reply.data.tracking.root_delay),
-               UTI_FloatNetworkToHost(reply.data.tracking.root_dispersion),
-               UTI_FloatNetworkToHost(reply.data.tracking.last_update_interval),
-               ntohs(reply.data.tracking.leap_status), REPORT_END);
+               UTI_FloatNetworkToHost(reply->data.tracking.current_correction),
+               UTI_FloatNetworkToHost(reply->data.tracking.last_offset),
+               UTI_FloatNetworkToHost(reply->data.tracking.rms_offset),
+               UTI_FloatNetworkToHost(reply->data.tracking.freq_ppm),
+               UTI_FloatNetworkToHost(reply->data.tracking.resid_freq_ppm),
+               UTI_FloatNetworkToHost(reply->data.tracking.skew_ppm),
+               UTI_FloatNetworkToHost(reply->data.tracking.root_delay),
+               UTI_FloatNetworkToHost(reply->data.tracking.root_dispersion),
+               UTI_FloatNetworkToHost(reply->data.tracking.last_update_interval),
+               ntohs(reply->data.tracking.leap_status), REPORT_END);
+}
+
+/* ================================================== */
+
+static int
+process_cmd_tracking(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+
+  request.command = htons(REQ_TRACKING);
+  if (!request_reply(&request, &reply, RPY_TRACKING, 0))
+    return 0;
+
+  print_tracking(&reply);
+
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+print_event(CMD_Reply *reply)
+{
+  RPY_Event *event = &reply->data.event;
+  char name[50];
+  IPAddr ip_addr;
+  struct timespec ts;
+  uint32_t ref_id;
+
+  if (ntohl(event->dropped) > 0)
+    print_report("%U dropped %U\n", (unsigned long)ntohl(event->sequence),
+                 (unsigned long)ntohl(event->dropped), REPORT_END);
+
+  switch (ntohs(event->type)) {
+    case RPY_EVT_TRACKING:
+      ref_id = ntohl(event->data.tracking.ref_id);
+      UTI_IPNetworkToHost(&event->data.tracking.ip_addr, &ip_addr);
+      UTI_TimespecNetworkToHost(&event->data.tracking.ref_time, &ts);
+      print_report("%U tracking %R %s %d %T %+.9f %+.3f %.3f %.9f %.9f %L\n",
+                   (unsigned long)ntohl(event->sequence), (unsigned long)ref_id,
+                   ip_addr.family != IPADDR_UNSPEC ? UTI_IPToString(&ip_addr) :
+                     UTI_RefidToString(ref_id),
+                   ntohs(event->data.tracking.stratum), &ts,
+                   UTI_FloatNetworkToHost(event->data.tracking.last_offset),
+                   UTI_FloatNetworkToHost(event->data.tracking.freq_ppm),
+                   UTI_FloatNetworkToHost(event->data.tracking.skew_ppm),
+                   UTI_FloatNetworkToHost(event->data.tracking.root_delay),
+                   UTI_FloatNetworkToHost(event->data.tracking.root_dispersion),
+                   ntohs(event->data.tracking.leap_status), REPORT_END);
+      break;
+    case RPY_EVT_MEASUREMENT:
+      ref_id = ntohl(event->data.measurement.ref_id);
+      UTI_IPNetworkToHost(&event->data.measurement.ip_addr, &ip_addr);
+      UTI_TimespecNetworkToHost(&event->data.measurement.sample_time, &ts);
+      format_name(name, sizeof (name), 25, ip_addr.family == IPADDR_UNSPEC,
+                  ref_id, &ip_addr);
+      print_report("%U measurement %s %d %T %+.9f %.9f %.9f\n",
+                   (unsigned long)ntohl(event->sequence), name,
+                   ntohs(event->data.measurement.stratum), &ts,
+                   UTI_FloatNetworkToHost(event->data.measurement.offset),
+                   UTI_FloatNetworkToHost(event->data.measurement.peer_delay),
+                   UTI_FloatNetworkToHost(event->data.measurement.peer_dispersion),
+                   REPORT_END);
+      break;
+    case RPY_EVT_SELECTION:
+      ref_id = ntohl(event->data.selection.ref_id);
+      UTI_IPNetworkToHost(&event->data.selection.ip_addr, &ip_addr);
+      if (ref_id)
+        format_name(name, sizeof (name), 25, ip_addr.family == IPADDR_UNSPEC,
+                    ref_id, &ip_addr);
+      else
+        snprintf(name, sizeof (name), "none");
+      print_report("%U selection %s\n", (unsigned long)ntohl(event->sequence),
+                   name, REPORT_END);
+      break;
+    case RPY_EVT_SERVERSTATS:
+      print_report("%U serverstats %U %U %U %U %U\n",
+                   (unsigned long)ntohl(event->sequence),
+                   (unsigned long)ntohl(event->data.server_stats.ntp_hits),
+                   (unsigned long)ntohl(event->data.server_stats.ntp_drops),
+                   (unsigned long)ntohl(event->data.server_stats.cmd_hits),
+                   (unsigned long)ntohl(event->data.server_stats.cmd_drops),
+                   (unsigned long)ntohl(event->data.server_stats.log_drops),
+                   REPORT_END);
+      break;
+  }
+}
+
+/* ================================================== */
+
+static int
+process_cmd_monitor(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t events;
+  char *word;
+  fd_set rdfd;
+  int len;
+
+  for (events = 0; *line; ) {
+    word = line;
+    line = CPS_SplitWord(line);
+
+    if (!strcmp(word, "tracking")) {
+      events |= REQ_SUBSCRIBE_TRACKING;
+    } else if (!strcmp(word, "measurements")) {
+      events |= REQ_SUBSCRIBE_MEASUREMENTS;
+    } else if (!strcmp(word, "selection")) {
+      events |= REQ_SUBSCRIBE_SELECTION;
+    } else if (!strcmp(word, "serverstats")) {
+      events |= REQ_SUBSCRIBE_SERVERSTATS;
+    } else {
+      LOG(LOGS_ERR, "Invalid event %s", word);
+      return 0;
+    }
+  }
+
+  if (!events)
+    events = REQ_SUBSCRIBE_ALL;
+
+  request.command = htons(REQ_SUBSCRIBE);
+  request.data.subscribe.events = htonl(events);
+  request.data.subscribe.stats_interval = htonl(1);
+  if (!request_reply(&request, &reply, RPY_NULL, 0))
+    return 0;
+
+  /* Print the pushed records until interrupted.  The daemon removes the
+     subscription when the socket of the client is closed. */
+  while (!quit) {
+    fflush(stdout);
+
+    FD_ZERO(&rdfd);
+    FD_SET(sock_fd, &rdfd);
+
+    if (select(sock_fd + 1, &rdfd, NULL, NULL, NULL) < 0) {
+      if (errno == EINTR)
+        continue;
+      DEBUG_LOG("select failed : %s", strerror(errno));
+      return 0;
+    }
+
+    len = recv(sock_fd, (void *)&reply, sizeof (reply), 0);
+
+    if (len < (int)offsetof(CMD_Reply, data) || len < PKL_ReplyLength(&reply) ||
+        reply.version != proto_version || reply.pkt_type != PKT_TYPE_CMD_REPLY ||
+        reply.command != htons(REQ_SUBSCRIBE) || reply.reply != htons(RPY_EVENT))
+      continue;
+
+    print_event(&reply);
+  }
 
   return 1;
 }
@@ -2363,6 +2637,37 @@ process_cmd_serverstats(char *line)
   CMD_Request request;
   CMD_Reply reply;
 
+  request.command = htons(REQ_SERVER_STATS2);
+  if (submit_request(&request, &reply) && ntohs(reply.status) == STT_SUCCESS &&
+      ntohs(reply.reply) == RPY_SERVER_STATS2) {
+    print_report("NTP packets received       : %U\n"
+                 "NTP packets dropped        : %U\n"
+                 "Command packets received   : %U\n"
+                 "Command packets dropped    : %U\n"
+                 "Client log records dropped : %U\n"
+                 "Interleaved NTP hits       : %U\n"
+                 "Interleaved NTP misses     : %U\n"
+                 "NTP timestamps held        : %U\n"
+                 "Client log IPv4 records    : %U/%U\n"
+                 "Client log IPv6 records    : %U/%U\n",
+                 (unsigned long)ntohl(reply.data.server_stats2.ntp_hits),
+                 (unsigned long)ntohl(reply.data.server_stats2.ntp_drops),
+                 (unsigned long)ntohl(reply.data.server_stats2.cmd_hits),
+                 (unsigned long)ntohl(reply.data.server_stats2.cmd_drops),
+                 (unsigned long)ntohl(reply.data.server_stats2.log_drops),
+                 (unsigned long)ntohl(reply.data.server_stats2.ntp_interleaved_hits),
+                 (unsigned long)ntohl(reply.data.server_stats2.ntp_interleaved_misses),
+                 (unsigned long)ntohl(reply.data.server_stats2.ntp_timestamps),
+                 (unsigned long)ntohl(reply.data.server_stats2.log_records_ipv4),
+                 (unsigned long)ntohl(reply.data.server_stats2.log_records_ipv4_size),
+                 (unsigned long)ntohl(reply.data.server_stats2.log_records_ipv6),
+                 (unsigned long)ntohl(reply.data.server_stats2.log_records_ipv6_size),
+                 REPORT_END);
+    return 1;
+  }
+
+  /* Fall back to the original request for daemons which don't support
+     the newer request */
   request.command = htons(REQ_SERVER_STATS);
   if (!request_reply(&request, &reply, RPY_SERVER_STATS, 0))
     return 0;
@@ -2382,35 +2687,356 @@ process_cmd_serverstats(char *line)
   return 1;
 }
 
+/* ================================================== */
+/* Get an upper estimate of a quantile from a log2 histogram of intervals
+   with the first bucket ending at the specified unit */
+
+static double
+get_histogram_quantile(uint32_t *histogram, int buckets, double unit,
+                       uint32_t calls, double max_time, double q)
+{
+  uint32_t sum, limit;
+  int i;
+
+  limit = q * calls;
+
+  for (i = sum = 0; i < buckets - 1; i++) {
+    sum += ntohl(histogram[i]);
+    if (sum > limit)
+      return MIN(ldexp(unit, i), max_time);
+  }
+
+  return max_time;
+}
+
 /* ================================================== */
 
 static int
-process_cmd_smoothing(char *line)
+process_cmd_schedstats(char *line)
 {
   CMD_Request request;
   CMD_Reply reply;
-  uint32_t flags;
+  uint32_t i, n_records, calls;
+  double total_time, max_time;
+  const char *type;
+  char name[32];
 
-  request.command = htons(REQ_SMOOTHING);
-  if (!request_reply(&request, &reply, RPY_SMOOTHING, 0))
-    return 0;
+  print_header("Handler                   Type         Calls   Mean    Max    P50    P99");
 
-  flags = ntohl(reply.data.smoothing.flags);
+  for (i = n_records = 0; i == 0 || i < n_records; i++) {
+    request.command = htons(REQ_SCHED_STATS);
+    request.data.sched_stats.index = htonl(i);
+    if (!request_reply(&request, &reply, RPY_SCHED_STATS, 0))
+      return 0;
 
-  print_report("Active         : %B %s\n"
-               "Offset         : %+.9f seconds\n"
-               "Frequency      : %+.6f ppm\n"
-               "Wander         : %+.6f ppm per second\n"
+    n_records = ntohl(reply.data.sched_stats.n_records);
+
+    switch (ntohs(reply.data.sched_stats.type)) {
+      case RPY_SCHED_LAG:
+        type = "lag";
+        break;
+      case RPY_SCHED_TIMEOUT:
+        type = "timeout";
+        break;
+      case RPY_SCHED_FILE:
+        type = "file";
+        break;
+      default:
+        type = "?";
+        break;
+    }
+
+    snprintf(name, sizeof (name), "%.*s", (int)sizeof (reply.data.sched_stats.name),
+             (char *)reply.data.sched_stats.name);
+    calls = ntohl(reply.data.sched_stats.calls);
+    total_time = UTI_FloatNetworkToHost(reply.data.sched_stats.total_time);
+    max_time = UTI_FloatNetworkToHost(reply.data.sched_stats.max_time);
+
+    print_report("%-25s %-7s %10U %S %S %S %S\n",
+                 name, type, (unsigned long)calls,
+                 calls > 0 ? total_time / calls : 0.0, max_time,
+                 get_histogram_quantile(reply.data.sched_stats.histogram,
+                                        RPY_SCHED_HISTOGRAM_BUCKETS, 1.0e-6,
+                                        calls, max_time, 0.5),
+                 get_histogram_quantile(reply.data.sched_stats.histogram,
+                                        RPY_SCHED_HISTOGRAM_BUCKETS, 1.0e-6,
+                                        calls, max_time, 0.99),
+                 REPORT_END);
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_keystats(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t i, n_records, samples;
+  double mean_delay, max_delay;
+
+  print_header("    Key ID    Samples  Comp.   Mean    Max    P50    P99");
+
+  for (i = n_records = 0; i == 0 || i < n_records; i++) {
+    request.command = htons(REQ_KEY_STATS);
+    request.data.key_stats.index = htonl(i);
+    if (!request_reply(&request, &reply, RPY_KEY_STATS, 0))
+      return 0;
+
+    n_records = ntohl(reply.data.key_stats.n_records);
+    if (n_records == 0)
+      break;
+
+    samples = ntohl(reply.data.key_stats.samples);
+    mean_delay = UTI_FloatNetworkToHost(reply.data.key_stats.mean_delay);
+    max_delay = UTI_FloatNetworkToHost(reply.data.key_stats.max_delay);
+
+    print_report("%10U %10U %S %S %S %S %S\n",
+                 (unsigned long)ntohl(reply.data.key_stats.key_id),
+                 (unsigned long)samples,
+                 UTI_FloatNetworkToHost(reply.data.key_stats.auth_delay),
+                 mean_delay, max_delay,
+                 get_histogram_quantile(reply.data.key_stats.histogram,
+                                        RPY_KEY_HISTOGRAM_BUCKETS, 1.0e-9,
+                                        samples, max_delay, 0.5),
+                 get_histogram_quantile(reply.data.key_stats.histogram,
+                                        RPY_KEY_HISTOGRAM_BUCKETS, 1.0e-9,
+                                        samples, max_delay, 0.99),
+                 REPORT_END);
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_hwclocks(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t i, n_records;
+  char name[16];
+
+  print_header("Interface        NP  Interval   Freq ppm   LastErr  RMSErr Resets   "
+               "Reads ReadAvg ReadMax ReadErr");
+
+  for (i = n_records = 0; i == 0 || i < n_records; i++) {
+    request.command = htons(REQ_HWCLOCK_STATS);
+    request.data.hwclock_stats.index = htonl(i);
+    if (!request_reply(&request, &reply, RPY_HWCLOCK_STATS, 0))
+      return 0;
+
+    n_records = ntohl(reply.data.hwclock_stats.n_records);
+    if (n_records == 0)
+      break;
+
+    snprintf(name, sizeof (name), "%.*s", (int)sizeof (reply.data.hwclock_stats.name),
+             (char *)reply.data.hwclock_stats.name);
+
+    print_report("%-15s %3U %9.3f %+P %+S %S %6U %7U %S %S %S\n",
+                 name, (unsigned long)ntohl(reply.data.hwclock_stats.n_samples),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.separation),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.frequency),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.last_error),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.rms_error),
+                 (unsigned long)ntohl(reply.data.hwclock_stats.n_resets),
+                 (unsigned long)ntohl(reply.data.hwclock_stats.phc_readings),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.phc_read_time),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.phc_read_max),
+                 UTI_FloatNetworkToHost(reply.data.hwclock_stats.phc_error),
+                 REPORT_END);
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_sysstats(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+
+  request.command = htons(REQ_SYS_STATS);
+  if (!request_reply(&request, &reply, RPY_SYS_STATS, 0))
+    return 0;
+
+  print_report("Adjtimex calls          : %U\n"
+               "Adjtimex last time      : %.9f seconds\n"
+               "Adjtimex mean time      : %.9f seconds\n"
+               "Adjtimex max time       : %.9f seconds\n"
+               "Privileged helper       : %B\n"
+               "Helper channel requests : %U\n"
+               "Helper socket requests  : %U\n",
+               (unsigned long)ntohl(reply.data.sys_stats.adjtimex_calls),
+               UTI_FloatNetworkToHost(reply.data.sys_stats.adjtimex_last_time),
+               UTI_FloatNetworkToHost(reply.data.sys_stats.adjtimex_mean_time),
+               UTI_FloatNetworkToHost(reply.data.sys_stats.adjtimex_max_time),
+               !!(ntohl(reply.data.sys_stats.flags) & RPY_SYS_STATS_FLAG_HELPER),
+               (unsigned long)ntohl(reply.data.sys_stats.helper_channel_requests),
+               (unsigned long)ntohl(reply.data.sys_stats.helper_socket_requests),
+               REPORT_END);
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_signdstats(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+
+  request.command = htons(REQ_SIGND_STATS);
+  if (!request_reply(&request, &reply, RPY_SIGND_STATS, 0))
+    return 0;
+
+  print_report("Connections             : %U (%U open)\n"
+               "Queue length            : %U (peak %U, max %U)\n"
+               "Requests                : %U\n"
+               "Signed                  : %U\n"
+               "Failed                  : %U\n"
+               "Dropped                 : %U\n"
+               "Queued                  : %U\n"
+               "Median delay            : %.6f seconds\n"
+               "99th percentile delay   : %.6f seconds\n",
+               (unsigned long)ntohl(reply.data.signd_stats.connections),
+               (unsigned long)ntohl(reply.data.signd_stats.open_connections),
+               (unsigned long)ntohl(reply.data.signd_stats.queue_length),
+               (unsigned long)ntohl(reply.data.signd_stats.peak_queue_length),
+               (unsigned long)ntohl(reply.data.signd_stats.max_queue_length),
+               (unsigned long)ntohl(reply.data.signd_stats.requests),
+               (unsigned long)ntohl(reply.data.signd_stats.successes),
+               (unsigned long)ntohl(reply.data.signd_stats.failures),
+               (unsigned long)ntohl(reply.data.signd_stats.drops),
+               (unsigned long)ntohl(reply.data.signd_stats.queued),
+               UTI_FloatNetworkToHost(reply.data.signd_stats.median_delay),
+               UTI_FloatNetworkToHost(reply.data.signd_stats.p99_delay),
+               REPORT_END);
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_startupstats(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t flags;
+
+  request.command = htons(REQ_STARTUP_STATS);
+  if (!request_reply(&request, &reply, RPY_STARTUP_STATS, 0))
+    return 0;
+
+  flags = ntohl(reply.data.startup_stats.flags);
+
+  print_report("Completed               : %B\n"
+               "Fast start              : %B\n"
+               "Configuration           : %.6f seconds\n"
+               "Initialisation          : %.6f seconds\n"
+               "RTC                     : %.6f seconds\n"
+               "Initstepslew            : %.6f seconds\n"
+               "Resolving               : %.6f seconds\n"
+               "Dumps                   : %.6f seconds\n"
+               "Total                   : %.6f seconds\n",
+               !!(flags & RPY_STARTUP_STATS_FLAG_COMPLETE),
+               !!(flags & RPY_STARTUP_STATS_FLAG_FASTSTART),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.config_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.init_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.rtc_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.initstepslew_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.resolving_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.dumps_time),
+               UTI_FloatNetworkToHost(reply.data.startup_stats.total_time),
+               REPORT_END);
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+process_cmd_slotstats(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  uint32_t i, n_records;
+  char name[16];
+
+  print_header("Name             Timeouts   Slot   Load  Scheduled    Delayed AvgDel MaxDel");
+
+  for (i = n_records = 0; i == 0 || i < n_records; i++) {
+    request.command = htons(REQ_SLOT_STATS);
+    request.data.slot_stats.index = htonl(i);
+    if (!request_reply(&request, &reply, RPY_SLOT_STATS, 0))
+      return 0;
+
+    n_records = ntohl(reply.data.slot_stats.n_records);
+    if (n_records == 0)
+      break;
+
+    snprintf(name, sizeof (name), "%.*s", (int)sizeof (reply.data.slot_stats.name),
+             (char *)reply.data.slot_stats.name);
+
+    print_report("%-15s %9U %S %6.3f %10U %10U %S %S\n",
+                 name, (unsigned long)ntohl(reply.data.slot_stats.timeouts),
+                 UTI_FloatNetworkToHost(reply.data.slot_stats.slot),
+                 UTI_FloatNetworkToHost(reply.data.slot_stats.load),
+                 (unsigned long)ntohl(reply.data.slot_stats.scheduled),
+                 (unsigned long)ntohl(reply.data.slot_stats.delayed),
+                 UTI_FloatNetworkToHost(reply.data.slot_stats.mean_delay),
+                 UTI_FloatNetworkToHost(reply.data.slot_stats.max_delay),
+                 REPORT_END);
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+print_smoothing(CMD_Reply *reply)
+{
+  uint32_t flags;
+
+  flags = ntohl(reply->data.smoothing.flags);
+
+  print_report("Active         : %B %s\n"
+               "Offset         : %+.9f seconds\n"
+               "Frequency      : %+.6f ppm\n"
+               "Wander         : %+.6f ppm per second\n"
                "Last update    : %.1f seconds ago\n"
                "Remaining time : %.1f seconds\n",
                !!(flags & RPY_SMT_FLAG_ACTIVE),
                flags & RPY_SMT_FLAG_LEAPONLY ? "(leap second only)" : "",
-               UTI_FloatNetworkToHost(reply.data.smoothing.offset),
-               UTI_FloatNetworkToHost(reply.data.smoothing.freq_ppm),
-               UTI_FloatNetworkToHost(reply.data.smoothing.wander_ppm),
-               UTI_FloatNetworkToHost(reply.data.smoothing.last_update_ago),
-               UTI_FloatNetworkToHost(reply.data.smoothing.remaining_time),
+               UTI_FloatNetworkToHost(reply->data.smoothing.offset),
+               UTI_FloatNetworkToHost(reply->data.smoothing.freq_ppm),
+               UTI_FloatNetworkToHost(reply->data.smoothing.wander_ppm),
+               UTI_FloatNetworkToHost(reply->data.smoothing.last_update_ago),
+               UTI_FloatNetworkToHost(reply->data.smoothing.remaining_time),
                REPORT_END);
+}
+
+/* ================================================== */
+
+static int
+process_cmd_smoothing(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+
+  request.command = htons(REQ_SMOOTHING);
+  if (!request_reply(&request, &reply, RPY_SMOOTHING, 0))
+    return 0;
+
+  print_smoothing(&reply);
 
   return 1;
 }
@@ -2436,18 +3062,12 @@ process_cmd_smoothtime(CMD_Request *msg, const char *line)
 
 /* ================================================== */
 
-static int
-process_cmd_rtcreport(char *line)
+static void
+print_rtcreport(CMD_Reply *reply)
 {
-  CMD_Request request;
-  CMD_Reply reply;
   struct timespec ref_time;
-  
-  request.command = htons(REQ_RTCREPORT);
-  if (!request_reply(&request, &reply, RPY_RTC, 0))
-    return 0;
 
-  UTI_TimespecNetworkToHost(&reply.data.rtc.ref_time, &ref_time);
+  UTI_TimespecNetworkToHost(&reply->data.rtc.ref_time, &ref_time);
 
   print_report("RTC ref time (UTC) : %T\n"
                "Number of samples  : %u\n"
@@ -2456,12 +3076,27 @@ process_cmd_rtcreport(char *line)
                "RTC is fast by     : %12.6f seconds\n"
                "RTC gains time at  : %9.3f ppm\n",
                &ref_time,
-               ntohs(reply.data.rtc.n_samples),
-               ntohs(reply.data.rtc.n_runs),
-               (unsigned long)ntohl(reply.data.rtc.span_seconds),
-               UTI_FloatNetworkToHost(reply.data.rtc.rtc_seconds_fast),
-               UTI_FloatNetworkToHost(reply.data.rtc.rtc_gain_rate_ppm),
+               ntohs(reply->data.rtc.n_samples),
+               ntohs(reply->data.rtc.n_runs),
+               (unsigned long)ntohl(reply->data.rtc.span_seconds),
+               UTI_FloatNetworkToHost(reply->data.rtc.rtc_seconds_fast),
+               UTI_FloatNetworkToHost(reply->data.rtc.rtc_gain_rate_ppm),
                REPORT_END);
+}
+
+/* ================================================== */
+
+static int
+process_cmd_rtcreport(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+
+  request.command = htons(REQ_RTCREPORT);
+  if (!request_reply(&request, &reply, RPY_RTC, 0))
+    return 0;
+
+  print_rtcreport(&reply);
 
   return 1;
 }
@@ -2530,6 +3165,67 @@ process_cmd_clients(char *line)
 }
 
 
+/* ================================================== */
+
+static int
+process_cmd_monitordata(char *line)
+{
+  CMD_Request request;
+  CMD_Reply reply;
+  IPAddr ip;
+  uint32_t i, n_sources, next_index, n_indices;
+  RPY_MonitorData_Source *source;
+  char name[50];
+
+  next_index = 0;
+
+  print_header("Name/IP address             Stratum Poll Reach LastRx Last sample Min delay");
+
+  /*           "NNNNNNNNNNNNNNNNNNNNNNNNNNN  SS  PP   RRR  RRRR  SSSSSSS/SSSSS SSSSSSS/SSSSS" */
+
+  while (1) {
+    request.command = htons(REQ_MONITOR_DATA);
+    request.data.monitor_data.first_index = htonl(next_index);
+    request.data.monitor_data.n_sources = htonl(MAX_MONITOR_SOURCES);
+
+    if (!request_reply(&request, &reply, RPY_MONITOR_DATA, 0))
+      return 0;
+
+    n_sources = ntohl(reply.data.monitor_data.n_sources);
+    n_indices = ntohl(reply.data.monitor_data.n_indices);
+
+    for (i = 0; i < n_sources && i < MAX_MONITOR_SOURCES; i++) {
+      source = &reply.data.monitor_data.sources[i];
+
+      UTI_IPNetworkToHost(&source->ip_addr, &ip);
+      if (ip.family == IPADDR_UNSPEC)
+        continue;
+
+      format_name(name, sizeof (name), 25, 0, 0, &ip);
+
+      print_report("%-27s  %2d  %2d   %3o  %I  %+S/%S %+S/%S\n",
+                   name,
+                   ntohs(source->stratum),
+                   (int16_t)ntohs(source->poll),
+                   ntohs(source->reachability),
+                   (unsigned long)ntohl(source->since_sample),
+                   UTI_FloatNetworkToHost(source->offset),
+                   UTI_FloatNetworkToHost(source->delay),
+                   UTI_FloatNetworkToHost(source->min_delay_offset),
+                   UTI_FloatNetworkToHost(source->min_delay),
+                   REPORT_END);
+    }
+
+    /* Set the next index to probe based on what the server tells us */
+    next_index = ntohl(reply.data.monitor_data.next_index);
+
+    if (next_index >= n_indices || n_sources < MAX_MONITOR_SOURCES)
+      break;
+  }
+
+  return 1;
+}
+
 /* ================================================== */
 /* Process the manual list command */
 static int
@@ -2649,6 +3345,26 @@ process_cmd_makestep(CMD_Request *msg, char *line)
 
 /* ================================================== */
 
+static void
+print_activity(CMD_Reply *reply)
+{
+  print_info_field("200 OK\n");
+
+  print_report("%U sources online\n"
+               "%U sources offline\n"
+               "%U sources doing burst (return to online)\n"
+               "%U sources doing burst (return to offline)\n"
+               "%U sources with unknown address\n",
+               (unsigned long)ntohl(reply->data.activity.online),
+               (unsigned long)ntohl(reply->data.activity.offline),
+               (unsigned long)ntohl(reply->data.activity.burst_online),
+               (unsigned long)ntohl(reply->data.activity.burst_offline),
+               (unsigned long)ntohl(reply->data.activity.unresolved),
+               REPORT_END);
+}
+
+/* ================================================== */
+
 static int
 process_cmd_activity(const char *line)
 {
@@ -2659,19 +3375,7 @@ process_cmd_activity(const char *line)
   if (!request_reply(&request, &reply, RPY_ACTIVITY, 0))
     return 0;
 
-  print_info_field("200 OK\n");
-
-  print_report("%U sources online\n"
-               "%U sources offline\n"
-               "%U sources doing burst (return to online)\n"
-               "%U sources doing burst (return to offline)\n"
-               "%U sources with unknown address\n",
-               (unsigned long)ntohl(reply.data.activity.online),
-               (unsigned long)ntohl(reply.data.activity.offline),
-               (unsigned long)ntohl(reply.data.activity.burst_online),
-               (unsigned long)ntohl(reply.data.activity.burst_offline),
-               (unsigned long)ntohl(reply.data.activity.unresolved),
-               REPORT_END);
+  print_activity(&reply);
 
   return 1;
 }
@@ -2695,6 +3399,23 @@ process_cmd_reselectdist(CMD_Request *msg, char *line)
 
 /* ================================================== */
 
+static int
+process_cmd_reload(CMD_Request *msg, char *line)
+{
+  if (!strcmp(line, "access")) {
+    msg->command = htons(REQ_RELOAD_ACCESS);
+  } else if (!strcmp(line, "config")) {
+    msg->command = htons(REQ_RELOAD_CONFIG);
+  } else {
+    LOG(LOGS_ERR, "Bad syntax for reload command");
+    return 0;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
 static void
 process_cmd_reselect(CMD_Request *msg, char *line)
 {
@@ -2943,6 +3664,9 @@ process_line(char *line)
     do_normal_submit = 0;
     give_help();
     ret = 1;
+  } else if (!strcmp(command, "hwclocks")) {
+    do_normal_submit = 0;
+    ret = process_cmd_hwclocks(line);
   } else if (!strcmp(command, "keygen")) {
     ret = process_cmd_keygen(line);
     do_normal_submit = 0;
@@ -2973,6 +3697,12 @@ process_line(char *line)
     do_normal_submit = process_cmd_minpoll(&tx_message, line);
   } else if (!strcmp(command, "minstratum")) {
     do_normal_submit = process_cmd_minstratum(&tx_message, line);
+  } else if (!strcmp(command, "monitor")) {
+    do_normal_submit = 0;
+    ret = process_cmd_monitor(line);
+  } else if (!strcmp(command, "monitordata")) {
+    do_normal_submit = 0;
+    ret = process_cmd_monitordata(line);
   } else if (!strcmp(command, "ntpdata")) {
     do_normal_submit = 0;
     ret = process_cmd_ntpdata(line);
@@ -2990,6 +3720,8 @@ process_line(char *line)
     process_cmd_refresh(&tx_message, line);
   } else if (!strcmp(command, "rekey")) {
     process_cmd_rekey(&tx_message, line);
+  } else if (!strcmp(command, "reload")) {
+    do_normal_submit = process_cmd_reload(&tx_message, line);
   } else if (!strcmp(command, "reselect")) {
     process_cmd_reselect(&tx_message, line);
   } else if (!strcmp(command, "reselectdist")) {
@@ -3000,12 +3732,18 @@ process_line(char *line)
   } else if (!strcmp(command, "rtcdata")) {
     do_normal_submit = 0;
     ret = process_cmd_rtcreport(line);
+  } else if (!strcmp(command, "schedstats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_schedstats(line);
   } else if (!strcmp(command, "serverstats")) {
     do_normal_submit = 0;
     ret = process_cmd_serverstats(line);
   } else if (!strcmp(command, "settime")) {
     do_normal_submit = 0;
     ret = process_cmd_settime(line);
+  } else if (!strcmp(command, "slotstats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_slotstats(line);
   } else if (!strcmp(command, "smoothing")) {
     do_normal_submit = 0;
     ret = process_cmd_smoothing(line);
@@ -3017,6 +3755,18 @@ process_line(char *line)
   } else if (!strcmp(command, "sourcestats")) {
     do_normal_submit = 0;
     ret = process_cmd_sourcestats(line);
+  } else if (!strcmp(command, "keystats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_keystats(line);
+  } else if (!strcmp(command, "signdstats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_signdstats(line);
+  } else if (!strcmp(command, "startupstats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_startupstats(line);
+  } else if (!strcmp(command, "sysstats")) {
+    do_normal_submit = 0;
+    ret = process_cmd_sysstats(line);
   } else if (!strcmp(command, "timeout")) {
     ret = process_cmd_timeout(line);
     do_normal_submit = 0;
@@ -3049,6 +3799,347 @@ process_line(char *line)
   return ret;
 }
 
+/* ================================================== */
+/* Sending of a request to many hosts in parallel */
+
+/* Maximum number of hosts waiting for a reply at the same time */
+#define MAX_PARALLEL_REQUESTS 256
+
+typedef struct {
+  const char *name;
+  int request;
+  int reply;
+  void (*print)(CMD_Reply *reply);
+} ParallelCommand;
+
+static const ParallelCommand parallel_commands[] = {
+  { "activity", REQ_ACTIVITY, RPY_ACTIVITY, print_activity },
+  { "rtcdata", REQ_RTCREPORT, RPY_RTC, print_rtcreport },
+  { "smoothing", REQ_SMOOTHING, RPY_SMOOTHING, print_smoothing },
+  { "tracking", REQ_TRACKING, RPY_TRACKING, print_tracking },
+  { NULL, 0, 0, NULL }
+};
+
+typedef enum {
+  HOST_WAITING,
+  HOST_SENT,
+  HOST_REPLIED,
+  HOST_FAILED,
+  HOST_INVALID
+} HostState;
+
+typedef struct {
+  char *name;
+  HostState state;
+  IPAddr ip_addr;
+  union sockaddr_all addr;
+  socklen_t addr_len;
+  CMD_Request request;
+  CMD_Reply reply;
+  int version;
+  int n_attempts;
+  struct timespec tx_time;
+} HostQuery;
+
+/* ================================================== */
+
+static ARR_Instance
+read_host_list(const char *filename)
+{
+  ARR_Instance hosts;
+  HostQuery *host;
+  char line[256], *name;
+  FILE *f;
+
+  if (!strcmp(filename, "-")) {
+    f = stdin;
+  } else {
+    f = fopen(filename, "r");
+    if (!f)
+      LOG_FATAL("Could not open %s : %s", filename, strerror(errno));
+  }
+
+  hosts = ARR_CreateInstance(sizeof (HostQuery));
+
+  /* Read one address per line, ignoring comments */
+  while (fgets(line, sizeof (line), f)) {
+    name = line;
+    CPS_SplitWord(name);
+    if (name[0] == '\0' || name[0] == '#')
+      continue;
+
+    host = ARR_GetNewElement(hosts);
+    memset(host, 0, sizeof (*host));
+    host->name = Strdup(name);
+    host->state = HOST_WAITING;
+  }
+
+  if (f != stdin)
+    fclose(f);
+
+  return hosts;
+}
+
+/* ================================================== */
+
+static int
+open_parallel_socket(int family)
+{
+  int sock_fd;
+
+  sock_fd = socket(family, SOCK_DGRAM, 0);
+  if (sock_fd < 0) {
+    DEBUG_LOG("Could not create socket : %s", strerror(errno));
+    return -1;
+  }
+
+  UTI_FdSetCloexec(sock_fd);
+
+  if (fcntl(sock_fd, F_SETFL, O_NONBLOCK) < 0) {
+    DEBUG_LOG("Could not set O_NONBLOCK : %s", strerror(errno));
+    close(sock_fd);
+    return -1;
+  }
+
+  return sock_fd;
+}
+
+/* ================================================== */
+
+static int
+send_parallel_request(HostQuery *host, int sock_fd, struct timespec *now)
+{
+  int command_length;
+
+  if (host->n_attempts > max_retries)
+    return 0;
+
+  command_length = prepare_request(&host->request, host->n_attempts, host->version);
+  host->n_attempts++;
+  host->tx_time = *now;
+
+  /* A failed send is handled as a lost packet */
+  if (sendto(sock_fd, (void *)&host->request, command_length, 0,
+             &host->addr.sa, host->addr_len) < 0)
+    DEBUG_LOG("Could not send to %s : %s", host->name, strerror(errno));
+
+  return 1;
+}
+
+/* ================================================== */
+
+static HostQuery *
+find_parallel_host(HostQuery **active, int n_active, CMD_Reply *reply,
+                   union sockaddr_all *addr)
+{
+  unsigned short port;
+  IPAddr ip_addr;
+  int i;
+
+  UTI_SockaddrToIPAndPort(&addr->sa, &ip_addr, &port);
+
+  for (i = 0; i < n_active; i++) {
+    if (active[i]->request.sequence == reply->sequence &&
+        UTI_CompareIPs(&active[i]->ip_addr, &ip_addr, NULL) == 0)
+      return active[i];
+  }
+
+  return NULL;
+}
+
+/* ================================================== */
+
+static int
+process_parallel_cmd(const char *host_file, int port, char *line)
+{
+  HostQuery *host, *active[MAX_PARALLEL_REQUESTS];
+  int i, n_active, next_host, ret, status, length, max_fd, sock_fds[2];
+  const ParallelCommand *command;
+  union sockaddr_all addr;
+  socklen_t addr_len;
+  struct timespec now;
+  struct timeval tv;
+  double timeout, min_timeout;
+  ARR_Instance hosts;
+  CMD_Reply reply;
+  fd_set rdfd;
+
+  CPS_SplitWord(line);
+
+  for (command = parallel_commands; command->name; command++) {
+    if (!strcmp(command->name, line))
+      break;
+  }
+
+  if (!command->name) {
+    LOG(LOGS_ERR, "Command %s not supported with host list", line);
+    return 0;
+  }
+
+  /* Print one line per host */
+  csv_mode = 1;
+
+  hosts = read_host_list(host_file);
+  sock_fds[0] = sock_fds[1] = -1;
+
+  for (i = 0; i < ARR_GetSize(hosts); i++) {
+    host = ARR_GetElement(hosts, i);
+
+    /* Accept only addresses to not block on name resolution */
+    if (!UTI_StringToIP(host->name, &host->ip_addr)) {
+      DEBUG_LOG("Invalid address %s", host->name);
+      host->state = HOST_INVALID;
+      continue;
+    }
+
+    host->addr_len = UTI_IPAndPortToSockaddr(&host->ip_addr, port, &host->addr.sa);
+    host->request.command = htons(command->request);
+    host->version = proto_version;
+  }
+
+  n_active = next_host = 0;
+
+  while (!quit) {
+    if (gettimeofday(&tv, NULL))
+      break;
+    UTI_TimevalToTimespec(&tv, &now);
+
+    /* Start new queries */
+    for (; n_active < MAX_PARALLEL_REQUESTS && next_host < ARR_GetSize(hosts); next_host++) {
+      host = ARR_GetElement(hosts, next_host);
+      if (host->state != HOST_WAITING)
+        continue;
+
+      i = host->ip_addr.family == IPADDR_INET4 ? 0 : 1;
+      if (sock_fds[i] < 0)
+        sock_fds[i] = open_parallel_socket(host->addr.sa.sa_family);
+      if (sock_fds[i] < 0 || !send_parallel_request(host, sock_fds[i], &now)) {
+        host->state = HOST_FAILED;
+        continue;
+      }
+
+      host->state = HOST_SENT;
+      active[n_active++] = host;
+    }
+
+    if (n_active == 0)
+      break;
+
+    /* Resend requests which timed out, using the same timeouts as
+       submit_request() */
+    min_timeout = initial_timeout / 1000.0 * (1U << max_retries);
+
+    for (i = 0; i < n_active; i++) {
+      host = active[i];
+      timeout = initial_timeout / 1000.0 * (1U << (host->n_attempts - 1)) -
+                UTI_DiffTimespecsToDouble(&now, &host->tx_time);
+
+      if (timeout <= 0.0) {
+        if (!send_parallel_request(host, sock_fds[host->ip_addr.family ==
+                                                  IPADDR_INET4 ? 0 : 1], &now)) {
+          host->state = HOST_FAILED;
+          active[i--] = active[--n_active];
+          continue;
+        }
+        timeout = initial_timeout / 1000.0 * (1U << (host->n_attempts - 1));
+      }
+
+      if (timeout < min_timeout)
+        min_timeout = timeout;
+    }
+
+    if (n_active == 0)
+      continue;
+
+    FD_ZERO(&rdfd);
+    for (i = max_fd = 0; i < 2; i++) {
+      if (sock_fds[i] < 0)
+        continue;
+      FD_SET(sock_fds[i], &rdfd);
+      max_fd = MAX(max_fd, sock_fds[i]);
+    }
+
+    UTI_DoubleToTimeval(min_timeout, &tv);
+
+    if (select(max_fd + 1, &rdfd, NULL, NULL, &tv) < 0) {
+      DEBUG_LOG("select failed : %s", strerror(errno));
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    for (i = 0; i < 2; i++) {
+      if (sock_fds[i] < 0 || !FD_ISSET(sock_fds[i], &rdfd))
+        continue;
+
+      /* Receive all queued replies */
+      while (1) {
+        addr_len = sizeof (addr);
+        length = recvfrom(sock_fds[i], (void *)&reply, sizeof (reply), 0, &addr.sa, &addr_len);
+        if (length < 0)
+          break;
+
+        host = find_parallel_host(active, n_active, &reply, &addr);
+        if (!host || !check_reply(&host->request, &reply, length, host->version))
+          continue;
+
+        /* Switch to the older protocol version if the host needs it */
+        if (host->version == PROTO_VERSION_NUMBER &&
+            reply.version == PROTO_VERSION_NUMBER - 1) {
+          host->version = PROTO_VERSION_NUMBER - 1;
+          host->n_attempts--;
+          send_parallel_request(host, sock_fds[i], &now);
+          continue;
+        }
+
+        host->reply = reply;
+        host->state = HOST_REPLIED;
+      }
+    }
+
+    /* Remove hosts which replied */
+    for (i = 0; i < n_active; i++) {
+      if (active[i]->state == HOST_REPLIED)
+        active[i--] = active[--n_active];
+    }
+  }
+
+  for (i = 0; i < 2; i++) {
+    if (sock_fds[i] >= 0)
+      close(sock_fds[i]);
+  }
+
+  /* Print the results in the order of the list */
+  for (i = 0, ret = 1; i < ARR_GetSize(hosts); i++) {
+    host = ARR_GetElement(hosts, i);
+    printf("%s,", host->name);
+
+    status = ntohs(host->reply.status);
+
+    if (host->state == HOST_INVALID) {
+      printf("Invalid address\n");
+      ret = 0;
+    } else if (host->state != HOST_REPLIED) {
+      printf("506 Cannot talk to daemon\n");
+      ret = 0;
+    } else if (status != STT_SUCCESS) {
+      printf("%s\n", get_status_message(status));
+      ret = 0;
+    } else if (ntohs(host->reply.reply) != command->reply) {
+      printf("508 Bad reply from daemon\n");
+      ret = 0;
+    } else {
+      command->print(&host->reply);
+    }
+
+    Free(host->name);
+  }
+
+  ARR_DestroyInstance(hosts);
+
+  return ret && !quit;
+}
+
 /* ================================================== */
 
 static int
@@ -3112,7 +4203,7 @@ display_gpl(void)
 static void
 print_help(const char *progname)
 {
-      printf("Usage: %s [-h HOST] [-p PORT] [-n] [-c] [-d] [-4|-6] [-m] [COMMAND]\n",
+      printf("Usage: %s [-h HOST|-H FILE] [-p PORT] [-n] [-c] [-d] [-4|-6] [-m] [COMMAND]\n",
              progname);
 }
 
@@ -3131,7 +4222,7 @@ main(int argc, char **argv)
 {
   char *line;
   const char *progname = argv[0];
-  const char *hostnames = NULL;
+  const char *hostnames = NULL, *host_file = NULL;
   int opt, ret = 1, multi = 0, family = IPADDR_UNSPEC;
   int port = DEFAULT_CANDM_PORT;
 
@@ -3149,7 +4240,7 @@ main(int argc, char **argv)
   optind = 1;
 
   /* Parse short command-line options */
-  while ((opt = getopt(argc, argv, "+46acdf:h:mnp:v")) != -1) {
+  while ((opt = getopt(argc, argv, "+46acdf:h:H:mnp:v")) != -1) {
     switch (opt) {
       case '4':
       case '6':
@@ -3168,6 +4259,9 @@ main(int argc, char **argv)
       case 'h':
         hostnames = optarg;
         break;
+      case 'H':
+        host_file = optarg;
+        break;
       case 'm':
         multi = 1;
         break;
@@ -3202,6 +4296,13 @@ main(int argc, char **argv)
 
   UTI_SetQuitSignalsHandler(signal_handler);
 
+  /* Send the command to all hosts in the list in parallel */
+  if (host_file) {
+    if (optind + 1 != argc)
+      LOG_FATAL("Host list requires one command");
+    return !process_parallel_cmd(host_file, port, argv[optind]);
+  }
+
   sockaddrs = get_sockaddrs(hostnames, port);
 
   if (!open_io())
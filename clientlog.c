@@ -45,7 +45,6 @@
 #include "logging.h"
 
 typedef struct {
-  IPAddr ip_addr;
   uint32_t last_ntp_hit;
   uint32_t last_cmd_hit;
   uint32_t ntp_hits;
@@ -58,12 +57,39 @@ typedef struct {
   int8_t cmd_rate;
   int8_t ntp_timeout_rate;
   uint8_t flags;
-  NTP_int64 ntp_rx_ts;
-  NTP_int64 ntp_tx_ts;
 } Record;
 
-/* Hash table of records, there is a fixed number of records per slot */
-static ARR_Instance records;
+/* Records are kept in separate pools for IPv4 and IPv6 clients, which
+   allows IPv4 records to not waste memory on space for IPv6 addresses.
+   The address follows the common part of the record. */
+
+typedef struct {
+  Record record;
+  uint32_t ip4;
+} Record4;
+
+typedef struct {
+  Record record;
+  uint8_t ip6[16];
+} Record6;
+
+/* Pool of records of one address family.  Each pool has its own hash table
+   with a fixed number of records per slot. */
+typedef struct {
+  ARR_Instance records;
+  int family;
+  unsigned int record_size;
+  /* Number of slots in the hash table */
+  unsigned int slots;
+  /* Number of used records */
+  unsigned int used;
+} RecordPool;
+
+#define POOL_IPV4 0
+#define POOL_IPV6 1
+#define N_POOLS 2
+
+static RecordPool pools[N_POOLS];
 
 #define SLOT_BITS 4
 
@@ -76,11 +102,8 @@ static ARR_Instance records;
 /* Maximum number of slots, this is a hard limit */
 #define MAX_SLOTS (1U << (24 - SLOT_BITS))
 
-/* Number of slots in the hash table */
-static unsigned int slots;
-
-/* Maximum number of slots given memory allocation limit */
-static unsigned int max_slots;
+/* Memory allocation limit shared by the hash tables of both pools */
+static size_t max_records_memory;
 
 /* Times of last hits are saved as 32-bit fixed point values */
 #define TS_FRAC 4
@@ -128,9 +151,37 @@ static int cmd_leak_rate;
 /* Flag indicating whether the last response was dropped */
 #define FLAG_NTP_DROPPED 0x1
 
+/* Flag indicating whether the record is used */
+#define FLAG_USED 0x2
+
 /* NTP limit interval in log2 */
 static int ntp_limit_interval;
 
+/* Table of transmit timestamps for the server interleaved mode.  The
+   entries are keyed by the client address and the receive timestamp of
+   the request, which the client returns in the origin timestamp of its next
+   request.  The table is separate from the records, so responses can be
+   interleaved even when records of clients are dropped.  A bucket fills one
+   cache line and the oldest entry in the bucket is replaced on collision. */
+
+#define TS_BUCKET_ENTRIES 3
+#define TS_BUCKET_ALIGNMENT 64
+
+typedef struct {
+  NTP_int64 rx_ts[TS_BUCKET_ENTRIES];
+  NTP_int64 tx_ts[TS_BUCKET_ENTRIES];
+  uint32_t addr_hash[TS_BUCKET_ENTRIES];
+  uint32_t pad;
+} TimestampBucket;
+
+/* Minimum and maximum number of buckets (in log2) */
+#define MIN_TS_BUCKETS_BITS 4
+#define MAX_TS_BUCKETS_BITS 20
+
+static TimestampBucket *ts_buckets;
+static void *ts_buckets_memory;
+static int ts_buckets_bits;
+
 /* Flag indicating whether facility is turned on or not */
 static int active;
 
@@ -140,12 +191,15 @@ static uint32_t total_cmd_hits;
 static uint32_t total_ntp_drops;
 static uint32_t total_cmd_drops;
 static uint32_t total_record_drops;
+static uint32_t total_interleaved_hits;
+static uint32_t total_interleaved_misses;
+static uint32_t total_timestamps;
 
 #define NSEC_PER_SEC 1000000000U
 
 /* ================================================== */
 
-static int expand_hashtable(void);
+static int expand_hashtable(RecordPool *pool);
 
 /* ================================================== */
 
@@ -161,29 +215,93 @@ compare_ts(uint32_t x, uint32_t y)
 
 /* ================================================== */
 
+static RecordPool *
+get_pool(int family)
+{
+  switch (family) {
+    case IPADDR_INET4:
+      return &pools[POOL_IPV4];
+    case IPADDR_INET6:
+      return &pools[POOL_IPV6];
+    default:
+      return NULL;
+  }
+}
+
+/* ================================================== */
+
+static Record *
+get_pool_record(RecordPool *pool, unsigned int index)
+{
+  return ARR_GetElement(pool->records, index);
+}
+
+/* ================================================== */
+
+static int
+compare_address(RecordPool *pool, Record *record, IPAddr *ip)
+{
+  if (pool->family == IPADDR_INET4)
+    return ((Record4 *)record)->ip4 == ip->addr.in4;
+  else
+    return !memcmp(((Record6 *)record)->ip6, ip->addr.in6, sizeof (ip->addr.in6));
+}
+
+/* ================================================== */
+
+static void
+set_address(RecordPool *pool, Record *record, IPAddr *ip)
+{
+  if (pool->family == IPADDR_INET4)
+    ((Record4 *)record)->ip4 = ip->addr.in4;
+  else
+    memcpy(((Record6 *)record)->ip6, ip->addr.in6, sizeof (ip->addr.in6));
+}
+
+/* ================================================== */
+
+static void
+get_address(RecordPool *pool, Record *record, IPAddr *ip)
+{
+  memset(ip, 0, sizeof (*ip));
+  ip->family = pool->family;
+
+  if (pool->family == IPADDR_INET4)
+    ip->addr.in4 = ((Record4 *)record)->ip4;
+  else
+    memcpy(ip->addr.in6, ((Record6 *)record)->ip6, sizeof (ip->addr.in6));
+}
+
+/* ================================================== */
+
 static Record *
 get_record(IPAddr *ip)
 {
   unsigned int first, i;
   time_t last_hit, oldest_hit = 0;
   Record *record, *oldest_record;
+  RecordPool *pool;
 
-  if (!active || (ip->family != IPADDR_INET4 && ip->family != IPADDR_INET6))
+  if (!active)
+    return NULL;
+
+  pool = get_pool(ip->family);
+  if (!pool)
     return NULL;
 
   while (1) {
     /* Get index of the first record in the slot */
-    first = UTI_IPToHash(ip) % slots * SLOT_SIZE;
+    first = UTI_IPToHash(ip) % pool->slots * SLOT_SIZE;
 
     for (i = 0, oldest_record = NULL; i < SLOT_SIZE; i++) {
-      record = ARR_GetElement(records, first + i);
-
-      if (!UTI_CompareIPs(ip, &record->ip_addr, NULL))
-        return record;
+      record = get_pool_record(pool, first + i);
 
-      if (record->ip_addr.family == IPADDR_UNSPEC)
+      if (!(record->flags & FLAG_USED))
         break;
 
+      if (compare_address(pool, record, ip))
+        return record;
+
       last_hit = compare_ts(record->last_ntp_hit, record->last_cmd_hit) > 0 ?
                  record->last_ntp_hit : record->last_cmd_hit;
 
@@ -196,12 +314,14 @@ get_record(IPAddr *ip)
     }
 
     /* If the slot still has an empty record, use it */
-    if (record->ip_addr.family == IPADDR_UNSPEC)
+    if (!(record->flags & FLAG_USED)) {
+      pool->used++;
       break;
+    }
 
     /* Resize the table if possible and try again as the new slot may
        have some empty records */
-    if (expand_hashtable())
+    if (expand_hashtable(pool))
       continue;
 
     /* There is no other option, replace the oldest record */
@@ -210,7 +330,7 @@ get_record(IPAddr *ip)
     break;
   }
 
-  record->ip_addr = *ip;
+  set_address(pool, record, ip);
   record->last_ntp_hit = record->last_cmd_hit = INVALID_TS;
   record->ntp_hits = record->cmd_hits = 0;
   record->ntp_drops = record->cmd_drops = 0;
@@ -218,56 +338,84 @@ get_record(IPAddr *ip)
   record->cmd_tokens = max_cmd_tokens;
   record->ntp_rate = record->cmd_rate = INVALID_RATE;
   record->ntp_timeout_rate = INVALID_RATE;
-  record->flags = 0;
-  UTI_ZeroNtp64(&record->ntp_rx_ts);
-  UTI_ZeroNtp64(&record->ntp_tx_ts);
+  record->flags = FLAG_USED;
 
   return record;
 }
 
 /* ================================================== */
 
-static int
-expand_hashtable(void)
+static size_t
+get_table_memory(RecordPool *pool, unsigned int slots)
 {
-  ARR_Instance old_records;
-  Record *old_record, *new_record;
-  unsigned int i;
+  return (size_t)slots * SLOT_SIZE * pool->record_size;
+}
 
-  old_records = records;
+/* ================================================== */
+
+static int
+expand_hashtable(RecordPool *pool)
+{
+  Record *record, *new_record;
+  RecordPool *other_pool;
+  unsigned int i, j, k, n, slots, old_slots, max_slots;
+  size_t memory, other_memory;
+  IPAddr ip;
+
+  /* Find the maximum number of slots that fits in the memory limit with the
+     table of the other pool.  The table is expanded in place, so there are
+     no two copies of the records which would need to fit in the limit. */
+  other_pool = &pools[pool == &pools[POOL_IPV4] ? POOL_IPV6 : POOL_IPV4];
+  other_memory = get_table_memory(other_pool, other_pool->slots);
+  memory = max_records_memory > other_memory ? max_records_memory - other_memory : 0;
+  max_slots = memory / get_table_memory(pool, 1);
+  max_slots = CLAMP(MIN_SLOTS, max_slots, MAX_SLOTS);
 
-  if (2 * slots > max_slots)
+  /* Double the size of the table.  Only doubling ensures that the records
+     of an old slot fit in the new slots without dropping any record. */
+  slots = MAX(MIN_SLOTS, 2 * pool->slots);
+  if (slots > max_slots)
     return 0;
 
-  records = ARR_CreateInstance(sizeof (Record));
+  if (!pool->records)
+    pool->records = ARR_CreateInstance(pool->record_size);
 
-  slots = MAX(MIN_SLOTS, 2 * slots);
-  assert(slots <= max_slots);
+  old_slots = pool->slots;
+  pool->slots = slots;
 
-  ARR_SetSize(records, slots * SLOT_SIZE);
+  ARR_SetSize(pool->records, slots * SLOT_SIZE);
 
   /* Mark all new records as empty */
-  for (i = 0; i < slots * SLOT_SIZE; i++) {
-    new_record = ARR_GetElement(records, i);
-    new_record->ip_addr.family = IPADDR_UNSPEC;
+  for (i = old_slots * SLOT_SIZE; i < slots * SLOT_SIZE; i++) {
+    new_record = get_pool_record(pool, i);
+    new_record->flags = 0;
   }
 
-  if (!old_records)
-    return 1;
+  /* Split the old slots.  A record in slot i either stays in the slot, or
+     moves to slot i + old_slots.  The used records need to be kept at the
+     beginning of the slot. */
+  for (i = 0; i < old_slots; i++) {
+    for (j = k = n = 0; j < SLOT_SIZE; j++) {
+      record = get_pool_record(pool, i * SLOT_SIZE + j);
+      if (!(record->flags & FLAG_USED))
+        break;
 
-  /* Copy old records to the new hash table */
-  for (i = 0; i < ARR_GetSize(old_records); i++) {
-    old_record = ARR_GetElement(old_records, i);
-    if (old_record->ip_addr.family == IPADDR_UNSPEC)
-      continue;
+      get_address(pool, record, &ip);
 
-    new_record = get_record(&old_record->ip_addr);
+      if (UTI_IPToHash(&ip) % slots == i)
+        new_record = get_pool_record(pool, i * SLOT_SIZE + k++);
+      else
+        new_record = get_pool_record(pool, (i + old_slots) * SLOT_SIZE + n++);
 
-    assert(new_record);
-    *new_record = *old_record;
-  }
+      if (new_record != record)
+        memcpy(new_record, record, pool->record_size);
+    }
 
-  ARR_DestroyInstance(old_records);
+    for (; k < j; k++) {
+      record = get_pool_record(pool, i * SLOT_SIZE + k);
+      record->flags = 0;
+    }
+  }
 
   return 1;
 }
@@ -303,8 +451,8 @@ set_bucket_params(int interval, int burst, uint16_t *max_tokens,
 
 /* ================================================== */
 
-void
-CLG_Initialise(void)
+static void
+set_rate_limits(void)
 {
   int interval, burst, leak_rate;
 
@@ -326,6 +474,16 @@ CLG_Initialise(void)
                       &cmd_token_shift);
     cmd_leak_rate = CLAMP(MIN_LEAK_RATE, leak_rate, MAX_LEAK_RATE);
   }
+}
+
+/* ================================================== */
+
+void
+CLG_Initialise(void)
+{
+  int i;
+
+  set_rate_limits();
 
   active = !CNF_GetNoClientLog();
   if (!active) {
@@ -334,16 +492,33 @@ CLG_Initialise(void)
     return;
   }
 
-  /* Calculate the maximum number of slots that can be allocated in the
-     configured memory limit.  Take into account expanding of the hash
-     table where two copies exist at the same time. */
-  max_slots = CNF_GetClientLogLimit() / (sizeof (Record) * SLOT_SIZE * 3 / 2);
-  max_slots = CLAMP(MIN_SLOTS, max_slots, MAX_SLOTS);
+  /* The hash tables of records can use three quarters of the configured
+     memory limit.  The pools are expanded as needed, so the memory is shared
+     according to the numbers of IPv4 and IPv6 clients. */
+  max_records_memory = CNF_GetClientLogLimit() / 4 * 3;
 
-  slots = 0;
-  records = NULL;
+  /* The rest of the limit is used by the table of timestamps */
+  for (ts_buckets_bits = MIN_TS_BUCKETS_BITS; ts_buckets_bits < MAX_TS_BUCKETS_BITS;
+       ts_buckets_bits++) {
+    if (sizeof (TimestampBucket) << (ts_buckets_bits + 1) > CNF_GetClientLogLimit() / 4)
+      break;
+  }
 
-  expand_hashtable();
+  assert(sizeof (TimestampBucket) == TS_BUCKET_ALIGNMENT);
+  ts_buckets_memory = Malloc2((1U << ts_buckets_bits) + 1, sizeof (TimestampBucket));
+  ts_buckets = (TimestampBucket *)(((uintptr_t)ts_buckets_memory + TS_BUCKET_ALIGNMENT - 1) /
+                                   TS_BUCKET_ALIGNMENT * TS_BUCKET_ALIGNMENT);
+  memset(ts_buckets, 0, sizeof (TimestampBucket) << ts_buckets_bits);
+  total_timestamps = 0;
+
+  for (i = 0; i < N_POOLS; i++) {
+    pools[i].records = NULL;
+    pools[i].family = i == POOL_IPV4 ? IPADDR_INET4 : IPADDR_INET6;
+    pools[i].record_size = i == POOL_IPV4 ? sizeof (Record4) : sizeof (Record6);
+    pools[i].slots = 0;
+    pools[i].used = 0;
+    expand_hashtable(&pools[i]);
+  }
 
   UTI_GetRandomBytes(&ts_offset, sizeof (ts_offset));
   ts_offset %= NSEC_PER_SEC / (1U << TS_FRAC);
@@ -351,13 +526,44 @@ CLG_Initialise(void)
 
 /* ================================================== */
 
+void
+CLG_UpdateRateLimits(void)
+{
+  Record *record;
+  unsigned int i, j;
+
+  set_rate_limits();
+
+  if (!active) {
+    if (ntp_leak_rate || cmd_leak_rate)
+      LOG(LOGS_WARN, "ratelimit cannot be used with noclientlog");
+    return;
+  }
+
+  /* The tokens may have a different scale now.  Fill the buckets of all
+     clients as if they were new. */
+  for (i = 0; i < N_POOLS; i++) {
+    for (j = 0; j < ARR_GetSize(pools[i].records); j++) {
+      record = get_pool_record(&pools[i], j);
+      record->ntp_tokens = max_ntp_tokens;
+      record->cmd_tokens = max_cmd_tokens;
+    }
+  }
+}
+
+/* ================================================== */
+
 void
 CLG_Finalise(void)
 {
+  int i;
+
   if (!active)
     return;
 
-  ARR_DestroyInstance(records);
+  for (i = 0; i < N_POOLS; i++)
+    ARR_DestroyInstance(pools[i].records);
+  Free(ts_buckets_memory);
 }
 
 /* ================================================== */
@@ -435,24 +641,44 @@ update_record(struct timespec *now, uint32_t *last_hit, uint32_t *hits,
 
 /* ================================================== */
 
+/* Indices of records in the IPv6 pool follow the indices of the IPv4 pool */
+
 static int
-get_index(Record *record)
+get_index(IPAddr *ip, Record *record)
 {
-  return record - (Record *)ARR_GetElements(records);
+  RecordPool *pool;
+  int index, i;
+
+  pool = get_pool(ip->family);
+  assert(pool);
+
+  index = ((char *)record - (char *)ARR_GetElements(pool->records)) / pool->record_size;
+
+  for (i = 0; &pools[i] != pool; i++)
+    index += ARR_GetSize(pools[i].records);
+
+  return index;
 }
 
 /* ================================================== */
 
-int
-CLG_GetClientIndex(IPAddr *client)
+static Record *
+get_record_by_index(int index, RecordPool **pool)
 {
-  Record *record;
+  int i;
 
-  record = get_record(client);
-  if (record == NULL)
-    return -1;
+  if (!active || index < 0)
+    return NULL;
 
-  return get_index(record);
+  for (i = 0; i < N_POOLS; i++) {
+    if (index < ARR_GetSize(pools[i].records)) {
+      *pool = &pools[i];
+      return get_pool_record(&pools[i], index);
+    }
+    index -= ARR_GetSize(pools[i].records);
+  }
+
+  return NULL;
 }
 
 /* ================================================== */
@@ -479,7 +705,7 @@ CLG_LogNTPAccess(IPAddr *client, struct timespec *now)
             record->ntp_hits, record->ntp_rate, record->ntp_timeout_rate,
             record->ntp_tokens);
 
-  return get_index(record);
+  return get_index(client, record);
 }
 
 /* ================================================== */
@@ -502,7 +728,7 @@ CLG_LogCommandAccess(IPAddr *client, struct timespec *now)
   DEBUG_LOG("Cmd hits %"PRIu32" rate %d tokens %d",
             record->cmd_hits, record->cmd_rate, record->cmd_tokens);
 
-  return get_index(record);
+  return get_index(client, record);
 }
 
 /* ================================================== */
@@ -532,13 +758,15 @@ limit_response_random(int leak_rate)
 int
 CLG_LimitNTPResponseRate(int index)
 {
+  RecordPool *pool;
   Record *record;
   int drop;
 
   if (!ntp_tokens_per_packet)
     return 0;
 
-  record = ARR_GetElement(records, index);
+  record = get_record_by_index(index, &pool);
+  assert(record);
   record->flags &= ~FLAG_NTP_DROPPED;
 
   if (record->ntp_tokens >= ntp_tokens_per_packet) {
@@ -574,12 +802,14 @@ CLG_LimitNTPResponseRate(int index)
 int
 CLG_LimitCommandResponseRate(int index)
 {
+  RecordPool *pool;
   Record *record;
 
   if (!cmd_tokens_per_packet)
     return 0;
 
-  record = ARR_GetElement(records, index);
+  record = get_record_by_index(index, &pool);
+  assert(record);
 
   if (record->cmd_tokens >= cmd_tokens_per_packet) {
     record->cmd_tokens -= cmd_tokens_per_packet;
@@ -599,14 +829,111 @@ CLG_LimitCommandResponseRate(int index)
 
 /* ================================================== */
 
-void CLG_GetNtpTimestamps(int index, NTP_int64 **rx_ts, NTP_int64 **tx_ts)
+static TimestampBucket *
+get_ts_bucket(uint32_t addr_hash, NTP_int64 *rx_ts)
 {
-  Record *record;
+  uint32_t hash;
 
-  record = ARR_GetElement(records, index);
+  hash = (addr_hash ^ ntohl(rx_ts->hi) ^ ntohl(rx_ts->lo)) * 2654435761U;
 
-  *rx_ts = &record->ntp_rx_ts;
-  *tx_ts = &record->ntp_tx_ts;
+  return &ts_buckets[hash >> (32 - ts_buckets_bits)];
+}
+
+/* ================================================== */
+
+static NTP_int64 *
+find_tx_timestamp(IPAddr *client, NTP_int64 *rx_ts)
+{
+  TimestampBucket *bucket;
+  uint32_t addr_hash;
+  int i;
+
+  if (!active || UTI_IsZeroNtp64(rx_ts))
+    return NULL;
+
+  addr_hash = UTI_IPToHash(client);
+  bucket = get_ts_bucket(addr_hash, rx_ts);
+
+  for (i = 0; i < TS_BUCKET_ENTRIES; i++) {
+    if (bucket->addr_hash[i] == addr_hash && !UTI_CompareNtp64(&bucket->rx_ts[i], rx_ts))
+      return &bucket->tx_ts[i];
+  }
+
+  return NULL;
+}
+
+/* ================================================== */
+
+void
+CLG_SaveNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts, NTP_int64 *tx_ts)
+{
+  TimestampBucket *bucket;
+  uint32_t addr_hash;
+  int i, oldest;
+
+  if (!active || UTI_IsZeroNtp64(rx_ts))
+    return;
+
+  addr_hash = UTI_IPToHash(client);
+  bucket = get_ts_bucket(addr_hash, rx_ts);
+
+  /* Use an empty entry, or replace the oldest entry.  Prefer entries
+     without a transmit timestamp, which are saved for all clients, to keep
+     the entries of clients using the interleaved mode. */
+  for (i = oldest = 0; i < TS_BUCKET_ENTRIES; i++) {
+    if (UTI_IsZeroNtp64(&bucket->rx_ts[i])) {
+      oldest = i;
+      total_timestamps++;
+      break;
+    }
+    if (UTI_IsZeroNtp64(&bucket->tx_ts[i]) != UTI_IsZeroNtp64(&bucket->tx_ts[oldest])) {
+      if (UTI_IsZeroNtp64(&bucket->tx_ts[i]))
+        oldest = i;
+    } else if (UTI_CompareNtp64(&bucket->rx_ts[i], &bucket->rx_ts[oldest]) < 0) {
+      oldest = i;
+    }
+  }
+
+  bucket->rx_ts[oldest] = *rx_ts;
+  bucket->tx_ts[oldest] = *tx_ts;
+  bucket->addr_hash[oldest] = addr_hash;
+}
+
+/* ================================================== */
+
+NTP_int64 *
+CLG_GetNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts)
+{
+  return find_tx_timestamp(client, rx_ts);
+}
+
+/* ================================================== */
+
+int
+CLG_GetNtpInterleavedTimestamp(IPAddr *client, NTP_int64 *origin_ts, NTP_int64 *tx_ts)
+{
+  NTP_int64 *ts;
+
+  if (!active)
+    return 0;
+
+  /* Clients in the basic mode are not expected to have their origin
+     timestamp in the table */
+  ts = find_tx_timestamp(client, origin_ts);
+  if (!ts)
+    return 0;
+
+  /* The origin timestamp is a receive timestamp of a previous response,
+     i.e. the client is using the interleaved mode, but the transmit
+     timestamp is missing if that response was not in the interleaved mode */
+  if (!UTI_IsZeroNtp64(ts))
+    total_interleaved_hits++;
+  else
+    total_interleaved_misses++;
+
+  *tx_ts = *ts;
+
+  return 1;
 }
 
 /* ================================================== */
@@ -625,7 +952,7 @@ CLG_GetNumberOfIndices(void)
   if (!active)
     return -1;
 
-  return ARR_GetSize(records);
+  return ARR_GetSize(pools[POOL_IPV4].records) + ARR_GetSize(pools[POOL_IPV6].records);
 }
 
 /* ================================================== */
@@ -655,20 +982,17 @@ static uint32_t get_last_ago(uint32_t x, uint32_t y)
 int
 CLG_GetClientAccessReportByIndex(int index, RPT_ClientAccessByIndex_Report *report, struct timespec *now)
 {
+  RecordPool *pool;
   Record *record;
   uint32_t now_ts;
 
-  if (!active || index < 0 || index >= ARR_GetSize(records))
-    return 0;
-
-  record = ARR_GetElement(records, index);
-
-  if (record->ip_addr.family == IPADDR_UNSPEC)
+  record = get_record_by_index(index, &pool);
+  if (!record || !(record->flags & FLAG_USED))
     return 0;
 
   now_ts = get_ts_from_timespec(now);
 
-  report->ip_addr = record->ip_addr;
+  get_address(pool, record, &report->ip_addr);
   report->ntp_hits = record->ntp_hits;
   report->cmd_hits = record->cmd_hits;
   report->ntp_drops = record->ntp_drops;
@@ -692,4 +1016,11 @@ CLG_GetServerStatsReport(RPT_ServerStatsReport *report)
   report->ntp_drops = total_ntp_drops;
   report->cmd_drops = total_cmd_drops;
   report->log_drops = total_record_drops;
+  report->ntp_interleaved_hits = total_interleaved_hits;
+  report->ntp_interleaved_misses = total_interleaved_misses;
+  report->ntp_timestamps = total_timestamps;
+  report->log_records_ipv4 = active ? pools[POOL_IPV4].used : 0;
+  report->log_records_ipv4_size = active ? ARR_GetSize(pools[POOL_IPV4].records) : 0;
+  report->log_records_ipv6 = active ? pools[POOL_IPV6].used : 0;
+  report->log_records_ipv6_size = active ? ARR_GetSize(pools[POOL_IPV6].records) : 0;
 }
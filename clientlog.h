@@ -33,12 +33,15 @@
 
 extern void CLG_Initialise(void);
 extern void CLG_Finalise(void);
-extern int CLG_GetClientIndex(IPAddr *client);
+extern void CLG_UpdateRateLimits(void);
 extern int CLG_LogNTPAccess(IPAddr *client, struct timespec *now);
 extern int CLG_LogCommandAccess(IPAddr *client, struct timespec *now);
 extern int CLG_LimitNTPResponseRate(int index);
 extern int CLG_LimitCommandResponseRate(int index);
-extern void CLG_GetNtpTimestamps(int index, NTP_int64 **rx_ts, NTP_int64 **tx_ts);
+extern void CLG_SaveNtpTimestamps(IPAddr *client, NTP_int64 *rx_ts, NTP_int64 *tx_ts);
+extern NTP_int64 *CLG_GetNtpTxTimestamp(IPAddr *client, NTP_int64 *rx_ts);
+extern int CLG_GetNtpInterleavedTimestamp(IPAddr *client, NTP_int64 *origin_ts,
+                                          NTP_int64 *tx_ts);
 extern int CLG_GetNtpMinPoll(void);
 
 /* And some reporting functions, for use by chronyc. */
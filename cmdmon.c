@@ -37,6 +37,8 @@
 #include "keys.h"
 #include "ntp_sources.h"
 #include "ntp_core.h"
+#include "ntp_io.h"
+#include "ntp_signd.h"
 #include "smooth.h"
 #include "sources.h"
 #include "sourcestats.h"
@@ -50,6 +52,7 @@
 #include "pktlength.h"
 #include "clientlog.h"
 #include "refclock.h"
+#include "sys.h"
 
 /* ================================================== */
 
@@ -138,6 +141,20 @@ static const char permissions[] = {
   PERMIT_AUTH, /* ADD_PEER2 */
   PERMIT_AUTH, /* ADD_SERVER3 */
   PERMIT_AUTH, /* ADD_PEER3 */
+  PERMIT_AUTH, /* RELOAD_ACCESS */
+  PERMIT_AUTH, /* SOURCE_RECORDS */
+  PERMIT_AUTH, /* SUBSCRIBE */
+  PERMIT_AUTH, /* SCHED_STATS */
+  PERMIT_AUTH, /* HWCLOCK_STATS */
+  PERMIT_AUTH, /* SYS_STATS */
+  PERMIT_AUTH, /* SLOT_STATS */
+  PERMIT_AUTH, /* MONITOR_DATA */
+  PERMIT_AUTH, /* DEL_SOURCES */
+  PERMIT_AUTH, /* RELOAD_CONFIG */
+  PERMIT_AUTH, /* STARTUP_STATS */
+  PERMIT_AUTH, /* KEY_STATS */
+  PERMIT_AUTH, /* SIGND_STATS */
+  PERMIT_AUTH, /* SERVER_STATS2 */
 };
 
 /* ================================================== */
@@ -146,9 +163,42 @@ static const char permissions[] = {
    machines are allowed to make command and monitoring requests. */
 static ADF_AuthTable access_auth_table;
 
+/* Table used until the new table is committed by CAM_EndAccessRestrictions() */
+static ADF_AuthTable saved_access_auth_table;
+
+/* Report of the daemon initialisation */
+static RPT_StartupReport startup_report;
+
+/* ================================================== */
+/* Clients subscribed to events over the Unix domain socket */
+
+#define MAX_SUBSCRIBERS 8
+
+/* Limits for the interval of server statistics records (in seconds) */
+#define MIN_STATS_INTERVAL 1
+#define MAX_STATS_INTERVAL 3600
+
+typedef struct {
+  struct sockaddr_un addr;
+  uint32_t events;
+  uint32_t request_sequence;
+  uint32_t event_sequence;
+  uint32_t dropped;
+  int stats_interval;
+  SCH_TimeoutID stats_timeout;
+  RPT_ServerStatsReport last_stats;
+} Subscriber;
+
+static Subscriber subscribers[MAX_SUBSCRIBERS];
+static int n_subscribers;
+
+/* Union of events of all subscribers */
+static uint32_t subscribed_events;
+
 /* ================================================== */
 /* Forward prototypes */
 static void read_from_cmd_socket(int sock_fd, int event, void *anything);
+static void handle_stats_timeout(void *arg);
 
 /* ================================================== */
 
@@ -254,6 +304,223 @@ prepare_socket(int family, int port_number)
 
 /* ================================================== */
 
+static void
+update_subscribed_events(void)
+{
+  int i;
+
+  for (i = 0, subscribed_events = 0; i < n_subscribers; i++)
+    subscribed_events |= subscribers[i].events;
+}
+
+/* ================================================== */
+
+static void
+remove_subscriber(int index)
+{
+  Subscriber *sub = &subscribers[index];
+
+  DEBUG_LOG("Removing subscriber %s", sub->addr.sun_path);
+
+  SCH_RemoveTimeout(sub->stats_timeout);
+
+  /* Keep the array compact, the order of subscribers doesn't matter */
+  *sub = subscribers[--n_subscribers];
+
+  /* Restart the timeout of the moved subscriber with the new address */
+  if (index < n_subscribers && sub->stats_timeout) {
+    SCH_RemoveTimeout(sub->stats_timeout);
+    sub->stats_timeout = SCH_AddTimeoutByDelay(sub->stats_interval,
+                                               handle_stats_timeout, sub);
+  }
+
+  update_subscribed_events();
+}
+
+/* ================================================== */
+
+static void
+init_event(CMD_Reply *msg, int type)
+{
+  memset(msg, 0, offsetof(CMD_Reply, data) + sizeof (msg->data.event));
+  msg->version = PROTO_VERSION_NUMBER;
+  msg->pkt_type = PKT_TYPE_CMD_REPLY;
+  msg->command = htons(REQ_SUBSCRIBE);
+  msg->reply = htons(RPY_EVENT);
+  msg->status = htons(STT_SUCCESS);
+  msg->data.event.type = htons(type);
+}
+
+/* ================================================== */
+
+/* Push an event to a subscriber without blocking.  If the socket buffer of
+   the client is full, the record is dropped and the drop is reported in the
+   next record.  Return 0 if the subscriber was removed. */
+
+static int
+push_event(int index, CMD_Reply *msg)
+{
+  Subscriber *sub = &subscribers[index];
+  int status;
+
+  msg->sequence = sub->request_sequence;
+  msg->data.event.sequence = htonl(sub->event_sequence++);
+  msg->data.event.dropped = htonl(sub->dropped);
+
+  status = sendto(sock_fdu, (void *)msg, PKL_ReplyLength(msg), MSG_DONTWAIT,
+                  (struct sockaddr *)&sub->addr, sizeof (sub->addr));
+
+  if (status >= 0) {
+    sub->dropped = 0;
+    return 1;
+  }
+
+  if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+    sub->dropped++;
+    return 1;
+  }
+
+  /* The client is gone */
+  DEBUG_LOG("Could not push event to %s : %s", sub->addr.sun_path, strerror(errno));
+  remove_subscriber(index);
+  return 0;
+}
+
+/* ================================================== */
+
+static void
+push_event_to_all(uint32_t event, CMD_Reply *msg)
+{
+  int i;
+
+  /* Iterate backwards as push_event() may remove the subscriber */
+  for (i = n_subscribers - 1; i >= 0; i--) {
+    if (subscribers[i].events & event)
+      push_event(i, msg);
+  }
+}
+
+/* ================================================== */
+
+static void
+handle_reference_update(void)
+{
+  RPT_TrackingReport rpt;
+  CMD_Reply msg;
+
+  if (!(subscribed_events & REQ_SUBSCRIBE_TRACKING))
+    return;
+
+  REF_GetTrackingReport(&rpt);
+
+  init_event(&msg, RPY_EVT_TRACKING);
+  msg.data.event.data.tracking.ref_id = htonl(rpt.ref_id);
+  UTI_IPHostToNetwork(&rpt.ip_addr, &msg.data.event.data.tracking.ip_addr);
+  msg.data.event.data.tracking.stratum = htons(rpt.stratum);
+  msg.data.event.data.tracking.leap_status = htons(rpt.leap_status);
+  UTI_TimespecHostToNetwork(&rpt.ref_time, &msg.data.event.data.tracking.ref_time);
+  msg.data.event.data.tracking.last_offset = UTI_FloatHostToNetwork(rpt.last_offset);
+  msg.data.event.data.tracking.rms_offset = UTI_FloatHostToNetwork(rpt.rms_offset);
+  msg.data.event.data.tracking.freq_ppm = UTI_FloatHostToNetwork(rpt.freq_ppm);
+  msg.data.event.data.tracking.resid_freq_ppm = UTI_FloatHostToNetwork(rpt.resid_freq_ppm);
+  msg.data.event.data.tracking.skew_ppm = UTI_FloatHostToNetwork(rpt.skew_ppm);
+  msg.data.event.data.tracking.root_delay = UTI_FloatHostToNetwork(rpt.root_delay);
+  msg.data.event.data.tracking.root_dispersion = UTI_FloatHostToNetwork(rpt.root_dispersion);
+
+  push_event_to_all(REQ_SUBSCRIBE_TRACKING, &msg);
+}
+
+/* ================================================== */
+
+static void
+handle_sample(uint32_t ref_id, IPAddr *ip_addr, struct timespec *sample_time,
+              double offset, double peer_delay, double peer_dispersion, int stratum)
+{
+  IPAddr no_addr;
+  CMD_Reply msg;
+
+  if (!(subscribed_events & REQ_SUBSCRIBE_MEASUREMENTS))
+    return;
+
+  if (!ip_addr) {
+    no_addr.family = IPADDR_UNSPEC;
+    ip_addr = &no_addr;
+  }
+
+  init_event(&msg, RPY_EVT_MEASUREMENT);
+  msg.data.event.data.measurement.ref_id = htonl(ref_id);
+  UTI_IPHostToNetwork(ip_addr, &msg.data.event.data.measurement.ip_addr);
+  msg.data.event.data.measurement.stratum = htons(stratum);
+  UTI_TimespecHostToNetwork(sample_time, &msg.data.event.data.measurement.sample_time);
+  msg.data.event.data.measurement.offset = UTI_FloatHostToNetwork(offset);
+  msg.data.event.data.measurement.peer_delay = UTI_FloatHostToNetwork(peer_delay);
+  msg.data.event.data.measurement.peer_dispersion = UTI_FloatHostToNetwork(peer_dispersion);
+
+  push_event_to_all(REQ_SUBSCRIBE_MEASUREMENTS, &msg);
+}
+
+/* ================================================== */
+
+static void
+handle_selection(uint32_t ref_id, IPAddr *ip_addr)
+{
+  IPAddr no_addr;
+  CMD_Reply msg;
+
+  if (!(subscribed_events & REQ_SUBSCRIBE_SELECTION))
+    return;
+
+  if (!ip_addr) {
+    no_addr.family = IPADDR_UNSPEC;
+    ip_addr = &no_addr;
+  }
+
+  init_event(&msg, RPY_EVT_SELECTION);
+  msg.data.event.data.selection.ref_id = htonl(ref_id);
+  UTI_IPHostToNetwork(ip_addr, &msg.data.event.data.selection.ip_addr);
+
+  push_event_to_all(REQ_SUBSCRIBE_SELECTION, &msg);
+}
+
+/* ================================================== */
+
+static void
+handle_stats_timeout(void *arg)
+{
+  RPT_ServerStatsReport report, *last;
+  Subscriber *sub;
+  CMD_Reply msg;
+  int index;
+
+  index = (Subscriber *)arg - subscribers;
+  assert(index >= 0 && index < n_subscribers);
+  sub = &subscribers[index];
+  sub->stats_timeout = 0;
+
+  CLG_GetServerStatsReport(&report);
+  last = &sub->last_stats;
+
+  /* Push only non-zero deltas */
+  if (report.ntp_hits != last->ntp_hits || report.cmd_hits != last->cmd_hits ||
+      report.ntp_drops != last->ntp_drops || report.cmd_drops != last->cmd_drops ||
+      report.log_drops != last->log_drops) {
+    init_event(&msg, RPY_EVT_SERVERSTATS);
+    msg.data.event.data.server_stats.ntp_hits = htonl(report.ntp_hits - last->ntp_hits);
+    msg.data.event.data.server_stats.cmd_hits = htonl(report.cmd_hits - last->cmd_hits);
+    msg.data.event.data.server_stats.ntp_drops = htonl(report.ntp_drops - last->ntp_drops);
+    msg.data.event.data.server_stats.cmd_drops = htonl(report.cmd_drops - last->cmd_drops);
+    msg.data.event.data.server_stats.log_drops = htonl(report.log_drops - last->log_drops);
+    *last = report;
+
+    if (!push_event(index, &msg))
+      return;
+  }
+
+  sub->stats_timeout = SCH_AddTimeoutByDelay(sub->stats_interval, handle_stats_timeout, sub);
+}
+
+/* ================================================== */
+
 static void
 do_size_checks(void)
 {
@@ -279,6 +546,7 @@ do_size_checks(void)
     reply.reply = htons(i);
     reply.status = STT_SUCCESS;
     reply.data.manual_list.n_samples = htonl(MAX_MANUAL_LIST_SAMPLES);
+    reply.data.source_records.n_records = htonl(MAX_SOURCE_RECORDS);
     reply_length = PKL_ReplyLength(&reply);
     if ((reply_length && reply_length < offsetof(CMD_Reply, data)) ||
         reply_length > sizeof (CMD_Reply))
@@ -321,7 +589,13 @@ CAM_Initialise(int family)
   }
 
   access_auth_table = ADF_CreateTable();
+  saved_access_auth_table = NULL;
 
+  n_subscribers = 0;
+  subscribed_events = 0;
+  REF_SetUpdateHandler(handle_reference_update);
+  SRC_SetSampleHandler(handle_sample);
+  SRC_SetSelectionHandler(handle_selection);
 }
 
 /* ================================================== */
@@ -335,6 +609,13 @@ CAM_Finalise(void)
     unlink(CNF_GetBindCommandPath());
   }
   sock_fdu = -1;
+
+  while (n_subscribers > 0)
+    remove_subscriber(n_subscribers - 1);
+  REF_SetUpdateHandler(NULL);
+  SRC_SetSampleHandler(NULL);
+  SRC_SetSelectionHandler(NULL);
+
   if (sock_fd4 >= 0) {
     SCH_RemoveFileHandler(sock_fd4);
     close(sock_fd4);
@@ -348,6 +629,9 @@ CAM_Finalise(void)
   sock_fd6 = -1;
 #endif
 
+  if (saved_access_auth_table)
+    CAM_EndAccessRestrictions(0);
+
   ADF_DestroyTable(access_auth_table);
 
   initialised = 0;
@@ -634,6 +918,77 @@ handle_n_sources(CMD_Request *rx_message, CMD_Reply *tx_message)
 
 /* ================================================== */
 
+static int
+get_source_report(int index, RPT_SourceReport *report, struct timespec *now)
+{
+  if (!SRC_ReportSource(index, report, now))
+    return 0;
+
+  switch (SRC_GetType(index)) {
+    case SRC_NTP:
+      NSR_ReportSource(report, now);
+      break;
+    case SRC_REFCLOCK:
+      RCL_ReportSource(report, now);
+      break;
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static uint16_t
+convert_source_state(RPT_SourceReport *report)
+{
+  switch (report->state) {
+    case RPT_SYNC:
+      return htons(RPY_SD_ST_SYNC);
+    case RPT_UNREACH:
+      return htons(RPY_SD_ST_UNREACH);
+    case RPT_FALSETICKER:
+      return htons(RPY_SD_ST_FALSETICKER);
+    case RPT_JITTERY:
+      return htons(RPY_SD_ST_JITTERY);
+    case RPT_CANDIDATE:
+      return htons(RPY_SD_ST_CANDIDATE);
+    case RPT_OUTLIER:
+      return htons(RPY_SD_ST_OUTLIER);
+    default:
+      return 0;
+  }
+}
+
+/* ================================================== */
+
+static uint16_t
+convert_source_mode(RPT_SourceReport *report)
+{
+  switch (report->mode) {
+    case RPT_NTP_CLIENT:
+      return htons(RPY_SD_MD_CLIENT);
+    case RPT_NTP_PEER:
+      return htons(RPY_SD_MD_PEER);
+    case RPT_LOCAL_REFERENCE:
+      return htons(RPY_SD_MD_REF);
+    default:
+      return 0;
+  }
+}
+
+/* ================================================== */
+
+static uint16_t
+convert_source_flags(RPT_SourceReport *report)
+{
+  return htons((report->sel_options & SRC_SELECT_PREFER ? RPY_SD_FLAG_PREFER : 0) |
+               (report->sel_options & SRC_SELECT_NOSELECT ? RPY_SD_FLAG_NOSELECT : 0) |
+               (report->sel_options & SRC_SELECT_TRUST ? RPY_SD_FLAG_TRUST : 0) |
+               (report->sel_options & SRC_SELECT_REQUIRE ? RPY_SD_FLAG_REQUIRE : 0));
+}
+
+/* ================================================== */
+
 static void
 handle_source_data(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
@@ -642,57 +997,15 @@ handle_source_data(CMD_Request *rx_message, CMD_Reply *tx_message)
 
   /* Get data */
   SCH_GetLastEventTime(&now_corr, NULL, NULL);
-  if (SRC_ReportSource(ntohl(rx_message->data.source_data.index), &report, &now_corr)) {
-    switch (SRC_GetType(ntohl(rx_message->data.source_data.index))) {
-      case SRC_NTP:
-        NSR_ReportSource(&report, &now_corr);
-        break;
-      case SRC_REFCLOCK:
-        RCL_ReportSource(&report, &now_corr);
-        break;
-    }
-    
+  if (get_source_report(ntohl(rx_message->data.source_data.index), &report, &now_corr)) {
     tx_message->reply  = htons(RPY_SOURCE_DATA);
     
     UTI_IPHostToNetwork(&report.ip_addr, &tx_message->data.source_data.ip_addr);
     tx_message->data.source_data.stratum = htons(report.stratum);
     tx_message->data.source_data.poll    = htons(report.poll);
-    switch (report.state) {
-      case RPT_SYNC:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_SYNC);
-        break;
-      case RPT_UNREACH:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_UNREACH);
-        break;
-      case RPT_FALSETICKER:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_FALSETICKER);
-        break;
-      case RPT_JITTERY:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_JITTERY);
-        break;
-      case RPT_CANDIDATE:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_CANDIDATE);
-        break;
-      case RPT_OUTLIER:
-        tx_message->data.source_data.state   = htons(RPY_SD_ST_OUTLIER);
-        break;
-    }
-    switch (report.mode) {
-      case RPT_NTP_CLIENT:
-        tx_message->data.source_data.mode    = htons(RPY_SD_MD_CLIENT);
-        break;
-      case RPT_NTP_PEER:
-        tx_message->data.source_data.mode    = htons(RPY_SD_MD_PEER);
-        break;
-      case RPT_LOCAL_REFERENCE:
-        tx_message->data.source_data.mode    = htons(RPY_SD_MD_REF);
-        break;
-    }
-    tx_message->data.source_data.flags =
-                  htons((report.sel_options & SRC_SELECT_PREFER ? RPY_SD_FLAG_PREFER : 0) |
-                        (report.sel_options & SRC_SELECT_NOSELECT ? RPY_SD_FLAG_NOSELECT : 0) |
-                        (report.sel_options & SRC_SELECT_TRUST ? RPY_SD_FLAG_TRUST : 0) |
-                        (report.sel_options & SRC_SELECT_REQUIRE ? RPY_SD_FLAG_REQUIRE : 0));
+    tx_message->data.source_data.state   = convert_source_state(&report);
+    tx_message->data.source_data.mode    = convert_source_mode(&report);
+    tx_message->data.source_data.flags   = convert_source_flags(&report);
     tx_message->data.source_data.reachability = htons(report.reachability);
     tx_message->data.source_data.since_sample = htonl(report.latest_meas_ago);
     tx_message->data.source_data.orig_latest_meas = UTI_FloatHostToNetwork(report.orig_latest_meas);
@@ -705,6 +1018,63 @@ handle_source_data(CMD_Request *rx_message, CMD_Reply *tx_message)
 
 /* ================================================== */
 
+static void
+handle_source_records(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_SourceReport report;
+  RPT_SourcestatsReport stats;
+  RPY_SourceRecord *record;
+  struct timespec now_corr;
+  uint32_t i, j, first_index, n_records;
+  int n_sources;
+
+  SCH_GetLastEventTime(&now_corr, NULL, NULL);
+
+  first_index = ntohl(rx_message->data.source_records.first_index);
+  n_records = ntohl(rx_message->data.source_records.n_records);
+  if (n_records > MAX_SOURCE_RECORDS)
+    n_records = MAX_SOURCE_RECORDS;
+
+  n_sources = SRC_ReadNumberOfSources();
+
+  tx_message->reply = htons(RPY_SOURCE_RECORDS);
+  tx_message->data.source_records.n_sources = htonl(n_sources);
+  tx_message->data.source_records.first_index = htonl(first_index);
+
+  for (i = first_index, j = 0; i < (uint32_t)n_sources && j < n_records; i++, j++) {
+    if (!get_source_report(i, &report, &now_corr) ||
+        !SRC_ReportSourcestats(i, &stats, &now_corr))
+      break;
+
+    record = &tx_message->data.source_records.records[j];
+
+    UTI_IPHostToNetwork(&report.ip_addr, &record->ip_addr);
+    record->ref_id = htonl(stats.ref_id);
+    record->poll = htons(report.poll);
+    record->stratum = htons(report.stratum);
+    record->state = convert_source_state(&report);
+    record->mode = convert_source_mode(&report);
+    record->flags = convert_source_flags(&report);
+    record->reachability = htons(report.reachability);
+    record->since_sample = htonl(report.latest_meas_ago);
+    record->orig_latest_meas = UTI_FloatHostToNetwork(report.orig_latest_meas);
+    record->latest_meas = UTI_FloatHostToNetwork(report.latest_meas);
+    record->latest_meas_err = UTI_FloatHostToNetwork(report.latest_meas_err);
+    record->n_samples = htonl(stats.n_samples);
+    record->n_runs = htonl(stats.n_runs);
+    record->span_seconds = htonl(stats.span_seconds);
+    record->sd = UTI_FloatHostToNetwork(stats.sd);
+    record->resid_freq_ppm = UTI_FloatHostToNetwork(stats.resid_freq_ppm);
+    record->skew_ppm = UTI_FloatHostToNetwork(stats.skew_ppm);
+    record->est_offset = UTI_FloatHostToNetwork(stats.est_offset);
+    record->est_offset_err = UTI_FloatHostToNetwork(stats.est_offset_err);
+  }
+
+  tx_message->data.source_records.n_records = htonl(j);
+}
+
+/* ================================================== */
+
 static void
 handle_rekey(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
@@ -741,6 +1111,24 @@ handle_cmdallowdeny(CMD_Request *rx_message, CMD_Reply *tx_message, int allow, i
 
 /* ================================================== */
 
+static void
+handle_reload_access(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  if (!NCR_ReloadAccessRestrictionFiles())
+    tx_message->status = htons(STT_FAILED);
+}
+
+/* ================================================== */
+
+static void
+handle_reload_config(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  if (!CNF_ReloadConfig())
+    tx_message->status = htons(STT_FAILED);
+}
+
+/* ================================================== */
+
 static void
 handle_accheck(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
@@ -801,13 +1189,14 @@ handle_add_source(NTP_Source_Type type, CMD_Request *rx_message, CMD_Reply *tx_m
   params.auto_offline = ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_AUTOOFFLINE ? 1 : 0;
   params.iburst = ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_IBURST ? 1 : 0;
   params.interleaved = ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_INTERLEAVED ? 1 : 0;
+  params.monitor = ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_MONITOR ? 1 : 0;
   params.sel_options =
     (ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_PREFER ? SRC_SELECT_PREFER : 0) |
     (ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_NOSELECT ? SRC_SELECT_NOSELECT : 0) |
     (ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_TRUST ? SRC_SELECT_TRUST : 0) |
     (ntohl(rx_message->data.ntp_source.flags) & REQ_ADDSRC_REQUIRE ? SRC_SELECT_REQUIRE : 0);
 
-  status = NSR_AddSource(&rem_addr, type, &params);
+  status = NSR_AddSource(&rem_addr, type, &params, NULL);
   switch (status) {
     case NSR_Success:
       break;
@@ -828,6 +1217,19 @@ handle_add_source(NTP_Source_Type type, CMD_Request *rx_message, CMD_Reply *tx_m
 
 /* ================================================== */
 
+static void
+handle_del_sources(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  IPAddr address, mask;
+
+  UTI_IPNetworkToHost(&rx_message->data.del_sources.mask, &mask);
+  UTI_IPNetworkToHost(&rx_message->data.del_sources.address, &address);
+  if (!NSR_RemoveSources(&mask, &address))
+    tx_message->status = htons(STT_NOSUCHSOURCE);
+}
+
+/* ================================================== */
+
 static void
 handle_del_source(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
@@ -1196,6 +1598,96 @@ handle_server_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
 
 /* ================================================== */
 
+static void
+handle_server_stats2(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_ServerStatsReport report;
+
+  CLG_GetServerStatsReport(&report);
+  tx_message->reply = htons(RPY_SERVER_STATS2);
+  tx_message->data.server_stats2.ntp_hits = htonl(report.ntp_hits);
+  tx_message->data.server_stats2.cmd_hits = htonl(report.cmd_hits);
+  tx_message->data.server_stats2.ntp_drops = htonl(report.ntp_drops);
+  tx_message->data.server_stats2.cmd_drops = htonl(report.cmd_drops);
+  tx_message->data.server_stats2.log_drops = htonl(report.log_drops);
+  tx_message->data.server_stats2.ntp_interleaved_hits = htonl(report.ntp_interleaved_hits);
+  tx_message->data.server_stats2.ntp_interleaved_misses =
+    htonl(report.ntp_interleaved_misses);
+  tx_message->data.server_stats2.ntp_timestamps = htonl(report.ntp_timestamps);
+  tx_message->data.server_stats2.log_records_ipv4 = htonl(report.log_records_ipv4);
+  tx_message->data.server_stats2.log_records_ipv4_size =
+    htonl(report.log_records_ipv4_size);
+  tx_message->data.server_stats2.log_records_ipv6 = htonl(report.log_records_ipv6);
+  tx_message->data.server_stats2.log_records_ipv6_size =
+    htonl(report.log_records_ipv6_size);
+}
+
+/* ================================================== */
+
+static void
+handle_subscribe(CMD_Request *rx_message, CMD_Reply *tx_message,
+                 union sockaddr_all *where_from)
+{
+  uint32_t events;
+  Subscriber *sub;
+  int i;
+
+  /* Events can be pushed only to clients with a named socket */
+  if (where_from->sa.sa_family != AF_UNIX || !where_from->un.sun_path[0]) {
+    tx_message->status = htons(STT_INVALID);
+    return;
+  }
+
+  events = ntohl(rx_message->data.subscribe.events) & REQ_SUBSCRIBE_ALL;
+
+  for (i = 0; i < n_subscribers; i++) {
+    if (strncmp(subscribers[i].addr.sun_path, where_from->un.sun_path,
+                sizeof (subscribers[i].addr.sun_path)) == 0)
+      break;
+  }
+
+  if (!events) {
+    if (i < n_subscribers)
+      remove_subscriber(i);
+    return;
+  }
+
+  if (i >= n_subscribers) {
+    if (n_subscribers >= MAX_SUBSCRIBERS) {
+      tx_message->status = htons(STT_FAILED);
+      return;
+    }
+
+    sub = &subscribers[n_subscribers++];
+    sub->addr = where_from->un;
+    sub->event_sequence = 0;
+    sub->dropped = 0;
+    sub->stats_timeout = 0;
+    DEBUG_LOG("Adding subscriber %s", sub->addr.sun_path);
+  } else {
+    sub = &subscribers[i];
+  }
+
+  sub->events = events;
+  sub->request_sequence = rx_message->sequence;
+
+  SCH_RemoveTimeout(sub->stats_timeout);
+  sub->stats_timeout = 0;
+
+  if (events & REQ_SUBSCRIBE_SERVERSTATS) {
+    sub->stats_interval = ntohl(rx_message->data.subscribe.stats_interval);
+    sub->stats_interval = CLAMP(MIN_STATS_INTERVAL, sub->stats_interval,
+                                MAX_STATS_INTERVAL);
+    CLG_GetServerStatsReport(&sub->last_stats);
+    sub->stats_timeout = SCH_AddTimeoutByDelay(sub->stats_interval,
+                                               handle_stats_timeout, sub);
+  }
+
+  update_subscribed_events();
+}
+
+/* ================================================== */
+
 static void
 handle_ntp_data(CMD_Request *rx_message, CMD_Reply *tx_message)
 {
@@ -1238,6 +1730,270 @@ handle_ntp_data(CMD_Request *rx_message, CMD_Reply *tx_message)
   memset(tx_message->data.ntp_data.reserved, 0xff, sizeof (tx_message->data.ntp_data.reserved));
 }
 
+/* ================================================== */
+
+static void
+handle_sched_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_SchedReport report;
+  int i;
+
+  if (!SCH_GetReport(ntohl(rx_message->data.sched_stats.index), &report)) {
+    tx_message->status = htons(STT_INVALID);
+    return;
+  }
+
+  tx_message->reply = htons(RPY_SCHED_STATS);
+  tx_message->data.sched_stats.n_records = htonl(SCH_GetNumberOfReports());
+  memset(tx_message->data.sched_stats.name, 0, sizeof (tx_message->data.sched_stats.name));
+  snprintf((char *)tx_message->data.sched_stats.name,
+           sizeof (tx_message->data.sched_stats.name), "%s", report.name);
+  switch (report.type) {
+    case RPT_SCHED_LAG:
+      tx_message->data.sched_stats.type = htons(RPY_SCHED_LAG);
+      break;
+    case RPT_SCHED_TIMEOUT:
+      tx_message->data.sched_stats.type = htons(RPY_SCHED_TIMEOUT);
+      break;
+    case RPT_SCHED_FILE:
+      tx_message->data.sched_stats.type = htons(RPY_SCHED_FILE);
+      break;
+    default:
+      assert(0);
+  }
+  tx_message->data.sched_stats.pad = 0;
+  tx_message->data.sched_stats.calls = htonl(report.calls);
+  tx_message->data.sched_stats.total_time = UTI_FloatHostToNetwork(report.total_time);
+  tx_message->data.sched_stats.max_time = UTI_FloatHostToNetwork(report.max_time);
+  for (i = 0; i < RPY_SCHED_HISTOGRAM_BUCKETS; i++)
+    tx_message->data.sched_stats.histogram[i] =
+      htonl(i < RPT_SCHED_HISTOGRAM_BUCKETS ? report.histogram[i] : 0);
+}
+
+/* ================================================== */
+
+static void
+handle_hwclock_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_HwClockReport report;
+  uint32_t index;
+
+  index = ntohl(rx_message->data.hwclock_stats.index);
+
+  if (!NIO_GetHwClockReport(index, &report)) {
+    /* Allow the client to find out there are no clocks */
+    if (index != 0 || NIO_GetNumberOfHwClocks() != 0) {
+      tx_message->status = htons(STT_INVALID);
+      return;
+    }
+    memset(&report, 0, sizeof (report));
+  }
+
+  tx_message->reply = htons(RPY_HWCLOCK_STATS);
+  tx_message->data.hwclock_stats.n_records = htonl(NIO_GetNumberOfHwClocks());
+  memset(tx_message->data.hwclock_stats.name, 0, sizeof (tx_message->data.hwclock_stats.name));
+  snprintf((char *)tx_message->data.hwclock_stats.name,
+           sizeof (tx_message->data.hwclock_stats.name), "%s", report.name);
+  tx_message->data.hwclock_stats.n_samples = htonl(report.n_samples);
+  tx_message->data.hwclock_stats.n_samples_total = htonl(report.n_samples_total);
+  tx_message->data.hwclock_stats.n_resets = htonl(report.n_resets);
+  tx_message->data.hwclock_stats.phc_readings = htonl(report.phc_readings);
+  tx_message->data.hwclock_stats.separation = UTI_FloatHostToNetwork(report.separation);
+  tx_message->data.hwclock_stats.frequency = UTI_FloatHostToNetwork(report.frequency);
+  tx_message->data.hwclock_stats.last_error = UTI_FloatHostToNetwork(report.last_error);
+  tx_message->data.hwclock_stats.rms_error = UTI_FloatHostToNetwork(report.rms_error);
+  tx_message->data.hwclock_stats.phc_read_time = UTI_FloatHostToNetwork(report.phc_read_time);
+  tx_message->data.hwclock_stats.phc_read_max = UTI_FloatHostToNetwork(report.phc_read_max);
+  tx_message->data.hwclock_stats.phc_error = UTI_FloatHostToNetwork(report.phc_error);
+}
+
+/* ================================================== */
+
+static void
+handle_sys_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_SysReport report;
+
+  SYS_GetReport(&report);
+
+  tx_message->reply = htons(RPY_SYS_STATS);
+  tx_message->data.sys_stats.adjtimex_calls = htonl(report.adjtimex_calls);
+  tx_message->data.sys_stats.flags = htonl(report.helper ? RPY_SYS_STATS_FLAG_HELPER : 0);
+  tx_message->data.sys_stats.helper_channel_requests = htonl(report.helper_channel_requests);
+  tx_message->data.sys_stats.helper_socket_requests = htonl(report.helper_socket_requests);
+  tx_message->data.sys_stats.adjtimex_last_time =
+    UTI_FloatHostToNetwork(report.adjtimex_last_time);
+  tx_message->data.sys_stats.adjtimex_mean_time =
+    UTI_FloatHostToNetwork(report.adjtimex_mean_time);
+  tx_message->data.sys_stats.adjtimex_max_time =
+    UTI_FloatHostToNetwork(report.adjtimex_max_time);
+}
+
+/* ================================================== */
+
+static void
+handle_startup_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_StartupReport *report = &startup_report;
+  uint32_t flags = 0;
+
+  if (report->complete)
+    flags |= RPY_STARTUP_STATS_FLAG_COMPLETE;
+  if (report->fast_start)
+    flags |= RPY_STARTUP_STATS_FLAG_FASTSTART;
+
+  tx_message->reply = htons(RPY_STARTUP_STATS);
+  tx_message->data.startup_stats.flags = htonl(flags);
+  tx_message->data.startup_stats.config_time = UTI_FloatHostToNetwork(report->config_time);
+  tx_message->data.startup_stats.init_time = UTI_FloatHostToNetwork(report->init_time);
+  tx_message->data.startup_stats.rtc_time = UTI_FloatHostToNetwork(report->rtc_time);
+  tx_message->data.startup_stats.initstepslew_time =
+    UTI_FloatHostToNetwork(report->initstepslew_time);
+  tx_message->data.startup_stats.resolving_time =
+    UTI_FloatHostToNetwork(report->resolving_time);
+  tx_message->data.startup_stats.dumps_time = UTI_FloatHostToNetwork(report->dumps_time);
+  tx_message->data.startup_stats.total_time = UTI_FloatHostToNetwork(report->total_time);
+}
+
+/* ================================================== */
+
+static void
+handle_key_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_KeyReport report;
+  uint32_t index;
+  int i;
+
+  index = ntohl(rx_message->data.key_stats.index);
+
+  if (!KEY_GetReport(index, &report)) {
+    /* Allow the client to find out there are no keys */
+    if (index != 0 || KEY_GetNumberOfReports() != 0) {
+      tx_message->status = htons(STT_INVALID);
+      return;
+    }
+    memset(&report, 0, sizeof (report));
+  }
+
+  tx_message->reply = htons(RPY_KEY_STATS);
+  tx_message->data.key_stats.n_records = htonl(KEY_GetNumberOfReports());
+  tx_message->data.key_stats.key_id = htonl(report.id);
+  tx_message->data.key_stats.samples = htonl(report.samples);
+  tx_message->data.key_stats.auth_delay = UTI_FloatHostToNetwork(report.auth_delay);
+  tx_message->data.key_stats.mean_delay = UTI_FloatHostToNetwork(report.mean_delay);
+  tx_message->data.key_stats.max_delay = UTI_FloatHostToNetwork(report.max_delay);
+  for (i = 0; i < RPY_KEY_HISTOGRAM_BUCKETS; i++)
+    tx_message->data.key_stats.histogram[i] =
+      htonl(i < RPT_KEY_HISTOGRAM_BUCKETS ? report.histogram[i] : 0);
+}
+
+/* ================================================== */
+
+static void
+handle_signd_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_SigndReport report;
+
+  if (!NSD_GetReport(&report)) {
+    tx_message->status = htons(STT_NOTENABLED);
+    return;
+  }
+
+  tx_message->reply = htons(RPY_SIGND_STATS);
+  tx_message->data.signd_stats.connections = htonl(report.connections);
+  tx_message->data.signd_stats.open_connections = htonl(report.open_connections);
+  tx_message->data.signd_stats.queue_length = htonl(report.queue_length);
+  tx_message->data.signd_stats.max_queue_length = htonl(report.max_queue_length);
+  tx_message->data.signd_stats.peak_queue_length = htonl(report.peak_queue_length);
+  tx_message->data.signd_stats.requests = htonl(report.requests);
+  tx_message->data.signd_stats.successes = htonl(report.successes);
+  tx_message->data.signd_stats.failures = htonl(report.failures);
+  tx_message->data.signd_stats.drops = htonl(report.drops);
+  tx_message->data.signd_stats.queued = htonl(report.queued);
+  tx_message->data.signd_stats.median_delay = UTI_FloatHostToNetwork(report.median_delay);
+  tx_message->data.signd_stats.p99_delay = UTI_FloatHostToNetwork(report.p99_delay);
+}
+
+/* ================================================== */
+
+static void
+handle_slot_stats(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_SlotReport report;
+  uint32_t index;
+
+  index = ntohl(rx_message->data.slot_stats.index);
+
+  if (!SCH_GetSlotReport(index, &report)) {
+    /* Allow the client to find out there are no calendars */
+    if (index != 0 || SCH_GetNumberOfSlotReports() != 0) {
+      tx_message->status = htons(STT_INVALID);
+      return;
+    }
+    memset(&report, 0, sizeof (report));
+  }
+
+  tx_message->reply = htons(RPY_SLOT_STATS);
+  tx_message->data.slot_stats.n_records = htonl(SCH_GetNumberOfSlotReports());
+  memset(tx_message->data.slot_stats.name, 0, sizeof (tx_message->data.slot_stats.name));
+  snprintf((char *)tx_message->data.slot_stats.name,
+           sizeof (tx_message->data.slot_stats.name), "%s", report.name);
+  tx_message->data.slot_stats.timeouts = htonl(report.timeouts);
+  tx_message->data.slot_stats.scheduled = htonl(report.scheduled);
+  tx_message->data.slot_stats.delayed = htonl(report.delayed);
+  tx_message->data.slot_stats.slot = UTI_FloatHostToNetwork(report.slot);
+  tx_message->data.slot_stats.load = UTI_FloatHostToNetwork(report.load);
+  tx_message->data.slot_stats.mean_delay = UTI_FloatHostToNetwork(report.mean_delay);
+  tx_message->data.slot_stats.max_delay = UTI_FloatHostToNetwork(report.max_delay);
+}
+
+/* ================================================== */
+
+static void
+handle_monitor_data(CMD_Request *rx_message, CMD_Reply *tx_message)
+{
+  RPT_MonitorReport report;
+  RPY_MonitorData_Source *source;
+  uint32_t i, j, req_first_index, req_n_sources, n_indices;
+  struct timespec now;
+
+  SCH_GetLastEventTime(&now, NULL, NULL);
+
+  req_first_index = ntohl(rx_message->data.monitor_data.first_index);
+  req_n_sources = ntohl(rx_message->data.monitor_data.n_sources);
+  if (req_n_sources > MAX_MONITOR_SOURCES)
+    req_n_sources = MAX_MONITOR_SOURCES;
+
+  n_indices = NSR_GetNumberOfIndices();
+
+  tx_message->reply = htons(RPY_MONITOR_DATA);
+  tx_message->data.monitor_data.n_indices = htonl(n_indices);
+
+  memset(tx_message->data.monitor_data.sources, 0,
+         sizeof (tx_message->data.monitor_data.sources));
+
+  for (i = req_first_index, j = 0; i < n_indices && j < req_n_sources; i++) {
+    if (!NSR_GetMonitorReportByIndex(i, &report, &now))
+      continue;
+
+    source = &tx_message->data.monitor_data.sources[j++];
+
+    UTI_IPHostToNetwork(&report.ip_addr, &source->ip_addr);
+    source->stratum = htons(report.stratum);
+    source->poll = htons(report.poll);
+    source->reachability = htons(report.reachability);
+    source->samples = htons(report.samples);
+    source->since_sample = htonl(report.latest_meas_ago);
+    source->offset = UTI_FloatHostToNetwork(report.offset);
+    source->delay = UTI_FloatHostToNetwork(report.delay);
+    source->min_delay_offset = UTI_FloatHostToNetwork(report.min_delay_offset);
+    source->min_delay = UTI_FloatHostToNetwork(report.min_delay);
+  }
+
+  tx_message->data.monitor_data.next_index = htonl(i);
+  tx_message->data.monitor_data.n_sources = htonl(j);
+}
+
 /* ================================================== */
 /* Read a packet and process it */
 
@@ -1485,6 +2241,10 @@ read_from_cmd_socket(int sock_fd, int event, void *anything)
           handle_source_data(&rx_message, &tx_message);
           break;
 
+        case REQ_SOURCE_RECORDS:
+          handle_source_records(&rx_message, &tx_message);
+          break;
+
         case REQ_REKEY:
           handle_rekey(&rx_message, &tx_message);
           break;
@@ -1521,6 +2281,14 @@ read_from_cmd_socket(int sock_fd, int event, void *anything)
           handle_cmdallowdeny(&rx_message, &tx_message, 0, 1);
           break;
 
+        case REQ_RELOAD_ACCESS:
+          handle_reload_access(&rx_message, &tx_message);
+          break;
+
+        case REQ_RELOAD_CONFIG:
+          handle_reload_config(&rx_message, &tx_message);
+          break;
+
         case REQ_ACCHECK:
           handle_accheck(&rx_message, &tx_message);
           break;
@@ -1541,6 +2309,10 @@ read_from_cmd_socket(int sock_fd, int event, void *anything)
           handle_del_source(&rx_message, &tx_message);
           break;
 
+        case REQ_DEL_SOURCES:
+          handle_del_sources(&rx_message, &tx_message);
+          break;
+
         case REQ_WRITERTC:
           handle_writertc(&rx_message, &tx_message);
           break;
@@ -1629,6 +2401,46 @@ read_from_cmd_socket(int sock_fd, int event, void *anything)
           handle_ntp_data(&rx_message, &tx_message);
           break;
 
+        case REQ_SUBSCRIBE:
+          handle_subscribe(&rx_message, &tx_message, &where_from);
+          break;
+
+        case REQ_SCHED_STATS:
+          handle_sched_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_HWCLOCK_STATS:
+          handle_hwclock_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_SYS_STATS:
+          handle_sys_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_SLOT_STATS:
+          handle_slot_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_MONITOR_DATA:
+          handle_monitor_data(&rx_message, &tx_message);
+          break;
+
+        case REQ_STARTUP_STATS:
+          handle_startup_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_KEY_STATS:
+          handle_key_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_SIGND_STATS:
+          handle_signd_stats(&rx_message, &tx_message);
+          break;
+
+        case REQ_SERVER_STATS2:
+          handle_server_stats2(&rx_message, &tx_message);
+          break;
+
         default:
           DEBUG_LOG("Unhandled command %d", rx_command);
           tx_message.status = htons(STT_FAILED);
@@ -1687,12 +2499,47 @@ CAM_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
 
 /* ================================================== */
 
+void
+CAM_BeginAccessRestrictions(void)
+{
+  assert(!saved_access_auth_table);
+
+  saved_access_auth_table = access_auth_table;
+  access_auth_table = ADF_CreateTable();
+}
+
+/* ================================================== */
+
+void
+CAM_EndAccessRestrictions(int commit)
+{
+  assert(saved_access_auth_table);
+
+  if (commit) {
+    ADF_DestroyTable(saved_access_auth_table);
+  } else {
+    ADF_DestroyTable(access_auth_table);
+    access_auth_table = saved_access_auth_table;
+  }
+
+  saved_access_auth_table = NULL;
+}
+
+/* ================================================== */
+
 int
 CAM_CheckAccessRestriction(IPAddr *ip_addr)
 {
   return ADF_IsAllowed(access_auth_table, ip_addr);
 }
 
+/* ================================================== */
+
+void
+CAM_SetStartupReport(RPT_StartupReport *report)
+{
+  startup_report = *report;
+}
 
 /* ================================================== */
 /* ================================================== */
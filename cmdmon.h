@@ -28,6 +28,7 @@
 #define GOT_CMDMON_H
 
 #include "addressing.h"
+#include "reports.h"
 
 extern void CAM_Initialise(int family);
 
@@ -35,6 +36,15 @@ extern void CAM_Finalise(void);
 
 extern void CAM_OpenUnixSocket(void);
 extern int CAM_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all);
+
+/* Start replacing all access restrictions, the new restrictions replace
+   the current restrictions only if they are committed */
+extern void CAM_BeginAccessRestrictions(void);
+extern void CAM_EndAccessRestrictions(int commit);
+
+/* Save a report of the daemon initialisation */
+extern void CAM_SetStartupReport(RPT_StartupReport *report);
+
 extern int CAM_CheckAccessRestriction(IPAddr *ip_addr);
 
 #endif /* GOT_CMDMON_H */
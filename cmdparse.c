@@ -59,6 +59,7 @@ CPS_ParseNTPSourceAdd(char *line, CPS_NTP_Source *src)
   src->params.min_samples = SRC_DEFAULT_MINSAMPLES;
   src->params.max_samples = SRC_DEFAULT_MAXSAMPLES;
   src->params.interleaved = 0;
+  src->params.monitor = 0;
   src->params.sel_options = 0;
   src->params.authkey = INACTIVE_AUTHKEY;
   src->params.max_delay = SRC_DEFAULT_MAXDELAY;
@@ -86,6 +87,8 @@ CPS_ParseNTPSourceAdd(char *line, CPS_NTP_Source *src)
       src->params.auto_offline = 1;
     } else if (!strcasecmp(cmd, "iburst")) {
       src->params.iburst = 1;
+    } else if (!strcasecmp(cmd, "monitor")) {
+      src->params.monitor = 1;
     } else if (!strcasecmp(cmd, "offline")) {
       src->params.online = 0;
     } else if (!strcasecmp(cmd, "noselect")) {
@@ -280,3 +283,49 @@ CPS_ParseKey(char *line, uint32_t *id, const char **hash, char **key)
 
   return 1;
 }
+
+/* ================================================== */
+
+int
+CPS_ParseSubnet(char *line, IPAddr *ip, int *subnet_bits)
+{
+  unsigned long a, b, c, d;
+  char *slash, *s1, *s2;
+  int n;
+
+  s1 = line;
+  s2 = CPS_SplitWord(s1);
+
+  /* Require one word */
+  if (!*s1 || *s2)
+    return 0;
+
+  slash = strchr(s1, '/');
+  if (slash)
+    *slash = '\0';
+
+  if (UTI_StringToIP(s1, ip)) {
+    *subnet_bits = ip->family == IPADDR_INET6 ? 128 : 32;
+  } else {
+    /* Allow the shortened IPv4 form, e.g. 1.2.3 for 1.2.3.0/24 */
+    n = sscanf(s1, "%lu.%lu.%lu.%lu", &a, &b, &c, &d);
+    if (n < 1)
+      return 0;
+
+    a &= 0xff;
+    b = n > 1 ? b & 0xff : 0;
+    c = n > 2 ? c & 0xff : 0;
+    d = n > 3 ? d & 0xff : 0;
+
+    ip->family = IPADDR_INET4;
+    ip->addr.in4 = (a << 24) | (b << 16) | (c << 8) | d;
+    *subnet_bits = 8 * n;
+  }
+
+  if (slash) {
+    if (sscanf(slash + 1, "%d%n", subnet_bits, &n) != 1 || slash[n + 1] != '\0')
+      return 0;
+  }
+
+  return 1;
+}
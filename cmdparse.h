@@ -51,4 +51,7 @@ extern char *CPS_SplitWord(char *line);
 /* Parse a key from keyfile */
 extern int CPS_ParseKey(char *line, uint32_t *id, const char **hash, char **key);
 
+/* Parse a subnet specified as an address with optional number of bits */
+extern int CPS_ParseSubnet(char *line, IPAddr *ip, int *subnet_bits);
+
 #endif /* GOT_CMDPARSE_H */
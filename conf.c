@@ -30,7 +30,9 @@
 #include "sysincl.h"
 
 #include "array.h"
+#include "clientlog.h"
 #include "conf.h"
+#include "keys.h"
 #include "ntp_sources.h"
 #include "ntp_core.h"
 #include "refclock.h"
@@ -51,9 +53,11 @@ static int parse_double(char *line, double *result);
 static int parse_null(char *line);
 
 static void parse_allow_deny(char *line, ARR_Instance restrictions, int allow);
+static void parse_allow_deny_file(char *line, ARR_Instance restrictions, int allow);
 static void parse_bindacqaddress(char *);
 static void parse_bindaddress(char *);
 static void parse_bindcmdaddress(char *);
+static void parse_bindmetricsaddress(char *);
 static void parse_broadcast(char *);
 static void parse_clientloglimit(char *);
 static void parse_fallbackdrift(char *);
@@ -66,12 +70,21 @@ static void parse_log(char *);
 static void parse_mailonchange(char *);
 static void parse_makestep(char *);
 static void parse_maxchange(char *);
-static void parse_ratelimit(char *line, int *enabled, int *interval,
-                            int *burst, int *leak);
+typedef struct {
+  int enabled;
+  int interval;
+  int burst;
+  int leak;
+} RateLimit;
+
+static void parse_ratelimit(char *line, RateLimit *ratelimit);
+static void parse_ntpsigndsocket(char *line);
 static void parse_refclock(char *);
 static void parse_smoothtime(char *);
 static void parse_source(char *line, NTP_Source_Type type, int pool);
 static void parse_tempcomp(char *);
+static void clear_access_restrictions(void);
+static void free_sources(ARR_Instance sources);
 
 /* ================================================== */
 /* Configuration variables */
@@ -83,6 +96,7 @@ static int ntp_port = NTP_PORT;
 static char *keys_file = NULL;
 static char *drift_file = NULL;
 static char *rtc_file = NULL;
+static char *time_export_file = NULL;
 static double max_update_skew = 1000.0;
 static double correction_time_ratio = 3.0;
 static double max_clock_error = 1.0; /* in ppm */
@@ -96,6 +110,7 @@ static double stratum_weight = 1e-3;
 static double combine_limit = 3.0;
 
 static int cmd_port = DEFAULT_CANDM_PORT;
+static int metrics_port = 0;
 
 static int raw_measurements = 0;
 static int do_log_measurements = 0;
@@ -121,6 +136,9 @@ static ARR_Instance init_sources;
 
 static int enable_manual=0;
 
+/* Flag enabling faster start of the daemon */
+static int fast_start = 0;
+
 /* Flag set if the RTC runs UTC (default is it runs local time
    incl. daylight saving). */
 static int rtc_on_utc = 0;
@@ -183,22 +201,32 @@ static IPAddr bind_cmd_address4, bind_cmd_address6;
 /* Path to the Unix domain command socket. */
 static char *bind_cmd_path;
 
+/* IP addresses for binding the metrics socket to.  UNSPEC family means
+   the loopback address will be used */
+static IPAddr bind_metrics_address4, bind_metrics_address6;
+
+/* Path to the Unix domain metrics socket. */
+static char *bind_metrics_path;
+
 /* Path to Samba (ntp_signd) socket. */
 static char *ntp_signd_socket = NULL;
 
+/* Number of connections to ntp_signd and maximum number of requests
+   waiting for a free connection */
+#define MAX_NTP_SIGND_CONNECTIONS 16
+#define MAX_NTP_SIGND_QUEUE 65536
+static int ntp_signd_connections = 1;
+static int ntp_signd_max_queue = 1024;
+
 /* Filename to use for storing pid of running chronyd, to prevent multiple
  * chronyds being started. */
 static char *pidfile;
 
 /* Rate limiting parameters */
-static int ntp_ratelimit_enabled = 0;
-static int ntp_ratelimit_interval = 3;
-static int ntp_ratelimit_burst = 8;
-static int ntp_ratelimit_leak = 2;
-static int cmd_ratelimit_enabled = 0;
-static int cmd_ratelimit_interval = -4;
-static int cmd_ratelimit_burst = 8;
-static int cmd_ratelimit_leak = 2;
+#define DEFAULT_NTP_RATELIMIT { 0, 3, 8, 2 }
+#define DEFAULT_CMD_RATELIMIT { 0, -4, 8, 2 }
+static RateLimit ntp_ratelimit = DEFAULT_NTP_RATELIMIT;
+static RateLimit cmd_ratelimit = DEFAULT_CMD_RATELIMIT;
 
 /* Smoothing constants */
 static double smooth_max_freq = 0.0; /* in ppm */
@@ -230,11 +258,16 @@ typedef struct {
   NTP_Source_Type type;
   int pool;
   CPS_NTP_Source params;
+  uint32_t conf_id;
 } NTP_Source;
 
-/* Array of NTP_Source */
+/* Array of NTP_Source, which are kept after they are added in order to
+   find changes in the configuration when it is reloaded */
 static ARR_Instance ntp_sources;
 
+/* Flag indicating the sources were added */
+static int sources_added = 0;
+
 /* Array of RefclockParameters */
 static ARR_Instance refclock_sources;
 
@@ -243,6 +276,7 @@ typedef struct _AllowDeny {
   int subnet_bits;
   int all; /* 1 to override existing more specific defns */
   int allow; /* 0 for deny, 1 for allow */
+  char *file; /* File with subnets instead of the single subnet */
 } AllowDeny;
 
 /* Arrays of AllowDeny */
@@ -265,14 +299,41 @@ static int line_number;
 static const char *processed_file;
 static const char *processed_command;
 
+/* Main configuration file, which can be reloaded */
+static char *config_file = NULL;
+
+/* Flag indicating the configuration is being reloaded, errors are not
+   fatal and only some directives are processed */
+static int reloading = 0;
+
+/* Flag indicating an error in the reloaded configuration */
+static int reload_failed;
+
+/* Directives which are processed when the configuration is reloaded */
+static const char *reloadable_directives[] = {
+  "allow", "allowfile", "cmdallow", "cmddeny", "cmdratelimit", "deny",
+  "denyfile", "include", "keyfile", "peer", "pool", "ratelimit", "server", NULL
+};
+
+/* ================================================== */
+
+static void
+end_parse_error(void)
+{
+  if (!reloading)
+    exit(1);
+  reload_failed = 1;
+}
+
 /* ================================================== */
 
 static void
 command_parse_error(void)
 {
-    LOG_FATAL("Could not parse %s directive at line %d%s%s",
+    LOG(reloading ? LOGS_ERR : LOGS_FATAL, "Could not parse %s directive at line %d%s%s",
         processed_command, line_number, processed_file ? " in file " : "",
         processed_file ? processed_file : "");
+    end_parse_error();
 }
 
 /* ================================================== */
@@ -280,9 +341,10 @@ command_parse_error(void)
 static void
 other_parse_error(const char *message)
 {
-    LOG_FATAL("%s at line %d%s%s",
+    LOG(reloading ? LOGS_ERR : LOGS_FATAL, "%s at line %d%s%s",
         message, line_number, processed_file ? " in file " : "",
         processed_file ? processed_file : "");
+    end_parse_error();
 }
 
 /* ================================================== */
@@ -313,10 +375,11 @@ check_number_of_args(char *line, int num)
   num -= get_number_of_args(line);
 
   if (num) {
-    LOG_FATAL("%s arguments for %s directive at line %d%s%s",
+    LOG(reloading ? LOGS_ERR : LOGS_FATAL, "%s arguments for %s directive at line %d%s%s",
         num > 0 ? "Missing" : "Too many",
         processed_command, line_number, processed_file ? " in file " : "",
         processed_file ? processed_file : "");
+    end_parse_error();
   }
 }
 
@@ -342,6 +405,7 @@ CNF_Initialise(int r, int client_only)
   rtc_device = Strdup(DEFAULT_RTC_DEVICE);
   hwclock_file = Strdup(DEFAULT_HWCLOCK_FILE);
   user = Strdup(DEFAULT_USER);
+  bind_metrics_path = Strdup("");
 
   if (client_only) {
     cmd_port = ntp_port = 0;
@@ -360,21 +424,23 @@ CNF_Finalise(void)
 {
   unsigned int i;
 
-  for (i = 0; i < ARR_GetSize(hwts_interfaces); i++)
+  for (i = 0; i < ARR_GetSize(hwts_interfaces); i++) {
     Free(((CNF_HwTsInterface *)ARR_GetElement(hwts_interfaces, i))->name);
+    Free(((CNF_HwTsInterface *)ARR_GetElement(hwts_interfaces, i))->phc);
+  }
   ARR_DestroyInstance(hwts_interfaces);
 
-  for (i = 0; i < ARR_GetSize(ntp_sources); i++)
-    Free(((NTP_Source *)ARR_GetElement(ntp_sources, i))->params.name);
+  clear_access_restrictions();
 
   ARR_DestroyInstance(init_sources);
-  ARR_DestroyInstance(ntp_sources);
+  free_sources(ntp_sources);
   ARR_DestroyInstance(refclock_sources);
   ARR_DestroyInstance(broadcasts);
 
   ARR_DestroyInstance(ntp_restrictions);
   ARR_DestroyInstance(cmd_restrictions);
 
+  Free(config_file);
   Free(drift_file);
   Free(dumpdir);
   Free(hwclock_file);
@@ -382,10 +448,12 @@ CNF_Finalise(void)
   Free(leapsec_tz);
   Free(logdir);
   Free(bind_cmd_path);
+  Free(bind_metrics_path);
   Free(ntp_signd_socket);
   Free(pidfile);
   Free(rtc_device);
   Free(rtc_file);
+  Free(time_export_file);
   Free(user);
   Free(mail_user_on_change);
   Free(tempcomp_sensor_file);
@@ -402,10 +470,15 @@ CNF_ReadFile(const char *filename)
   char line[2048];
   int i;
 
+  /* The first file is the main configuration file */
+  if (!config_file)
+    config_file = Strdup(filename);
+
   in = fopen(filename, "r");
   if (!in) {
-    LOG_FATAL("Could not open configuration file %s : %s",
-              filename, strerror(errno));
+    LOG(reloading ? LOGS_ERR : LOGS_FATAL, "Could not open configuration file %s : %s",
+        filename, strerror(errno));
+    end_parse_error();
     return;
   }
 
@@ -425,6 +498,7 @@ void
 CNF_ParseLine(const char *filename, int number, char *line)
 {
   char *p, *command;
+  int i;
 
   /* Set global variables used in error messages */
   processed_file = filename;
@@ -441,16 +515,29 @@ CNF_ParseLine(const char *filename, int number, char *line)
   processed_command = command = line;
   p = CPS_SplitWord(line);
 
+  if (reloading) {
+    for (i = 0; reloadable_directives[i]; i++) {
+      if (!strcasecmp(command, reloadable_directives[i]))
+        break;
+    }
+    if (!reloadable_directives[i])
+      return;
+  }
+
   if (!strcasecmp(command, "acquisitionport")) {
     parse_int(p, &acquisition_port);
   } else if (!strcasecmp(command, "allow")) {
     parse_allow_deny(p, ntp_restrictions, 1);
+  } else if (!strcasecmp(command, "allowfile")) {
+    parse_allow_deny_file(p, ntp_restrictions, 1);
   } else if (!strcasecmp(command, "bindacqaddress")) {
     parse_bindacqaddress(p);
   } else if (!strcasecmp(command, "bindaddress")) {
     parse_bindaddress(p);
   } else if (!strcasecmp(command, "bindcmdaddress")) {
     parse_bindcmdaddress(p);
+  } else if (!strcasecmp(command, "bindmetricsaddress")) {
+    parse_bindmetricsaddress(p);
   } else if (!strcasecmp(command, "broadcast")) {
     parse_broadcast(p);
   } else if (!strcasecmp(command, "clientloglimit")) {
@@ -462,14 +549,15 @@ CNF_ParseLine(const char *filename, int number, char *line)
   } else if (!strcasecmp(command, "cmdport")) {
     parse_int(p, &cmd_port);
   } else if (!strcasecmp(command, "cmdratelimit")) {
-    parse_ratelimit(p, &cmd_ratelimit_enabled, &cmd_ratelimit_interval,
-                    &cmd_ratelimit_burst, &cmd_ratelimit_leak);
+    parse_ratelimit(p, &cmd_ratelimit);
   } else if (!strcasecmp(command, "combinelimit")) {
     parse_double(p, &combine_limit);
   } else if (!strcasecmp(command, "corrtimeratio")) {
     parse_double(p, &correction_time_ratio);
   } else if (!strcasecmp(command, "deny")) {
     parse_allow_deny(p, ntp_restrictions, 0);
+  } else if (!strcasecmp(command, "denyfile")) {
+    parse_allow_deny_file(p, ntp_restrictions, 0);
   } else if (!strcasecmp(command, "driftfile")) {
     parse_string(p, &drift_file);
   } else if (!strcasecmp(command, "dumpdir")) {
@@ -478,6 +566,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
     /* Silently ignored */
   } else if (!strcasecmp(command, "fallbackdrift")) {
     parse_fallbackdrift(p);
+  } else if (!strcasecmp(command, "faststart")) {
+    fast_start = parse_null(p);
   } else if (!strcasecmp(command, "hwclockfile")) {
     parse_string(p, &hwclock_file);
   } else if (!strcasecmp(command, "hwtimestamp")) {
@@ -526,6 +616,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
     parse_double(p, &max_slew_rate);
   } else if (!strcasecmp(command, "maxupdateskew")) {
     parse_double(p, &max_update_skew);
+  } else if (!strcasecmp(command, "metricsport")) {
+    parse_int(p, &metrics_port);
   } else if (!strcasecmp(command, "minsamples")) {
     parse_int(p, &min_samples);
   } else if (!strcasecmp(command, "minsources")) {
@@ -533,7 +625,7 @@ CNF_ParseLine(const char *filename, int number, char *line)
   } else if (!strcasecmp(command, "noclientlog")) {
     no_client_log = parse_null(p);
   } else if (!strcasecmp(command, "ntpsigndsocket")) {
-    parse_string(p, &ntp_signd_socket);
+    parse_ntpsigndsocket(p);
   } else if (!strcasecmp(command, "peer")) {
     parse_source(p, NTP_PEER, 0);
   } else if (!strcasecmp(command, "pidfile")) {
@@ -543,8 +635,7 @@ CNF_ParseLine(const char *filename, int number, char *line)
   } else if (!strcasecmp(command, "port")) {
     parse_int(p, &ntp_port);
   } else if (!strcasecmp(command, "ratelimit")) {
-    parse_ratelimit(p, &ntp_ratelimit_enabled, &ntp_ratelimit_interval,
-                    &ntp_ratelimit_burst, &ntp_ratelimit_leak);
+    parse_ratelimit(p, &ntp_ratelimit);
   } else if (!strcasecmp(command, "refclock")) {
     parse_refclock(p);
   } else if (!strcasecmp(command, "reselectdist")) {
@@ -569,6 +660,8 @@ CNF_ParseLine(const char *filename, int number, char *line)
     parse_double(p, &stratum_weight);
   } else if (!strcasecmp(command, "tempcomp")) {
     parse_tempcomp(p);
+  } else if (!strcasecmp(command, "timeexportfile")) {
+    parse_string(p, &time_export_file);
   } else if (!strcasecmp(command, "user")) {
     parse_string(p, &user);
   } else if (!strcasecmp(command, "commandkey") ||
@@ -634,6 +727,8 @@ parse_source(char *line, NTP_Source_Type type, int pool)
 {
   NTP_Source source;
 
+  /* Clear padding in the parameters, which are compared on reload */
+  memset(&source, 0, sizeof (source));
   source.type = type;
   source.pool = pool;
 
@@ -649,12 +744,12 @@ parse_source(char *line, NTP_Source_Type type, int pool)
 /* ================================================== */
 
 static void
-parse_ratelimit(char *line, int *enabled, int *interval, int *burst, int *leak)
+parse_ratelimit(char *line, RateLimit *ratelimit)
 {
   int n, val;
   char *opt;
 
-  *enabled = 1;
+  ratelimit->enabled = 1;
 
   while (*line) {
     opt = line;
@@ -665,11 +760,47 @@ parse_ratelimit(char *line, int *enabled, int *interval, int *burst, int *leak)
     }
     line += n;
     if (!strcasecmp(opt, "interval"))
-      *interval = val;
+      ratelimit->interval = val;
     else if (!strcasecmp(opt, "burst"))
-      *burst = val;
+      ratelimit->burst = val;
     else if (!strcasecmp(opt, "leak"))
-      *leak = val;
+      ratelimit->leak = val;
+    else
+      command_parse_error();
+  }
+}
+
+/* ================================================== */
+
+static void
+parse_ntpsigndsocket(char *line)
+{
+  int n, val;
+  char *opt, *path;
+
+  if (!*line) {
+    command_parse_error();
+    return;
+  }
+
+  path = line;
+  line = CPS_SplitWord(line);
+
+  Free(ntp_signd_socket);
+  ntp_signd_socket = Strdup(path);
+
+  while (*line) {
+    opt = line;
+    line = CPS_SplitWord(line);
+    if (sscanf(line, "%d%n", &val, &n) != 1) {
+      command_parse_error();
+      return;
+    }
+    line += n;
+    if (!strcasecmp(opt, "connections"))
+      ntp_signd_connections = CLAMP(1, val, MAX_NTP_SIGND_CONNECTIONS);
+    else if (!strcasecmp(opt, "maxqueue"))
+      ntp_signd_max_queue = CLAMP(0, val, MAX_NTP_SIGND_QUEUE);
     else
       command_parse_error();
   }
@@ -1020,6 +1151,7 @@ parse_allow_deny(char *line, ARR_Instance restrictions, int allow)
     new_node = (AllowDeny *)ARR_GetNewElement(restrictions);
     new_node->allow = allow;
     new_node->all = all;
+    new_node->file = NULL;
     new_node->ip.family = IPADDR_UNSPEC;
     new_node->subnet_bits = 0;
   } else {
@@ -1034,6 +1166,7 @@ parse_allow_deny(char *line, ARR_Instance restrictions, int allow)
       new_node = (AllowDeny *)ARR_GetNewElement(restrictions);
       new_node->allow = allow;
       new_node->all = all;
+      new_node->file = NULL;
 
       if (n == 0) {
         new_node->ip = ip_addr;
@@ -1086,6 +1219,7 @@ parse_allow_deny(char *line, ARR_Instance restrictions, int allow)
         new_node = (AllowDeny *)ARR_GetNewElement(restrictions);
         new_node->allow = allow;
         new_node->all = all;
+        new_node->file = NULL;
         new_node->ip = ip_addr;
         if (ip_addr.family == IPADDR_INET6)
           new_node->subnet_bits = 128;
@@ -1100,6 +1234,23 @@ parse_allow_deny(char *line, ARR_Instance restrictions, int allow)
   
 /* ================================================== */
 
+static void
+parse_allow_deny_file(char *line, ARR_Instance restrictions, int allow)
+{
+  AllowDeny *new_node;
+
+  check_number_of_args(line, 1);
+
+  new_node = (AllowDeny *)ARR_GetNewElement(restrictions);
+  new_node->allow = allow;
+  new_node->all = 0;
+  new_node->file = Strdup(line);
+  new_node->ip.family = IPADDR_UNSPEC;
+  new_node->subnet_bits = 0;
+}
+
+/* ================================================== */
+
 static void
 parse_bindacqaddress(char *line)
 {
@@ -1161,6 +1312,28 @@ parse_bindcmdaddress(char *line)
 
 /* ================================================== */
 
+static void
+parse_bindmetricsaddress(char *line)
+{
+  IPAddr ip;
+
+  check_number_of_args(line, 1);
+
+  /* Address starting with / is for the Unix domain socket */
+  if (line[0] == '/') {
+    parse_string(line, &bind_metrics_path);
+  } else if (UTI_StringToIP(line, &ip)) {
+    if (ip.family == IPADDR_INET4)
+      bind_metrics_address4 = ip;
+    else if (ip.family == IPADDR_INET6)
+      bind_metrics_address6 = ip;
+  } else {
+    command_parse_error();
+  }
+}
+
+/* ================================================== */
+
 static void
 parse_broadcast(char *line)
 {
@@ -1291,11 +1464,13 @@ parse_hwtimestamp(char *line)
   iface = ARR_GetNewElement(hwts_interfaces);
   iface->name = Strdup(p);
   iface->minpoll = 0;
+  iface->maxpoll = 4;
   iface->nocrossts = 0;
   iface->rxfilter = CNF_HWTS_RXFILTER_ANY;
   iface->precision = 100.0e-9;
   iface->tx_comp = 0.0;
   iface->rx_comp = 0.0;
+  iface->phc = NULL;
 
   for (p = line; *p; line += n, p = line) {
     line = CPS_SplitWord(line);
@@ -1303,6 +1478,9 @@ parse_hwtimestamp(char *line)
     if (!strcasecmp(p, "minpoll")) {
       if (sscanf(line, "%d%n", &iface->minpoll, &n) != 1)
         break;
+    } else if (!strcasecmp(p, "maxpoll")) {
+      if (sscanf(line, "%d%n", &iface->maxpoll, &n) != 1)
+        break;
     } else if (!strcasecmp(p, "precision")) {
       if (sscanf(line, "%lf%n", &iface->precision, &n) != 1)
         break;
@@ -1326,6 +1504,11 @@ parse_hwtimestamp(char *line)
     } else if (!strcasecmp(p, "nocrossts")) {
       n = 0;
       iface->nocrossts = 1;
+    } else if (!strcasecmp(p, "phc") && *line && !iface->phc) {
+      p = line;
+      line = CPS_SplitWord(line);
+      n = 0;
+      iface->phc = Strdup(p);
     } else {
       break;
     }
@@ -1351,8 +1534,10 @@ parse_include(char *line)
                 GLOB_NOMAGIC |
 #endif
                 GLOB_ERR, NULL, &gl)) != 0) {
-    if (r != GLOB_NOMATCH)
-      LOG_FATAL("Could not search for files matching %s", line);
+    if (r != GLOB_NOMATCH) {
+      LOG(reloading ? LOGS_ERR : LOGS_FATAL, "Could not search for files matching %s", line);
+      end_parse_error();
+    }
 
     DEBUG_LOG("glob of %s failed", line);
     return;
@@ -1413,7 +1598,7 @@ CNF_AddInitSources(void)
     cps_source.params.iburst = 1;
     cps_source.params.online = 0;
 
-    NSR_AddSource(&ntp_addr, NTP_SERVER, &cps_source.params);
+    NSR_AddSource(&ntp_addr, NTP_SERVER, &cps_source.params, NULL);
   }
 
   ARR_SetSize(init_sources, 0);
@@ -1430,11 +1615,11 @@ CNF_AddSources(void)
   for (i = 0; i < ARR_GetSize(ntp_sources); i++) {
     source = (NTP_Source *)ARR_GetElement(ntp_sources, i);
     NSR_AddSourceByName(source->params.name, source->params.port,
-                        source->pool, source->type, &source->params.params);
-    Free(source->params.name);
+                        source->pool, source->type, &source->params.params,
+                        &source->conf_id);
   }
 
-  ARR_SetSize(ntp_sources, 0);
+  sources_added = 1;
 }
 
 /* ================================================== */
@@ -1687,6 +1872,14 @@ CNF_GetManualEnabled(void)
 
 /* ================================================== */
 
+int
+CNF_GetFastStart(void)
+{
+  return fast_start;
+}
+
+/* ================================================== */
+
 int
 CNF_GetCommandPort(void) {
   return cmd_port;
@@ -1694,6 +1887,14 @@ CNF_GetCommandPort(void) {
 
 /* ================================================== */
 
+int
+CNF_GetMetricsPort(void)
+{
+  return metrics_port;
+}
+
+/* ================================================== */
+
 int
 CNF_AllowLocalReference(int *stratum, int *orphan, double *distance)
 {
@@ -1768,8 +1969,8 @@ CNF_GetMailOnChange(int *enabled, double *threshold, char **user)
 
 /* ================================================== */
 
-void
-CNF_SetupAccessRestrictions(void)
+static int
+add_access_restrictions(void)
 {
   AllowDeny *node;
   int status;
@@ -1777,9 +1978,17 @@ CNF_SetupAccessRestrictions(void)
 
   for (i = 0; i < ARR_GetSize(ntp_restrictions); i++) {
     node = ARR_GetElement(ntp_restrictions, i);
+    if (node->file) {
+      if (!NCR_AddAccessRestrictionFile(node->file, node->allow)) {
+        LOG(LOGS_ERR, "Could not load subnets from %s", node->file);
+        return 0;
+      }
+      continue;
+    }
     status = NCR_AddAccessRestriction(&node->ip, node->subnet_bits, node->allow, node->all);
     if (!status) {
-      LOG_FATAL("Bad subnet in %s/%d", UTI_IPToString(&node->ip), node->subnet_bits);
+      LOG(LOGS_ERR, "Bad subnet in %s/%d", UTI_IPToString(&node->ip), node->subnet_bits);
+      return 0;
     }
   }
 
@@ -1787,16 +1996,185 @@ CNF_SetupAccessRestrictions(void)
     node = ARR_GetElement(cmd_restrictions, i);
     status = CAM_AddAccessRestriction(&node->ip, node->subnet_bits, node->allow, node->all);
     if (!status) {
-      LOG_FATAL("Bad subnet in %s/%d", UTI_IPToString(&node->ip), node->subnet_bits);
+      LOG(LOGS_ERR, "Bad subnet in %s/%d", UTI_IPToString(&node->ip), node->subnet_bits);
+      return 0;
     }
   }
 
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+clear_access_restrictions(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(ntp_restrictions); i++)
+    Free(((AllowDeny *)ARR_GetElement(ntp_restrictions, i))->file);
+
   ARR_SetSize(ntp_restrictions, 0);
   ARR_SetSize(cmd_restrictions, 0);
 }
 
 /* ================================================== */
 
+void
+CNF_SetupAccessRestrictions(void)
+{
+  if (!add_access_restrictions())
+    LOG_FATAL("Could not set up access restrictions");
+
+  clear_access_restrictions();
+}
+
+/* ================================================== */
+
+static void
+free_sources(ARR_Instance sources)
+{
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(sources); i++)
+    Free(((NTP_Source *)ARR_GetElement(sources, i))->params.name);
+  ARR_DestroyInstance(sources);
+}
+
+/* ================================================== */
+
+static int
+is_same_source(NTP_Source *a, NTP_Source *b)
+{
+  return a->type == b->type && a->pool == b->pool && a->params.port == b->params.port &&
+         !strcmp(a->params.name, b->params.name) &&
+         !memcmp(&a->params.params, &b->params.params, sizeof (a->params.params));
+}
+
+/* ================================================== */
+/* Remove sources which are no longer in the configuration and add the new
+   sources.  Unchanged sources keep their state. */
+
+static void
+update_sources(ARR_Instance old_sources)
+{
+  NTP_Source *old_source, *new_source;
+  unsigned int i, j, n_old, n_new, removed, added;
+
+  n_old = ARR_GetSize(old_sources);
+  n_new = ARR_GetSize(ntp_sources);
+
+  for (i = removed = 0; i < n_old; i++) {
+    old_source = ARR_GetElement(old_sources, i);
+
+    for (j = 0; j < n_new; j++) {
+      new_source = ARR_GetElement(ntp_sources, j);
+      if (!new_source->conf_id && is_same_source(old_source, new_source)) {
+        new_source->conf_id = old_source->conf_id;
+        break;
+      }
+    }
+
+    if (j < n_new)
+      continue;
+
+    NSR_RemoveSourcesById(old_source->conf_id);
+    removed++;
+  }
+
+  for (i = added = 0; i < n_new; i++) {
+    new_source = ARR_GetElement(ntp_sources, i);
+    if (new_source->conf_id)
+      continue;
+
+    NSR_AddSourceByName(new_source->params.name, new_source->params.port,
+                        new_source->pool, new_source->type, &new_source->params.params,
+                        &new_source->conf_id);
+    added++;
+  }
+
+  if (added)
+    NSR_ResolveSources();
+
+  LOG(LOGS_INFO, "Reloaded configuration with %u new and %u removed sources",
+      added, removed);
+}
+
+/* ================================================== */
+
+int
+CNF_ReloadConfig(void)
+{
+  RateLimit old_ntp_ratelimit, old_cmd_ratelimit;
+  ARR_Instance old_sources;
+  char *old_keys_file;
+  int ok;
+
+  if (!config_file) {
+    LOG(LOGS_ERR, "No configuration file to reload");
+    return 0;
+  }
+
+  old_sources = ntp_sources;
+  old_keys_file = keys_file;
+  old_ntp_ratelimit = ntp_ratelimit;
+  old_cmd_ratelimit = cmd_ratelimit;
+
+  /* Parse the reloadable directives from their default values */
+  ntp_sources = ARR_CreateInstance(sizeof (NTP_Source));
+  keys_file = NULL;
+  ntp_ratelimit = (RateLimit)DEFAULT_NTP_RATELIMIT;
+  cmd_ratelimit = (RateLimit)DEFAULT_CMD_RATELIMIT;
+
+  reloading = 1;
+  reload_failed = 0;
+  CNF_ReadFile(config_file);
+  reloading = 0;
+
+  ok = !reload_failed;
+
+  if (ok && no_client_log && (ntp_ratelimit.enabled || cmd_ratelimit.enabled)) {
+    LOG(LOGS_ERR, "ratelimit cannot be used with noclientlog");
+    ok = 0;
+  }
+
+  /* Replace the access restrictions only if all of them can be added */
+  if (ok) {
+    NCR_BeginAccessRestrictions();
+    CAM_BeginAccessRestrictions();
+    ok = add_access_restrictions();
+    NCR_EndAccessRestrictions(ok);
+    CAM_EndAccessRestrictions(ok);
+  }
+
+  clear_access_restrictions();
+
+  if (!ok) {
+    LOG(LOGS_ERR, "Could not reload %s", config_file);
+    free_sources(ntp_sources);
+    ntp_sources = old_sources;
+    Free(keys_file);
+    keys_file = old_keys_file;
+    ntp_ratelimit = old_ntp_ratelimit;
+    cmd_ratelimit = old_cmd_ratelimit;
+    return 0;
+  }
+
+  Free(old_keys_file);
+
+  /* Sources which were not added yet will be added with the new list */
+  if (sources_added)
+    update_sources(old_sources);
+  free_sources(old_sources);
+
+  KEY_Reload();
+  CLG_UpdateRateLimits();
+
+  return 1;
+}
+
+/* ================================================== */
+
 int
 CNF_GetNoClientLog(void)
 {
@@ -1869,6 +2247,27 @@ CNF_GetBindCommandAddress(int family, IPAddr *addr)
 
 /* ================================================== */
 
+char *
+CNF_GetBindMetricsPath(void)
+{
+  return bind_metrics_path;
+}
+
+/* ================================================== */
+
+void
+CNF_GetBindMetricsAddress(int family, IPAddr *addr)
+{
+  if (family == IPADDR_INET4)
+    *addr = bind_metrics_address4;
+  else if (family == IPADDR_INET6)
+    *addr = bind_metrics_address6;
+  else
+    addr->family = IPADDR_UNSPEC;
+}
+
+/* ================================================== */
+
 char *
 CNF_GetNtpSigndSocket(void)
 {
@@ -1877,6 +2276,15 @@ CNF_GetNtpSigndSocket(void)
 
 /* ================================================== */
 
+void
+CNF_GetNtpSigndLimits(int *connections, int *max_queue)
+{
+  *connections = ntp_signd_connections;
+  *max_queue = ntp_signd_max_queue;
+}
+
+/* ================================================== */
+
 char *
 CNF_GetPidFile(void)
 {
@@ -1919,20 +2327,20 @@ CNF_GetLockMemory(void)
 
 int CNF_GetNTPRateLimit(int *interval, int *burst, int *leak)
 {
-  *interval = ntp_ratelimit_interval;
-  *burst = ntp_ratelimit_burst;
-  *leak = ntp_ratelimit_leak;
-  return ntp_ratelimit_enabled;
+  *interval = ntp_ratelimit.interval;
+  *burst = ntp_ratelimit.burst;
+  *leak = ntp_ratelimit.leak;
+  return ntp_ratelimit.enabled;
 }
 
 /* ================================================== */
 
 int CNF_GetCommandRateLimit(int *interval, int *burst, int *leak)
 {
-  *interval = cmd_ratelimit_interval;
-  *burst = cmd_ratelimit_burst;
-  *leak = cmd_ratelimit_leak;
-  return cmd_ratelimit_enabled;
+  *interval = cmd_ratelimit.interval;
+  *burst = cmd_ratelimit.burst;
+  *leak = cmd_ratelimit.leak;
+  return cmd_ratelimit.enabled;
 }
 
 /* ================================================== */
@@ -2001,6 +2409,14 @@ CNF_GetHwclockFile(void)
 
 /* ================================================== */
 
+char *
+CNF_GetTimeExportFile(void)
+{
+  return time_export_file;
+}
+
+/* ================================================== */
+
 int
 CNF_GetInitSources(void)
 {
@@ -61,7 +61,9 @@ extern int CNF_GetLogTempComp(void);
 extern char *CNF_GetKeysFile(void);
 extern char *CNF_GetRtcFile(void);
 extern int CNF_GetManualEnabled(void);
+extern int CNF_GetFastStart(void);
 extern int CNF_GetCommandPort(void);
+extern int CNF_GetMetricsPort(void);
 extern int CNF_GetRtcOnUtc(void);
 extern int CNF_GetRtcSync(void);
 extern void CNF_GetMakeStep(int *limit, double *threshold);
@@ -75,7 +77,10 @@ extern void CNF_GetBindAddress(int family, IPAddr *addr);
 extern void CNF_GetBindAcquisitionAddress(int family, IPAddr *addr);
 extern void CNF_GetBindCommandAddress(int family, IPAddr *addr);
 extern char *CNF_GetBindCommandPath(void);
+extern void CNF_GetBindMetricsAddress(int family, IPAddr *addr);
+extern char *CNF_GetBindMetricsPath(void);
 extern char *CNF_GetNtpSigndSocket(void);
+extern void CNF_GetNtpSigndLimits(int *connections, int *max_queue);
 extern char *CNF_GetPidFile(void);
 extern REF_LeapMode CNF_GetLeapSecMode(void);
 extern char *CNF_GetLeapSecTimezone(void);
@@ -97,6 +102,11 @@ extern int CNF_AllowLocalReference(int *stratum, int *orphan, double *distance);
 
 extern void CNF_SetupAccessRestrictions(void);
 
+/* Reload sources, access restrictions, keys and rate limiting from the
+   configuration file.  Other directives are ignored.  Returns 0 if the
+   file could not be parsed, in which case nothing is changed. */
+extern int CNF_ReloadConfig(void);
+
 extern int CNF_GetSchedPriority(void);
 extern int CNF_GetLockMemory(void);
 
@@ -114,6 +124,7 @@ extern int CNF_GetMinSources(void);
 
 extern double CNF_GetRtcAutotrim(void);
 extern char *CNF_GetHwclockFile(void);
+extern char *CNF_GetTimeExportFile(void);
 
 extern int CNF_GetInitSources(void);
 extern double CNF_GetInitStepThreshold(void);
@@ -128,11 +139,13 @@ typedef enum {
 typedef struct {
   char *name;
   int minpoll;
+  int maxpoll;
   int nocrossts;
   CNF_HwTs_RxFilter rxfilter;
   double precision;
   double tx_comp;
   double rx_comp;
+  char *phc;
 } CNF_HwTsInterface;
 
 extern int CNF_GetHwTsInterface(unsigned int index, CNF_HwTsInterface **iface);
@@ -37,7 +37,18 @@
 #include "util.h"
 
 /* Maximum number of samples per clock */
-#define MAX_SAMPLES 16
+#define MAX_SAMPLES 64
+
+/* Number of consecutive samples predicted within their error needed to
+   double the sampling interval */
+#define GOOD_PREDICTIONS 4
+
+/* Ratio of the prediction error to the error of the sample which halves
+   the sampling interval */
+#define MAX_PREDICTION_ERROR_RATIO 3.0
+
+/* Weight of new prediction errors in the averaged error */
+#define PREDICTION_ERROR_WEIGHT 0.125
 
 /* Maximum acceptable frequency offset of the clock */
 #define MAX_FREQ_OFFSET (2.0 / 3.0)
@@ -58,8 +69,23 @@ struct HCL_Instance_Record {
   /* Maximum error of the last sample */
   double last_err;
 
-  /* Minimum interval between samples */
+  /* Minimum and maximum interval between samples */
   double min_separation;
+  double max_separation;
+
+  /* Current interval between samples */
+  double separation;
+
+  /* Number of consecutive samples predicted within their error */
+  int good_predictions;
+
+  /* Last prediction error and average squared prediction error */
+  double last_pred_err;
+  double mean_sq_pred_err;
+
+  /* Total number of accumulated samples and resets of the model */
+  uint32_t n_total;
+  uint32_t n_resets;
 
   /* Flag indicating the offset and frequency values are valid */
   int valid_coefs;
@@ -89,7 +115,7 @@ handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
 /* ================================================== */
 
 HCL_Instance
-HCL_CreateInstance(double min_separation)
+HCL_CreateInstance(double min_separation, double max_separation)
 {
   HCL_Instance clock;
 
@@ -99,6 +125,13 @@ HCL_CreateInstance(double min_separation)
   clock->n_samples = 0;
   clock->valid_coefs = 0;
   clock->min_separation = min_separation;
+  clock->max_separation = MAX(min_separation, max_separation);
+  clock->separation = min_separation;
+  clock->good_predictions = 0;
+  clock->last_pred_err = 0.0;
+  clock->mean_sq_pred_err = 0.0;
+  clock->n_total = 0;
+  clock->n_resets = 0;
 
   LCL_AddParameterChangeHandler(handle_slew, clock);
 
@@ -119,7 +152,7 @@ int
 HCL_NeedsNewSample(HCL_Instance clock, struct timespec *now)
 {
   if (!clock->n_samples ||
-      fabs(UTI_DiffTimespecsToDouble(now, &clock->local_ref)) >= clock->min_separation)
+      fabs(UTI_DiffTimespecsToDouble(now, &clock->local_ref)) >= clock->separation)
     return 1;
 
   return 0;
@@ -127,6 +160,56 @@ HCL_NeedsNewSample(HCL_Instance clock, struct timespec *now)
 
 /* ================================================== */
 
+static void
+update_separation(HCL_Instance clock, struct timespec *hw_ts, struct timespec *local_ts,
+                  double err)
+{
+  struct timespec predicted_ts;
+  double pred_err;
+
+  if (!HCL_CookTime(clock, hw_ts, &predicted_ts, NULL))
+    return;
+
+  pred_err = UTI_DiffTimespecsToDouble(&predicted_ts, local_ts);
+
+  if (clock->mean_sq_pred_err > 0.0)
+    clock->mean_sq_pred_err += PREDICTION_ERROR_WEIGHT *
+                               (pred_err * pred_err - clock->mean_sq_pred_err);
+  else
+    clock->mean_sq_pred_err = pred_err * pred_err;
+  clock->last_pred_err = pred_err;
+
+  /* Sample less frequently if the model predicts the samples within their
+     error and more frequently if it doesn't */
+  if (fabs(pred_err) <= err) {
+    if (++clock->good_predictions >= GOOD_PREDICTIONS) {
+      clock->separation = MIN(2.0 * clock->separation, clock->max_separation);
+      clock->good_predictions = 0;
+    }
+  } else {
+    clock->good_predictions = 0;
+    if (fabs(pred_err) > MAX_PREDICTION_ERROR_RATIO * err)
+      clock->separation = MAX(clock->separation / 2.0, clock->min_separation);
+  }
+
+  DEBUG_LOG("HW clock prediction error=%e err=%e separation=%f",
+            pred_err, err, clock->separation);
+}
+
+/* ================================================== */
+
+static void
+reset_model(HCL_Instance clock)
+{
+  clock->n_samples = 0;
+  clock->valid_coefs = 0;
+  clock->separation = clock->min_separation;
+  clock->good_predictions = 0;
+  clock->n_resets++;
+}
+
+/* ================================================== */
+
 void
 HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
                      struct timespec *local_ts, double err)
@@ -136,6 +219,9 @@ HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
 
   local_freq = 1.0 - LCL_ReadAbsoluteFrequency() / 1.0e6;
 
+  if (clock->valid_coefs)
+    update_separation(clock, hw_ts, local_ts, err);
+
   /* Shift old samples */
   if (clock->n_samples) {
     if (clock->n_samples >= MAX_SAMPLES)
@@ -145,7 +231,7 @@ HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
     local_delta = UTI_DiffTimespecsToDouble(local_ts, &clock->local_ref) / local_freq;
 
     if (hw_delta <= 0.0 || local_delta < clock->min_separation / 2.0) {
-      clock->n_samples = 0;
+      reset_model(clock);
       DEBUG_LOG("HW clock reset interval=%f", local_delta);
     }
 
@@ -156,6 +242,7 @@ HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
   }
 
   clock->n_samples++;
+  clock->n_total++;
   clock->hw_ref = *hw_ts;
   clock->local_ref = *local_ts;
   clock->last_err = err;
@@ -182,8 +269,7 @@ HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
   if (fabs(clock->offset) > err ||
       fabs(clock->frequency - 1.0) > MAX_FREQ_OFFSET) {
     DEBUG_LOG("HW clock reset");
-    clock->n_samples = 0;
-    clock->valid_coefs = 0;
+    reset_model(clock);
   }
 
   DEBUG_LOG("HW clock samples=%d offset=%e freq=%e raw_freq=%e err=%e ref_diff=%e",
@@ -211,3 +297,17 @@ HCL_CookTime(HCL_Instance clock, struct timespec *raw, struct timespec *cooked,
 
   return 1;
 }
+
+/* ================================================== */
+
+void
+HCL_GetReport(HCL_Instance clock, RPT_HwClockReport *report)
+{
+  report->n_samples = clock->n_samples;
+  report->separation = clock->separation;
+  report->frequency = clock->valid_coefs ? (clock->frequency - 1.0) * 1.0e6 : 0.0;
+  report->last_error = clock->last_pred_err;
+  report->rms_error = sqrt(clock->mean_sq_pred_err);
+  report->n_samples_total = clock->n_total;
+  report->n_resets = clock->n_resets;
+}
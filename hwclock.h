@@ -26,10 +26,14 @@
 #ifndef GOT_HWCLOCK_H
 #define GOT_HWCLOCK_H
 
+#include "reports.h"
+
 typedef struct HCL_Instance_Record *HCL_Instance;
 
-/* Create a new HW clock instance */
-extern HCL_Instance HCL_CreateInstance(double min_separation);
+/* Create a new HW clock instance.  The interval between samples is adapted
+   to the prediction error of the model between the minimum and maximum
+   separation. */
+extern HCL_Instance HCL_CreateInstance(double min_separation, double max_separation);
 
 /* Destroy a HW clock instance */
 extern void HCL_DestroyInstance(HCL_Instance clock);
@@ -45,4 +49,7 @@ extern void HCL_AccumulateSample(HCL_Instance clock, struct timespec *hw_ts,
 extern int HCL_CookTime(HCL_Instance clock, struct timespec *raw, struct timespec *cooked,
                         double *err);
 
+/* Get statistics of the model */
+extern void HCL_GetReport(HCL_Instance clock, RPT_HwClockReport *report);
+
 #endif
@@ -42,12 +42,24 @@
 /* Consider 80 bits as the absolute minimum for a secure key */
 #define MIN_SECURE_KEY_LENGTH 10
 
+/* Weight of new measurements of the authentication delay in the moving
+   average, and the maximum ratio of a measurement to the average to limit
+   the impact of measurements interrupted by the scheduler */
+#define AUTH_DELAY_AVG_WEIGHT 0.05
+#define MAX_AUTH_DELAY_RATIO 2.0
+
 typedef struct {
   uint32_t id;
   char *val;
   int len;
   int hash_id;
+  /* Compensation of the delay in nanoseconds, or negative if not measured */
   int auth_delay;
+  /* Statistics of the delay measured in generating of authentication data */
+  double auth_delay_avg;
+  double auth_delay_max;
+  uint32_t auth_samples;
+  uint32_t auth_histogram[RPT_KEY_HISTOGRAM_BUCKETS];
 } Key;
 
 static ARR_Instance keys;
@@ -100,17 +112,39 @@ get_key(unsigned int index)
 /* ================================================== */
 
 static int
-determine_hash_delay(uint32_t key_id)
+generate_ntp_auth(int hash_id, const unsigned char *key, int key_len,
+                  const unsigned char *data, int data_len,
+                  unsigned char *auth, int auth_len)
+{
+  return HSH_Hash(hash_id, key, key_len, data, data_len, auth, auth_len);
+}
+
+/* ================================================== */
+
+static void
+set_auth_delay(Key *key, double delay)
+{
+  key->auth_delay_avg = delay;
+
+  /* Add on a bit extra to allow for copying, conversions etc */
+  key->auth_delay = 1.0625e9 * delay;
+}
+
+/* ================================================== */
+
+static void
+determine_hash_delay(Key *key)
 {
   NTP_Packet pkt;
   struct timespec before, after;
   double diff, min_diff;
-  int i, nsecs;
+  int i;
 
   for (i = 0; i < 10; i++) {
     LCL_ReadRawTime(&before);
-    KEY_GenerateAuth(key_id, (unsigned char *)&pkt, NTP_NORMAL_PACKET_LENGTH,
-        (unsigned char *)&pkt.auth_data, sizeof (pkt.auth_data));
+    generate_ntp_auth(key->hash_id, (unsigned char *)key->val, key->len,
+                      (unsigned char *)&pkt, NTP_NORMAL_PACKET_LENGTH,
+                      (unsigned char *)&pkt.auth_data, sizeof (pkt.auth_data));
     LCL_ReadRawTime(&after);
 
     diff = UTI_DiffTimespecsToDouble(&after, &before);
@@ -119,12 +153,45 @@ determine_hash_delay(uint32_t key_id)
       min_diff = diff;
   }
 
-  /* Add on a bit extra to allow for copying, conversions etc */
-  nsecs = 1.0625e9 * min_diff;
+  set_auth_delay(key, min_diff);
+
+  DEBUG_LOG("authentication delay for key %"PRIu32": %d nsecs", key->id, key->auth_delay);
+}
+
+/* ================================================== */
+
+static void
+update_auth_delay(Key *key, double delay)
+{
+  int bucket;
 
-  DEBUG_LOG("authentication delay for key %"PRIu32": %d nsecs", key_id, nsecs);
+  /* Ignore intervals broken by unexpected time jumps */
+  if (!(delay >= 0.0))
+    return;
+
+  if (delay < 1.0e-9) {
+    bucket = 0;
+  } else {
+    frexp(delay * 1.0e9, &bucket);
+    if (bucket >= RPT_KEY_HISTOGRAM_BUCKETS)
+      bucket = RPT_KEY_HISTOGRAM_BUCKETS - 1;
+  }
+
+  key->auth_samples++;
+  key->auth_histogram[bucket]++;
+  if (key->auth_delay_max < delay)
+    key->auth_delay_max = delay;
 
-  return nsecs;
+  if (key->auth_delay < 0) {
+    set_auth_delay(key, delay);
+    return;
+  }
+
+  /* Follow changes in the delay due to CPU frequency scaling, caching, etc */
+  if (key->auth_delay_avg > 0.0)
+    delay = MIN(delay, MAX_AUTH_DELAY_RATIO * key->auth_delay_avg);
+  set_auth_delay(key, key->auth_delay_avg +
+                      AUTH_DELAY_AVG_WEIGHT * (delay - key->auth_delay_avg));
 }
 
 /* ================================================== */
@@ -231,6 +298,12 @@ KEY_Reload(void)
     key.id = key_id;
     key.val = MallocArray(char, key.len);
     memcpy(key.val, keyval, key.len);
+    /* Measure the authentication delay on first use to not slow down
+       the start with many keys in the file */
+    key.auth_delay = -1;
+    key.auth_delay_avg = key.auth_delay_max = 0.0;
+    key.auth_samples = 0;
+    memset(key.auth_histogram, 0, sizeof (key.auth_histogram));
     ARR_AppendElement(keys, &key);
   }
 
@@ -249,9 +322,6 @@ KEY_Reload(void)
 
   /* Erase any passwords from stack */
   memset(line, 0, sizeof (line));
-
-  for (i = 0; i < ARR_GetSize(keys); i++)
-    get_key(i)->auth_delay = determine_hash_delay(get_key(i)->id);
 }
 
 /* ================================================== */
@@ -317,6 +387,9 @@ KEY_GetAuthDelay(uint32_t key_id)
   if (!key)
     return 0;
 
+  if (key->auth_delay < 0)
+    determine_hash_delay(key);
+
   return key->auth_delay;
 }
 
@@ -353,16 +426,6 @@ KEY_CheckKeyLength(uint32_t key_id)
 
 /* ================================================== */
 
-static int
-generate_ntp_auth(int hash_id, const unsigned char *key, int key_len,
-                  const unsigned char *data, int data_len,
-                  unsigned char *auth, int auth_len)
-{
-  return HSH_Hash(hash_id, key, key_len, data, data_len, auth, auth_len);
-}
-
-/* ================================================== */
-
 static int
 check_ntp_auth(int hash_id, const unsigned char *key, int key_len,
                const unsigned char *data, int data_len,
@@ -382,15 +445,24 @@ int
 KEY_GenerateAuth(uint32_t key_id, const unsigned char *data, int data_len,
     unsigned char *auth, int auth_len)
 {
+  struct timespec before, after;
   Key *key;
+  int len;
 
   key = get_key_by_id(key_id);
 
   if (!key)
     return 0;
 
-  return generate_ntp_auth(key->hash_id, (unsigned char *)key->val, key->len,
-                           data, data_len, auth, auth_len);
+  LCL_ReadRawTime(&before);
+
+  len = generate_ntp_auth(key->hash_id, (unsigned char *)key->val, key->len,
+                          data, data_len, auth, auth_len);
+
+  LCL_ReadRawTime(&after);
+  update_auth_delay(key, UTI_DiffTimespecsToDouble(&after, &before));
+
+  return len;
 }
 
 /* ================================================== */
@@ -409,3 +481,33 @@ KEY_CheckAuth(uint32_t key_id, const unsigned char *data, int data_len,
   return check_ntp_auth(key->hash_id, (unsigned char *)key->val, key->len,
                         data, data_len, auth, auth_len, trunc_len);
 }
+
+/* ================================================== */
+
+int
+KEY_GetNumberOfReports(void)
+{
+  return ARR_GetSize(keys);
+}
+
+/* ================================================== */
+
+int
+KEY_GetReport(int index, RPT_KeyReport *report)
+{
+  Key *key;
+
+  if (index < 0 || index >= ARR_GetSize(keys))
+    return 0;
+
+  key = get_key(index);
+
+  report->id = key->id;
+  report->auth_delay = key->auth_delay > 0 ? key->auth_delay * 1.0e-9 : 0.0;
+  report->samples = key->auth_samples;
+  report->mean_delay = key->auth_delay_avg;
+  report->max_delay = key->auth_delay_max;
+  memcpy(report->histogram, key->auth_histogram, sizeof (report->histogram));
+
+  return 1;
+}
@@ -29,6 +29,8 @@
 
 #include "sysincl.h"
 
+#include "reports.h"
+
 extern void KEY_Initialise(void);
 extern void KEY_Finalise(void);
 
@@ -45,4 +47,7 @@ extern int KEY_GenerateAuth(uint32_t key_id, const unsigned char *data,
 extern int KEY_CheckAuth(uint32_t key_id, const unsigned char *data, int data_len,
                          const unsigned char *auth, int auth_len, int trunc_len);
 
+extern int KEY_GetNumberOfReports(void);
+extern int KEY_GetReport(int index, RPT_KeyReport *report);
+
 #endif /* GOT_KEYS_H */
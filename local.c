@@ -61,6 +61,30 @@ static lcl_ApplyStepOffsetDriver drv_apply_step_offset;
 static lcl_OffsetCorrectionDriver drv_offset_convert;
 static lcl_SetLeapDriver drv_set_leap;
 static lcl_SetSyncStatusDriver drv_set_sync_status;
+static lcl_SetFrequencyAndOffsetDriver drv_set_freq_and_offset;
+
+/* ================================================== */
+
+/* Changes of the frequency and offset made in an update, which are
+   passed to the system driver and parameter change handlers together
+   when the outermost update is finished */
+
+typedef struct {
+  int pending;
+  int set_freq;
+  int accrue_offset;
+  int notify;
+  struct timespec raw;
+  struct timespec cooked;
+  double dfreq;
+  double offset;
+  double corr_rate;
+} PendingUpdate;
+
+static PendingUpdate update;
+
+/* Number of nested updates in progress */
+static int update_depth;
 
 /* ================================================== */
 
@@ -165,6 +189,10 @@ LCL_Initialise(void)
   drv_set_freq = NULL;
   drv_accrue_offset = NULL;
   drv_offset_convert = NULL;
+  drv_set_freq_and_offset = NULL;
+
+  update.pending = 0;
+  update_depth = 0;
 
   /* This ought to be set from the system driver layer */
   current_freq_ppm = 0.0;
@@ -398,6 +426,10 @@ LCL_GetOffsetCorrection(struct timespec *raw, double *correction, double *err)
 {
   /* Call system specific driver to get correction */
   (*drv_offset_convert)(raw, correction, err);
+
+  /* Include the offset accumulated in a pending update */
+  if (update.pending && update.accrue_offset)
+    *correction -= update.offset;
 }
 
 /* ================================================== */
@@ -446,15 +478,142 @@ check_offset(struct timespec *now, double offset)
 
 /* ================================================== */
 
+/* Combine two relative frequency changes */
+
+static double
+combine_dfreq(double dfreq1, double dfreq2)
+{
+  return dfreq1 + dfreq2 - dfreq1 * dfreq2;
+}
+
+/* ================================================== */
+/* Start a new update if none is pending.  The raw and cooked time passed
+   to the handlers is the time before any of the changes were made. */
+
+static void
+start_update(void)
+{
+  if (update.pending)
+    return;
+
+  LCL_ReadRawTime(&update.raw);
+  LCL_CookTime(&update.raw, &update.cooked, NULL);
+
+  update.pending = 1;
+  update.set_freq = 0;
+  update.accrue_offset = 0;
+  update.notify = 0;
+  update.dfreq = 0.0;
+  update.offset = 0.0;
+  update.corr_rate = 0.0;
+}
+
+/* ================================================== */
+/* Pass the pending changes to the system driver and dispatch them to
+   all handlers */
+
+static void
+finish_update(void)
+{
+  double target_freq_ppm;
+  int accrue_offset;
+
+  if (!update.pending)
+    return;
+
+  update.pending = 0;
+  accrue_offset = update.accrue_offset;
+
+  if (update.set_freq) {
+    target_freq_ppm = current_freq_ppm;
+
+    /* Call the system-specific driver for setting the frequency, with
+       the offset if it can make both changes at once */
+    if (accrue_offset && drv_set_freq_and_offset) {
+      current_freq_ppm = (*drv_set_freq_and_offset)(current_freq_ppm, update.offset,
+                                                     update.corr_rate);
+      accrue_offset = 0;
+    } else {
+      current_freq_ppm = (*drv_set_freq)(current_freq_ppm);
+    }
+
+    /* Include the difference between the requested and actual frequency */
+    update.dfreq = combine_dfreq(update.dfreq, (current_freq_ppm - target_freq_ppm) /
+                                               (1.0e6 - target_freq_ppm));
+  }
+
+  if (accrue_offset)
+    (*drv_accrue_offset)(update.offset, update.corr_rate);
+
+  DEBUG_LOG("dfreq=%.3e offset=%.6f notify=%d", update.dfreq, update.offset, update.notify);
+
+  /* Dispatch to all handlers */
+  if (update.notify)
+    invoke_parameter_change_handlers(&update.raw, &update.cooked, update.dfreq,
+                                     update.offset, LCL_ChangeAdjust);
+}
+
+/* ================================================== */
+
+static void
+update_frequency(double freq_ppm)
+{
+  start_update();
+
+  update.dfreq = combine_dfreq(update.dfreq, (freq_ppm - current_freq_ppm) /
+                                             (1.0e6 - current_freq_ppm));
+  update.set_freq = 1;
+  update.notify = 1;
+  current_freq_ppm = freq_ppm;
+}
+
+/* ================================================== */
+
+static int
+update_offset(double offset, double corr_rate)
+{
+  start_update();
+
+  /* Due to modifying the offset, the check has to be made with the cooked
+     time prior to all changes in the update */
+  if (!check_offset(&update.cooked, update.offset + offset))
+    return 0;
+
+  update.offset += offset;
+  update.corr_rate = corr_rate;
+  update.accrue_offset = 1;
+  update.notify = 1;
+
+  return 1;
+}
+
+/* ================================================== */
+
+void
+LCL_BeginUpdate(void)
+{
+  update_depth++;
+}
+
+/* ================================================== */
+
+void
+LCL_EndUpdate(void)
+{
+  assert(update_depth > 0);
+
+  if (--update_depth == 0)
+    finish_update();
+}
+
+/* ================================================== */
+
 /* This involves both setting the absolute frequency with the
    system-specific driver, as well as calling all notify handlers */
 
 void
 LCL_SetAbsoluteFrequency(double afreq_ppm)
 {
-  struct timespec raw, cooked;
-  double dfreq;
-  
   afreq_ppm = clamp_freq(afreq_ppm);
 
   /* Apply temperature compensation */
@@ -462,20 +621,10 @@ LCL_SetAbsoluteFrequency(double afreq_ppm)
     afreq_ppm = afreq_ppm * (1.0 - 1.0e-6 * temp_comp_ppm) - temp_comp_ppm;
   }
 
-  /* Call the system-specific driver for setting the frequency */
-  
-  afreq_ppm = (*drv_set_freq)(afreq_ppm);
-
-  dfreq = (afreq_ppm - current_freq_ppm) / (1.0e6 - current_freq_ppm);
-
-  LCL_ReadRawTime(&raw);
-  LCL_CookTime(&raw, &cooked, NULL);
-
-  /* Dispatch to all handlers */
-  invoke_parameter_change_handlers(&raw, &cooked, dfreq, 0.0, LCL_ChangeAdjust);
-
-  current_freq_ppm = afreq_ppm;
+  update_frequency(afreq_ppm);
 
+  if (update_depth == 0)
+    finish_update();
 }
 
 /* ================================================== */
@@ -483,28 +632,18 @@ LCL_SetAbsoluteFrequency(double afreq_ppm)
 void
 LCL_AccumulateDeltaFrequency(double dfreq)
 {
-  struct timespec raw, cooked;
-  double old_freq_ppm;
-
-  old_freq_ppm = current_freq_ppm;
+  double freq_ppm;
 
   /* Work out new absolute frequency.  Note that absolute frequencies
    are handled in units of ppm, whereas the 'dfreq' argument is in
    terms of the gradient of the (offset) v (local time) function. */
 
-  current_freq_ppm += dfreq * (1.0e6 - current_freq_ppm);
-
-  current_freq_ppm = clamp_freq(current_freq_ppm);
-
-  /* Call the system-specific driver for setting the frequency */
-  current_freq_ppm = (*drv_set_freq)(current_freq_ppm);
-  dfreq = (current_freq_ppm - old_freq_ppm) / (1.0e6 - old_freq_ppm);
+  freq_ppm = current_freq_ppm + dfreq * (1.0e6 - current_freq_ppm);
 
-  LCL_ReadRawTime(&raw);
-  LCL_CookTime(&raw, &cooked, NULL);
+  update_frequency(clamp_freq(freq_ppm));
 
-  /* Dispatch to all handlers */
-  invoke_parameter_change_handlers(&raw, &cooked, dfreq, 0.0, LCL_ChangeAdjust);
+  if (update_depth == 0)
+    finish_update();
 }
 
 /* ================================================== */
@@ -512,21 +651,10 @@ LCL_AccumulateDeltaFrequency(double dfreq)
 void
 LCL_AccumulateOffset(double offset, double corr_rate)
 {
-  struct timespec raw, cooked;
-
-  /* In this case, the cooked time to be passed to the notify clients
-     has to be the cooked time BEFORE the change was made */
+  update_offset(offset, corr_rate);
 
-  LCL_ReadRawTime(&raw);
-  LCL_CookTime(&raw, &cooked, NULL);
-
-  if (!check_offset(&cooked, offset))
-      return;
-
-  (*drv_accrue_offset)(offset, corr_rate);
-
-  /* Dispatch to all handlers */
-  invoke_parameter_change_handlers(&raw, &cooked, 0.0, offset, LCL_ChangeAdjust);
+  if (update_depth == 0)
+    finish_update();
 }
 
 /* ================================================== */
@@ -536,6 +664,9 @@ LCL_ApplyStepOffset(double offset)
 {
   struct timespec raw, cooked;
 
+  /* Apply pending changes before the step */
+  finish_update();
+
   /* In this case, the cooked time to be passed to the notify clients
      has to be the cooked time BEFORE the change was made */
 
@@ -565,6 +696,8 @@ void
 LCL_NotifyExternalTimeStep(struct timespec *raw, struct timespec *cooked,
     double offset, double dispersion)
 {
+  finish_update();
+
   /* Dispatch to all handlers */
   invoke_parameter_change_handlers(raw, cooked, 0.0, offset, LCL_ChangeUnknownStep);
 
@@ -578,6 +711,8 @@ LCL_NotifyLeap(int leap)
 {
   struct timespec raw, cooked;
 
+  finish_update();
+
   LCL_ReadRawTime(&raw);
   LCL_CookTime(&raw, &cooked, NULL);
 
@@ -593,37 +728,22 @@ LCL_NotifyLeap(int leap)
 void
 LCL_AccumulateFrequencyAndOffset(double dfreq, double doffset, double corr_rate)
 {
-  struct timespec raw, cooked;
-  double old_freq_ppm;
-
-  LCL_ReadRawTime(&raw);
-  /* Due to modifying the offset, this has to be the cooked time prior
-     to the change we are about to make */
-  LCL_CookTime(&raw, &cooked, NULL);
+  double freq_ppm;
 
-  if (!check_offset(&cooked, doffset))
-      return;
+  if (update_offset(doffset, corr_rate)) {
+    /* Work out new absolute frequency.  Note that absolute frequencies
+     are handled in units of ppm, whereas the 'dfreq' argument is in
+     terms of the gradient of the (offset) v (local time) function. */
+    freq_ppm = clamp_freq(current_freq_ppm + dfreq * (1.0e6 - current_freq_ppm));
 
-  old_freq_ppm = current_freq_ppm;
+    DEBUG_LOG("old_freq=%.3fppm new_freq=%.3fppm offset=%.6fsec",
+        current_freq_ppm, freq_ppm, doffset);
 
-  /* Work out new absolute frequency.  Note that absolute frequencies
-   are handled in units of ppm, whereas the 'dfreq' argument is in
-   terms of the gradient of the (offset) v (local time) function. */
-  current_freq_ppm += dfreq * (1.0e6 - current_freq_ppm);
-
-  current_freq_ppm = clamp_freq(current_freq_ppm);
-
-  DEBUG_LOG("old_freq=%.3fppm new_freq=%.3fppm offset=%.6fsec",
-      old_freq_ppm, current_freq_ppm, doffset);
-
-  /* Call the system-specific driver for setting the frequency */
-  current_freq_ppm = (*drv_set_freq)(current_freq_ppm);
-  dfreq = (current_freq_ppm - old_freq_ppm) / (1.0e6 - old_freq_ppm);
-
-  (*drv_accrue_offset)(doffset, corr_rate);
+    update_frequency(freq_ppm);
+  }
 
-  /* Dispatch to all handlers */
-  invoke_parameter_change_handlers(&raw, &cooked, dfreq, doffset, LCL_ChangeAdjust);
+  if (update_depth == 0)
+    finish_update();
 }
 
 /* ================================================== */
@@ -663,6 +783,14 @@ lcl_RegisterSystemDrivers(lcl_ReadFrequencyDriver read_freq,
   DEBUG_LOG("Local freq=%.3fppm", current_freq_ppm);
 }
 
+/* ================================================== */
+
+void
+lcl_RegisterSystemUpdateDriver(lcl_SetFrequencyAndOffsetDriver set_freq_and_offset)
+{
+  drv_set_freq_and_offset = set_freq_and_offset;
+}
+
 /* ================================================== */
 /* Look at the current difference between the system time and the NTP
    time, and make a step to cancel it. */
@@ -712,7 +840,7 @@ LCL_SetSystemLeap(int leap, int tai_offset)
 double
 LCL_SetTempComp(double comp)
 {
-  double uncomp_freq_ppm;
+  double uncomp_freq_ppm, target_freq_ppm;
 
   if (temp_comp_ppm == comp)
     return comp;
@@ -726,9 +854,19 @@ LCL_SetTempComp(double comp)
   /* Apply new compensation */
   current_freq_ppm = current_freq_ppm * (1.0 - 1.0e-6 * comp) - comp;
 
-  /* Call the system-specific driver for setting the frequency */
+  target_freq_ppm = current_freq_ppm;
+
+  /* Call the system-specific driver for setting the frequency.  This is
+     done even in an update in order to get the compensation which is
+     actually applied. */
   current_freq_ppm = (*drv_set_freq)(current_freq_ppm);
 
+  /* Include the rounding of other frequency changes pending in the update
+     (the compensation is not dispatched to the handlers) */
+  if (update.pending && update.set_freq)
+    update.dfreq = combine_dfreq(update.dfreq, (current_freq_ppm - target_freq_ppm) /
+                                               (1.0e6 - target_freq_ppm));
+
   temp_comp_ppm = (uncomp_freq_ppm - current_freq_ppm) /
     (1.0e-6 * uncomp_freq_ppm + 1.0);
 
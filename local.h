@@ -173,6 +173,16 @@ extern void LCL_NotifyLeap(int leap);
    a slew, in one easy step */
 extern void LCL_AccumulateFrequencyAndOffset(double dfreq, double doffset, double corr_rate);
 
+/* Routines to group changes of the frequency and offset made by the
+   functions above (and LCL_SetTempComp()) into one update of the system
+   driver and one call of the parameter change handlers, which are made
+   when the outermost update is finished.  The cooked time includes the
+   pending offset, but not the pending frequency change.  A step or leap
+   second finishes the pending changes immediately.  Updates can be
+   nested. */
+extern void LCL_BeginUpdate(void);
+extern void LCL_EndUpdate(void);
+
 /* Routine to read the system precision as a log to base 2 value. */
 extern int LCL_GetSysPrecisionAsLog(void);
 
@@ -60,6 +60,11 @@ typedef void (*lcl_SetLeapDriver)(int leap, int tai_offset);
 /* System driver to set the synchronisation status */
 typedef void (*lcl_SetSyncStatusDriver)(int synchronised, double est_error, double max_error);
 
+/* Optional system driver to set the frequency and accrue an offset in
+   one operation.  Return actual frequency as lcl_SetFrequencyDriver. */
+typedef double (*lcl_SetFrequencyAndOffsetDriver)(double freq_ppm, double offset,
+                                                  double corr_rate);
+
 extern void lcl_InvokeDispersionNotifyHandlers(double dispersion);
 
 extern void
@@ -71,4 +76,7 @@ lcl_RegisterSystemDrivers(lcl_ReadFrequencyDriver read_freq,
                           lcl_SetLeapDriver set_leap,
                           lcl_SetSyncStatusDriver set_sync_status);
 
+extern void
+lcl_RegisterSystemUpdateDriver(lcl_SetFrequencyAndOffsetDriver set_freq_and_offset);
+
 #endif /* GOT_LOCALP_H */
@@ -46,6 +46,7 @@
 #include "cmdmon.h"
 #include "keys.h"
 #include "manual.h"
+#include "metrics.h"
 #include "rtc.h"
 #include "refclock.h"
 #include "clientlog.h"
@@ -53,6 +54,7 @@
 #include "privops.h"
 #include "smooth.h"
 #include "tempcomp.h"
+#include "timeexport.h"
 #include "util.h"
 #ifdef HAVE_SYSTEMD
 #include <systemd/sd-daemon.h>
@@ -71,6 +73,12 @@ static int reload = 0;
 
 static REF_Mode ref_mode = REF_ModeNormal;
 
+/* Times of the start and the last completed phase of the initialisation */
+static struct timespec startup_start;
+static struct timespec startup_phase_start;
+
+static RPT_StartupReport startup_report;
+
 /* ================================================== */
 
 static void
@@ -85,6 +93,62 @@ do_platform_checks(void)
 
 /* ================================================== */
 
+static void
+read_startup_time(struct timespec *ts)
+{
+  /* Use a monotonic clock if possible to not be affected by steps of the
+     clock made in the initialisation */
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  if (clock_gettime(CLOCK_MONOTONIC, ts) == 0)
+    return;
+#endif
+  LCL_ReadRawTime(ts);
+}
+
+/* ================================================== */
+
+static void
+start_startup(void)
+{
+  memset(&startup_report, 0, sizeof (startup_report));
+  read_startup_time(&startup_start);
+  startup_phase_start = startup_start;
+}
+
+/* ================================================== */
+
+static void
+end_startup_phase(double *phase_time)
+{
+  struct timespec now;
+
+  read_startup_time(&now);
+
+  *phase_time = UTI_DiffTimespecsToDouble(&now, &startup_phase_start);
+  startup_phase_start = now;
+
+  startup_report.total_time = UTI_DiffTimespecsToDouble(&now, &startup_start);
+
+  CAM_SetStartupReport(&startup_report);
+}
+
+/* ================================================== */
+
+static void
+end_startup(void)
+{
+  startup_report.complete = 1;
+  CAM_SetStartupReport(&startup_report);
+
+  LOG(LOGS_INFO, "Startup completed in %.3f seconds"
+      " (config %.3f init %.3f rtc %.3f initstepslew %.3f resolving %.3f dumps %.3f)",
+      startup_report.total_time, startup_report.config_time, startup_report.init_time,
+      startup_report.rtc_time, startup_report.initstepslew_time,
+      startup_report.resolving_time, startup_report.dumps_time);
+}
+
+/* ================================================== */
+
 static void
 delete_pidfile(void)
 {
@@ -111,6 +175,7 @@ MAI_CleanupAndExit(void)
   /* Don't update clock when removing sources */
   REF_SetMode(REF_ModeIgnore);
 
+  TEX_Finalise();
   SMT_Finalise();
   TMC_Finalise();
   MNL_Finalise();
@@ -120,6 +185,7 @@ MAI_CleanupAndExit(void)
   SST_Finalise();
   NCR_Finalise();
   NIO_Finalise();
+  MET_Finalise();
   CAM_Finalise();
   KEY_Finalise();
   RCL_Finalise();
@@ -166,6 +232,8 @@ ntp_source_resolving_end(void)
 {
   NSR_SetSourceResolvingEndHandler(NULL);
 
+  end_startup_phase(&startup_report.resolving_time);
+
   if (reload) {
     /* Note, we want reload to come well after the initialisation from
        the real time clock - this gives us a fighting chance that the
@@ -174,6 +242,8 @@ ntp_source_resolving_end(void)
     SRC_ReloadSources();
   }
 
+  end_startup_phase(&startup_report.dumps_time);
+
   SRC_RemoveDumpFiles();
   RTC_StartMeasurements();
   RCL_StartRefclocks();
@@ -185,6 +255,8 @@ ntp_source_resolving_end(void)
   if (ref_mode != REF_ModeNormal && !SRC_ActiveSources()) {
     REF_SetUnsynchronised();
   }
+
+  end_startup();
 }
 
 /* ================================================== */
@@ -197,6 +269,8 @@ post_init_ntp_hook(void *anything)
     NSR_RemoveAllSources();
     ref_mode = REF_ModeNormal;
     REF_SetMode(ref_mode);
+
+    end_startup_phase(&startup_report.initstepslew_time);
   }
 
   /* Close the pipe to the foreground process so it can exit */
@@ -237,6 +311,8 @@ reference_mode_end(int result)
 static void
 post_init_rtc_hook(void *anything)
 {
+  end_startup_phase(&startup_report.rtc_time);
+
   if (CNF_GetInitSources() > 0) {
     CNF_AddInitSources();
     NSR_StartSources();
@@ -512,6 +588,8 @@ int main
 
   CNF_Initialise(restarted, client_only);
 
+  start_startup();
+
   /* Parse the config file or the remaining command line arguments */
   config_args = argc - optind;
   if (!config_args) {
@@ -521,6 +599,9 @@ int main
       CNF_ParseLine(NULL, config_args + optind - argc + 1, argv[optind]);
   }
 
+  startup_report.fast_start = CNF_GetFastStart();
+  end_startup_phase(&startup_report.config_time);
+
   /* Check whether another chronyd may already be running */
   check_pidfile();
 
@@ -538,6 +619,7 @@ int main
 
   /* Open privileged ports before dropping root */
   CAM_Initialise(address_family);
+  MET_Initialise(address_family);
   NIO_Initialise(address_family);
   NCR_Initialise();
   CNF_SetupAccessRestrictions();
@@ -576,6 +658,7 @@ int main
   MNL_Initialise();
   TMC_Initialise();
   SMT_Initialise();
+  TEX_Initialise();
 
   /* From now on, it is safe to do finalisation on exit */
   initialised = 1;
@@ -583,6 +666,7 @@ int main
   UTI_SetQuitSignalsHandler(signal_cleanup);
 
   CAM_OpenUnixSocket();
+  MET_OpenUnixSocket();
 
   if (scfilter_level)
     SYS_EnableSystemCallFilter(scfilter_level);
@@ -597,6 +681,8 @@ int main
   if (timeout > 0)
     SCH_AddTimeoutByDelay(timeout, quit_timeout, NULL);
 
+  end_startup_phase(&startup_report.init_time);
+
   if (do_init_rtc) {
     RTC_TimeInit(post_init_rtc_hook, NULL);
   } else {
@@ -0,0 +1,964 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+
+  =======================================================================
+
+  OpenMetrics exporter.  The metrics are rendered from the reports that are
+  provided also to chronyc and they are served over HTTP on a TCP or Unix
+  domain stream socket.  Only one connection is handled at a time and the
+  response is rendered into a buffer allocated on start, so a scrape doesn't
+  allocate memory (unless the number of sources has increased).
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include "metrics.h"
+#include "array.h"
+#include "clientlog.h"
+#include "conf.h"
+#include "logging.h"
+#include "memory.h"
+#include "ntp_sources.h"
+#include "refclock.h"
+#include "reference.h"
+#include "sched.h"
+#include "sources.h"
+#include "util.h"
+
+/* ================================================== */
+
+union sockaddr_all {
+  struct sockaddr_in in4;
+#ifdef FEAT_IPV6
+  struct sockaddr_in6 in6;
+#endif
+  struct sockaddr_un un;
+  struct sockaddr sa;
+};
+
+/* Maximum length of the response including the HTTP header */
+#define MAX_RESPONSE_LENGTH (512 * 1024)
+
+/* Space reserved for the HTTP header in front of the metrics */
+#define MAX_HEADER_LENGTH 256
+
+/* Space reserved for the end of the metrics */
+#define EOF_LENGTH 16
+
+/* Maximum length of the HTTP request */
+#define MAX_REQUEST_LENGTH 1024
+
+/* Maximum time to receive the request and send the response */
+#define CONNECTION_TIMEOUT 10.0
+
+#define MAX_NAME_LENGTH 64
+
+/* Listening sockets */
+static int sock_fd4;
+#ifdef FEAT_IPV6
+static int sock_fd6;
+#endif
+static int sock_fdu;
+
+/* Accepted connection */
+static int conn_fd;
+static SCH_TimeoutID conn_timeout;
+
+static char request[MAX_REQUEST_LENGTH + 1];
+static int request_length;
+
+/* Buffer for the response, the metrics start at MAX_HEADER_LENGTH */
+static char *response;
+static int response_start;
+static int response_end;
+static int response_sent;
+
+/* Current end of metrics and flag indicating that they didn't fit
+   in the buffer */
+static int metrics_length;
+static int metrics_truncated;
+
+/* Reports of sources collected for one scrape */
+struct SourceRecord {
+  char name[MAX_NAME_LENGTH];
+  RPT_SourceReport report;
+  RPT_SourcestatsReport stats;
+  int have_stats;
+};
+
+static ARR_Instance source_records;
+
+static int initialised = 0;
+
+/* ================================================== */
+
+static void accept_connection(int fd, int event, void *anything);
+static void close_connection(void);
+
+/* ================================================== */
+
+static int
+prepare_socket(int family, int port_number)
+{
+  int sock_fd, on_off = 1;
+  socklen_t my_addr_len;
+  union sockaddr_all my_addr;
+  IPAddr bind_address;
+
+  sock_fd = socket(family, SOCK_STREAM, 0);
+  if (sock_fd < 0) {
+    LOG(LOGS_ERR, "Could not open %s metrics socket : %s",
+        UTI_SockaddrFamilyToString(family), strerror(errno));
+    return -1;
+  }
+
+  /* Close on exec */
+  UTI_FdSetCloexec(sock_fd);
+
+  if (family != AF_UNIX) {
+    /* Allow reuse of port number */
+    if (setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, (char *)&on_off, sizeof (on_off)) < 0)
+      LOG(LOGS_ERR, "Could not set reuseaddr socket options");
+
+#ifdef FEAT_IPV6
+#ifdef IPV6_V6ONLY
+    if (family == AF_INET6 &&
+        setsockopt(sock_fd, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&on_off, sizeof (on_off)) < 0)
+      LOG(LOGS_ERR, "Could not request IPV6_V6ONLY socket option");
+#endif
+#endif
+  }
+
+  memset(&my_addr, 0, sizeof (my_addr));
+
+  switch (family) {
+    case AF_INET:
+      my_addr_len = sizeof (my_addr.in4);
+      my_addr.in4.sin_family = family;
+      my_addr.in4.sin_port = htons((unsigned short)port_number);
+
+      CNF_GetBindMetricsAddress(IPADDR_INET4, &bind_address);
+
+      if (bind_address.family == IPADDR_INET4)
+        my_addr.in4.sin_addr.s_addr = htonl(bind_address.addr.in4);
+      else
+        my_addr.in4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      break;
+#ifdef FEAT_IPV6
+    case AF_INET6:
+      my_addr_len = sizeof (my_addr.in6);
+      my_addr.in6.sin6_family = family;
+      my_addr.in6.sin6_port = htons((unsigned short)port_number);
+
+      CNF_GetBindMetricsAddress(IPADDR_INET6, &bind_address);
+
+      if (bind_address.family == IPADDR_INET6)
+        memcpy(my_addr.in6.sin6_addr.s6_addr, bind_address.addr.in6,
+            sizeof (my_addr.in6.sin6_addr.s6_addr));
+      else
+        my_addr.in6.sin6_addr = in6addr_loopback;
+      break;
+#endif
+    case AF_UNIX:
+      my_addr_len = sizeof (my_addr.un);
+      my_addr.un.sun_family = family;
+      if (snprintf(my_addr.un.sun_path, sizeof (my_addr.un.sun_path), "%s",
+                   CNF_GetBindMetricsPath()) >= sizeof (my_addr.un.sun_path))
+        LOG_FATAL("Unix socket path too long");
+      unlink(my_addr.un.sun_path);
+      break;
+    default:
+      assert(0);
+  }
+
+  if (bind(sock_fd, &my_addr.sa, my_addr_len) < 0 || listen(sock_fd, 8) < 0) {
+    LOG(LOGS_ERR, "Could not bind %s metrics socket : %s",
+        UTI_SockaddrFamilyToString(family), strerror(errno));
+    close(sock_fd);
+    return -1;
+  }
+
+  SCH_AddFileHandler(sock_fd, SCH_FILE_INPUT, accept_connection, NULL);
+
+  return sock_fd;
+}
+
+/* ================================================== */
+
+static void
+close_socket(int *fd)
+{
+  if (*fd < 0)
+    return;
+  SCH_RemoveFileHandler(*fd);
+  close(*fd);
+  *fd = -1;
+}
+
+/* ================================================== */
+
+void
+MET_Initialise(int family)
+{
+  int port_number;
+
+  assert(!initialised);
+  initialised = 1;
+
+  sock_fd4 = -1;
+#ifdef FEAT_IPV6
+  sock_fd6 = -1;
+#endif
+  sock_fdu = -1;
+  conn_fd = -1;
+  conn_timeout = 0;
+  response = NULL;
+  source_records = NULL;
+
+  port_number = CNF_GetMetricsPort();
+
+  if (!port_number && !CNF_GetBindMetricsPath()[0])
+    return;
+
+  response = Malloc(MAX_RESPONSE_LENGTH);
+  source_records = ARR_CreateInstance(sizeof (struct SourceRecord));
+
+  if (!port_number)
+    return;
+
+  if (family == IPADDR_UNSPEC || family == IPADDR_INET4)
+    sock_fd4 = prepare_socket(AF_INET, port_number);
+#ifdef FEAT_IPV6
+  if (family == IPADDR_UNSPEC || family == IPADDR_INET6)
+    sock_fd6 = prepare_socket(AF_INET6, port_number);
+#endif
+
+  if (sock_fd4 < 0
+#ifdef FEAT_IPV6
+      && sock_fd6 < 0
+#endif
+      ) {
+    LOG_FATAL("Could not open any metrics socket");
+  }
+}
+
+/* ================================================== */
+
+void
+MET_Finalise(void)
+{
+  close_connection();
+
+  if (sock_fdu >= 0) {
+    close_socket(&sock_fdu);
+    unlink(CNF_GetBindMetricsPath());
+  }
+  close_socket(&sock_fd4);
+#ifdef FEAT_IPV6
+  close_socket(&sock_fd6);
+#endif
+
+  Free(response);
+  if (source_records)
+    ARR_DestroyInstance(source_records);
+
+  initialised = 0;
+}
+
+/* ================================================== */
+
+void
+MET_OpenUnixSocket(void)
+{
+  /* This is separated from MET_Initialise() as it needs to be called when
+     the process has already dropped the root privileges */
+  if (CNF_GetBindMetricsPath()[0])
+    sock_fdu = prepare_socket(AF_UNIX, 0);
+}
+
+/* ================================================== */
+
+static void
+add_text(const char *format, ...)
+{
+  int max_length, length;
+  va_list ap;
+
+  if (metrics_truncated)
+    return;
+
+  max_length = MAX_RESPONSE_LENGTH - EOF_LENGTH - metrics_length;
+
+  va_start(ap, format);
+  length = vsnprintf(response + metrics_length, max_length, format, ap);
+  va_end(ap);
+
+  /* Drop incomplete lines and everything after them */
+  if (length < 0 || length >= max_length) {
+    while (metrics_length > MAX_HEADER_LENGTH && response[metrics_length - 1] != '\n')
+      metrics_length--;
+    metrics_truncated = 1;
+    return;
+  }
+
+  metrics_length += length;
+}
+
+/* ================================================== */
+
+/* Copy a label value to a buffer with backslashes, double quotes and
+   newlines escaped as required by the text format */
+
+static void
+escape_label_value(char *buf, int size, const char *value)
+{
+  int i;
+
+  for (i = 0; *value && i + 2 < size; value++) {
+    switch (*value) {
+      case '\\':
+      case '"':
+        buf[i++] = '\\';
+        buf[i++] = *value;
+        break;
+      case '\n':
+        buf[i++] = '\\';
+        buf[i++] = 'n';
+        break;
+      default:
+        buf[i++] = *value;
+        break;
+    }
+  }
+
+  buf[i] = '\0';
+}
+
+/* ================================================== */
+
+static void
+add_family(const char *name, const char *type, const char *help)
+{
+  add_text("# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+/* ================================================== */
+
+static void
+add_gauge(const char *name, const char *help, double value)
+{
+  add_family(name, "gauge", help);
+  add_text("%s %.15g\n", name, value);
+}
+
+/* ================================================== */
+
+static void
+add_counter(const char *name, const char *help, unsigned long value)
+{
+  add_family(name, "counter", help);
+  add_text("%s_total %lu\n", name, value);
+}
+
+/* ================================================== */
+
+static const char * 
+get_leap_name(NTP_Leap leap)
+{
+  switch (leap) {
+    case LEAP_Normal:
+      return "normal";
+    case LEAP_InsertSecond:
+      return "insert";
+    case LEAP_DeleteSecond:
+      return "delete";
+    default:
+      return "unsynchronised";
+  }
+}
+
+/* ================================================== */
+
+static void
+render_tracking(void)
+{
+  RPT_TrackingReport rpt;
+  char name[MAX_NAME_LENGTH];
+
+  REF_GetTrackingReport(&rpt);
+
+  if (rpt.ip_addr.family != IPADDR_UNSPEC)
+    escape_label_value(name, sizeof (name), UTI_IPToString(&rpt.ip_addr));
+  else
+    escape_label_value(name, sizeof (name), UTI_RefidToString(rpt.ref_id));
+
+  add_family("chrony_tracking", "info", "Reference of the system clock");
+  add_text("chrony_tracking_info{ref_id=\"%08"PRIX32"\",name=\"%s\",leap=\"%s\"} 1\n",
+           rpt.ref_id, name, get_leap_name(rpt.leap_status));
+  add_gauge("chrony_tracking_stratum", "Stratum of the system clock", rpt.stratum);
+  add_gauge("chrony_tracking_reference_time_seconds", "Time of the last update",
+            UTI_TimespecToDouble(&rpt.ref_time));
+  add_gauge("chrony_tracking_system_time_seconds",
+            "Offset of the system clock being corrected", rpt.current_correction);
+  add_gauge("chrony_tracking_last_offset_seconds",
+            "Offset of the last update", rpt.last_offset);
+  add_gauge("chrony_tracking_rms_offset_seconds",
+            "Long-term average of the offset", rpt.rms_offset);
+  add_gauge("chrony_tracking_frequency_ppm",
+            "Frequency error of the system clock", rpt.freq_ppm);
+  add_gauge("chrony_tracking_residual_frequency_ppm",
+            "Residual frequency of the reference", rpt.resid_freq_ppm);
+  add_gauge("chrony_tracking_skew_ppm", "Error bound of the frequency", rpt.skew_ppm);
+  add_gauge("chrony_tracking_root_delay_seconds", "Root delay", rpt.root_delay);
+  add_gauge("chrony_tracking_root_dispersion_seconds", "Root dispersion",
+            rpt.root_dispersion);
+  add_gauge("chrony_tracking_update_interval_seconds",
+            "Interval between the last two updates", rpt.last_update_interval);
+}
+
+/* ================================================== */
+
+static const char * 
+get_state_name(RPT_SourceReport *report)
+{
+  switch (report->state) {
+    case RPT_SYNC:
+      return "sync";
+    case RPT_UNREACH:
+      return "unreachable";
+    case RPT_FALSETICKER:
+      return "falseticker";
+    case RPT_JITTERY:
+      return "jittery";
+    case RPT_CANDIDATE:
+      return "candidate";
+    case RPT_OUTLIER:
+      return "outlier";
+    default:
+      return "unknown";
+  }
+}
+
+/* ================================================== */
+
+static const char * 
+get_mode_name(RPT_SourceReport *report)
+{
+  switch (report->mode) {
+    case RPT_NTP_CLIENT:
+      return "client";
+    case RPT_NTP_PEER:
+      return "peer";
+    case RPT_LOCAL_REFERENCE:
+      return "refclock";
+    default:
+      return "unknown";
+  }
+}
+
+/* ================================================== */
+
+static int
+collect_sources(struct timespec *now)
+{
+  struct SourceRecord *record;
+  int i, j, n_sources;
+
+  n_sources = SRC_ReadNumberOfSources();
+
+  /* The array is only extended, the records are reused in next scrapes */
+  if (ARR_GetSize(source_records) < n_sources)
+    ARR_SetSize(source_records, n_sources);
+
+  for (i = j = 0; i < n_sources; i++) {
+    record = ARR_GetElement(source_records, j);
+
+    if (!SRC_ReportSource(i, &record->report, now))
+      continue;
+
+    switch (SRC_GetType(i)) {
+      case SRC_NTP:
+        NSR_ReportSource(&record->report, now);
+        break;
+      case SRC_REFCLOCK:
+        RCL_ReportSource(&record->report, now);
+        break;
+    }
+
+    if (record->report.mode == RPT_LOCAL_REFERENCE)
+      escape_label_value(record->name, sizeof (record->name),
+                         UTI_RefidToString(record->report.ip_addr.addr.in4));
+    else
+      escape_label_value(record->name, sizeof (record->name),
+                         UTI_IPToString(&record->report.ip_addr));
+
+    record->have_stats = SRC_ReportSourcestats(i, &record->stats, now);
+    j++;
+  }
+
+  return j;
+}
+
+/* ================================================== */
+
+typedef enum {
+  SM_STRATUM,
+  SM_POLL,
+  SM_REACHABILITY,
+  SM_LAST_SAMPLE_AGE,
+  SM_LAST_SAMPLE_OFFSET,
+  SM_LAST_SAMPLE_ERROR,
+  SM_SAMPLES,
+  SM_RUNS,
+  SM_SPAN,
+  SM_FREQUENCY,
+  SM_SKEW,
+  SM_OFFSET,
+  SM_STDDEV,
+} SourceMetric;
+
+static const struct {
+  SourceMetric metric;
+  const char *name;
+  const char *help;
+} source_metrics[] = {
+  { SM_STRATUM, "chrony_source_stratum", "Stratum of the source" },
+  { SM_POLL, "chrony_source_poll_log2_seconds", "Polling interval" },
+  { SM_REACHABILITY, "chrony_source_reachability", "Reachability register" },
+  { SM_LAST_SAMPLE_AGE, "chrony_source_last_sample_age_seconds",
+    "Time since the last sample" },
+  { SM_LAST_SAMPLE_OFFSET, "chrony_source_last_sample_offset_seconds",
+    "Offset of the last sample" },
+  { SM_LAST_SAMPLE_ERROR, "chrony_source_last_sample_error_seconds",
+    "Error bound of the last sample" },
+  { SM_SAMPLES, "chrony_sourcestats_samples", "Number of retained samples" },
+  { SM_RUNS, "chrony_sourcestats_runs", "Number of runs of residuals" },
+  { SM_SPAN, "chrony_sourcestats_span_seconds",
+    "Interval between the oldest and newest sample" },
+  { SM_FREQUENCY, "chrony_sourcestats_frequency_ppm", "Estimated residual frequency" },
+  { SM_SKEW, "chrony_sourcestats_skew_ppm", "Error bound of the frequency" },
+  { SM_OFFSET, "chrony_sourcestats_offset_seconds", "Estimated offset" },
+  { SM_STDDEV, "chrony_sourcestats_stddev_seconds", "Estimated sample standard deviation" },
+};
+
+static int
+get_source_metric(struct SourceRecord *record, SourceMetric metric, double *value)
+{
+  RPT_SourceReport *r = &record->report;
+  RPT_SourcestatsReport *s = &record->stats;
+
+  switch (metric) {
+    case SM_STRATUM:
+      *value = r->stratum;
+      return 1;
+    case SM_POLL:
+      *value = r->poll;
+      return 1;
+    case SM_REACHABILITY:
+      *value = r->reachability;
+      return 1;
+    case SM_LAST_SAMPLE_AGE:
+      *value = r->latest_meas_ago;
+      return r->latest_meas_ago != (uint32_t)-1;
+    case SM_LAST_SAMPLE_OFFSET:
+      *value = r->latest_meas;
+      return 1;
+    case SM_LAST_SAMPLE_ERROR:
+      *value = r->latest_meas_err;
+      return 1;
+    default:
+      break;
+  }
+
+  if (!record->have_stats)
+    return 0;
+
+  switch (metric) {
+    case SM_SAMPLES:
+      *value = s->n_samples;
+      break;
+    case SM_RUNS:
+      *value = s->n_runs;
+      break;
+    case SM_SPAN:
+      *value = s->span_seconds;
+      break;
+    case SM_FREQUENCY:
+      *value = s->resid_freq_ppm;
+      break;
+    case SM_SKEW:
+      *value = s->skew_ppm;
+      break;
+    case SM_OFFSET:
+      *value = s->est_offset;
+      break;
+    case SM_STDDEV:
+      *value = s->sd;
+      break;
+    default:
+      assert(0);
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+static void
+render_sources(void)
+{
+  struct SourceRecord *record;
+  struct timespec now;
+  int i, j, n_sources;
+  double value;
+
+  SCH_GetLastEventTime(&now, NULL, NULL);
+  n_sources = collect_sources(&now);
+
+  add_family("chrony_source", "info", "Mode and selection state of the source");
+  for (i = 0; i < n_sources; i++) {
+    record = ARR_GetElement(source_records, i);
+    add_text("chrony_source_info{source=\"%s\",mode=\"%s\",state=\"%s\"} 1\n",
+             record->name, get_mode_name(&record->report),
+             get_state_name(&record->report));
+  }
+
+  for (j = 0; j < sizeof (source_metrics) / sizeof (source_metrics[0]); j++) {
+    add_family(source_metrics[j].name, "gauge", source_metrics[j].help);
+    for (i = 0; i < n_sources; i++) {
+      record = ARR_GetElement(source_records, i);
+      if (!get_source_metric(record, source_metrics[j].metric, &value))
+        continue;
+      add_text("%s{source=\"%s\"} %.15g\n", source_metrics[j].name, record->name, value);
+    }
+  }
+}
+
+/* ================================================== */
+
+static void
+render_server_stats(void)
+{
+  RPT_ServerStatsReport report;
+
+  CLG_GetServerStatsReport(&report);
+
+  add_counter("chrony_server_ntp_packets_received", "Received valid NTP requests",
+              report.ntp_hits);
+  add_counter("chrony_server_ntp_packets_dropped", "Dropped NTP requests",
+              report.ntp_drops);
+  add_counter("chrony_server_command_packets_received", "Received command requests",
+              report.cmd_hits);
+  add_counter("chrony_server_command_packets_dropped", "Dropped command requests",
+              report.cmd_drops);
+  add_counter("chrony_server_client_log_records_dropped",
+              "Client log records dropped due to memory limit", report.log_drops);
+  add_counter("chrony_server_ntp_interleaved_hits",
+              "NTP requests answered in the interleaved mode", report.ntp_interleaved_hits);
+  add_counter("chrony_server_ntp_interleaved_misses",
+              "Interleaved NTP requests missing transmit timestamp", report.ntp_interleaved_misses);
+  add_gauge("chrony_server_ntp_timestamps", "Timestamps held for the interleaved mode",
+            report.ntp_timestamps);
+  add_family("chrony_server_client_log_records", "gauge", "Used client log records");
+  add_text("chrony_server_client_log_records{family=\"ipv4\"} %lu\n",
+           (unsigned long)report.log_records_ipv4);
+  add_text("chrony_server_client_log_records{family=\"ipv6\"} %lu\n",
+           (unsigned long)report.log_records_ipv6);
+  add_family("chrony_server_client_log_capacity", "gauge", "Allocated client log records");
+  add_text("chrony_server_client_log_capacity{family=\"ipv4\"} %lu\n",
+           (unsigned long)report.log_records_ipv4_size);
+  add_text("chrony_server_client_log_capacity{family=\"ipv6\"} %lu\n",
+           (unsigned long)report.log_records_ipv6_size);
+}
+
+/* ================================================== */
+
+static void
+render_activity(void)
+{
+  RPT_ActivityReport report;
+
+  NSR_GetActivityReport(&report);
+
+  add_gauge("chrony_sources_online", "Sources which are online", report.online);
+  add_gauge("chrony_sources_offline", "Sources which are offline", report.offline);
+  add_gauge("chrony_sources_burst_online",
+            "Sources doing burst and returning to online", report.burst_online);
+  add_gauge("chrony_sources_burst_offline",
+            "Sources doing burst and returning to offline", report.burst_offline);
+  add_gauge("chrony_sources_unresolved", "Sources with unknown address",
+            report.unresolved);
+}
+
+/* ================================================== */
+
+static void
+add_histogram_samples(const char *name, const char *labels, RPT_SchedReport *report)
+{
+  unsigned long sum;
+  int i;
+
+  for (i = sum = 0; i < RPT_SCHED_HISTOGRAM_BUCKETS - 1; i++) {
+    sum += report->histogram[i];
+    add_text("%s_bucket{%s%sle=\"%.15g\"} %lu\n", name, labels, labels[0] ? "," : "",
+             ldexp(1.0e-6, i), sum);
+  }
+
+  add_text("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, labels[0] ? "," : "",
+           (unsigned long)report->calls);
+  add_text("%s_count%s%s%s %lu\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+           (unsigned long)report->calls);
+  add_text("%s_sum%s%s%s %.15g\n", name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+           report->total_time);
+}
+
+/* ================================================== */
+
+static void
+render_scheduler(void)
+{
+  RPT_SchedReport report;
+  char labels[MAX_NAME_LENGTH + 32], name[MAX_NAME_LENGTH];
+  int i;
+
+  add_family("chrony_scheduler_lag_seconds", "histogram",
+             "Delay of dispatched timeouts after their scheduled time");
+  if (SCH_GetReport(0, &report))
+    add_histogram_samples("chrony_scheduler_lag_seconds", "", &report);
+
+  add_family("chrony_scheduler_handler_seconds", "histogram",
+             "Execution time of timeout and file handlers");
+  for (i = 1; SCH_GetReport(i, &report); i++) {
+    escape_label_value(name, sizeof (name), report.name);
+    snprintf(labels, sizeof (labels), "handler=\"%s\",type=\"%s\"", name,
+             report.type == RPT_SCHED_TIMEOUT ? "timeout" : "file");
+    add_histogram_samples("chrony_scheduler_handler_seconds", labels, &report);
+  }
+}
+
+/* ================================================== */
+
+static void
+render_slots(void)
+{
+  RPT_SlotReport report;
+  char name[MAX_NAME_LENGTH];
+  int i;
+
+  add_family("chrony_scheduler_slot_timeouts", "gauge",
+             "Timeouts holding a slot in the calendar");
+  for (i = 0; SCH_GetSlotReport(i, &report); i++) {
+    escape_label_value(name, sizeof (name), report.name);
+    add_text("chrony_scheduler_slot_timeouts{calendar=\"%s\"} %lu\n", name,
+             (unsigned long)report.timeouts);
+  }
+
+  add_family("chrony_scheduler_slot_width_seconds", "gauge",
+             "Width of the last assigned slot");
+  for (i = 0; SCH_GetSlotReport(i, &report); i++) {
+    escape_label_value(name, sizeof (name), report.name);
+    add_text("chrony_scheduler_slot_width_seconds{calendar=\"%s\"} %.15g\n", name,
+             report.slot);
+  }
+
+  add_family("chrony_scheduler_slot_load", "gauge",
+             "Fraction of the intervals occupied by the slots");
+  for (i = 0; SCH_GetSlotReport(i, &report); i++) {
+    escape_label_value(name, sizeof (name), report.name);
+    add_text("chrony_scheduler_slot_load{calendar=\"%s\"} %.15g\n", name,
+             report.load);
+  }
+
+  add_family("chrony_scheduler_slot_delayed_timeouts", "counter",
+             "Timeouts delayed to a later free slot");
+  for (i = 0; SCH_GetSlotReport(i, &report); i++) {
+    escape_label_value(name, sizeof (name), report.name);
+    add_text("chrony_scheduler_slot_delayed_timeouts_total{calendar=\"%s\"} %lu\n",
+             name, (unsigned long)report.delayed);
+  }
+}
+
+/* ================================================== */
+
+static void
+render_response(int ok)
+{
+  char header[MAX_HEADER_LENGTH];
+  int header_length;
+
+  metrics_length = MAX_HEADER_LENGTH;
+  metrics_truncated = 0;
+
+  if (ok) {
+    render_tracking();
+    render_sources();
+    render_server_stats();
+    render_activity();
+    render_scheduler();
+    render_slots();
+
+    if (metrics_truncated)
+      LOG(LOGS_WARN, "Metrics truncated to %d bytes", metrics_length - MAX_HEADER_LENGTH);
+
+    metrics_length += snprintf(response + metrics_length, EOF_LENGTH, "# EOF\n");
+
+    header_length = snprintf(header, sizeof (header),
+                             "HTTP/1.0 200 OK\r\n"
+                             "Content-Type: application/openmetrics-text; "
+                             "version=1.0.0; charset=utf-8\r\n"
+                             "Content-Length: %d\r\n\r\n",
+                             metrics_length - MAX_HEADER_LENGTH);
+  } else {
+    header_length = snprintf(header, sizeof (header),
+                             "HTTP/1.0 400 Bad Request\r\n"
+                             "Content-Length: 0\r\n\r\n");
+  }
+
+  assert(header_length > 0 && header_length < MAX_HEADER_LENGTH);
+
+  response_start = MAX_HEADER_LENGTH - header_length;
+  memcpy(response + response_start, header, header_length);
+  response_end = metrics_length;
+  response_sent = response_start;
+}
+
+/* ================================================== */
+
+static void
+close_connection(void)
+{
+  if (conn_fd < 0)
+    return;
+
+  SCH_RemoveTimeout(conn_timeout);
+  conn_timeout = 0;
+  close_socket(&conn_fd);
+}
+
+/* ================================================== */
+
+static void
+handle_timeout(void *arg)
+{
+  conn_timeout = 0;
+  DEBUG_LOG("Metrics connection timed out");
+  close_connection();
+}
+
+/* ================================================== */
+
+static void
+write_response(int fd, int event, void *anything)
+{
+  int r;
+
+  r = send(fd, response + response_sent, response_end - response_sent, MSG_NOSIGNAL);
+
+  if (r < 0) {
+    if (errno == EAGAIN || errno == EINTR)
+      return;
+    DEBUG_LOG("Could not send metrics : %s", strerror(errno));
+    close_connection();
+    return;
+  }
+
+  response_sent += r;
+
+  if (response_sent >= response_end)
+    close_connection();
+}
+
+/* ================================================== */
+
+static void
+read_request(int fd, int event, void *anything)
+{
+  int r;
+
+  r = recv(fd, request + request_length, MAX_REQUEST_LENGTH - request_length, 0);
+
+  if (r <= 0) {
+    if (r < 0 && (errno == EAGAIN || errno == EINTR))
+      return;
+    close_connection();
+    return;
+  }
+
+  request_length += r;
+  request[request_length] = '\0';
+
+  /* Wait for the end of the header */
+  if (!strstr(request, "\r\n\r\n") && !strstr(request, "\n\n") &&
+      request_length < MAX_REQUEST_LENGTH)
+    return;
+
+  render_response(strncmp(request, "GET ", 4) == 0);
+
+  SCH_RemoveFileHandler(fd);
+  SCH_AddFileHandler(fd, SCH_FILE_OUTPUT, write_response, NULL);
+}
+
+/* ================================================== */
+
+static void
+accept_connection(int fd, int event, void *anything)
+{
+  int new_fd;
+#ifndef HAVE_ACCEPT4
+  int flags;
+#endif
+
+#ifdef HAVE_ACCEPT4
+  new_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+  new_fd = accept(fd, NULL, NULL);
+#endif
+  if (new_fd < 0) {
+    DEBUG_LOG("Could not accept metrics connection : %s", strerror(errno));
+    return;
+  }
+
+  /* Only one connection is handled at a time */
+  if (conn_fd >= 0) {
+    DEBUG_LOG("Metrics connection refused");
+    close(new_fd);
+    return;
+  }
+
+#ifndef HAVE_ACCEPT4
+  UTI_FdSetCloexec(new_fd);
+
+  flags = fcntl(new_fd, F_GETFL);
+  if (flags < 0 || fcntl(new_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    LOG(LOGS_ERR, "Could not set O_NONBLOCK : %s", strerror(errno));
+    close(new_fd);
+    return;
+  }
+#endif
+
+  conn_fd = new_fd;
+  request_length = 0;
+  conn_timeout = SCH_AddTimeoutByDelay(CONNECTION_TIMEOUT, handle_timeout, NULL);
+
+  SCH_AddFileHandler(conn_fd, SCH_FILE_INPUT, read_request, NULL);
+}
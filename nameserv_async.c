@@ -53,6 +53,12 @@ struct DNS_Async_Instance {
 
 static int resolving_threads = 0;
 
+#ifdef PRIVOPS_NAME2IPADDRESS
+/* The helper process handles only one request at a time.  Lookups made
+   without the helper can run concurrently. */
+static pthread_mutex_t privops_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /* ================================================== */
 
 static void *
@@ -60,7 +66,17 @@ start_resolving(void *anything)
 {
   struct DNS_Async_Instance *inst = (struct DNS_Async_Instance *)anything;
 
+#ifdef PRIVOPS_NAME2IPADDRESS
+  if (PRV_IsHelperRunning()) {
+    pthread_mutex_lock(&privops_lock);
+    inst->status = PRV_Name2IPAddress(inst->name, inst->addresses, DNS_MAX_ADDRESSES);
+    pthread_mutex_unlock(&privops_lock);
+  } else {
+    inst->status = DNS_Name2IPAddress(inst->name, inst->addresses, DNS_MAX_ADDRESSES);
+  }
+#else
   inst->status = PRV_Name2IPAddress(inst->name, inst->addresses, DNS_MAX_ADDRESSES);
+#endif
 
   /* Notify the main thread that the result is ready */
   if (write(inst->pipe[1], "", 1) < 0)
@@ -117,7 +133,7 @@ DNS_Name2IPAddressAsync(const char *name, DNS_NameResolveHandler handler, void *
   UTI_FdSetCloexec(inst->pipe[1]);
 
   resolving_threads++;
-  assert(resolving_threads <= 1);
+  assert(resolving_threads <= DNS_MAX_ASYNC_REQUESTS);
 
   if (pthread_create(&inst->thread, NULL, start_resolving, inst)) {
     LOG_FATAL("pthread_create() failed");
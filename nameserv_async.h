@@ -33,6 +33,9 @@
 /* Function type for callback to process the result */
 typedef void (*DNS_NameResolveHandler)(DNS_Status status, int n_addrs, IPAddr *ip_addrs, void *anything);
 
+/* Maximum number of concurrent requests */
+#define DNS_MAX_ASYNC_REQUESTS 16
+
 /* Request resolving of a name to IP address. The handler will be
    called when the result is available. */
 extern void DNS_Name2IPAddressAsync(const char *name, DNS_NameResolveHandler handler, void *anything);
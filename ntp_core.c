@@ -45,6 +45,7 @@
 #include "keys.h"
 #include "addrfilt.h"
 #include "clientlog.h"
+#include "cmdparse.h"
 
 /* ================================================== */
 
@@ -72,6 +73,23 @@ typedef enum {
   AUTH_MSSNTP_EXT,              /* MS-SNTP extended authenticator field */
 } AuthenticationMode;
 
+/* ================================================== */
+/* Number of measurements kept for a monitor-only source */
+#define MONITOR_SAMPLES 8
+
+/* Compact register of the latest measurements of a source which is only
+   monitored.  It replaces the source and sourcestats instances, which are
+   needed only for sources taking part in the source selection. */
+
+typedef struct {
+  struct timespec times[MONITOR_SAMPLES];
+  float offsets[MONITOR_SAMPLES];
+  float delays[MONITOR_SAMPLES];
+  int last_sample;
+  int n_samples;
+  int reachability;
+} MonitorData;
+
 /* ================================================== */
 /* Structure used for holding a single peer/server's
    protocol machine */
@@ -184,10 +202,14 @@ struct NCR_Instance_Record {
   unsigned int prev_tx_count;
 
   /* The instance record in the main source management module.  This
-     performs the statistical analysis on the samples we generate */
+     performs the statistical analysis on the samples we generate.  It is
+     NULL if the source is only monitored. */
 
   SRC_Instance source;
 
+  /* Register of measurements of a monitor-only source, or NULL */
+  MonitorData *monitor;
+
   int burst_good_samples_to_go;
   int burst_total_samples_to_go;
 
@@ -287,6 +309,24 @@ static int server_sock_fd6;
 
 static ADF_AuthTable access_auth_table;
 
+/* Access restrictions in the order in which they were added.  The table
+   needs to be rebuilt from them when the subnet files are reloaded. */
+typedef struct {
+  IPAddr ip_addr;
+  int subnet_bits;
+  int allow;
+  int all;
+  char *file;
+} AccessRestriction;
+
+/* Array of AccessRestriction */
+static ARR_Instance access_restrictions;
+
+/* Table and restrictions which are used until new restrictions are
+   committed by NCR_EndAccessRestrictions() */
+static ADF_AuthTable saved_access_auth_table;
+static ARR_Instance saved_access_restrictions;
+
 /* Characters for printing synchronisation status and timestamping source */
 static const char leap_chars[4] = {'N', '+', '-', '?'};
 static const char tss_chars[3] = {'D', 'K', 'H'};
@@ -371,6 +411,55 @@ zero_local_timestamp(NTP_Local_Timestamp *ts)
 
 /* ================================================== */
 
+static void
+reset_monitor(MonitorData *monitor)
+{
+  monitor->last_sample = MONITOR_SAMPLES - 1;
+  monitor->n_samples = 0;
+  monitor->reachability = 0;
+}
+
+/* ================================================== */
+
+static void
+accumulate_monitor_sample(MonitorData *monitor, struct timespec *sample_time,
+                          double offset, double delay)
+{
+  monitor->last_sample = (monitor->last_sample + 1) % MONITOR_SAMPLES;
+  monitor->times[monitor->last_sample] = *sample_time;
+  monitor->offsets[monitor->last_sample] = offset;
+  monitor->delays[monitor->last_sample] = delay;
+
+  if (monitor->n_samples < MONITOR_SAMPLES)
+    monitor->n_samples++;
+}
+
+/* ================================================== */
+
+static void
+update_reachability(NCR_Instance inst, int reachable)
+{
+  if (inst->source) {
+    SRC_UpdateReachability(inst->source, reachable);
+  } else {
+    inst->monitor->reachability = (inst->monitor->reachability << 1 | !!reachable) %
+                                  (1U << SOURCE_REACH_BITS);
+  }
+}
+
+/* ================================================== */
+
+static int
+is_reachable(NCR_Instance inst)
+{
+  if (inst->source)
+    return SRC_IsReachable(inst->source);
+
+  return inst->monitor->reachability != 0;
+}
+
+/* ================================================== */
+
 void
 NCR_Initialise(void)
 {
@@ -382,6 +471,10 @@ NCR_Initialise(void)
     : -1;
 
   access_auth_table = ADF_CreateTable();
+  NIO_SetServerFilter(access_auth_table);
+  access_restrictions = ARR_CreateInstance(sizeof (AccessRestriction));
+  saved_access_auth_table = NULL;
+  saved_access_restrictions = NULL;
   broadcasts = ARR_CreateInstance(sizeof (BroadcastDestination));
 
   /* Server socket will be opened when access is allowed */
@@ -391,6 +484,18 @@ NCR_Initialise(void)
 
 /* ================================================== */
 
+static void
+destroy_access_restrictions(ARR_Instance restrictions)
+{
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(restrictions); i++)
+    Free(((AccessRestriction *)ARR_GetElement(restrictions, i))->file);
+  ARR_DestroyInstance(restrictions);
+}
+
+/* ================================================== */
+
 void
 NCR_Finalise(void)
 {
@@ -405,6 +510,11 @@ NCR_Finalise(void)
     NIO_CloseServerSocket(((BroadcastDestination *)ARR_GetElement(broadcasts, i))->local_addr.sock_fd);
 
   ARR_DestroyInstance(broadcasts);
+
+  if (saved_access_auth_table)
+    NCR_EndAccessRestrictions(0);
+
+  destroy_access_restrictions(access_restrictions);
   ADF_DestroyTable(access_auth_table);
 }
 
@@ -424,12 +534,17 @@ restart_timeout(NCR_Instance inst, double delay)
   inst->rx_timeout_id = 0;
   SCH_RemoveTimeout(inst->tx_timeout_id);
 
-  /* Start new timer for transmission */
-  inst->tx_timeout_id = SCH_AddTimeoutInClass(delay, get_separation(inst->local_poll),
-                                              SAMPLING_RANDOMNESS,
-                                              inst->mode == MODE_CLIENT ?
-                                                SCH_NtpClientClass : SCH_NtpPeerClass,
-                                              transmit_timeout, (void *)inst);
+  /* Start new timer for transmission.  Sources of the same address family
+     share a socket (or probably an interface with separate client sockets),
+     so their transmissions are spread over slots in a common calendar. */
+  inst->tx_timeout_id = SCH_AddTimeoutInSlot(delay, get_separation(inst->local_poll),
+                                             UTI_Log2ToDouble(inst->local_poll),
+                                             SAMPLING_RANDOMNESS,
+                                             inst->mode == MODE_CLIENT ?
+                                               SCH_NtpClientClass : SCH_NtpPeerClass,
+                                             inst->remote_addr.ip_addr.family == IPADDR_INET6 ?
+                                               "IPv6" : "IPv4",
+                                             transmit_timeout, (void *)inst);
 }
 
 /* ================================================== */
@@ -444,7 +559,8 @@ start_initial_timeout(NCR_Instance inst)
     /* This will be the first transmission after mode change */
 
     /* Mark source active */
-    SRC_SetActive(inst->source);
+    if (inst->source)
+      SRC_SetActive(inst->source);
   }
 
   /* In case the offline period was too short, adjust the delay to keep
@@ -485,11 +601,15 @@ take_offline(NCR_Instance inst)
   SCH_RemoveTimeout(inst->tx_timeout_id);
   inst->tx_timeout_id = 0;
 
-  /* Mark source unreachable */
-  SRC_ResetReachability(inst->source);
+  if (inst->source) {
+    /* Mark source unreachable */
+    SRC_ResetReachability(inst->source);
 
-  /* And inactive */
-  SRC_UnsetActive(inst->source);
+    /* And inactive */
+    SRC_UnsetActive(inst->source);
+  } else {
+    inst->monitor->reachability = 0;
+  }
 
   close_client_socket(inst);
 
@@ -581,12 +701,20 @@ NCR_GetInstance(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourcePar
   if (params->version)
     result->version = CLAMP(NTP_MIN_COMPAT_VERSION, params->version, NTP_VERSION);
 
-  /* Create a source instance for this NTP source */
-  result->source = SRC_CreateNewInstance(UTI_IPToRefid(&remote_addr->ip_addr),
-                                         SRC_NTP, params->sel_options,
-                                         &result->remote_addr.ip_addr,
-                                         params->min_samples, params->max_samples,
-                                         params->min_delay, params->asymmetry);
+  if (params->monitor) {
+    /* A monitored source doesn't need the source and sourcestats instances */
+    result->source = NULL;
+    result->monitor = MallocNew(MonitorData);
+    reset_monitor(result->monitor);
+  } else {
+    /* Create a source instance for this NTP source */
+    result->source = SRC_CreateNewInstance(UTI_IPToRefid(&remote_addr->ip_addr),
+                                           SRC_NTP, params->sel_options,
+                                           &result->remote_addr.ip_addr,
+                                           params->min_samples, params->max_samples,
+                                           params->min_delay, params->asymmetry);
+    result->monitor = NULL;
+  }
 
   result->rx_timeout_id = 0;
   result->tx_timeout_id = 0;
@@ -623,9 +751,11 @@ NCR_DestroyInstance(NCR_Instance instance)
   /* This will destroy the source instance inside the
      structure, which will cause reselection if this was the
      synchronising source etc. */
-  SRC_DestroyInstance(instance->source);
+  if (instance->source)
+    SRC_DestroyInstance(instance->source);
 
   /* Free the data structure */
+  Free(instance->monitor);
   Free(instance);
 }
 
@@ -697,9 +827,13 @@ NCR_ChangeRemoteAddress(NCR_Instance inst, NTP_Remote_Address *remote_addr)
   }
 
   /* Update the reference ID and reset the source/sourcestats instances */
-  SRC_SetRefid(inst->source, UTI_IPToRefid(&remote_addr->ip_addr),
-               &inst->remote_addr.ip_addr);
-  SRC_ResetInstance(inst->source);
+  if (inst->source) {
+    SRC_SetRefid(inst->source, UTI_IPToRefid(&remote_addr->ip_addr),
+                 &inst->remote_addr.ip_addr);
+    SRC_ResetInstance(inst->source);
+  } else {
+    reset_monitor(inst->monitor);
+  }
 }
 
 /* ================================================== */
@@ -740,7 +874,8 @@ get_poll_adj(NCR_Instance inst, double error_in_estimate, double peer_distance)
   if (error_in_estimate > peer_distance) {
     poll_adj = -log(error_in_estimate / peer_distance) / log(2.0);
   } else {
-    samples = SST_Samples(SRC_GetSourcestats(inst->source));
+    samples = inst->source ? SST_Samples(SRC_GetSourcestats(inst->source)) :
+                             inst->monitor->n_samples;
 
     /* Adjust polling interval so that the number of sourcestats samples
        remains close to the target value */
@@ -1060,7 +1195,14 @@ transmit_packet(NTP_Mode my_mode, /* The mode this machine wants to be */
   } while (!UTI_CompareNtp64(&message.transmit_ts, &message.receive_ts) &&
            !UTI_IsZeroNtp64(&message.transmit_ts));
 
-  ret = NIO_SendPacket(&message, where_to, from, length, local_tx != NULL);
+  /* Client packets can be sent in a batch with other packets transmitted
+     in the same dispatch of timeouts as the transmit timestamp of a request
+     is not used by the server.  The remote side of other modes (including
+     broadcast) may need an accurate transmit timestamp. */
+  if (my_mode == MODE_CLIENT)
+    ret = NIO_QueuePacket(&message, where_to, from, length, local_tx != NULL);
+  else
+    ret = NIO_SendPacket(&message, where_to, from, length, local_tx != NULL);
 
   if (local_tx) {
     local_tx->ts = local_transmit;
@@ -1171,16 +1313,16 @@ transmit_timeout(void *arg)
     /* Implies we have missed at least one transmission */
 
     if (sent) {
-      adjust_poll(inst, SRC_IsSyncPeer(inst->source) ? 0.1 : 0.25);
+      adjust_poll(inst, NCR_IsSyncPeer(inst) ? 0.1 : 0.25);
     }
 
-    SRC_UpdateReachability(inst->source, 0);
+    update_reachability(inst, 0);
   }
 
   switch (inst->opmode) {
     case MD_BURST_WAS_ONLINE:
       /* When not reachable, don't stop online burst until sending succeeds */
-      if (!sent && !SRC_IsReachable(inst->source))
+      if (!sent && !is_reachable(inst))
         break;
       /* Fall through */
     case MD_BURST_WAS_OFFLINE:
@@ -1332,7 +1474,7 @@ check_delay_ratio(NCR_Instance inst, SST_Stats stats,
   double last_sample_ago, predicted_offset, min_delay, skew, std_dev;
   double max_delay;
 
-  if (inst->max_delay_ratio < 1.0 ||
+  if (inst->max_delay_ratio < 1.0 || !stats ||
       !SST_GetDelayTestData(stats, sample_time, &last_sample_ago,
                             &predicted_offset, &min_delay, &skew, &std_dev))
     return 1;
@@ -1356,7 +1498,8 @@ check_delay_dev_ratio(NCR_Instance inst, SST_Stats stats,
   double last_sample_ago, predicted_offset, min_delay, skew, std_dev;
   double delta, max_delta, error_in_estimate;
 
-  if (!SST_GetDelayTestData(stats, sample_time, &last_sample_ago,
+  if (!stats ||
+      !SST_GetDelayTestData(stats, sample_time, &last_sample_ago,
                             &predicted_offset, &min_delay, &skew, &std_dev))
     return 1;
 
@@ -1445,7 +1588,7 @@ receive_packet(NCR_Instance inst, NTP_Local_Address *local_addr,
 
   /* ==================== */
 
-  stats = SRC_GetSourcestats(inst->source);
+  stats = inst->source ? SRC_GetSourcestats(inst->source) : NULL;
 
   inst->report.total_rx_count++;
 
@@ -1573,7 +1716,10 @@ receive_packet(NCR_Instance inst, NTP_Local_Address *local_addr,
        sample pair. */
     sample_time = local_average;
     
-    SST_GetFrequencyRange(stats, &source_freq_lo, &source_freq_hi);
+    if (stats)
+      SST_GetFrequencyRange(stats, &source_freq_lo, &source_freq_hi);
+    else
+      source_freq_lo = source_freq_hi = 0.0;
 
     /* Calculate skew */
     skew = (source_freq_hi - source_freq_lo) / 2.0;
@@ -1708,9 +1854,14 @@ receive_packet(NCR_Instance inst, NTP_Local_Address *local_addr,
     inst->prev_tx_count = inst->tx_count;
     inst->tx_count = 0;
 
-    SRC_UpdateReachability(inst->source, synced_packet);
+    update_reachability(inst, synced_packet);
 
-    if (good_packet) {
+    if (good_packet && !inst->source) {
+      /* Monitored sources only save the measurement and don't take part
+         in the source selection */
+      accumulate_monitor_sample(inst->monitor, &sample_time, offset, delay);
+      estimated_offset = -offset;
+    } else if (good_packet) {
       /* Do this before we accumulate a new sample into the stats registers, obviously */
       estimated_offset = SST_PredictOffset(stats, &sample_time);
 
@@ -1722,7 +1873,9 @@ receive_packet(NCR_Instance inst, NTP_Local_Address *local_addr,
                            (NTP_Leap) pkt_leap);
 
       SRC_SelectSource(inst->source);
+    }
 
+    if (good_packet) {
       /* Now examine the registers.  First though, if the prediction is
          not even within +/- the peer distance of the peer, we are clearly
          not tracking the peer at all well, so we back off the sampling
@@ -1801,7 +1954,7 @@ receive_packet(NCR_Instance inst, NTP_Local_Address *local_addr,
     inst->report.peer_delay = delay;
     inst->report.peer_dispersion = dispersion;
     inst->report.response_time = response_time;
-    inst->report.jitter_asymmetry = SST_GetJitterAsymmetry(stats);
+    inst->report.jitter_asymmetry = stats ? SST_GetJitterAsymmetry(stats) : 0.0;
     inst->report.tests = ((((((((test1 << 1 | test2) << 1 | test3) << 1 |
                                test5) << 1 | test6) << 1 | test7) << 1 |
                             testA) << 1 | testB) << 1 | testC) << 1 | testD;
@@ -1986,7 +2139,7 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
                      NTP_Local_Timestamp *rx_ts, NTP_Packet *message, int length)
 {
   NTP_Mode pkt_mode, my_mode;
-  NTP_int64 *local_ntp_rx, *local_ntp_tx;
+  NTP_int64 local_ntp_rx, local_ntp_tx;
   NTP_Local_Timestamp local_tx, *tx_ts;
   int valid_auth, log_index, interleaved, poll;
   AuthenticationMode auth_mode;
@@ -2052,7 +2205,6 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
     }
   }
 
-  local_ntp_rx = local_ntp_tx = NULL;
   tx_ts = NULL;
   interleaved = 0;
 
@@ -2061,18 +2213,12 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
      in the interleaved mode.  This means the third reply to a new client is
      the earliest one that can be interleaved.  We don't want to waste time
      on clients that are not using the interleaved mode. */
-  if (log_index >= 0) {
-    CLG_GetNtpTimestamps(log_index, &local_ntp_rx, &local_ntp_tx);
-    interleaved = !UTI_IsZeroNtp64(local_ntp_rx) &&
-                  !UTI_CompareNtp64(&message->originate_ts, local_ntp_rx);
-
-    if (interleaved) {
-      UTI_Ntp64ToTimespec(local_ntp_tx, &local_tx.ts);
-      tx_ts = &local_tx;
-    } else {
-      UTI_ZeroNtp64(local_ntp_tx);
-      local_ntp_tx = NULL;
-    }
+  if (!UTI_IsZeroNtp64(&message->originate_ts) && !UTI_IsZeroNtp64(&message->receive_ts) &&
+      CLG_GetNtpInterleavedTimestamp(&remote_addr->ip_addr, &message->originate_ts,
+                                     &local_ntp_tx)) {
+    interleaved = 1;
+    UTI_Ntp64ToTimespec(&local_ntp_tx, &local_tx.ts);
+    tx_ts = &local_tx;
   }
 
   /* Suggest the client to increase its polling interval if it indicates
@@ -2081,13 +2227,18 @@ NCR_ProcessRxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
   poll = MAX(poll, message->poll);
 
   /* Send a reply */
-  transmit_packet(my_mode, interleaved, poll, NTP_LVM_TO_VERSION(message->lvm),
-                  auth_mode, key_id, &message->receive_ts, &message->transmit_ts,
-                  rx_ts, tx_ts, local_ntp_rx, NULL, remote_addr, local_addr);
+  if (!transmit_packet(my_mode, interleaved, poll, NTP_LVM_TO_VERSION(message->lvm),
+                       auth_mode, key_id, &message->receive_ts, &message->transmit_ts,
+                       rx_ts, tx_ts, &local_ntp_rx, NULL, remote_addr, local_addr))
+    return;
 
-  /* Save the transmit timestamp */
+  /* Save the receive timestamp to detect the interleaved mode in the next
+     request and the transmit timestamp if the client is using it */
   if (tx_ts)
-    UTI_TimespecToNtp64(&tx_ts->ts, local_ntp_tx, NULL);
+    UTI_TimespecToNtp64(&tx_ts->ts, &local_ntp_tx, NULL);
+  else
+    UTI_ZeroNtp64(&local_ntp_tx);
+  CLG_SaveNtpTimestamps(&remote_addr->ip_addr, &local_ntp_rx, &local_ntp_tx);
 }
 
 /* ================================================== */
@@ -2151,9 +2302,8 @@ void
 NCR_ProcessTxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_addr,
                      NTP_Local_Timestamp *tx_ts, NTP_Packet *message, int length)
 {
-  NTP_int64 *local_ntp_rx, *local_ntp_tx;
+  NTP_int64 *local_ntp_tx;
   NTP_Local_Timestamp local_tx;
-  int log_index;
 
   if (!check_packet_format(message, length))
     return;
@@ -2161,17 +2311,16 @@ NCR_ProcessTxUnknown(NTP_Remote_Address *remote_addr, NTP_Local_Address *local_a
   if (NTP_LVM_TO_MODE(message->lvm) == MODE_BROADCAST)
     return;
 
-  log_index = CLG_GetClientIndex(&remote_addr->ip_addr);
-  if (log_index < 0)
+  /* Find the transmit timestamp saved for the request */
+  local_ntp_tx = CLG_GetNtpTxTimestamp(&remote_addr->ip_addr, &message->receive_ts);
+  if (!local_ntp_tx)
     return;
 
   if (SMT_IsEnabled() && NTP_LVM_TO_MODE(message->lvm) == MODE_SERVER)
     UTI_AddDoubleToTimespec(&tx_ts->ts, SMT_GetOffset(&tx_ts->ts), &tx_ts->ts);
 
-  CLG_GetNtpTimestamps(log_index, &local_ntp_rx, &local_ntp_tx);
-
   UTI_Ntp64ToTimespec(local_ntp_tx, &local_tx.ts);
-  update_tx_timestamp(&local_tx, tx_ts, local_ntp_rx, NULL, message);
+  update_tx_timestamp(&local_tx, tx_ts, NULL, NULL, message);
   UTI_TimespecToNtp64(&local_tx.ts, local_ntp_tx, NULL);
 }
 
@@ -2181,6 +2330,7 @@ void
 NCR_SlewTimes(NCR_Instance inst, struct timespec *when, double dfreq, double doffset)
 {
   double delta;
+  int i;
 
   if (!UTI_IsZeroTimespec(&inst->local_rx.ts))
     UTI_AdjustTimespec(&inst->local_rx.ts, when, &inst->local_rx.ts, &delta, dfreq, doffset);
@@ -2189,6 +2339,12 @@ NCR_SlewTimes(NCR_Instance inst, struct timespec *when, double dfreq, double dof
   if (!UTI_IsZeroTimespec(&inst->prev_local_tx.ts))
     UTI_AdjustTimespec(&inst->prev_local_tx.ts, when, &inst->prev_local_tx.ts, &delta, dfreq,
                        doffset);
+
+  if (inst->monitor) {
+    for (i = 0; i < inst->monitor->n_samples; i++)
+      UTI_AdjustTimespec(&inst->monitor->times[i], when, &inst->monitor->times[i], &delta,
+                         dfreq, doffset);
+  }
 }
 
 /* ================================================== */
@@ -2380,59 +2536,271 @@ NCR_GetNTPReport(NCR_Instance inst, RPT_NTPReport *report)
 /* ================================================== */
 
 int
-NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
- {
+NCR_GetMonitorReport(NCR_Instance inst, RPT_MonitorReport *report, struct timespec *now)
+{
+  MonitorData *monitor = inst->monitor;
+  int i, j;
+
+  if (!monitor)
+    return 0;
+
+  report->ip_addr = inst->remote_addr.ip_addr;
+  report->stratum = inst->remote_stratum;
+  report->poll = get_transmit_poll(inst);
+  report->reachability = monitor->reachability;
+  report->samples = monitor->n_samples;
+
+  if (monitor->n_samples == 0) {
+    report->latest_meas_ago = 0;
+    report->offset = report->delay = 0.0;
+    report->min_delay_offset = report->min_delay = 0.0;
+    return 1;
+  }
+
+  i = monitor->last_sample;
+  report->latest_meas_ago = MAX(0.0, UTI_DiffTimespecsToDouble(now, &monitor->times[i]));
+  report->offset = monitor->offsets[i];
+  report->delay = monitor->delays[i];
+
+  /* Find the measurement with minimum delay in the register */
+  for (j = 0; j < monitor->n_samples; j++) {
+    if (monitor->delays[j] < monitor->delays[i])
+      i = j;
+  }
+
+  report->min_delay_offset = monitor->offsets[i];
+  report->min_delay = monitor->delays[i];
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+add_restriction(ADF_AuthTable table, IPAddr *ip_addr, int subnet_bits, int allow, int all)
+{
   ADF_Status status;
 
   if (allow) {
     if (all) {
-      status = ADF_AllowAll(access_auth_table, ip_addr, subnet_bits);
+      status = ADF_AllowAll(table, ip_addr, subnet_bits);
     } else {
-      status = ADF_Allow(access_auth_table, ip_addr, subnet_bits);
+      status = ADF_Allow(table, ip_addr, subnet_bits);
     }
   } else {
     if (all) {
-      status = ADF_DenyAll(access_auth_table, ip_addr, subnet_bits);
+      status = ADF_DenyAll(table, ip_addr, subnet_bits);
     } else {
-      status = ADF_Deny(access_auth_table, ip_addr, subnet_bits);
+      status = ADF_Deny(table, ip_addr, subnet_bits);
     }
   }
 
-  if (status != ADF_SUCCESS)
+  return status == ADF_SUCCESS;
+}
+
+/* ================================================== */
+
+static int
+add_restriction_file(ADF_AuthTable table, const char *file, int allow)
+{
+  ARR_Instance subnets;
+  ADF_Subnet *subnet;
+  char line[256];
+  FILE *f;
+  int ret, line_number;
+
+  f = fopen(file, "r");
+  if (!f) {
+    LOG(LOGS_ERR, "Could not open subnet file %s : %s", file, strerror(errno));
     return 0;
+  }
 
-  /* Keep server sockets open only when an address allowed */
-  if (allow) {
-    NTP_Remote_Address remote_addr;
+  subnets = ARR_CreateInstance(sizeof (ADF_Subnet));
+  ret = 1;
 
-    if (server_sock_fd4 == INVALID_SOCK_FD &&
-        ADF_IsAnyAllowed(access_auth_table, IPADDR_INET4)) {
-      remote_addr.ip_addr.family = IPADDR_INET4;
-      server_sock_fd4 = NIO_OpenServerSocket(&remote_addr);
-    }
-    if (server_sock_fd6 == INVALID_SOCK_FD &&
-        ADF_IsAnyAllowed(access_auth_table, IPADDR_INET6)) {
-      remote_addr.ip_addr.family = IPADDR_INET6;
-      server_sock_fd6 = NIO_OpenServerSocket(&remote_addr);
-    }
-  } else {
-    if (server_sock_fd4 != INVALID_SOCK_FD &&
-        !ADF_IsAnyAllowed(access_auth_table, IPADDR_INET4)) {
-      NIO_CloseServerSocket(server_sock_fd4);
-      server_sock_fd4 = INVALID_SOCK_FD;
-    }
-    if (server_sock_fd6 != INVALID_SOCK_FD &&
-        !ADF_IsAnyAllowed(access_auth_table, IPADDR_INET6)) {
-      NIO_CloseServerSocket(server_sock_fd6);
-      server_sock_fd6 = INVALID_SOCK_FD;
+  for (line_number = 1; fgets(line, sizeof (line), f); line_number++) {
+    CPS_NormalizeLine(line);
+    if (!*line)
+      continue;
+
+    subnet = ARR_GetNewElement(subnets);
+    if (!CPS_ParseSubnet(line, &subnet->ip, &subnet->subnet_bits)) {
+      LOG(LOGS_ERR, "Could not parse subnet at line %d in file %s", line_number, file);
+      ret = 0;
+      break;
     }
   }
 
+  fclose(f);
+
+  if (ret && ADF_AddSubnets(table, ARR_GetElements(subnets), ARR_GetSize(subnets),
+                            allow) != ADF_SUCCESS) {
+    LOG(LOGS_ERR, "Bad subnet in file %s", file);
+    ret = 0;
+  }
+
+  if (ret)
+    DEBUG_LOG("Loaded %u subnets from %s", ARR_GetSize(subnets), file);
+
+  ARR_DestroyInstance(subnets);
+
+  return ret;
+}
+
+/* ================================================== */
+
+static void
+update_server_sockets(void)
+{
+  NTP_Remote_Address remote_addr;
+
+  /* Wait for the new restrictions to be committed */
+  if (saved_access_auth_table)
+    return;
+
+  NIO_SetServerFilter(access_auth_table);
+
+  /* Keep server sockets open only when an address allowed */
+  if (server_sock_fd4 == INVALID_SOCK_FD &&
+      ADF_IsAnyAllowed(access_auth_table, IPADDR_INET4)) {
+    remote_addr.ip_addr.family = IPADDR_INET4;
+    server_sock_fd4 = NIO_OpenServerSocket(&remote_addr);
+  } else if (server_sock_fd4 != INVALID_SOCK_FD &&
+             !ADF_IsAnyAllowed(access_auth_table, IPADDR_INET4)) {
+    NIO_CloseServerSocket(server_sock_fd4);
+    server_sock_fd4 = INVALID_SOCK_FD;
+  }
+
+  if (server_sock_fd6 == INVALID_SOCK_FD &&
+      ADF_IsAnyAllowed(access_auth_table, IPADDR_INET6)) {
+    remote_addr.ip_addr.family = IPADDR_INET6;
+    server_sock_fd6 = NIO_OpenServerSocket(&remote_addr);
+  } else if (server_sock_fd6 != INVALID_SOCK_FD &&
+             !ADF_IsAnyAllowed(access_auth_table, IPADDR_INET6)) {
+    NIO_CloseServerSocket(server_sock_fd6);
+    server_sock_fd6 = INVALID_SOCK_FD;
+  }
+}
+
+/* ================================================== */
+
+int
+NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
+{
+  AccessRestriction *restriction;
+
+  if (!add_restriction(access_auth_table, ip_addr, subnet_bits, allow, all))
+    return 0;
+
+  restriction = ARR_GetNewElement(access_restrictions);
+  restriction->ip_addr = *ip_addr;
+  restriction->subnet_bits = subnet_bits;
+  restriction->allow = allow;
+  restriction->all = all;
+  restriction->file = NULL;
+
+  update_server_sockets();
+
   return 1;
 }
 
 /* ================================================== */
 
+int
+NCR_AddAccessRestrictionFile(const char *file, int allow)
+{
+  AccessRestriction *restriction;
+
+  if (!add_restriction_file(access_auth_table, file, allow))
+    return 0;
+
+  restriction = ARR_GetNewElement(access_restrictions);
+  restriction->ip_addr.family = IPADDR_UNSPEC;
+  restriction->subnet_bits = 0;
+  restriction->allow = allow;
+  restriction->all = 0;
+  restriction->file = Strdup(file);
+
+  update_server_sockets();
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+NCR_ReloadAccessRestrictionFiles(void)
+{
+  AccessRestriction *restriction;
+  ADF_AuthTable table;
+  unsigned int i;
+  int ret;
+
+  /* Build a new table from all restrictions and replace the current table
+     only if all files could be loaded */
+  table = ADF_CreateTable();
+
+  for (i = 0, ret = 1; ret && i < ARR_GetSize(access_restrictions); i++) {
+    restriction = ARR_GetElement(access_restrictions, i);
+    if (restriction->file)
+      ret = add_restriction_file(table, restriction->file, restriction->allow);
+    else
+      ret = add_restriction(table, &restriction->ip_addr, restriction->subnet_bits,
+                            restriction->allow, restriction->all);
+  }
+
+  if (!ret) {
+    ADF_DestroyTable(table);
+    return 0;
+  }
+
+  ADF_DestroyTable(access_auth_table);
+  access_auth_table = table;
+
+  update_server_sockets();
+
+  return 1;
+}
+
+/* ================================================== */
+
+void
+NCR_BeginAccessRestrictions(void)
+{
+  assert(!saved_access_auth_table);
+
+  saved_access_auth_table = access_auth_table;
+  saved_access_restrictions = access_restrictions;
+
+  access_auth_table = ADF_CreateTable();
+  access_restrictions = ARR_CreateInstance(sizeof (AccessRestriction));
+}
+
+/* ================================================== */
+
+void
+NCR_EndAccessRestrictions(int commit)
+{
+  assert(saved_access_auth_table);
+
+  if (commit) {
+    ADF_DestroyTable(saved_access_auth_table);
+    destroy_access_restrictions(saved_access_restrictions);
+  } else {
+    ADF_DestroyTable(access_auth_table);
+    destroy_access_restrictions(access_restrictions);
+    access_auth_table = saved_access_auth_table;
+    access_restrictions = saved_access_restrictions;
+  }
+
+  saved_access_auth_table = NULL;
+  saved_access_restrictions = NULL;
+
+  update_server_sockets();
+}
+
+/* ================================================== */
+
 int
 NCR_CheckAccessRestriction(IPAddr *ip_addr)
 {
@@ -2484,7 +2852,7 @@ NCR_GetLocalRefid(NCR_Instance inst)
 
 int NCR_IsSyncPeer(NCR_Instance inst)
 {
-  return SRC_IsSyncPeer(inst->source);
+  return inst->source && SRC_IsSyncPeer(inst->source);
 }
 
 /* ================================================== */
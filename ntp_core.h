@@ -124,8 +124,19 @@ extern void NCR_InitiateSampleBurst(NCR_Instance inst, int n_good_samples, int n
 
 extern void NCR_ReportSource(NCR_Instance inst, RPT_SourceReport *report, struct timespec *now);
 extern void NCR_GetNTPReport(NCR_Instance inst, RPT_NTPReport *report);
+extern int NCR_GetMonitorReport(NCR_Instance inst, RPT_MonitorReport *report,
+                                struct timespec *now);
 
 extern int NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all);
+extern int NCR_AddAccessRestrictionFile(const char *file, int allow);
+extern int NCR_ReloadAccessRestrictionFiles(void);
+
+/* Start replacing all access restrictions.  The restrictions added after
+   this call replace the current restrictions if they are committed with
+   NCR_EndAccessRestrictions(), otherwise they are discarded. */
+extern void NCR_BeginAccessRestrictions(void);
+extern void NCR_EndAccessRestrictions(int commit);
+
 extern int NCR_CheckAccessRestriction(IPAddr *ip_addr);
 
 extern void NCR_IncrementActivityCounters(NCR_Instance inst, int *online, int *offline, 
@@ -45,6 +45,10 @@
 #include "ntp_io_linux.h"
 #endif
 
+#ifdef HAVE_LINUX_SOCKET_FILTER
+#include <linux/filter.h>
+#endif
+
 #define INVALID_SOCK_FD -1
 #define CMSGBUF_SIZE 256
 
@@ -81,6 +85,26 @@ struct MessageHeader {
 static ARR_Instance recv_messages;
 static ARR_Instance recv_headers;
 
+#ifdef HAVE_SENDMMSG
+/* Maximum number of packets queued for transmission with sendmmsg() */
+#define MAX_SEND_MESSAGES 16
+
+/* Addresses of a queued message */
+typedef struct {
+  NTP_Remote_Address remote_addr;
+  NTP_Local_Address local_addr;
+  int process_tx;
+} SendAddress;
+
+/* Arrays of queued Message, MessageHeader, and SendAddress */
+static ARR_Instance send_messages;
+static ARR_Instance send_headers;
+static ARR_Instance send_addresses;
+
+/* Number of queued messages */
+static unsigned int n_send_messages;
+#endif
+
 /* The server/peer and client sockets for IPv4 and IPv6 */
 static int server_sock_fd4;
 static int client_sock_fd4;
@@ -105,6 +129,27 @@ static int separate_client_sockets;
    disabled */
 static int permanent_server_sockets;
 
+#ifdef HAVE_LINUX_SOCKET_FILTER
+/* Maximum number of access rules compiled into the socket filter */
+#define MAX_FILTER_RULES 256
+
+/* Maximum length of the filter, including the header checks, loading
+   of the source address, and up to 13 instructions per rule */
+#define MAX_FILTER_INSNS (24 + 13 * MAX_FILTER_RULES)
+
+/* Offsets in the data seen by the filter, which start at the UDP header */
+#define FILTER_NTP_OFFSET 8
+#define FILTER_IP4_SRC_OFFSET (SKF_NET_OFF + 12)
+#define FILTER_IP6_SRC_OFFSET (SKF_NET_OFF + 8)
+
+/* Positions of the final verdicts of the header checks */
+#define FILTER_DROP_INSN 13
+#define FILTER_ACCEPT_INSN 14
+
+/* Table of access restrictions compiled into filters of server sockets */
+static ADF_AuthTable server_filter_table;
+#endif
+
 /* Flag indicating that we have been initialised */
 static int initialised=0;
 
@@ -112,6 +157,165 @@ static int initialised=0;
 
 /* Forward prototypes */
 static void read_from_socket(int sock_fd, int event, void *anything);
+#ifdef HAVE_SENDMMSG
+static void send_queued_messages(void *arg);
+#endif
+
+/* ================================================== */
+
+#ifdef HAVE_LINUX_SOCKET_FILTER
+
+static void
+add_filter_insn(struct sock_filter *insns, int *n, int code, uint32_t k,
+                int jt_insn, int jf_insn)
+{
+  assert(*n < MAX_FILTER_INSNS);
+  assert(BPF_CLASS(code) != BPF_JMP ||
+         (jt_insn > *n && jf_insn > *n && jt_insn - *n <= 256 && jf_insn - *n <= 256));
+
+  insns[*n].code = code;
+  insns[*n].jt = BPF_CLASS(code) == BPF_JMP ? jt_insn - *n - 1 : 0;
+  insns[*n].jf = BPF_CLASS(code) == BPF_JMP ? jf_insn - *n - 1 : 0;
+  insns[*n].k = k;
+  (*n)++;
+}
+
+/* ================================================== */
+
+static int
+get_filter_rule_length(ADF_Rule *rule)
+{
+  int bits, length;
+
+  /* Load, mask, and compare each word of the prefix, and return the verdict */
+  for (length = 1, bits = rule->subnet.subnet_bits; bits > 0; bits -= 32)
+    length += bits >= 32 ? 2 : 3;
+
+  return length;
+}
+
+/* ================================================== */
+/* Compile a classic BPF program dropping packets which would be dropped
+   in NCR_ProcessRxUnknown() due to an invalid length, version, or mode,
+   and client requests from addresses not allowed by the table */
+
+static int
+build_socket_filter(int family, ADF_AuthTable table, struct sock_filter *insns)
+{
+  ADF_Rule rules[MAX_FILTER_RULES];
+  int i, j, n, n_rules, n_words, next_rule, bits, default_allow;
+  uint32_t addr[4], mask;
+
+  n = 0;
+
+  /* Check the length of the UDP data */
+  add_filter_insn(insns, &n, BPF_LD | BPF_W | BPF_LEN, 0, 0, 0);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JGE | BPF_K,
+                  FILTER_NTP_OFFSET + NTP_NORMAL_PACKET_LENGTH, n + 1, FILTER_DROP_INSN);
+  add_filter_insn(insns, &n, BPF_ALU | BPF_AND | BPF_K, 3, 0, 0);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, n + 1, FILTER_DROP_INSN);
+
+  /* Check the version */
+  add_filter_insn(insns, &n, BPF_LD | BPF_B | BPF_ABS, FILTER_NTP_OFFSET, 0, 0);
+  add_filter_insn(insns, &n, BPF_ALU | BPF_AND | BPF_K, NTP_LVM(0, 7, 0), 0, 0);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, FILTER_DROP_INSN, n + 1);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JGT | BPF_K, NTP_LVM(0, NTP_VERSION, 0),
+                  FILTER_DROP_INSN, n + 1);
+
+  /* Check the mode and accept everything except client requests */
+  add_filter_insn(insns, &n, BPF_LD | BPF_B | BPF_ABS, FILTER_NTP_OFFSET, 0, 0);
+  add_filter_insn(insns, &n, BPF_ALU | BPF_AND | BPF_K, NTP_LVM(0, 0, 7), 0, 0);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JEQ | BPF_K, MODE_UNDEFINED,
+                  FILTER_DROP_INSN, n + 1);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JGT | BPF_K, MODE_BROADCAST,
+                  FILTER_DROP_INSN, n + 1);
+  add_filter_insn(insns, &n, BPF_JMP | BPF_JEQ | BPF_K, MODE_CLIENT,
+                  FILTER_ACCEPT_INSN + 1, FILTER_ACCEPT_INSN);
+
+  assert(n == FILTER_DROP_INSN);
+  add_filter_insn(insns, &n, BPF_RET | BPF_K, 0, 0, 0);
+  assert(n == FILTER_ACCEPT_INSN);
+  add_filter_insn(insns, &n, BPF_RET | BPF_K, 0xffffffffU, 0, 0);
+
+  if (!table)
+    n_rules = -1;
+  else if (family == AF_INET)
+    n_rules = ADF_GetRules(table, IPADDR_INET4, rules, MAX_FILTER_RULES, &default_allow);
+  else
+    n_rules = ADF_GetRules(table, IPADDR_INET6, rules, MAX_FILTER_RULES, &default_allow);
+
+  /* Leave the address check to NCR_ProcessRxUnknown() if the table
+     is not available or too large */
+  if (n_rules < 0) {
+    add_filter_insn(insns, &n, BPF_RET | BPF_K, 0xffffffffU, 0, 0);
+    return n;
+  }
+
+  /* Save the source address to the scratch memory */
+  n_words = family == AF_INET ? 1 : 4;
+  for (i = 0; i < n_words; i++) {
+    add_filter_insn(insns, &n, BPF_LD | BPF_W | BPF_ABS,
+                    (family == AF_INET ? FILTER_IP4_SRC_OFFSET : FILTER_IP6_SRC_OFFSET) +
+                    4 * i, 0, 0);
+    add_filter_insn(insns, &n, BPF_ST, i, 0, 0);
+  }
+
+  /* Check the rules in the order of decreasing prefix length */
+  for (i = 0; i < n_rules; i++) {
+    if (family == AF_INET) {
+      addr[0] = rules[i].subnet.ip.addr.in4;
+    } else {
+      for (j = 0; j < 4; j++)
+        addr[j] = (uint32_t)rules[i].subnet.ip.addr.in6[j * 4 + 0] << 24 |
+                  rules[i].subnet.ip.addr.in6[j * 4 + 1] << 16 |
+                  rules[i].subnet.ip.addr.in6[j * 4 + 2] << 8 |
+                  rules[i].subnet.ip.addr.in6[j * 4 + 3];
+    }
+
+    next_rule = n + get_filter_rule_length(&rules[i]);
+
+    for (j = 0, bits = rules[i].subnet.subnet_bits; bits > 0; j++, bits -= 32) {
+      mask = bits >= 32 ? 0xffffffffU : ~(0xffffffffU >> bits);
+      add_filter_insn(insns, &n, BPF_LD | BPF_MEM, j, 0, 0);
+      if (bits < 32)
+        add_filter_insn(insns, &n, BPF_ALU | BPF_AND | BPF_K, mask, 0, 0);
+      add_filter_insn(insns, &n, BPF_JMP | BPF_JEQ | BPF_K, addr[j] & mask, n + 1, next_rule);
+    }
+
+    add_filter_insn(insns, &n, BPF_RET | BPF_K, rules[i].allow ? 0xffffffffU : 0, 0, 0);
+    assert(n == next_rule);
+  }
+
+  add_filter_insn(insns, &n, BPF_RET | BPF_K, default_allow ? 0xffffffffU : 0, 0, 0);
+
+  return n;
+}
+
+/* ================================================== */
+
+static void
+set_socket_filter(int sock_fd, int family)
+{
+  static struct sock_filter insns[MAX_FILTER_INSNS];
+  struct sock_fprog prog;
+
+  prog.filter = insns;
+  prog.len = build_socket_filter(family, server_filter_table, insns);
+
+  if (setsockopt(sock_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof (prog)) == 0) {
+    DEBUG_LOG("Attached %d-instruction filter to socket %d", prog.len, sock_fd);
+    return;
+  }
+
+  /* The filter may exceed the kernel limit on socket option memory */
+  DEBUG_LOG("Could not attach %d-instruction filter : %s", prog.len, strerror(errno));
+  prog.len = build_socket_filter(family, NULL, insns);
+
+  if (setsockopt(sock_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof (prog)) < 0)
+    LOG(LOGS_ERR, "Could not set %s socket option", "SO_ATTACH_FILTER");
+}
+
+#endif
 
 /* ================================================== */
 
@@ -257,6 +461,12 @@ prepare_socket(int family, int port_number, int client_only)
   }
 #endif
 
+#ifdef HAVE_LINUX_SOCKET_FILTER
+  /* Drop invalid and unauthorised requests in the kernel */
+  if (!client_only)
+    set_socket_filter(sock_fd, family);
+#endif
+
   /* Bind the socket if a port or address was specified */
   if (my_addr_len > 0 && PRV_BindSocket(sock_fd, &my_addr.u, my_addr_len) < 0) {
     LOG(LOGS_ERR, "Could not bind %s NTP socket : %s",
@@ -318,6 +528,12 @@ close_socket(int sock_fd)
   if (sock_fd == INVALID_SOCK_FD)
     return;
 
+#ifdef HAVE_SENDMMSG
+  /* Don't lose packets queued for the socket */
+  if (n_send_messages > 0)
+    send_queued_messages(NULL);
+#endif
+
   SCH_RemoveFileHandler(sock_fd);
   close(sock_fd);
 }
@@ -374,6 +590,16 @@ NIO_Initialise(int family)
   ARR_SetSize(recv_headers, MAX_RECV_MESSAGES);
   prepare_buffers(MAX_RECV_MESSAGES);
 
+#ifdef HAVE_SENDMMSG
+  send_messages = ARR_CreateInstance(sizeof (struct Message));
+  ARR_SetSize(send_messages, MAX_SEND_MESSAGES);
+  send_headers = ARR_CreateInstance(sizeof (struct MessageHeader));
+  ARR_SetSize(send_headers, MAX_SEND_MESSAGES);
+  send_addresses = ARR_CreateInstance(sizeof (SendAddress));
+  ARR_SetSize(send_addresses, MAX_SEND_MESSAGES);
+  n_send_messages = 0;
+#endif
+
   server_port = CNF_GetNTPPort();
   client_port = CNF_GetAcquisitionPort();
 
@@ -448,6 +674,11 @@ NIO_Finalise(void)
 #endif
   ARR_DestroyInstance(recv_headers);
   ARR_DestroyInstance(recv_messages);
+#ifdef HAVE_SENDMMSG
+  ARR_DestroyInstance(send_addresses);
+  ARR_DestroyInstance(send_headers);
+  ARR_DestroyInstance(send_messages);
+#endif
 
 #ifdef HAVE_LINUX_TIMESTAMPING
   NIO_Linux_Finalise();
@@ -554,6 +785,23 @@ NIO_CloseServerSocket(int sock_fd)
 
 /* ================================================== */
 
+void
+NIO_SetServerFilter(ADF_AuthTable table)
+{
+#ifdef HAVE_LINUX_SOCKET_FILTER
+  server_filter_table = table;
+
+  if (server_sock_fd4 != INVALID_SOCK_FD)
+    set_socket_filter(server_sock_fd4, AF_INET);
+#ifdef FEAT_IPV6
+  if (server_sock_fd6 != INVALID_SOCK_FD)
+    set_socket_filter(server_sock_fd6, AF_INET6);
+#endif
+#endif
+}
+
+/* ================================================== */
+
 int
 NIO_IsServerSocket(int sock_fd)
 {
@@ -724,21 +972,18 @@ read_from_socket(int sock_fd, int event, void *anything)
 }
 
 /* ================================================== */
-/* Send a packet to remote address from local address */
+/* Prepare a message for sending a packet to remote address from local
+   address.  The packet is not copied to the message buffer. */
 
-int
-NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
-               NTP_Local_Address *local_addr, int length, int process_tx)
+static int
+prepare_message(struct Message *message, struct msghdr *msg, NTP_Packet *packet,
+                NTP_Remote_Address *remote_addr, NTP_Local_Address *local_addr,
+                int length, int process_tx)
 {
-  union sockaddr_in46 remote;
-  struct msghdr msg;
-  struct iovec iov;
-  struct cmsghdr *cmsg, cmsgbuf[CMSGBUF_SIZE / sizeof (struct cmsghdr)];
+  struct cmsghdr *cmsg;
   int cmsglen;
   socklen_t addrlen = 0;
 
-  assert(initialised);
-
   if (local_addr->sock_fd == INVALID_SOCK_FD) {
     DEBUG_LOG("No socket to send to %s:%d",
               UTI_IPToString(&remote_addr->ip_addr), remote_addr->port);
@@ -748,33 +993,33 @@ NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
   /* Don't set address with connected socket */
   if (NIO_IsServerSocket(local_addr->sock_fd) || !separate_client_sockets) {
     addrlen = UTI_IPAndPortToSockaddr(&remote_addr->ip_addr, remote_addr->port,
-                                      &remote.u);
+                                      &message->name.u);
     if (!addrlen)
       return 0;
   }
 
   if (addrlen) {
-    msg.msg_name = &remote.u;
-    msg.msg_namelen = addrlen;
+    msg->msg_name = &message->name.u;
+    msg->msg_namelen = addrlen;
   } else {
-    msg.msg_name = NULL;
-    msg.msg_namelen = 0;
+    msg->msg_name = NULL;
+    msg->msg_namelen = 0;
   }
 
-  iov.iov_base = packet;
-  iov.iov_len = length;
-  msg.msg_iov = &iov;
-  msg.msg_iovlen = 1;
-  msg.msg_control = cmsgbuf;
-  msg.msg_controllen = sizeof(cmsgbuf);
-  msg.msg_flags = 0;
+  message->iov.iov_base = packet;
+  message->iov.iov_len = length;
+  msg->msg_iov = &message->iov;
+  msg->msg_iovlen = 1;
+  msg->msg_control = message->cmsgbuf;
+  msg->msg_controllen = sizeof (message->cmsgbuf);
+  msg->msg_flags = 0;
   cmsglen = 0;
 
 #ifdef HAVE_IN_PKTINFO
   if (local_addr->ip_addr.family == IPADDR_INET4) {
     struct in_pktinfo *ipi;
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = message->cmsgbuf;
     memset(cmsg, 0, CMSG_SPACE(sizeof(struct in_pktinfo)));
     cmsglen += CMSG_SPACE(sizeof(struct in_pktinfo));
 
@@ -791,7 +1036,7 @@ NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
   if (local_addr->ip_addr.family == IPADDR_INET6) {
     struct in6_pktinfo *ipi;
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = message->cmsgbuf;
     memset(cmsg, 0, CMSG_SPACE(sizeof(struct in6_pktinfo)));
     cmsglen += CMSG_SPACE(sizeof(struct in6_pktinfo));
 
@@ -807,13 +1052,32 @@ NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
 
 #ifdef HAVE_LINUX_TIMESTAMPING
   if (process_tx)
-   cmsglen = NIO_Linux_RequestTxTimestamp(&msg, cmsglen, local_addr->sock_fd);
+   cmsglen = NIO_Linux_RequestTxTimestamp(msg, cmsglen, local_addr->sock_fd);
 #endif
 
-  msg.msg_controllen = cmsglen;
+  msg->msg_controllen = cmsglen;
   /* This is apparently required on some systems */
   if (!cmsglen)
-    msg.msg_control = NULL;
+    msg->msg_control = NULL;
+
+  return 1;
+}
+
+/* ================================================== */
+/* Send a packet to remote address from local address */
+
+int
+NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
+               NTP_Local_Address *local_addr, int length, int process_tx)
+{
+  struct Message message;
+  struct msghdr msg;
+
+  assert(initialised);
+
+  if (!prepare_message(&message, &msg, packet, remote_addr, local_addr,
+                       length, process_tx))
+    return 0;
 
   if (sendmsg(local_addr->sock_fd, &msg, 0) < 0) {
     DEBUG_LOG("Could not send to %s:%d from %s fd %d : %s",
@@ -829,3 +1093,144 @@ NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
 
   return 1;
 }
+
+/* ================================================== */
+
+#ifdef HAVE_SENDMMSG
+static void
+send_queued_messages(void *arg)
+{
+  struct MessageHeader hdrs[MAX_SEND_MESSAGES], *hdr;
+  SendAddress *addrs, *batch[MAX_SEND_MESSAGES];
+  NTP_Local_Timestamp local_ts;
+  int sock_fd, status;
+  unsigned int i, j, k, n;
+
+  addrs = ARR_GetElements(send_addresses);
+
+  /* Send the messages in batches of messages using the same socket */
+  for (i = 0; i < n_send_messages; i++) {
+    sock_fd = addrs[i].local_addr.sock_fd;
+    if (sock_fd == INVALID_SOCK_FD)
+      continue;
+
+    for (j = i, n = 0; j < n_send_messages; j++) {
+      if (addrs[j].local_addr.sock_fd != sock_fd)
+        continue;
+      hdr = ARR_GetElement(send_headers, j);
+      hdrs[n] = *hdr;
+      batch[n++] = &addrs[j];
+    }
+
+    /* Capture a daemon timestamp of the transmission, which will be used
+       by the sources if the kernel doesn't provide a TX timestamp */
+    LCL_ReadCookedTime(&local_ts.ts, &local_ts.err);
+    local_ts.source = NTP_TS_DAEMON;
+
+    for (j = 0; j < n; j += status > 0 ? status : 1) {
+      status = sendmmsg(sock_fd, hdrs + j, n - j, 0);
+      if (status < 0) {
+        DEBUG_LOG("Could not send to fd %d : %s", sock_fd, strerror(errno));
+        continue;
+      }
+
+      for (k = j; k < j + status; k++) {
+        if (batch[k]->process_tx)
+          NSR_ProcessTx(&batch[k]->remote_addr, &batch[k]->local_addr, &local_ts,
+                        (NTP_Packet *)hdrs[k].msg_hdr.msg_iov[0].iov_base,
+                        hdrs[k].msg_hdr.msg_iov[0].iov_len);
+      }
+    }
+
+    for (j = 0; j < n; j++)
+      batch[j]->local_addr.sock_fd = INVALID_SOCK_FD;
+
+    DEBUG_LOG("Sent %u messages from fd %d", n, sock_fd);
+  }
+
+  n_send_messages = 0;
+}
+#endif
+
+/* ================================================== */
+
+int
+NIO_QueuePacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
+                NTP_Local_Address *local_addr, int length, int process_tx)
+{
+#ifdef HAVE_SENDMMSG
+  struct MessageHeader *hdr;
+  struct Message *message;
+  SendAddress *addr;
+
+  assert(initialised);
+
+  /* Without kernel TX timestamps the transmit timestamp captured by the
+     caller needs to be close to the actual transmission */
+#ifdef HAVE_LINUX_TIMESTAMPING
+  if (process_tx && !NIO_Linux_HasTxTimestamps())
+    return NIO_SendPacket(packet, remote_addr, local_addr, length, process_tx);
+#else
+  if (process_tx)
+    return NIO_SendPacket(packet, remote_addr, local_addr, length, process_tx);
+#endif
+
+  if (n_send_messages >= MAX_SEND_MESSAGES)
+    send_queued_messages(NULL);
+
+  message = ARR_GetElement(send_messages, n_send_messages);
+  hdr = ARR_GetElement(send_headers, n_send_messages);
+
+  if (length < 0 || length > (int)sizeof (message->buf))
+    return 0;
+
+  memcpy(&message->buf, packet, length);
+
+  if (!prepare_message(message, &hdr->msg_hdr, &message->buf.ntp_pkt, remote_addr,
+                       local_addr, length, process_tx))
+    return 0;
+
+  hdr->msg_len = 0;
+  addr = ARR_GetElement(send_addresses, n_send_messages);
+  addr->remote_addr = *remote_addr;
+  addr->local_addr = *local_addr;
+  addr->process_tx = process_tx;
+
+  /* Send the queued messages after all timeouts and file handlers which
+     are currently due are dispatched */
+  if (n_send_messages++ == 0)
+    SCH_AddDeferredHandler(send_queued_messages, NULL);
+
+  DEBUG_LOG("Queued %d bytes to %s:%d from %s fd %d", length,
+      UTI_IPToString(&remote_addr->ip_addr), remote_addr->port,
+      UTI_IPToString(&local_addr->ip_addr), local_addr->sock_fd);
+
+  return 1;
+#else
+  return NIO_SendPacket(packet, remote_addr, local_addr, length, process_tx);
+#endif
+}
+
+/* ================================================== */
+
+int
+NIO_GetNumberOfHwClocks(void)
+{
+#ifdef HAVE_LINUX_TIMESTAMPING
+  return NIO_Linux_GetNumberOfInterfaces();
+#else
+  return 0;
+#endif
+}
+
+/* ================================================== */
+
+int
+NIO_GetHwClockReport(int index, RPT_HwClockReport *report)
+{
+#ifdef HAVE_LINUX_TIMESTAMPING
+  return NIO_Linux_GetReport(index, report);
+#else
+  return 0;
+#endif
+}
@@ -31,6 +31,8 @@
 
 #include "ntp.h"
 #include "addressing.h"
+#include "addrfilt.h"
+#include "reports.h"
 
 /* Function to initialise the module. */
 extern void NIO_Initialise(int family);
@@ -50,6 +52,10 @@ extern void NIO_CloseClientSocket(int sock_fd);
 /* Function to close a socket returned by NIO_OpenServerSocket() */
 extern void NIO_CloseServerSocket(int sock_fd);
 
+/* Function to set the access table compiled into a kernel filter of
+   server sockets.  It needs to be called again when the table changes. */
+extern void NIO_SetServerFilter(ADF_AuthTable table);
+
 /* Function to check if socket is a server socket */
 extern int NIO_IsServerSocket(int sock_fd);
 
@@ -57,4 +63,14 @@ extern int NIO_IsServerSocket(int sock_fd);
 extern int NIO_SendPacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
                           NTP_Local_Address *local_addr, int length, int process_tx);
 
+/* Function to queue a packet for transmission after all timeouts (or file
+   handlers) which are currently due are dispatched, allowing packets to be
+   sent in batches */
+extern int NIO_QueuePacket(NTP_Packet *packet, NTP_Remote_Address *remote_addr,
+                           NTP_Local_Address *local_addr, int length, int process_tx);
+
+/* Functions to get statistics of HW clocks used for timestamping */
+extern int NIO_GetNumberOfHwClocks(void);
+extern int NIO_GetHwClockReport(int index, RPT_HwClockReport *report);
+
 #endif /* GOT_NTP_IO_H */
@@ -44,6 +44,7 @@
 #include "ntp_io.h"
 #include "ntp_io_linux.h"
 #include "ntp_sources.h"
+#include "phcsim.h"
 #include "sched.h"
 #include "sys_linux.h"
 #include "util.h"
@@ -62,6 +63,8 @@ struct Interface {
   int phc_fd;
   int phc_mode;
   int phc_nocrossts;
+  /* Flag indicating HW timestamps are emulated with a simulated PHC */
+  int phc_simulated;
   /* Link speed in mbit/s */
   int link_speed;
   /* Start of UDP data at layer 2 for IPv4 and IPv6 */
@@ -73,6 +76,12 @@ struct Interface {
   double tx_comp;
   double rx_comp;
   HCL_Instance clock;
+  /* Number of PHC readings, their total and maximum duration, and the
+     error of the last reading */
+  uint32_t phc_readings;
+  double phc_read_time;
+  double phc_read_max;
+  double phc_error;
 };
 
 /* Number of PHC readings per HW clock sample */
@@ -97,56 +106,26 @@ static int permanent_ts_options;
 /* ================================================== */
 
 static int
-add_interface(CNF_HwTsInterface *conf_iface)
+enable_hw_timestamping(int sock_fd, struct ifreq *req, CNF_HwTsInterface *conf_iface,
+                       int *phc_index, int *rx_filter)
 {
   struct ethtool_ts_info ts_info;
   struct hwtstamp_config ts_config;
-  struct ifreq req;
-  int sock_fd, if_index, phc_fd, req_hwts_flags;
-  unsigned int i;
-  struct Interface *iface;
-
-  /* Check if the interface was not already added */
-  for (i = 0; i < ARR_GetSize(interfaces); i++) {
-    if (!strcmp(conf_iface->name, ((struct Interface *)ARR_GetElement(interfaces, i))->name))
-      return 1;
-  }
-
-  sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
-  if (sock_fd < 0)
-    return 0;
+  int req_hwts_flags;
 
-  memset(&req, 0, sizeof (req));
   memset(&ts_info, 0, sizeof (ts_info));
-
-  if (snprintf(req.ifr_name, sizeof (req.ifr_name), "%s", conf_iface->name) >=
-      sizeof (req.ifr_name)) {
-    close(sock_fd);
-    return 0;
-  }
-
-  if (ioctl(sock_fd, SIOCGIFINDEX, &req)) {
-    DEBUG_LOG("ioctl(%s) failed : %s", "SIOCGIFINDEX", strerror(errno));
-    close(sock_fd);
-    return 0;
-  }
-
-  if_index = req.ifr_ifindex;
-
   ts_info.cmd = ETHTOOL_GET_TS_INFO;
-  req.ifr_data = (char *)&ts_info;
+  req->ifr_data = (char *)&ts_info;
 
-  if (ioctl(sock_fd, SIOCETHTOOL, &req)) {
+  if (ioctl(sock_fd, SIOCETHTOOL, req)) {
     DEBUG_LOG("ioctl(%s) failed : %s", "SIOCETHTOOL", strerror(errno));
-    close(sock_fd);
     return 0;
   }
 
   req_hwts_flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE |
                    SOF_TIMESTAMPING_RAW_HARDWARE;
   if ((ts_info.so_timestamping & req_hwts_flags) != req_hwts_flags) {
-    DEBUG_LOG("HW timestamping not supported on %s", req.ifr_name);
-    close(sock_fd);
+    DEBUG_LOG("HW timestamping not supported on %s", req->ifr_name);
     return 0;
   }
 
@@ -178,17 +157,70 @@ add_interface(CNF_HwTsInterface *conf_iface)
       break;
   }
 
-  req.ifr_data = (char *)&ts_config;
+  req->ifr_data = (char *)&ts_config;
 
-  if (ioctl(sock_fd, SIOCSHWTSTAMP, &req)) {
+  if (ioctl(sock_fd, SIOCSHWTSTAMP, req)) {
     DEBUG_LOG("ioctl(%s) failed : %s", "SIOCSHWTSTAMP", strerror(errno));
+    return 0;
+  }
+
+  *phc_index = ts_info.phc_index;
+  *rx_filter = ts_config.rx_filter;
+
+  return 1;
+}
+
+/* ================================================== */
+
+static int
+add_interface(CNF_HwTsInterface *conf_iface)
+{
+  struct ifreq req;
+  int sock_fd, if_index, phc_fd, phc_index, rx_filter, simulated;
+  unsigned int i;
+  struct Interface *iface;
+
+  /* Check if the interface was not already added */
+  for (i = 0; i < ARR_GetSize(interfaces); i++) {
+    if (!strcmp(conf_iface->name, ((struct Interface *)ARR_GetElement(interfaces, i))->name))
+      return 1;
+  }
+
+  sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock_fd < 0)
+    return 0;
+
+  memset(&req, 0, sizeof (req));
+
+  if (snprintf(req.ifr_name, sizeof (req.ifr_name), "%s", conf_iface->name) >=
+      sizeof (req.ifr_name)) {
+    close(sock_fd);
+    return 0;
+  }
+
+  if (ioctl(sock_fd, SIOCGIFINDEX, &req)) {
+    DEBUG_LOG("ioctl(%s) failed : %s", "SIOCGIFINDEX", strerror(errno));
+    close(sock_fd);
+    return 0;
+  }
+
+  if_index = req.ifr_ifindex;
+
+  /* With a simulated PHC the HW timestamps are emulated from SW timestamps
+     and the NIC is not configured */
+  simulated = PSM_IsSimulatorPath(conf_iface->phc);
+
+  if (simulated) {
+    phc_index = 0;
+    rx_filter = HWTSTAMP_FILTER_ALL;
+  } else if (!enable_hw_timestamping(sock_fd, &req, conf_iface, &phc_index, &rx_filter)) {
     close(sock_fd);
     return 0;
   }
 
   close(sock_fd);
 
-  phc_fd = SYS_Linux_OpenPHC(NULL, ts_info.phc_index);
+  phc_fd = SYS_Linux_OpenPHC(conf_iface->phc, phc_index);
   if (phc_fd < 0)
     return 0;
 
@@ -199,6 +231,7 @@ add_interface(CNF_HwTsInterface *conf_iface)
   iface->phc_fd = phc_fd;
   iface->phc_mode = 0;
   iface->phc_nocrossts = conf_iface->nocrossts;
+  iface->phc_simulated = simulated;
 
   /* Start with 1 gbit and no VLANs or IPv4/IPv6 options */
   iface->link_speed = 1000;
@@ -209,10 +242,15 @@ add_interface(CNF_HwTsInterface *conf_iface)
   iface->tx_comp = conf_iface->tx_comp;
   iface->rx_comp = conf_iface->rx_comp;
 
-  iface->clock = HCL_CreateInstance(UTI_Log2ToDouble(MAX(conf_iface->minpoll, MIN_PHC_POLL)));
+  iface->clock = HCL_CreateInstance(UTI_Log2ToDouble(MAX(conf_iface->minpoll, MIN_PHC_POLL)),
+                                    UTI_Log2ToDouble(MAX(conf_iface->maxpoll, MIN_PHC_POLL)));
+  iface->phc_readings = 0;
+  iface->phc_read_time = 0.0;
+  iface->phc_read_max = 0.0;
+  iface->phc_error = 0.0;
 
-  LOG(LOGS_INFO, "Enabled HW timestamping %son %s",
-      ts_config.rx_filter == HWTSTAMP_FILTER_NONE ? "(TX only) " : "", iface->name);
+  LOG(LOGS_INFO, "Enabled %s timestamping %son %s", simulated ? "simulated HW" : "HW",
+      rx_filter == HWTSTAMP_FILTER_NONE ? "(TX only) " : "", iface->name);
 
   return 1;
 }
@@ -363,7 +401,7 @@ NIO_Linux_Finalise(void)
   for (i = 0; i < ARR_GetSize(interfaces); i++) {
     iface = ARR_GetElement(interfaces, i);
     HCL_DestroyInstance(iface->clock);
-    close(iface->phc_fd);
+    SYS_Linux_ClosePHC(iface->phc_fd);
   }
 
   ARR_DestroyInstance(interfaces);
@@ -430,20 +468,32 @@ process_hw_timestamp(struct Interface *iface, struct timespec *hw_ts,
                      NTP_Local_Timestamp *local_ts, int rx_ntp_length, int family,
                      int l2_length)
 {
-  struct timespec sample_phc_ts, sample_sys_ts, sample_local_ts, ts;
-  double rx_correction, ts_delay, phc_err, local_err;
+  struct timespec sample_phc_ts, sample_sys_ts, sample_local_ts, ts, start_ts, end_ts;
+  double rx_correction, ts_delay, phc_err, local_err, read_time;
+  int r;
 
   if (HCL_NeedsNewSample(iface->clock, &local_ts->ts)) {
-    if (!SYS_Linux_GetPHCSample(iface->phc_fd, iface->phc_nocrossts, iface->precision,
-                                &iface->phc_mode, &sample_phc_ts, &sample_sys_ts,
-                                &phc_err))
+    LCL_ReadRawTime(&start_ts);
+    r = SYS_Linux_GetPHCSample(iface->phc_fd, iface->phc_nocrossts, iface->precision,
+                               &iface->phc_mode, &sample_phc_ts, &sample_sys_ts, &phc_err);
+    LCL_ReadRawTime(&end_ts);
+
+    read_time = UTI_DiffTimespecsToDouble(&end_ts, &start_ts);
+    iface->phc_readings++;
+    iface->phc_read_time += read_time;
+    iface->phc_read_max = MAX(iface->phc_read_max, read_time);
+
+    if (!r)
       return;
 
+    iface->phc_error = phc_err;
+
     LCL_CookTime(&sample_sys_ts, &sample_local_ts, &local_err);
     HCL_AccumulateSample(iface->clock, &sample_phc_ts, &sample_local_ts,
                          phc_err + local_err);
 
-    update_interface_speed(iface);
+    if (!iface->phc_simulated)
+      update_interface_speed(iface);
   }
 
   /* We need to transpose RX timestamps as hardware timestamps are normally
@@ -606,6 +656,14 @@ NIO_Linux_ProcessMessage(NTP_Remote_Address *remote_addr, NTP_Local_Address *loc
 
       memcpy(&ts3, CMSG_DATA(cmsg), sizeof (ts3));
 
+      /* Emulate a HW timestamp if the interface has a simulated PHC */
+      if (UTI_IsZeroTimespec(&ts3.ts[2]) && !UTI_IsZeroTimespec(&ts3.ts[0])) {
+        iface = get_interface(ts_if_index);
+        if (!iface || !iface->phc_simulated ||
+            !SYS_Linux_GetSimulatedPHCTimestamp(iface->phc_fd, &ts3.ts[0], &ts3.ts[2]))
+          iface = NULL;
+      }
+
       if (!UTI_IsZeroTimespec(&ts3.ts[2])) {
         iface = get_interface(ts_if_index);
         if (iface) {
@@ -701,3 +759,42 @@ NIO_Linux_RequestTxTimestamp(struct msghdr *msg, int cmsglen, int sock_fd)
 
   return cmsglen;
 }
+
+/* ================================================== */
+
+int
+NIO_Linux_HasTxTimestamps(void)
+{
+  return ts_flags != 0;
+}
+
+/* ================================================== */
+
+int
+NIO_Linux_GetNumberOfInterfaces(void)
+{
+  return ARR_GetSize(interfaces);
+}
+
+/* ================================================== */
+
+int
+NIO_Linux_GetReport(int index, RPT_HwClockReport *report)
+{
+  struct Interface *iface;
+
+  if (index < 0 || index >= ARR_GetSize(interfaces))
+    return 0;
+
+  iface = ARR_GetElement(interfaces, index);
+
+  HCL_GetReport(iface->clock, report);
+  snprintf(report->name, sizeof (report->name), "%s", iface->name);
+  report->phc_readings = iface->phc_readings;
+  report->phc_read_time = iface->phc_readings > 0 ?
+                          iface->phc_read_time / iface->phc_readings : 0.0;
+  report->phc_read_max = iface->phc_read_max;
+  report->phc_error = iface->phc_error;
+
+  return 1;
+}
@@ -34,3 +34,9 @@ extern int NIO_Linux_ProcessMessage(NTP_Remote_Address *remote_addr, NTP_Local_A
                                     NTP_Local_Timestamp *local_ts, struct msghdr *hdr, int length);
 
 extern int NIO_Linux_RequestTxTimestamp(struct msghdr *msg, int cmsglen, int sock_fd);
+
+extern int NIO_Linux_HasTxTimestamps(void);
+
+extern int NIO_Linux_GetNumberOfInterfaces(void);
+
+extern int NIO_Linux_GetReport(int index, RPT_HwClockReport *report);
@@ -78,29 +78,64 @@ typedef struct {
   SigndResponse response;
 } SignInstance;
 
-/* As the communication with ntp_signd is asynchronous, incoming packets are
-   saved in a queue in order to avoid loss when they come in bursts */
+/* Connection to ntp_signd.  Each connection has at most one request in
+   progress, requests are signed concurrently over multiple connections. */
+
+typedef struct {
+  int sock_fd;
+  int busy;
+  SignInstance inst;
+} Connection;
+
+#define INVALID_SOCK_FD -1
+
+/* Array of Connection */
+static ARR_Instance connections;
 
-#define MAX_QUEUE_LENGTH 16U
-#define NEXT_QUEUE_INDEX(index) (((index) + 1) % MAX_QUEUE_LENGTH)
-#define IS_QUEUE_EMPTY() (queue_head == queue_tail)
+/* Number of open connections */
+static int open_connections;
 
-/* Fixed-size array of SignInstance */
+/* As the communication with ntp_signd is asynchronous, incoming packets are
+   saved in a queue when all connections are busy in order to avoid loss when
+   they come in bursts.  The queue grows as needed up to its maximum length. */
+
+/* Array of SignInstance, the waiting requests start at queue_head */
 static ARR_Instance queue;
 static unsigned int queue_head;
-static unsigned int queue_tail;
+static unsigned int max_queue_length;
 
-#define INVALID_SOCK_FD -1
+#define QUEUE_LENGTH() (ARR_GetSize(queue) - queue_head)
 
-/* Unix domain socket connected to ntp_signd */
-static int sock_fd;
+/* Minimum number of removed requests to be dropped from the array */
+#define MIN_QUEUE_SHIFT 64
+
+/* ID of the next request */
+static uint16_t next_packet_id;
+
+/* Statistics of the requests */
+static uint32_t n_requests;
+static uint32_t n_successes;
+static uint32_t n_failures;
+static uint32_t n_drops;
+static uint32_t n_queued;
+static uint32_t peak_queue_length;
 
 #define MIN_AUTH_DELAY 1.0e-5
 #define MAX_AUTH_DELAY 1.0e-2
 
-/* Average time needed for signing one packet.  This is used to adjust the
-   transmit timestamp in NTP packets.  The timestamp won't be very accurate as
-   the delay is variable, but it should be good enough for MS-SNTP clients. */
+/* Histogram of the time needed for signing a packet, including the time
+   spent in the queue.  There are 4 buckets per octave between the minimum
+   and maximum delay.  The counts are exponentially decaying to follow changes
+   in the load of the signing daemon. */
+#define DELAY_BUCKETS_PER_OCTAVE 4
+#define DELAY_HISTOGRAM_BUCKETS 40
+#define DELAY_HISTOGRAM_DECAY (1.0 / 1024)
+
+static double delay_histogram[DELAY_HISTOGRAM_BUCKETS];
+
+/* Median of the histogram, which is used to adjust the transmit timestamp in
+   NTP packets.  The timestamp won't be very accurate as the delay is variable,
+   but it should be good enough for MS-SNTP clients. */
 static double auth_delay;
 
 /* Flag indicating if the MS-SNTP authentication is enabled */
@@ -112,57 +147,176 @@ static void read_write_socket(int sock_fd, int event, void *anything);
 
 /* ================================================== */
 
+static double
+get_delay_quantile(double q)
+{
+  double sum, limit;
+  int i;
+
+  for (i = 0, sum = 0.0; i < DELAY_HISTOGRAM_BUCKETS; i++)
+    sum += delay_histogram[i];
+
+  if (sum <= 0.0)
+    return MIN_AUTH_DELAY;
+
+  limit = q * sum;
+
+  for (i = 0, sum = 0.0; i < DELAY_HISTOGRAM_BUCKETS - 1; i++) {
+    sum += delay_histogram[i];
+    if (sum >= limit)
+      break;
+  }
+
+  /* Return the geometric centre of the bucket */
+  return MIN_AUTH_DELAY * pow(2.0, (i + 0.5) / DELAY_BUCKETS_PER_OCTAVE);
+}
+
+/* ================================================== */
+
 static void
-close_socket(void)
+update_delay_histogram(double delay)
 {
-  SCH_RemoveFileHandler(sock_fd);
-  close(sock_fd);
-  sock_fd = INVALID_SOCK_FD;
+  int i, bucket;
 
-  /* Empty the queue */
-  queue_head = queue_tail = 0;
+  delay = CLAMP(MIN_AUTH_DELAY, delay, MAX_AUTH_DELAY);
+  bucket = DELAY_BUCKETS_PER_OCTAVE * log(delay / MIN_AUTH_DELAY) / log(2.0);
+  bucket = CLAMP(0, bucket, DELAY_HISTOGRAM_BUCKETS - 1);
+
+  for (i = 0; i < DELAY_HISTOGRAM_BUCKETS; i++)
+    delay_histogram[i] *= 1.0 - DELAY_HISTOGRAM_DECAY;
+  delay_histogram[bucket] += DELAY_HISTOGRAM_DECAY;
+
+  auth_delay = get_delay_quantile(0.5);
+}
+
+/* ================================================== */
+
+static void
+close_socket(Connection *conn)
+{
+  SCH_RemoveFileHandler(conn->sock_fd);
+  close(conn->sock_fd);
+  conn->sock_fd = INVALID_SOCK_FD;
+  open_connections--;
+
+  /* Drop the request in progress */
+  if (conn->busy) {
+    conn->busy = 0;
+    n_failures++;
+  }
 }
 
 /* ================================================== */
 
 static int
-open_socket(void)
+open_socket(Connection *conn)
 {
   struct sockaddr_un s;
 
-  if (sock_fd >= 0)
+  if (conn->sock_fd >= 0)
     return 1;
 
-  sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (sock_fd < 0) {
+  conn->sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (conn->sock_fd < 0) {
     DEBUG_LOG("Could not open signd socket : %s", strerror(errno));
     return 0;
   }
 
-  UTI_FdSetCloexec(sock_fd);
-  SCH_AddFileHandler(sock_fd, SCH_FILE_INPUT, read_write_socket, NULL);
+  open_connections++;
+
+  UTI_FdSetCloexec(conn->sock_fd);
+  SCH_AddFileHandler(conn->sock_fd, SCH_FILE_INPUT, read_write_socket, conn);
 
   s.sun_family = AF_UNIX;
   if (snprintf(s.sun_path, sizeof (s.sun_path), "%s/socket",
                CNF_GetNtpSigndSocket()) >= sizeof (s.sun_path)) {
     DEBUG_LOG("signd socket path too long");
-    close_socket();
+    close_socket(conn);
     return 0;
   }
 
-  if (connect(sock_fd, (struct sockaddr *)&s, sizeof (s)) < 0) {
+  if (connect(conn->sock_fd, (struct sockaddr *)&s, sizeof (s)) < 0) {
     DEBUG_LOG("Could not connect to signd : %s", strerror(errno));
-    close_socket();
+    close_socket(conn);
     return 0;
   }
 
-  DEBUG_LOG("Connected to signd");
+  DEBUG_LOG("Connected to signd (%d connections)", open_connections);
 
   return 1;
 }
 
 /* ================================================== */
 
+static void
+start_request(Connection *conn, SignInstance *inst)
+{
+  conn->inst = *inst;
+  conn->inst.request.packet_id = htons(next_packet_id++);
+  conn->busy = 1;
+
+  /* Enable output to send the request */
+  SCH_SetFileHandlerEvents(conn->sock_fd, SCH_FILE_INPUT | SCH_FILE_OUTPUT);
+}
+
+/* ================================================== */
+
+static SignInstance *
+get_queued_request(void)
+{
+  SignInstance *inst;
+  unsigned int length;
+
+  if (QUEUE_LENGTH() == 0)
+    return NULL;
+
+  inst = ARR_GetElement(queue, queue_head++);
+
+  /* Drop removed requests from the array when they make at least half
+     of it.  The returned pointer stays valid until the next call. */
+  length = QUEUE_LENGTH();
+  if (queue_head >= MIN_QUEUE_SHIFT && queue_head >= length) {
+    memcpy(ARR_GetElements(queue), inst, sizeof (*inst));
+    memmove((SignInstance *)ARR_GetElements(queue) + 1,
+            (SignInstance *)ARR_GetElements(queue) + queue_head,
+            length * sizeof (*inst));
+    ARR_SetSize(queue, length + 1);
+    queue_head = 1;
+    inst = ARR_GetElement(queue, 0);
+  }
+
+  return inst;
+}
+
+/* ================================================== */
+
+static void
+dispatch_requests(void)
+{
+  Connection *conn;
+  SignInstance *inst;
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(connections) && QUEUE_LENGTH() > 0; i++) {
+    conn = ARR_GetElement(connections, i);
+    if (conn->busy || !open_socket(conn))
+      continue;
+
+    inst = get_queued_request();
+    start_request(conn, inst);
+  }
+
+  /* Drop the waiting requests if no connection can be opened */
+  if (open_connections == 0 && QUEUE_LENGTH() > 0) {
+    DEBUG_LOG("Dropping %u queued requests", QUEUE_LENGTH());
+    n_failures += QUEUE_LENGTH();
+    ARR_SetSize(queue, 0);
+    queue_head = 0;
+  }
+}
+
+/* ================================================== */
+
 static void
 process_response(SignInstance *inst)
 {
@@ -171,17 +325,20 @@ process_response(SignInstance *inst)
 
   if (ntohs(inst->request.packet_id) != ntohl(inst->response.packet_id)) {
     DEBUG_LOG("Invalid response ID");
+    n_failures++;
     return;
   }
 
   if (ntohl(inst->response.op) != SIGNING_SUCCESS) {
     DEBUG_LOG("Signing failed");
+    n_failures++;
     return;
   }
 
   /* Check if the file descriptor is still valid */
   if (!NIO_IsServerSocket(inst->local_addr.sock_fd)) {
     DEBUG_LOG("Invalid NTP socket");
+    n_failures++;
     return;
   }
 
@@ -195,9 +352,8 @@ process_response(SignInstance *inst)
                  ntohl(inst->response.length) + sizeof (inst->response.length) -
                  offsetof(SigndResponse, signed_packet), 0);
 
-  /* Update exponential moving average of the authentication delay */
-  delay = CLAMP(MIN_AUTH_DELAY, delay, MAX_AUTH_DELAY);
-  auth_delay += 0.1 * (delay - auth_delay);
+  n_successes++;
+  update_delay_histogram(delay);
 }
 
 /* ================================================== */
@@ -205,25 +361,24 @@ process_response(SignInstance *inst)
 static void
 read_write_socket(int sock_fd, int event, void *anything)
 {
+  Connection *conn = anything;
   SignInstance *inst;
   uint32_t response_length;
   int s;
 
-  inst = ARR_GetElement(queue, queue_head);
+  inst = &conn->inst;
 
   if (event == SCH_FILE_OUTPUT) {
-    assert(!IS_QUEUE_EMPTY());
+    assert(conn->busy);
     assert(inst->sent < inst->request_length);
 
-    if (!inst->sent)
-      SCH_GetLastEventTime(NULL, NULL, &inst->request_ts);
-
     s = send(sock_fd, (char *)&inst->request + inst->sent,
              inst->request_length - inst->sent, 0);
 
     if (s < 0) {
       DEBUG_LOG("signd socket error: %s", strerror(errno));
-      close_socket();
+      close_socket(conn);
+      dispatch_requests();
       return;
     }
 
@@ -239,9 +394,10 @@ read_write_socket(int sock_fd, int event, void *anything)
   }
 
   if (event == SCH_FILE_INPUT) {
-    if (IS_QUEUE_EMPTY()) {
+    if (!conn->busy) {
         DEBUG_LOG("Unexpected signd response");
-        close_socket();
+        close_socket(conn);
+        dispatch_requests();
         return;
     }
 
@@ -255,7 +411,8 @@ read_write_socket(int sock_fd, int event, void *anything)
       else
         DEBUG_LOG("signd socket closed");
 
-      close_socket();
+      close_socket(conn);
+      dispatch_requests();
       return;
     }
 
@@ -270,7 +427,8 @@ read_write_socket(int sock_fd, int event, void *anything)
     if (response_length < offsetof(SigndResponse, signed_packet) ||
         response_length > sizeof (SigndResponse)) {
       DEBUG_LOG("Invalid response length");
-      close_socket();
+      close_socket(conn);
+      dispatch_requests();
       return;
     }
 
@@ -279,11 +437,12 @@ read_write_socket(int sock_fd, int event, void *anything)
       return;
 
     process_response(inst);
+    conn->busy = 0;
 
-    /* Move the head and enable output for the next packet */
-    queue_head = NEXT_QUEUE_INDEX(queue_head);
-    if (!IS_QUEUE_EMPTY())
-      SCH_SetFileHandlerEvents(sock_fd, SCH_FILE_INPUT | SCH_FILE_OUTPUT);
+    /* Continue with the next request in the queue */
+    inst = get_queued_request();
+    if (inst)
+      start_request(conn, inst);
   }
 }
 
@@ -292,16 +451,32 @@ read_write_socket(int sock_fd, int event, void *anything)
 void
 NSD_Initialise()
 {
-  sock_fd = INVALID_SOCK_FD;
+  Connection *conn;
+  int i, n_connections;
+
   auth_delay = MIN_AUTH_DELAY;
+  memset(delay_histogram, 0, sizeof (delay_histogram));
+  n_requests = n_successes = n_failures = n_drops = n_queued = 0;
+  peak_queue_length = 0;
+  open_connections = 0;
+  next_packet_id = 0;
   enabled = CNF_GetNtpSigndSocket() && CNF_GetNtpSigndSocket()[0];
 
   if (!enabled)
     return;
 
+  CNF_GetNtpSigndLimits(&n_connections, &i);
+  max_queue_length = i;
+
+  connections = ARR_CreateInstance(sizeof (Connection));
+  for (i = 0; i < n_connections; i++) {
+    conn = ARR_GetNewElement(connections);
+    conn->sock_fd = INVALID_SOCK_FD;
+    conn->busy = 0;
+  }
+
   queue = ARR_CreateInstance(sizeof (SignInstance));
-  ARR_SetSize(queue, MAX_QUEUE_LENGTH);
-  queue_head = queue_tail = 0;
+  queue_head = 0;
 
   LOG(LOGS_INFO, "MS-SNTP authentication enabled");
 }
@@ -311,10 +486,19 @@ NSD_Initialise()
 void
 NSD_Finalise()
 {
+  Connection *conn;
+  unsigned int i;
+
   if (!enabled)
     return;
-  if (sock_fd != INVALID_SOCK_FD)
-    close_socket();
+
+  for (i = 0; i < ARR_GetSize(connections); i++) {
+    conn = ARR_GetElement(connections, i);
+    if (conn->sock_fd != INVALID_SOCK_FD)
+      close_socket(conn);
+  }
+
+  ARR_DestroyInstance(connections);
   ARR_DestroyInstance(queue);
 }
 
@@ -337,43 +521,85 @@ NSD_SignAndSendPacket(uint32_t key_id, NTP_Packet *packet, NTP_Remote_Address *r
     return 0;
   }
 
-  if (queue_head == NEXT_QUEUE_INDEX(queue_tail)) {
-    DEBUG_LOG("signd queue full");
-    return 0;
-  }
-
   if (length != NTP_NORMAL_PACKET_LENGTH) {
     DEBUG_LOG("Invalid packet length");
     return 0;
   }
 
-  if (!open_socket())
-    return 0;
+  n_requests++;
+
+  /* Reuse the array if all previous requests were removed */
+  if (QUEUE_LENGTH() == 0) {
+    ARR_SetSize(queue, 0);
+    queue_head = 0;
+  }
 
-  inst = ARR_GetElement(queue, queue_tail);
+  inst = ARR_GetNewElement(queue);
   inst->remote_addr = *remote_addr;
   inst->local_addr = *local_addr;
   inst->sent = 0;
   inst->received = 0;
   inst->request_length = offsetof(SigndRequest, packet_to_sign) + length;
 
+  /* Include the time spent in the queue in the delay */
+  SCH_GetLastEventTime(NULL, NULL, &inst->request_ts);
+
   /* The length field doesn't include itself */
   inst->request.length = htonl(inst->request_length - sizeof (inst->request.length));
   inst->request.version = htonl(SIGND_VERSION);
   inst->request.op = htonl(SIGN_TO_CLIENT);
-  inst->request.packet_id = htons(queue_tail);
+  inst->request.packet_id = 0;
   inst->request._pad = 0;
   inst->request.key_id = htonl(key_id);
 
   memcpy(&inst->request.packet_to_sign, packet, length);
 
-  /* Enable output if there was no pending request */
-  if (IS_QUEUE_EMPTY())
-    SCH_SetFileHandlerEvents(sock_fd, SCH_FILE_INPUT | SCH_FILE_OUTPUT);
+  /* Start the request if a connection is free */
+  dispatch_requests();
+
+  /* The request was dropped if no connection could be opened */
+  if (open_connections == 0)
+    return 0;
+
+  if (QUEUE_LENGTH() > 0) {
+    /* Remove the new request from the end of the queue if it is full */
+    if (QUEUE_LENGTH() > max_queue_length) {
+      DEBUG_LOG("signd queue full");
+      ARR_SetSize(queue, ARR_GetSize(queue) - 1);
+      n_drops++;
+      return 0;
+    }
+
+    n_queued++;
+    if (peak_queue_length < QUEUE_LENGTH())
+      peak_queue_length = QUEUE_LENGTH();
 
-  queue_tail = NEXT_QUEUE_INDEX(queue_tail);
+    DEBUG_LOG("Packet added to signd queue (%u)", QUEUE_LENGTH());
+  }
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+NSD_GetReport(RPT_SigndReport *report)
+{
+  if (!enabled)
+    return 0;
 
-  DEBUG_LOG("Packet added to signd queue (%u:%u)", queue_head, queue_tail);
+  report->connections = ARR_GetSize(connections);
+  report->open_connections = open_connections;
+  report->queue_length = QUEUE_LENGTH();
+  report->max_queue_length = max_queue_length;
+  report->peak_queue_length = peak_queue_length;
+  report->requests = n_requests;
+  report->successes = n_successes;
+  report->failures = n_failures;
+  report->drops = n_drops;
+  report->queued = n_queued;
+  report->median_delay = get_delay_quantile(0.5);
+  report->p99_delay = get_delay_quantile(0.99);
 
   return 1;
 }
@@ -28,6 +28,7 @@
 
 #include "addressing.h"
 #include "ntp.h"
+#include "reports.h"
 
 /* Initialisation function */
 extern void NSD_Initialise(void);
@@ -41,4 +42,8 @@ extern int NSD_GetAuthDelay(uint32_t key_id);
 /* Function to sign an NTP packet and send it */
 extern int NSD_SignAndSendPacket(uint32_t key_id, NTP_Packet *packet, NTP_Remote_Address *remote_addr, NTP_Local_Address *local_addr, int length);
 
+/* Function to get statistics of the signing requests.  Returns zero if
+   the MS-SNTP authentication is disabled. */
+extern int NSD_GetReport(RPT_SigndReport *report);
+
 #endif
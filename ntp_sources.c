@@ -32,6 +32,7 @@
 #include "sysincl.h"
 
 #include "array.h"
+#include "conf.h"
 #include "ntp_sources.h"
 #include "ntp_core.h"
 #include "util.h"
@@ -55,15 +56,34 @@ typedef struct {
                                    added or INVALID_POOL */
   int tentative;                /* Flag indicating there was no valid response
                                    received from the source yet */
+  int removed;                  /* Flag indicating the slot is not in use, but
+                                   it may be in a probe sequence of other
+                                   sources */
+  uint32_t conf_id;             /* Configuration ID of the source, or zero
+                                   if it was not added from configuration */
 } SourceRecord;
 
 /* Hash table of SourceRecord, its size is a power of two and it's never
-   more than half full */
+   more than half full (including slots of removed sources) */
 static ARR_Instance records;
 
 /* Number of sources in the hash table */
 static int n_sources;
 
+/* Number of slots of removed sources in the hash table */
+static int n_removed;
+
+/* Entry of the index of sources sorted by their address, which allows
+   operations with a subnet to find the matching sources without walking
+   the whole hash table */
+typedef struct {
+  IPAddr ip_addr;
+  NCR_Instance data;
+} AddressIndexEntry;
+
+/* Array of AddressIndexEntry */
+static ARR_Instance address_index;
+
 /* Flag indicating new sources will be started automatically when added */
 static int auto_start_sources = 0;
 
@@ -73,12 +93,14 @@ struct UnresolvedSource {
   int port;
   int random_order;
   int replacement;
+  int resolving;
   union {
     struct {
       NTP_Source_Type type;
       SourceParameters params;
       int pool;
       int max_new_sources;
+      uint32_t conf_id;
     } new_source;
     NTP_Remote_Address replace_source;
   };
@@ -93,7 +115,13 @@ struct UnresolvedSource {
 static struct UnresolvedSource *unresolved_sources = NULL;
 static int resolving_interval = 0;
 static SCH_TimeoutID resolving_id;
+
+/* Next source to be resolved in the current round of resolving, the number
+   of sources being resolved, and the maximum number of sources resolved
+   concurrently */
 static struct UnresolvedSource *resolving_source = NULL;
+static int resolving_sources = 0;
+static int max_resolving_sources = 1;
 static NSR_SourceResolvingEndHandler resolving_end_handler = NULL;
 
 #define MAX_POOL_SOURCES 16
@@ -110,6 +138,9 @@ struct SourcePool {
 /* Array of SourcePool */
 static ARR_Instance pools;
 
+/* Last assigned configuration ID */
+static uint32_t last_conf_id;
+
 /* ================================================== */
 /* Forward prototypes */
 
@@ -144,11 +175,18 @@ void
 NSR_Initialise(void)
 {
   n_sources = 0;
+  n_removed = 0;
+  last_conf_id = 0;
   initialised = 1;
 
+  /* In the fast-start mode resolve the names concurrently */
+  max_resolving_sources = CNF_GetFastStart() ? DNS_MAX_ASYNC_REQUESTS : 1;
+
   records = ARR_CreateInstance(sizeof (SourceRecord));
   rehash_records();
 
+  address_index = ARR_CreateInstance(sizeof (AddressIndexEntry));
+
   pools = ARR_CreateInstance(sizeof (struct SourcePool));
 
   LCL_AddParameterChangeHandler(slew_sources, NULL);
@@ -172,6 +210,7 @@ NSR_Finalise(void)
   }
 
   ARR_DestroyInstance(records);
+  ARR_DestroyInstance(address_index);
 
   while (unresolved_sources) {
     us = unresolved_sources;
@@ -195,6 +234,8 @@ NSR_Finalise(void)
    match the IP address we stop the search regardless of whether the
    port number matches.
 
+   If the address is not found, the returned slot is the first empty slot
+   or slot of a removed source in the probe sequence.
   */
 
 static void
@@ -204,6 +245,7 @@ find_slot(NTP_Remote_Address *remote_addr, int *slot, int *found)
   uint32_t hash;
   unsigned int i, size;
   unsigned short port;
+  int free_slot;
 
   size = ARR_GetSize(records);
   
@@ -215,14 +257,21 @@ find_slot(NTP_Remote_Address *remote_addr, int *slot, int *found)
 
   hash = UTI_IPToHash(&remote_addr->ip_addr);
   port = remote_addr->port;
+  free_slot = -1;
+  *slot = 0;
 
   for (i = 0; i < size / 2; i++) {
     /* Use quadratic probing */
     *slot = (hash + (i + i * i) / 2) % size;
     record = get_record(*slot);
 
-    if (!record->remote_addr)
-      break;
+    if (!record->remote_addr) {
+      if (!record->removed)
+        break;
+      if (free_slot < 0)
+        free_slot = *slot;
+      continue;
+    }
 
     if (!UTI_CompareIPs(&record->remote_addr->ip_addr,
                         &remote_addr->ip_addr, NULL)) {
@@ -231,6 +280,9 @@ find_slot(NTP_Remote_Address *remote_addr, int *slot, int *found)
     }
   }
 
+  if (free_slot >= 0)
+    *slot = free_slot;
+
   *found = 0;
 }
 
@@ -263,8 +315,12 @@ rehash_records(void)
 
   ARR_SetSize(records, new_size);
 
-  for (i = 0; i < new_size; i++)
+  for (i = 0; i < new_size; i++) {
     get_record(i)->remote_addr = NULL;
+    get_record(i)->removed = 0;
+  }
+
+  n_removed = 0;
 
   for (i = 0; i < old_size; i++) {
     if (!temp_records[i].remote_addr)
@@ -279,11 +335,147 @@ rehash_records(void)
   Free(temp_records);
 }
 
+/* ================================================== */
+/* Remove slots of removed sources if there are too many of them, or shrink
+   the hash table if it is much larger than needed */
+
+static void
+check_removed_records(void)
+{
+  unsigned int size = ARR_GetSize(records);
+
+  if (!check_hashtable_size(n_sources + n_removed, size) ||
+      (size > 1 && check_hashtable_size(4 * n_sources, size)))
+    rehash_records();
+}
+
+/* ================================================== */
+/* Compare two addresses in the order of the address index */
+
+static int
+compare_index_addresses(IPAddr *a, IPAddr *b)
+{
+  if (a->family != b->family)
+    return a->family < b->family ? -1 : 1;
+
+  switch (a->family) {
+    case IPADDR_INET4:
+      return a->addr.in4 < b->addr.in4 ? -1 : a->addr.in4 > b->addr.in4;
+    case IPADDR_INET6:
+      return memcmp(a->addr.in6, b->addr.in6, sizeof (a->addr.in6));
+    default:
+      return 0;
+  }
+}
+
+/* ================================================== */
+/* Find the first entry of the address index which is not smaller than
+   the address (or larger if upper is set) */
+
+static unsigned int
+find_index_position(IPAddr *ip_addr, int upper)
+{
+  AddressIndexEntry *entries;
+  unsigned int first, end, middle;
+  int d;
+
+  entries = ARR_GetElements(address_index);
+
+  for (first = 0, end = ARR_GetSize(address_index); first < end; ) {
+    middle = first + (end - first) / 2;
+    d = compare_index_addresses(&entries[middle].ip_addr, ip_addr);
+    if (d < 0 || (upper && d == 0))
+      first = middle + 1;
+    else
+      end = middle;
+  }
+
+  return first;
+}
+
+/* ================================================== */
+
+static void
+add_to_index(NCR_Instance data)
+{
+  AddressIndexEntry *entries;
+  unsigned int i, n;
+  IPAddr *ip_addr;
+
+  ip_addr = &NCR_GetRemoteAddress(data)->ip_addr;
+  i = find_index_position(ip_addr, 0);
+
+  ARR_GetNewElement(address_index);
+  entries = ARR_GetElements(address_index);
+  n = ARR_GetSize(address_index);
+
+  memmove(&entries[i + 1], &entries[i], (n - i - 1) * sizeof (entries[0]));
+  entries[i].ip_addr = *ip_addr;
+  entries[i].data = data;
+}
+
+/* ================================================== */
+
+static void
+remove_from_index(NCR_Instance data)
+{
+  AddressIndexEntry *entries;
+  unsigned int i, n;
+
+  i = find_index_position(&NCR_GetRemoteAddress(data)->ip_addr, 0);
+  entries = ARR_GetElements(address_index);
+  n = ARR_GetSize(address_index);
+
+  assert(i < n && entries[i].data == data);
+
+  memmove(&entries[i], &entries[i + 1], (n - i - 1) * sizeof (entries[0]));
+  ARR_SetSize(address_index, n - 1);
+}
+
+/* ================================================== */
+/* Get the range of the address index which contains all sources matching
+   the address with the mask */
+
+static void
+get_index_range(IPAddr *mask, IPAddr *address, unsigned int *first, unsigned int *end)
+{
+  IPAddr low, high;
+  int i;
+
+  low = high = *address;
+
+  if (mask->family == address->family) {
+    switch (address->family) {
+      case IPADDR_INET4:
+        low.addr.in4 &= mask->addr.in4;
+        high.addr.in4 |= ~mask->addr.in4;
+        break;
+      case IPADDR_INET6:
+        for (i = 0; i < 16; i++) {
+          low.addr.in6[i] &= mask->addr.in6[i];
+          high.addr.in6[i] |= ~mask->addr.in6[i];
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (address->family == IPADDR_UNSPEC) {
+    *first = 0;
+    *end = ARR_GetSize(address_index);
+  } else {
+    *first = find_index_position(&low, 0);
+    *end = find_index_position(&high, 1);
+  }
+}
+
 /* ================================================== */
 
 /* Procedure to add a new source */
 static NSR_Status
-add_source(NTP_Remote_Address *remote_addr, char *name, NTP_Source_Type type, SourceParameters *params, int pool)
+add_source(NTP_Remote_Address *remote_addr, char *name, NTP_Source_Type type, SourceParameters *params,
+           int pool, uint32_t conf_id)
 {
   SourceRecord *record;
   int slot, found;
@@ -301,7 +493,9 @@ add_source(NTP_Remote_Address *remote_addr, char *name, NTP_Source_Type type, So
     } else {
       n_sources++;
 
-      if (!check_hashtable_size(n_sources, ARR_GetSize(records))) {
+      if (get_record(slot)->removed) {
+        n_removed--;
+      } else if (!check_hashtable_size(n_sources + n_removed, ARR_GetSize(records))) {
         rehash_records();
         find_slot(remote_addr, &slot, &found);
       }
@@ -313,6 +507,10 @@ add_source(NTP_Remote_Address *remote_addr, char *name, NTP_Source_Type type, So
       record->name = name ? Strdup(name) : NULL;
       record->pool = pool;
       record->tentative = 1;
+      record->removed = 0;
+      record->conf_id = conf_id;
+
+      add_to_index(record->data);
 
       if (auto_start_sources)
         NCR_StartInstance(record->data);
@@ -328,7 +526,7 @@ static NSR_Status
 replace_source(NTP_Remote_Address *old_addr, NTP_Remote_Address *new_addr)
 {
   int slot1, slot2, found;
-  SourceRecord *record;
+  SourceRecord *record, temp_record;
   struct SourcePool *pool;
 
   find_slot(old_addr, &slot1, &found);
@@ -339,9 +537,23 @@ replace_source(NTP_Remote_Address *old_addr, NTP_Remote_Address *new_addr)
   if (found)
     return NSR_AlreadyInUse;
 
+  /* Move the record to the slot of the new address and leave the old slot
+     marked as removed to not break probe sequences of other sources */
   record = get_record(slot1);
-  NCR_ChangeRemoteAddress(record->data, new_addr);
-  record->remote_addr = NCR_GetRemoteAddress(record->data);
+  temp_record = *record;
+  record->remote_addr = NULL;
+  record->removed = 1;
+  n_removed++;
+
+  remove_from_index(temp_record.data);
+  NCR_ChangeRemoteAddress(temp_record.data, new_addr);
+  temp_record.remote_addr = NCR_GetRemoteAddress(temp_record.data);
+  add_to_index(temp_record.data);
+
+  record = get_record(slot2);
+  if (record->removed)
+    n_removed--;
+  *record = temp_record;
 
   if (!record->tentative) {
     record->tentative = 1;
@@ -352,8 +564,7 @@ replace_source(NTP_Remote_Address *old_addr, NTP_Remote_Address *new_addr)
     }
   }
 
-  /* The hash table must be rebuilt for the new address */
-  rehash_records();
+  check_removed_records();
 
   LOG(LOGS_INFO, "Source %s replaced with %s",
       UTI_IPToString(&old_addr->ip_addr),
@@ -384,26 +595,75 @@ process_resolved_name(struct UnresolvedSource *us, IPAddr *ip_addrs, int n_addrs
       if (replace_source(&us->replace_source, &address) != NSR_AlreadyInUse)
         break;
     } else {
-      if (add_source(&address, us->name, us->new_source.type, &us->new_source.params,
-                     us->new_source.pool) == NSR_Success)
-        added++;
-
       if (added >= us->new_source.max_new_sources)
         break;
+
+      if (add_source(&address, us->name, us->new_source.type, &us->new_source.params,
+                     us->new_source.pool, us->new_source.conf_id) == NSR_Success)
+        added++;
     }
   }
 }
 
 /* ================================================== */
 
+static void
+end_resolving_round(void)
+{
+  /* If some sources couldn't be resolved, try again in exponentially
+     increasing interval */
+  if (unresolved_sources) {
+    if (resolving_interval < MIN_RESOLVE_INTERVAL)
+      resolving_interval = MIN_RESOLVE_INTERVAL;
+    else if (resolving_interval < MAX_RESOLVE_INTERVAL)
+      resolving_interval++;
+    resolving_id = SCH_AddTimeoutByDelay(RESOLVE_INTERVAL_UNIT *
+        (1 << resolving_interval), resolve_sources, NULL);
+  } else {
+    resolving_interval = 0;
+  }
+
+  /* This round of resolving is done */
+  if (resolving_end_handler)
+    (resolving_end_handler)();
+}
+
+/* ================================================== */
+
+static void name_resolve_handler(DNS_Status status, int n_addrs, IPAddr *ip_addrs,
+                                 void *anything);
+
+static void
+start_resolving(void)
+{
+  struct UnresolvedSource *us;
+
+  while (resolving_source && resolving_sources < max_resolving_sources) {
+    us = resolving_source;
+    resolving_source = us->next;
+    us->resolving = 1;
+    resolving_sources++;
+
+    DEBUG_LOG("resolving %s", us->name);
+    DNS_Name2IPAddressAsync(us->name, name_resolve_handler, us);
+  }
+
+  if (!resolving_sources)
+    end_resolving_round();
+}
+
+/* ================================================== */
+
 static void
 name_resolve_handler(DNS_Status status, int n_addrs, IPAddr *ip_addrs, void *anything)
 {
-  struct UnresolvedSource *us, **i, *next;
+  struct UnresolvedSource *us, **i;
 
   us = (struct UnresolvedSource *)anything;
 
-  assert(us == resolving_source);
+  assert(us->resolving && resolving_sources > 0);
+  us->resolving = 0;
+  resolving_sources--;
 
   DEBUG_LOG("%s resolved to %d addrs", us->name, n_addrs);
 
@@ -420,11 +680,9 @@ name_resolve_handler(DNS_Status status, int n_addrs, IPAddr *ip_addrs, void *any
       assert(0);
   }
 
-  next = us->next;
-
   /* Remove the source from the list on success or failure, replacements
-     are removed on any status */
-  if (us->replacement || status != DNS_TryAgain) {
+     and sources removed while being resolved are removed on any status */
+  if (us->replacement || status != DNS_TryAgain || !us->new_source.max_new_sources) {
     for (i = &unresolved_sources; *i; i = &(*i)->next) {
       if (*i == us) {
         *i = us->next;
@@ -435,30 +693,8 @@ name_resolve_handler(DNS_Status status, int n_addrs, IPAddr *ip_addrs, void *any
     }
   }
 
-  resolving_source = next;
-
-  if (next) {
-    /* Continue with the next source in the list */
-    DEBUG_LOG("resolving %s", next->name);
-    DNS_Name2IPAddressAsync(next->name, name_resolve_handler, next);
-  } else {
-    /* This was the last source in the list. If some sources couldn't
-       be resolved, try again in exponentially increasing interval. */
-    if (unresolved_sources) {
-      if (resolving_interval < MIN_RESOLVE_INTERVAL)
-        resolving_interval = MIN_RESOLVE_INTERVAL;
-      else if (resolving_interval < MAX_RESOLVE_INTERVAL)
-        resolving_interval++;
-      resolving_id = SCH_AddTimeoutByDelay(RESOLVE_INTERVAL_UNIT *
-          (1 << resolving_interval), resolve_sources, NULL);
-    } else {
-      resolving_interval = 0;
-    }
-
-    /* This round of resolving is done */
-    if (resolving_end_handler)
-      (resolving_end_handler)();
-  }
+  /* Continue with the next sources in the list */
+  start_resolving();
 }
 
 /* ================================================== */
@@ -466,19 +702,14 @@ name_resolve_handler(DNS_Status status, int n_addrs, IPAddr *ip_addrs, void *any
 static void
 resolve_sources(void *arg)
 {
-  struct UnresolvedSource *us;
-
-  assert(!resolving_source);
+  assert(!resolving_sources);
 
   PRV_ReloadDNS();
 
-  /* Start with the first source in the list, name_resolve_handler
-     will iterate over the rest */
-  us = unresolved_sources;
-
-  resolving_source = us;
-  DEBUG_LOG("resolving %s", us->name);
-  DNS_Name2IPAddressAsync(us->name, name_resolve_handler, us);
+  /* Start with the first sources in the list, name_resolve_handler
+     will continue with the rest */
+  resolving_source = unresolved_sources;
+  start_resolving();
 }
 
 /* ================================================== */
@@ -492,20 +723,45 @@ append_unresolved_source(struct UnresolvedSource *us)
     ;
   *i = us;
   us->next = NULL;
+  us->resolving = 0;
+
+  /* Include the source in the current round of resolving */
+  if (resolving_sources && !resolving_source)
+    resolving_source = us;
+}
+
+/* ================================================== */
+
+static uint32_t
+get_new_conf_id(uint32_t *conf_id)
+{
+  if (!conf_id)
+    return 0;
+
+  /* Zero is reserved for sources not added from configuration */
+  if (++last_conf_id == 0)
+    last_conf_id++;
+
+  *conf_id = last_conf_id;
+
+  return *conf_id;
 }
 
 /* ================================================== */
 
 NSR_Status
-NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourceParameters *params)
+NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourceParameters *params,
+              uint32_t *conf_id)
 {
-  return add_source(remote_addr, NULL, type, params, INVALID_POOL);
+  return add_source(remote_addr, NULL, type, params, INVALID_POOL,
+                    get_new_conf_id(conf_id));
 }
 
 /* ================================================== */
 
 void
-NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, SourceParameters *params)
+NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, SourceParameters *params,
+                    uint32_t *conf_id)
 {
   struct UnresolvedSource *us;
   struct SourcePool *sp;
@@ -515,7 +771,7 @@ NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, Source
      or later when trying to replace the source */
   if (UTI_StringToIP(name, &remote_addr.ip_addr)) {
     remote_addr.port = port;
-    NSR_AddSource(&remote_addr, type, params);
+    NSR_AddSource(&remote_addr, type, params, conf_id);
     return;
   }
 
@@ -526,6 +782,7 @@ NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, Source
   us->replacement = 0;
   us->new_source.type = type;
   us->new_source.params = *params;
+  us->new_source.conf_id = get_new_conf_id(conf_id);
 
   if (!pool) {
     us->new_source.pool = INVALID_POOL;
@@ -557,7 +814,7 @@ NSR_ResolveSources(void)
   /* Try to resolve unresolved sources now */
   if (unresolved_sources) {
     /* Make sure no resolving is currently running */
-    if (!resolving_source) {
+    if (!resolving_sources) {
       if (resolving_interval) {
         SCH_RemoveTimeout(resolving_id);
         resolving_interval--;
@@ -597,12 +854,15 @@ static void
 clean_source_record(SourceRecord *record)
 {
   assert(record->remote_addr);
+  remove_from_index(record->data);
   record->remote_addr = NULL;
+  record->removed = 1;
   NCR_DestroyInstance(record->data);
   if (record->name)
     Free(record->name);
 
   n_sources--;
+  n_removed++;
 }
 
 /* ================================================== */
@@ -625,16 +885,95 @@ NSR_RemoveSource(NTP_Remote_Address *remote_addr)
 
   clean_source_record(get_record(slot));
 
-  /* Rehash the table to make sure there are no broken probe sequences.
-     This is costly, but it's not expected to happen frequently. */
-
-  rehash_records();
+  check_removed_records();
 
   return NSR_Success;
 }
 
 /* ================================================== */
 
+int
+NSR_RemoveSources(IPAddr *mask, IPAddr *address)
+{
+  AddressIndexEntry *entry;
+  NTP_Remote_Address remote_addr;
+  unsigned int i, first, end;
+  int slot, found, removed;
+
+  assert(initialised);
+
+  if (address->family == IPADDR_UNSPEC)
+    return 0;
+
+  get_index_range(mask, address, &first, &end);
+
+  /* Remove the sources from the end of the range to not move entries
+     of the index which were not checked yet */
+  for (i = end, removed = 0; i > first; i--) {
+    entry = ARR_GetElement(address_index, i - 1);
+    if (UTI_CompareIPs(&entry->ip_addr, address, mask))
+      continue;
+
+    remote_addr.ip_addr = entry->ip_addr;
+    remote_addr.port = 0;
+    find_slot(&remote_addr, &slot, &found);
+    assert(found);
+
+    clean_source_record(get_record(slot));
+    removed++;
+  }
+
+  check_removed_records();
+
+  return removed;
+}
+
+/* ================================================== */
+
+void
+NSR_RemoveSourcesById(uint32_t conf_id)
+{
+  struct UnresolvedSource *us, **i;
+  SourceRecord *record;
+  unsigned int j;
+
+  assert(initialised && conf_id);
+
+  for (j = 0; j < ARR_GetSize(records); j++) {
+    record = get_record(j);
+    if (!record->remote_addr || record->conf_id != conf_id)
+      continue;
+    clean_source_record(record);
+  }
+
+  check_removed_records();
+
+  for (i = &unresolved_sources; *i; ) {
+    us = *i;
+    if (us->replacement || us->new_source.conf_id != conf_id) {
+      i = &us->next;
+      continue;
+    }
+
+    /* A source which is being resolved cannot be freed here, the resolving
+       handler will remove it when the resolving ends */
+    if (us->resolving) {
+      us->new_source.max_new_sources = 0;
+      i = &us->next;
+      continue;
+    }
+
+    if (us == resolving_source)
+      resolving_source = us->next;
+
+    *i = us->next;
+    Free(us->name);
+    Free(us);
+  }
+}
+
+/* ================================================== */
+
 void
 NSR_RemoveAllSources(void)
 {
@@ -750,7 +1089,7 @@ static void remove_tentative_pool_sources(int pool)
   }
 
   if (removed)
-    rehash_records();
+    check_removed_records();
 }
 
 /* ================================================== */
@@ -863,21 +1202,21 @@ slew_sources(struct timespec *raw,
 int
 NSR_TakeSourcesOnline(IPAddr *mask, IPAddr *address)
 {
-  SourceRecord *record;
-  unsigned int i;
+  AddressIndexEntry *entry;
+  unsigned int i, first, end;
   int any;
 
   NSR_ResolveSources();
 
+  get_index_range(mask, address, &first, &end);
+
   any = 0;
-  for (i = 0; i < ARR_GetSize(records); i++) {
-    record = get_record(i);
-    if (record->remote_addr) {
-      if (address->family == IPADDR_UNSPEC ||
-          !UTI_CompareIPs(&record->remote_addr->ip_addr, address, mask)) {
-        any = 1;
-        NCR_TakeSourceOnline(record->data);
-      }
+  for (i = first; i < end; i++) {
+    entry = ARR_GetElement(address_index, i);
+    if (address->family == IPADDR_UNSPEC ||
+        !UTI_CompareIPs(&entry->ip_addr, address, mask)) {
+      any = 1;
+      NCR_TakeSourceOnline(entry->data);
     }
   }
 
@@ -900,29 +1239,30 @@ NSR_TakeSourcesOnline(IPAddr *mask, IPAddr *address)
 int
 NSR_TakeSourcesOffline(IPAddr *mask, IPAddr *address)
 {
-  SourceRecord *record, *syncpeer;
-  unsigned int i, any;
+  AddressIndexEntry *entry;
+  NCR_Instance syncpeer;
+  unsigned int i, first, end, any;
+
+  get_index_range(mask, address, &first, &end);
 
   any = 0;
   syncpeer = NULL;
-  for (i = 0; i < ARR_GetSize(records); i++) {
-    record = get_record(i);
-    if (record->remote_addr) {
-      if (address->family == IPADDR_UNSPEC ||
-          !UTI_CompareIPs(&record->remote_addr->ip_addr, address, mask)) {
-        any = 1;
-        if (NCR_IsSyncPeer(record->data)) {
-          syncpeer = record;
-          continue;
-        }
-        NCR_TakeSourceOffline(record->data);
+  for (i = first; i < end; i++) {
+    entry = ARR_GetElement(address_index, i);
+    if (address->family == IPADDR_UNSPEC ||
+        !UTI_CompareIPs(&entry->ip_addr, address, mask)) {
+      any = 1;
+      if (NCR_IsSyncPeer(entry->data)) {
+        syncpeer = entry->data;
+        continue;
       }
+      NCR_TakeSourceOffline(entry->data);
     }
   }
 
   /* Take sync peer offline as last to avoid reference switching */
   if (syncpeer) {
-    NCR_TakeSourceOffline(syncpeer->data);
+    NCR_TakeSourceOffline(syncpeer);
   }
 
   if (address->family == IPADDR_UNSPEC) {
@@ -1078,19 +1418,19 @@ int
 NSR_InitiateSampleBurst(int n_good_samples, int n_total_samples,
                         IPAddr *mask, IPAddr *address)
 {
-  SourceRecord *record;
-  unsigned int i;
+  AddressIndexEntry *entry;
+  unsigned int i, first, end;
   int any;
 
+  get_index_range(mask, address, &first, &end);
+
   any = 0;
-  for (i = 0; i < ARR_GetSize(records); i++) {
-    record = get_record(i);
-    if (record->remote_addr) {
-      if (address->family == IPADDR_UNSPEC ||
-          !UTI_CompareIPs(&record->remote_addr->ip_addr, address, mask)) {
-        any = 1;
-        NCR_InitiateSampleBurst(record->data, n_good_samples, n_total_samples);
-      }
+  for (i = first; i < end; i++) {
+    entry = ARR_GetElement(address_index, i);
+    if (address->family == IPADDR_UNSPEC ||
+        !UTI_CompareIPs(&entry->ip_addr, address, mask)) {
+      any = 1;
+      NCR_InitiateSampleBurst(entry->data, n_good_samples, n_total_samples);
     }
   }
 
@@ -1141,6 +1481,32 @@ NSR_GetNTPReport(RPT_NTPReport *report)
 
 /* ================================================== */
 
+unsigned int
+NSR_GetNumberOfIndices(void)
+{
+  return ARR_GetSize(records);
+}
+
+/* ================================================== */
+
+int
+NSR_GetMonitorReportByIndex(unsigned int index, RPT_MonitorReport *report,
+                            struct timespec *now)
+{
+  SourceRecord *record;
+
+  if (index >= ARR_GetSize(records))
+    return 0;
+
+  record = get_record(index);
+  if (!record->remote_addr)
+    return 0;
+
+  return NCR_GetMonitorReport(record->data, report, now);
+}
+
+/* ================================================== */
+
 void
 NSR_GetActivityReport(RPT_ActivityReport *report)
 {
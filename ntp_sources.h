@@ -47,13 +47,18 @@ typedef enum {
   NSR_InvalidAF /* AddSource - attempt to add a source with invalid address family */
 } NSR_Status;
 
-/* Procedure to add a new server or peer source. */
-extern NSR_Status NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourceParameters *params);
+/* Procedure to add a new server or peer source.  If conf_id is not NULL,
+   a new configuration ID is assigned to the source, which can be used to
+   remove it later. */
+extern NSR_Status NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type,
+                                SourceParameters *params, uint32_t *conf_id);
 
 /* Procedure to add a new server, peer source, or pool of servers specified by
    name instead of address.  The name is resolved in exponentially increasing
-   intervals until it succeeds or fails with a non-temporary error. */
-extern void NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, SourceParameters *params);
+   intervals until it succeeds or fails with a non-temporary error.  All
+   sources added from the name get the same configuration ID. */
+extern void NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type,
+                                SourceParameters *params, uint32_t *conf_id);
 
 /* Function type for handlers to be called back when an attempt
  * (possibly unsuccessful) to resolve unresolved sources ends */
@@ -74,6 +79,14 @@ extern void NSR_AutoStartSources(void);
 /* Procedure to remove a source */
 extern NSR_Status NSR_RemoveSource(NTP_Remote_Address *remote_addr);
 
+/* Procedure to remove all sources matching the address with the mask.
+   Returns the number of removed sources. */
+extern int NSR_RemoveSources(IPAddr *mask, IPAddr *address);
+
+/* Procedure to remove all sources (including unresolved sources) which
+   have the specified configuration ID */
+extern void NSR_RemoveSourcesById(uint32_t conf_id);
+
 /* Procedure to remove all sources */
 extern void NSR_RemoveAllSources(void);
 
@@ -131,6 +144,15 @@ extern void NSR_ReportSource(RPT_SourceReport *report, struct timespec *now);
 
 extern int NSR_GetNTPReport(RPT_NTPReport *report);
 
+/* Get the number of indices in the table of sources, which may contain
+   unused slots */
+extern unsigned int NSR_GetNumberOfIndices(void);
+
+/* Get a report of a monitor-only source at the index of the table.  Returns 0
+   if the slot is unused or the source is taking part in the selection. */
+extern int NSR_GetMonitorReportByIndex(unsigned int index, RPT_MonitorReport *report,
+                                       struct timespec *now);
+
 extern void NSR_GetActivityReport(RPT_ActivityReport *report);
 
 #endif /* GOT_NTP_SOURCES_H */
@@ -0,0 +1,263 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+
+  =======================================================================
+
+  Software simulator of PTP hardware clocks.  The simulated clock runs
+  from the uncorrected system oscillator with a configurable offset,
+  frequency offset, random-walk frequency wander, readout jitter and
+  readout delay.  It is not stepped or slewed with the system clock.
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include "phcsim.h"
+#include "local.h"
+#include "logging.h"
+#include "memory.h"
+#include "util.h"
+
+#define PATH_PREFIX "sim"
+
+struct PSM_Instance_Record {
+  /* Raw system time of the last update of the model */
+  struct timespec last_ts;
+
+  /* Offset of the simulated clock relative to the raw system time */
+  double phase;
+
+  /* Current frequency offset of the simulated clock relative to
+     the uncorrected system clock (in ppm) */
+  double freq;
+
+  /* Absolute frequency offset of the system clock (in ppm) */
+  double sys_freq;
+
+  /* Standard deviation of the frequency random walk (in ppm per
+     square root of second) */
+  double wander;
+
+  /* Standard deviation of the readout and timestamping error */
+  double jitter;
+
+  /* Delay of a readout (between the two system timestamps) */
+  double delay;
+
+  /* State of the random number generator */
+  uint64_t rng_state;
+};
+
+/* ================================================== */
+
+static double
+get_uniform(PSM_Instance clock)
+{
+  uint64_t x;
+
+  /* xorshift64* */
+  x = clock->rng_state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  clock->rng_state = x;
+  x *= 0x2545F4914F6CDD1DULL;
+
+  /* Uniform in (0, 1) */
+  return ((x >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/* ================================================== */
+
+static double
+get_normal(PSM_Instance clock)
+{
+  return sqrt(-2.0 * log(get_uniform(clock))) * cos(2.0 * M_PI * get_uniform(clock));
+}
+
+/* ================================================== */
+
+static void
+update_model(PSM_Instance clock, struct timespec *now)
+{
+  double elapsed, uncorrected;
+
+  elapsed = UTI_DiffTimespecsToDouble(now, &clock->last_ts);
+  if (elapsed <= 0.0)
+    return;
+
+  uncorrected = elapsed / (1.0 - clock->sys_freq / 1.0e6);
+  clock->phase += uncorrected * (1.0 + clock->freq / 1.0e6) - elapsed;
+
+  if (clock->wander > 0.0)
+    clock->freq += clock->wander * sqrt(elapsed) * get_normal(clock);
+
+  clock->last_ts = *now;
+}
+
+/* ================================================== */
+
+static void
+handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
+            double doffset, LCL_ChangeType change_type, void *anything)
+{
+  PSM_Instance clock = anything;
+
+  update_model(clock, raw);
+
+  /* The simulated clock is not stepped with the system clock */
+  if (change_type == LCL_ChangeStep || change_type == LCL_ChangeUnknownStep) {
+    UTI_AddDoubleToTimespec(&clock->last_ts, -doffset, &clock->last_ts);
+    clock->phase += doffset;
+  }
+
+  clock->sys_freq = LCL_ReadAbsoluteFrequency();
+}
+
+/* ================================================== */
+
+int
+PSM_IsSimulatorPath(const char *path)
+{
+  return path && strncmp(path, PATH_PREFIX, strlen(PATH_PREFIX)) == 0 &&
+         (path[strlen(PATH_PREFIX)] == '\0' || path[strlen(PATH_PREFIX)] == ',');
+}
+
+/* ================================================== */
+
+static int
+parse_options(PSM_Instance clock, const char *options, uint64_t *seed)
+{
+  char name[16];
+  double value;
+  int n;
+
+  while (*options == ',') {
+    options++;
+    if (sscanf(options, "%15[^=,]=%lf%n", name, &value, &n) != 2)
+      return 0;
+    options += n;
+
+    if (strcmp(name, "offset") == 0)
+      clock->phase = value;
+    else if (strcmp(name, "freq") == 0)
+      clock->freq = value;
+    else if (strcmp(name, "wander") == 0 && value >= 0.0)
+      clock->wander = value;
+    else if (strcmp(name, "jitter") == 0 && value >= 0.0)
+      clock->jitter = value;
+    else if (strcmp(name, "delay") == 0 && value >= 0.0)
+      clock->delay = value;
+    else if (strcmp(name, "seed") == 0 && value >= 0.0)
+      *seed = value;
+    else
+      return 0;
+  }
+
+  return *options == '\0';
+}
+
+/* ================================================== */
+
+PSM_Instance
+PSM_CreateInstance(const char *path)
+{
+  PSM_Instance clock;
+  uint64_t seed = 0;
+
+  if (!PSM_IsSimulatorPath(path))
+    return NULL;
+
+  clock = MallocNew(struct PSM_Instance_Record);
+  clock->phase = 0.0;
+  clock->freq = 0.0;
+  clock->wander = 0.0;
+  clock->jitter = 0.0;
+  clock->delay = 0.0;
+
+  if (!parse_options(clock, path + strlen(PATH_PREFIX), &seed)) {
+    LOG(LOGS_ERR, "Invalid simulated PHC %s", path);
+    Free(clock);
+    return NULL;
+  }
+
+  if (!seed)
+    UTI_GetRandomBytes(&seed, sizeof (seed));
+  /* The state of the generator must not be zero */
+  clock->rng_state = seed ? seed : 1;
+
+  LCL_ReadRawTime(&clock->last_ts);
+  clock->sys_freq = LCL_ReadAbsoluteFrequency();
+
+  LCL_AddParameterChangeHandler(handle_slew, clock);
+
+  DEBUG_LOG("Simulated PHC offset=%e freq=%f wander=%e jitter=%e delay=%e",
+            clock->phase, clock->freq, clock->wander, clock->jitter, clock->delay);
+
+  return clock;
+}
+
+/* ================================================== */
+
+void
+PSM_DestroyInstance(PSM_Instance clock)
+{
+  LCL_RemoveParameterChangeHandler(handle_slew, clock);
+  Free(clock);
+}
+
+/* ================================================== */
+
+int
+PSM_GetSample(PSM_Instance clock, double precision, struct timespec *phc_ts,
+              struct timespec *sys_ts, double *err)
+{
+  struct timespec now;
+
+  LCL_ReadRawTime(&now);
+
+  /* The clock is read in the middle of the readout */
+  UTI_AddDoubleToTimespec(&now, clock->delay / 2.0, sys_ts);
+  PSM_ConvertTime(clock, sys_ts, phc_ts);
+
+  *err = MAX(clock->delay / 2.0, precision);
+
+  return 1;
+}
+
+/* ================================================== */
+
+void
+PSM_ConvertTime(PSM_Instance clock, struct timespec *sys_ts, struct timespec *phc_ts)
+{
+  double offset;
+
+  update_model(clock, sys_ts);
+
+  offset = clock->phase + UTI_DiffTimespecsToDouble(sys_ts, &clock->last_ts) *
+           clock->freq / 1.0e6;
+
+  if (clock->jitter > 0.0)
+    offset += clock->jitter * get_normal(clock);
+
+  UTI_AddDoubleToTimespec(sys_ts, offset, phc_ts);
+}
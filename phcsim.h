@@ -0,0 +1,51 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+
+  =======================================================================
+
+  Header for the software simulator of PTP hardware clocks */
+
+#ifndef GOT_PHCSIM_H
+#define GOT_PHCSIM_H
+
+typedef struct PSM_Instance_Record *PSM_Instance;
+
+/* Check if a PHC path specifies a simulated clock */
+extern int PSM_IsSimulatorPath(const char *path);
+
+/* Create a new simulated clock from a specification in the form
+   sim[,option=value]...  Return NULL if the specification is invalid */
+extern PSM_Instance PSM_CreateInstance(const char *path);
+
+/* Destroy a simulated clock */
+extern void PSM_DestroyInstance(PSM_Instance clock);
+
+/* Make a reading of the clock and the system clock, equivalent to
+   the PTP_SYS_OFFSET ioctl */
+extern int PSM_GetSample(PSM_Instance clock, double precision, struct timespec *phc_ts,
+                         struct timespec *sys_ts, double *err);
+
+/* Convert a raw system timestamp to a timestamp of the simulated clock,
+   emulating a hardware timestamp captured by a NIC */
+extern void PSM_ConvertTime(PSM_Instance clock, struct timespec *sys_ts,
+                            struct timespec *phc_ts);
+
+#endif
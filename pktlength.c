@@ -118,6 +118,20 @@ static const struct request_length request_lengths[] = {
   { 0, 0 },                                     /* ADD_PEER2 */
   REQ_LENGTH_ENTRY(ntp_source, null),           /* ADD_SERVER3 */
   REQ_LENGTH_ENTRY(ntp_source, null),           /* ADD_PEER3 */
+  REQ_LENGTH_ENTRY(null, null),                 /* RELOAD_ACCESS */
+  { offsetof(CMD_Request, data.source_records.EOR), 0 }, /* SOURCE_RECORDS */
+  REQ_LENGTH_ENTRY(subscribe, null),            /* SUBSCRIBE */
+  REQ_LENGTH_ENTRY(sched_stats, sched_stats),   /* SCHED_STATS */
+  REQ_LENGTH_ENTRY(hwclock_stats, hwclock_stats), /* HWCLOCK_STATS */
+  REQ_LENGTH_ENTRY(null, sys_stats),            /* SYS_STATS */
+  REQ_LENGTH_ENTRY(slot_stats, slot_stats),     /* SLOT_STATS */
+  REQ_LENGTH_ENTRY(monitor_data, monitor_data), /* MONITOR_DATA */
+  REQ_LENGTH_ENTRY(del_sources, null),          /* DEL_SOURCES */
+  REQ_LENGTH_ENTRY(null, null),                 /* RELOAD_CONFIG */
+  REQ_LENGTH_ENTRY(null, startup_stats),        /* STARTUP_STATS */
+  REQ_LENGTH_ENTRY(key_stats, key_stats),       /* KEY_STATS */
+  REQ_LENGTH_ENTRY(null, signd_stats),          /* SIGND_STATS */
+  REQ_LENGTH_ENTRY(null, server_stats2),        /* SERVER_STATS2 */
 };
 
 static const uint16_t reply_lengths[] = {
@@ -139,6 +153,17 @@ static const uint16_t reply_lengths[] = {
   RPY_LENGTH_ENTRY(client_accesses_by_index),   /* CLIENT_ACCESSES_BY_INDEX2 */
   RPY_LENGTH_ENTRY(ntp_data),                   /* NTP_DATA */
   RPY_LENGTH_ENTRY(manual_timestamp),           /* MANUAL_TIMESTAMP2 */
+  0,                                            /* SOURCE_RECORDS - variable length */
+  RPY_LENGTH_ENTRY(event),                      /* EVENT */
+  RPY_LENGTH_ENTRY(sched_stats),                /* SCHED_STATS */
+  RPY_LENGTH_ENTRY(hwclock_stats),              /* HWCLOCK_STATS */
+  RPY_LENGTH_ENTRY(sys_stats),                  /* SYS_STATS */
+  RPY_LENGTH_ENTRY(slot_stats),                 /* SLOT_STATS */
+  RPY_LENGTH_ENTRY(monitor_data),               /* MONITOR_DATA */
+  RPY_LENGTH_ENTRY(startup_stats),              /* STARTUP_STATS */
+  RPY_LENGTH_ENTRY(key_stats),                  /* KEY_STATS */
+  RPY_LENGTH_ENTRY(signd_stats),                /* SIGND_STATS */
+  RPY_LENGTH_ENTRY(server_stats2),              /* SERVER_STATS2 */
 };
 
 /* ================================================== */
@@ -210,6 +235,21 @@ PKL_ReplyLength(CMD_Reply *r)
            ns * sizeof (RPY_ManualListSample);
   }
 
+  /* Length of SOURCE_RECORDS depends on number of records stored in it */
+  if (type == RPY_SOURCE_RECORDS) {
+    uint32_t nr;
+
+    if (r->status != htons(STT_SUCCESS))
+      return offsetof(CMD_Reply, data);
+
+    nr = ntohl(r->data.source_records.n_records);
+    if (nr > MAX_SOURCE_RECORDS)
+      return 0;
+
+    return offsetof(CMD_Reply, data.source_records.records) +
+           nr * sizeof (RPY_SourceRecord);
+  }
+
   return reply_lengths[type];
 }
 
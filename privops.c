@@ -29,6 +29,8 @@
 
 #include "sysincl.h"
 
+#include <sys/mman.h>
+
 #include "conf.h"
 #include "nameserv.h"
 #include "logging.h"
@@ -41,8 +43,24 @@
 #define OP_BINDSOCKET     1027
 #define OP_NAME2IPADDRESS 1028
 #define OP_RELOADDNS      1029
+#define OP_WAKEUP         1030
 #define OP_QUIT           1099
 
+/* Time-critical operations can be passed through a shared-memory channel
+   instead of the socket, avoiding the wakeup latency of the helper and
+   daemon when they are spinning on the channel */
+#if defined(PRIVOPS_ADJUSTTIME) || defined(PRIVOPS_ADJUSTTIMEX) || defined(PRIVOPS_SETTIME)
+#define HAVE_SHARED_CHANNEL
+#endif
+
+#ifndef MAP_ANON
+#define MAP_ANON MAP_ANONYMOUS
+#endif
+
+/* Number of polls of the channel before the process falls back to
+   waiting on the socket.  Spinning is disabled on single-CPU systems. */
+#define SPIN_POLLS 100000
+
 union sockaddr_in46 {
   struct sockaddr_in in4;
 #ifdef FEAT_IPV6
@@ -128,9 +146,41 @@ typedef struct {
   } data;
 } PrvResponse;
 
+#ifdef HAVE_SHARED_CHANNEL
+/* States of the processes waiting for a request or response */
+#define STATE_SPINNING 0
+#define STATE_SLEEPING 1
+#define STATE_WOKEN 2
+#define STATE_DONE 3
+
+/* Channel shared by the daemon and helper.  The daemon has at most one
+   request in progress.  It writes the request and increments the request
+   sequence number.  If the helper is sleeping on the socket, it needs to be
+   woken up by the OP_WAKEUP request.  The helper writes the response and
+   copies the sequence number.  If the daemon stopped spinning and is sleeping
+   on the socket, the response is sent over the socket. */
+typedef struct {
+  volatile uint32_t request_seq;
+  volatile uint32_t response_seq;
+  volatile int helper_state;
+  volatile int daemon_state;
+  int spin_polls;
+  PrvRequest request;
+  PrvResponse response;
+} SharedChannel;
+
+#define CHANNEL_BARRIER() __sync_synchronize()
+
+static SharedChannel *channel;
+#endif
+
 static int helper_fd;
 static pid_t helper_pid;
 
+/* Numbers of requests passed through the shared channel and socket */
+static uint32_t channel_requests;
+static uint32_t socket_requests;
+
 static int
 have_helper(void)
 {
@@ -314,59 +364,137 @@ do_reload_dns(PrvResponse *res)
 
 /* ======================================================================= */
 
-/* HELPER - main loop - action requests from the daemon */
+/* HELPER - perform a request */
 
 static void
-helper_main(int fd)
+process_request(PrvRequest *req, PrvResponse *res)
 {
-  PrvRequest req;
-  PrvResponse res;
-  int quit = 0;
-
-  while (!quit) {
-    if (!receive_from_daemon(fd, &req))
-      /* read error or closed input - we cannot recover - give up */
-      break;
+  memset(res, 0, sizeof (*res));
 
-    memset(&res, 0, sizeof (res));
-
-    switch (req.op) {
+  switch (req->op) {
 #ifdef PRIVOPS_ADJUSTTIME
-      case OP_ADJUSTTIME:
-        do_adjust_time(&req.data.adjust_time, &res);
-        break;
+    case OP_ADJUSTTIME:
+      do_adjust_time(&req->data.adjust_time, res);
+      break;
 #endif
 #ifdef PRIVOPS_ADJUSTTIMEX
-      case OP_ADJUSTTIMEX:
-        do_adjust_timex(&req.data.adjust_timex, &res);
-        break;
+    case OP_ADJUSTTIMEX:
+      do_adjust_timex(&req->data.adjust_timex, res);
+      break;
 #endif
 #ifdef PRIVOPS_SETTIME
-      case OP_SETTIME:
-        do_set_time(&req.data.set_time, &res);
-        break;
+    case OP_SETTIME:
+      do_set_time(&req->data.set_time, res);
+      break;
 #endif
 #ifdef PRIVOPS_BINDSOCKET
-      case OP_BINDSOCKET:
-        do_bind_socket(&req.data.bind_socket, &res);
-        break;
+    case OP_BINDSOCKET:
+      do_bind_socket(&req->data.bind_socket, res);
+      break;
 #endif
 #ifdef PRIVOPS_NAME2IPADDRESS
-      case OP_NAME2IPADDRESS:
-        do_name_to_ipaddress(&req.data.name_to_ipaddress, &res);
-        break;
+    case OP_NAME2IPADDRESS:
+      do_name_to_ipaddress(&req->data.name_to_ipaddress, res);
+      break;
 #endif
 #ifdef PRIVOPS_RELOADDNS
-      case OP_RELOADDNS:
-        do_reload_dns(&res);
+    case OP_RELOADDNS:
+      do_reload_dns(res);
+      break;
+#endif
+    default:
+      res_fatal(res, "Unexpected operator %d", req->op);
+      break;
+  }
+}
+
+/* ======================================================================= */
+
+/* HELPER - process requests from the shared channel until no new request
+   arrives within the spinning interval */
+
+#ifdef HAVE_SHARED_CHANNEL
+static void
+serve_channel(int fd)
+{
+  static uint32_t last_seq = 0;
+  PrvRequest req;
+  PrvResponse res;
+  uint32_t seq;
+  int i;
+
+  while (1) {
+    channel->helper_state = STATE_SPINNING;
+    CHANNEL_BARRIER();
+
+    for (i = 0, seq = channel->request_seq; seq == last_seq && i < channel->spin_polls; i++)
+      seq = channel->request_seq;
+
+    if (seq == last_seq) {
+      channel->helper_state = STATE_SLEEPING;
+      CHANNEL_BARRIER();
+
+      /* Check for a request submitted before the state was changed */
+      seq = channel->request_seq;
+      if (seq == last_seq)
+        return;
+    }
+
+    CHANNEL_BARRIER();
+    last_seq = seq;
+    req = channel->request;
+
+    switch (req.op) {
+      case OP_ADJUSTTIME:
+      case OP_ADJUSTTIMEX:
+      case OP_SETTIME:
+        process_request(&req, &res);
+        break;
+      default:
+        memset(&res, 0, sizeof (res));
+        res_fatal(&res, "Unexpected operator %d in channel", req.op);
         break;
+    }
+
+    channel->response = res;
+    CHANNEL_BARRIER();
+    channel->response_seq = seq;
+    CHANNEL_BARRIER();
+
+    /* Send the response over the socket if the daemon stopped spinning */
+    if (!__sync_bool_compare_and_swap(&channel->daemon_state, STATE_SPINNING, STATE_DONE))
+      send_response(fd, &res);
+  }
+}
+#endif
+
+/* ======================================================================= */
+
+/* HELPER - main loop - action requests from the daemon */
+
+static void
+helper_main(int fd)
+{
+  PrvRequest req;
+  PrvResponse res;
+  int quit = 0;
+
+  while (!quit) {
+    if (!receive_from_daemon(fd, &req))
+      /* read error or closed input - we cannot recover - give up */
+      break;
+
+    switch (req.op) {
+#ifdef HAVE_SHARED_CHANNEL
+      case OP_WAKEUP:
+        serve_channel(fd);
+        continue;
 #endif
       case OP_QUIT:
         quit = 1;
         continue;
-
       default:
-        res_fatal(&res, "Unexpected operator %d", req.op);
+        process_request(&req, &res);
         break;
     }
 
@@ -381,6 +509,8 @@ helper_main(int fd)
 
 /* DAEMON - receive helper response */
 
+static void check_response(PrvResponse *res);
+
 static void
 receive_response(PrvResponse *res)
 {
@@ -392,6 +522,16 @@ receive_response(PrvResponse *res)
   if (resp_len != sizeof (*res))
     LOG_FATAL("Invalid helper response");
 
+  check_response(res);
+}
+
+/* ======================================================================= */
+
+/* DAEMON - check helper response */
+
+static void
+check_response(PrvResponse *res)
+{
   if (res->fatal_error)
     LOG_FATAL("Error in helper : %s", res->data.fatal_msg.msg);
 
@@ -454,13 +594,66 @@ send_request(PrvRequest *req)
 
 /* ======================================================================= */
 
+/* DAEMON - submit request through the shared channel */
+
+#ifdef HAVE_SHARED_CHANNEL
+static void
+submit_channel_request(PrvRequest *req, PrvResponse *res)
+{
+  PrvRequest wakeup;
+  uint32_t seq;
+  int i;
+
+  channel->request = *req;
+  channel->daemon_state = STATE_SPINNING;
+  CHANNEL_BARRIER();
+  seq = channel->request_seq + 1;
+  channel->request_seq = seq;
+  CHANNEL_BARRIER();
+
+  /* Wake up the helper if it is not spinning on the channel */
+  if (__sync_bool_compare_and_swap(&channel->helper_state, STATE_SLEEPING, STATE_WOKEN)) {
+    memset(&wakeup, 0, sizeof (wakeup));
+    wakeup.op = OP_WAKEUP;
+    send_request(&wakeup);
+  }
+
+  for (i = 0; channel->response_seq != seq && i < channel->spin_polls; i++)
+    ;
+
+  /* If the helper has not responded yet, it will send the response over
+     the socket */
+  if (channel->response_seq != seq &&
+      __sync_bool_compare_and_swap(&channel->daemon_state, STATE_SPINNING, STATE_SLEEPING)) {
+    receive_response(res);
+    return;
+  }
+
+  CHANNEL_BARRIER();
+  *res = channel->response;
+  check_response(res);
+}
+#endif
+
+/* ======================================================================= */
+
 /* DAEMON - send daemon request and wait for response */
 
 static void
 submit_request(PrvRequest *req, PrvResponse *res)
 {
+#ifdef HAVE_SHARED_CHANNEL
+  if (channel && (req->op == OP_ADJUSTTIME || req->op == OP_ADJUSTTIMEX ||
+                  req->op == OP_SETTIME)) {
+    submit_channel_request(req, res);
+    channel_requests++;
+    return;
+  }
+#endif
+
   send_request(req);
   receive_response(res);
+  socket_requests++;
 }
 
 /* ======================================================================= */
@@ -658,6 +851,8 @@ void
 PRV_Initialise(void)
 {
   helper_fd = -1;
+  channel_requests = 0;
+  socket_requests = 0;
 }
 
 /* ======================================================================= */
@@ -684,6 +879,19 @@ PRV_StartHelper(void)
   UTI_FdSetCloexec(sock_pair[0]);
   UTI_FdSetCloexec(sock_pair[1]);
 
+#ifdef HAVE_SHARED_CHANNEL
+  channel = mmap(NULL, sizeof (*channel), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANON, -1, 0);
+  if (channel == MAP_FAILED) {
+    LOG(LOGS_WARN, "Could not map shared channel : %s", strerror(errno));
+    channel = NULL;
+  } else {
+    memset(channel, 0, sizeof (*channel));
+    channel->helper_state = STATE_SLEEPING;
+    channel->spin_polls = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_POLLS : 0;
+  }
+#endif
+
   pid = fork();
   if (pid < 0)
     LOG_FATAL("fork() failed : %s", strerror(errno));
@@ -727,4 +935,28 @@ PRV_Finalise(void)
   stop_helper();
   close(helper_fd);
   helper_fd = -1;
+
+#ifdef HAVE_SHARED_CHANNEL
+  if (channel)
+    munmap(channel, sizeof (*channel));
+  channel = NULL;
+#endif
+}
+
+/* ======================================================================= */
+
+int
+PRV_IsHelperRunning(void)
+{
+  return have_helper();
+}
+
+/* ======================================================================= */
+
+void
+PRV_GetReport(RPT_SysReport *report)
+{
+  report->helper = have_helper();
+  report->helper_channel_requests = channel_requests;
+  report->helper_socket_requests = socket_requests;
 }
@@ -28,6 +28,8 @@
 #ifndef GOT_PRIVOPS_H
 #define GOT_PRIVOPS_H
 
+#include "reports.h"
+
 #ifdef PRIVOPS_ADJUSTTIME
 int PRV_AdjustTime(const struct timeval *delta, struct timeval *olddelta);
 #else
@@ -68,10 +70,14 @@ void PRV_ReloadDNS(void);
 void PRV_Initialise(void);
 void PRV_StartHelper(void);
 void PRV_Finalise(void);
+void PRV_GetReport(RPT_SysReport *report);
+int PRV_IsHelperRunning(void);
 #else
 #define PRV_Initialise()
 #define PRV_StartHelper()
 #define PRV_Finalise()
+#define PRV_GetReport(report)
+#define PRV_IsHelperRunning() 0
 #endif
 
 #endif
@@ -51,6 +51,12 @@ struct FilterSample {
   struct timespec sample_time;
 };
 
+/* Sample offset with its index for selecting samples by rank */
+struct FilterRank {
+  double offset;
+  int index;
+};
+
 struct MedianFilter {
   int length;
   int index;
@@ -60,6 +66,7 @@ struct MedianFilter {
   double avg_var;
   double max_var;
   struct FilterSample *samples;
+  struct FilterRank *ranks;
   int *selected;
   double *x_data;
   double *y_data;
@@ -747,6 +754,7 @@ filter_init(struct MedianFilter *filter, int length, double max_dispersion)
   filter->avg_var = LCL_GetSysPrecisionAsQuantum() * LCL_GetSysPrecisionAsQuantum();
   filter->max_var = max_dispersion * max_dispersion;
   filter->samples = MallocArray(struct FilterSample, filter->length);
+  filter->ranks = MallocArray(struct FilterRank, filter->length);
   filter->selected = MallocArray(int, filter->length);
   filter->x_data = MallocArray(double, filter->length);
   filter->y_data = MallocArray(double, filter->length);
@@ -757,6 +765,7 @@ static void
 filter_fini(struct MedianFilter *filter)
 {
   Free(filter->samples);
+  Free(filter->ranks);
   Free(filter->selected);
   Free(filter->x_data);
   Free(filter->y_data);
@@ -811,27 +820,79 @@ filter_get_samples(struct MedianFilter *filter)
   return filter->used;
 }
 
-static const struct FilterSample *tmp_sorted_array;
+/* Compare samples by offset.  Samples with equal offsets are ordered by
+   their index to make the ordering strict. */
 
 static int
-sample_compare(const void *a, const void *b)
+compare_ranks(const struct FilterRank *r1, const struct FilterRank *r2)
 {
-  const struct FilterSample *s1, *s2;
-
-  s1 = &tmp_sorted_array[*(int *)a];
-  s2 = &tmp_sorted_array[*(int *)b];
-
-  if (s1->offset < s2->offset)
+  if (r1->offset < r2->offset)
+    return -1;
+  else if (r1->offset > r2->offset)
+    return 1;
+  else if (r1->index < r2->index)
     return -1;
-  else if (s1->offset > s2->offset)
+  else if (r1->index > r2->index)
     return 1;
   return 0;
 }
 
+static void
+swap_ranks(struct FilterRank *r1, struct FilterRank *r2)
+{
+  struct FilterRank tmp;
+
+  tmp = *r1;
+  *r1 = *r2;
+  *r2 = tmp;
+}
+
+/* Partially order the ranks between left and right (exclusive) to get the
+   sample with rank k at index k, samples with smaller ranks before it and
+   samples with larger ranks after it (quickselect with median of three) */
+
+static void
+select_rank(struct FilterRank *ranks, int left, int right, int k)
+{
+  int i, j, mid;
+
+  while (right - left > 2) {
+    mid = left + (right - left) / 2;
+    right--;
+
+    /* put the median of the first, middle and last element at right */
+    if (compare_ranks(&ranks[mid], &ranks[left]) < 0)
+      swap_ranks(&ranks[mid], &ranks[left]);
+    if (compare_ranks(&ranks[right], &ranks[left]) < 0)
+      swap_ranks(&ranks[right], &ranks[left]);
+    if (compare_ranks(&ranks[mid], &ranks[right]) < 0)
+      swap_ranks(&ranks[mid], &ranks[right]);
+
+    for (i = j = left; i < right; i++) {
+      if (compare_ranks(&ranks[i], &ranks[right]) < 0)
+        swap_ranks(&ranks[i], &ranks[j++]);
+    }
+    swap_ranks(&ranks[j], &ranks[right]);
+
+    if (k == j)
+      return;
+    if (k < j) {
+      right = j;
+    } else {
+      left = j + 1;
+      right++;
+    }
+  }
+
+  if (right - left == 2 && compare_ranks(&ranks[left + 1], &ranks[left]) < 0)
+    swap_ranks(&ranks[left + 1], &ranks[left]);
+}
+
 int
 filter_select_samples(struct MedianFilter *filter)
 {
-  int i, j, k, o, from, to, *selected;
+  int i, j, o, from, to, *selected;
+  struct FilterRank *ranks;
   double min_dispersion;
 
   if (filter->used < 1)
@@ -844,6 +905,7 @@ filter_select_samples(struct MedianFilter *filter)
     return 0;
 
   selected = filter->selected;
+  ranks = filter->ranks;
 
   if (filter->used > 4) {
     /* select samples with dispersion better than 1.5 * minimum */
@@ -854,8 +916,10 @@ filter_select_samples(struct MedianFilter *filter)
     }
 
     for (i = j = 0; i < filter->used; i++) {
-      if (filter->samples[i].dispersion <= 1.5 * min_dispersion)
-        selected[j++] = i;
+      if (filter->samples[i].dispersion <= 1.5 * min_dispersion) {
+        ranks[j].offset = filter->samples[i].offset;
+        ranks[j++].index = i;
+      }
     }
   } else {
     j = 0;
@@ -864,14 +928,12 @@ filter_select_samples(struct MedianFilter *filter)
   if (j < 4) {
     /* select all samples */
 
-    for (j = 0; j < filter->used; j++)
-      selected[j] = j;
+    for (j = 0; j < filter->used; j++) {
+      ranks[j].offset = filter->samples[j].offset;
+      ranks[j].index = j;
+    }
   }
 
-  /* and sort their indices by offset */
-  tmp_sorted_array = filter->samples;
-  qsort(selected, j, sizeof (int), sample_compare);
-
   /* select 60 percent of the samples closest to the median */ 
   if (j > 2) {
     from = j / 5;
@@ -883,30 +945,25 @@ filter_select_samples(struct MedianFilter *filter)
     to = j;
   }
 
-  /* mark unused samples and sort the rest from oldest to newest */
+  /* move the samples with ranks in the interval [from, to) to the middle
+     of the array, which doesn't require sorting all samples by offset */
+  if (from > 0)
+    select_rank(ranks, 0, j, from);
+  if (to < j)
+    select_rank(ranks, from, j, to);
 
-  o = filter->used - filter->index - 1;
+  /* sort the selected samples from oldest to newest */
 
-  for (i = 0; i < from; i++)
-    selected[i] = -1;
-  for (; i < to; i++)
-    selected[i] = (selected[i] + o) % filter->used;
-  for (; i < filter->used; i++)
-    selected[i] = -1;
+  o = filter->used - filter->index - 1;
 
-  for (i = from; i < to; i++) {
-    j = selected[i];
+  for (i = 0; i < filter->used; i++)
     selected[i] = -1;
-    while (j != -1 && selected[j] != j) {
-      k = selected[j];
-      selected[j] = j;
-      j = k;
-    }
-  }
+  for (i = from; i < to; i++)
+    selected[(ranks[i].index + o) % filter->used] = ranks[i].index;
 
-  for (i = j = 0, k = -1; i < filter->used; i++) {
+  for (i = j = 0; i < filter->used; i++) {
     if (selected[i] != -1)
-      selected[j++] = (selected[i] + filter->used - o) % filter->used;
+      selected[j++] = selected[i];
   }
 
   return j;
@@ -31,6 +31,7 @@
 
 #include "refclock.h"
 #include "logging.h"
+#include "memory.h"
 #include "util.h"
 
 #define SHMKEY 0x4e545030
@@ -58,43 +59,188 @@ struct shmTime {
   int    dummy[8]; 
 };
 
+/* Ring format of the segment, which is enabled by the ring option.  It
+   allows the producer to write samples at a high rate without waiting
+   for chronyd to read them.  All fields have fixed sizes, so 32-bit and
+   64-bit processes can share the segment.
+
+   The producer writes a new sample into the slot
+   samples[write_index % SHM_RING_SLOTS] in this order: it sets the
+   sequence of the slot to 2 * write_index + 1 (truncated to 32 bits),
+   writes the other fields, sets the sequence to 2 * write_index + 2, and
+   finally increments write_index.  A memory barrier is needed between
+   each of the steps.  chronyd reads all slots between its last position
+   and write_index, and accepts a sample only if the sequence was equal to
+   2 * index + 2 before and after reading the fields.  If the producer
+   wrote more than SHM_RING_SLOTS samples since the last poll, the oldest
+   samples are lost.  The read_index field is updated by chronyd after
+   each poll and it is only informational for the producer. */
+
+#define SHM_RING_MAGIC 0x52494e47
+#define SHM_RING_VERSION 1
+#define SHM_RING_SLOTS 256
+
+struct shmRingSample {
+  volatile uint32_t sequence;
+  int32_t leap;
+  int64_t clock_sec;
+  int64_t receive_sec;
+  int32_t clock_nsec;
+  int32_t receive_nsec;
+};
+
+struct shmRing {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slots;
+  uint32_t reserved;
+  volatile uint64_t write_index;
+  volatile uint64_t read_index;
+  struct shmRingSample samples[SHM_RING_SLOTS];
+};
+
+#define SHM_BARRIER() __sync_synchronize()
+
+struct ShmInstance {
+  struct shmTime *shm;
+  struct shmRing *ring;
+  uint64_t read_index;
+};
+
 static int shm_initialise(RCL_Instance instance) {
-  int id, param, perm;
+  int id, param, perm, ring;
   char *s;
-  struct shmTime *shm;
+  struct ShmInstance *inst;
+  void *addr;
 
   param = atoi(RCL_GetDriverParameter(instance));
   s = RCL_GetDriverOption(instance, "perm");
   perm = s ? strtol(s, NULL, 8) & 0777 : 0600;
+  ring = RCL_GetDriverOption(instance, "ring") != NULL;
 
-  id = shmget(SHMKEY + param, sizeof (struct shmTime), IPC_CREAT | perm);
+  id = shmget(SHMKEY + param, ring ? sizeof (struct shmRing) : sizeof (struct shmTime),
+              IPC_CREAT | perm);
   if (id == -1) {
     LOG_FATAL("shmget() failed");
     return 0;
   }
    
-  shm = (struct shmTime *)shmat(id, 0, 0);
-  if ((long)shm == -1) {
+  addr = shmat(id, 0, 0);
+  if ((long)addr == -1) {
     LOG_FATAL("shmat() failed");
     return 0;
   }
 
-  RCL_SetDriverData(instance, shm);
+  inst = MallocNew(struct ShmInstance);
+  inst->shm = NULL;
+  inst->ring = NULL;
+
+  if (ring) {
+    inst->ring = addr;
+
+    /* Initialise a new segment, or check the format of a segment created
+       by the producer */
+    if (inst->ring->magic == 0) {
+      inst->ring->version = SHM_RING_VERSION;
+      inst->ring->slots = SHM_RING_SLOTS;
+      SHM_BARRIER();
+      inst->ring->magic = SHM_RING_MAGIC;
+    } else if (inst->ring->magic != SHM_RING_MAGIC ||
+               inst->ring->version != SHM_RING_VERSION ||
+               inst->ring->slots != SHM_RING_SLOTS) {
+      LOG_FATAL("Invalid format of SHM ring segment");
+    }
+
+    /* Ignore samples written before start */
+    inst->read_index = inst->ring->write_index;
+    inst->ring->read_index = inst->read_index;
+  } else {
+    inst->shm = addr;
+  }
+
+  RCL_SetDriverData(instance, inst);
   return 1;
 }
 
 static void shm_finalise(RCL_Instance instance)
 {
-  shmdt(RCL_GetDriverData(instance));
+  struct ShmInstance *inst;
+
+  inst = (struct ShmInstance *)RCL_GetDriverData(instance);
+  shmdt(inst->ring ? (void *)inst->ring : (void *)inst->shm);
+  Free(inst);
+}
+
+static int shm_ring_poll(RCL_Instance instance, struct ShmInstance *inst)
+{
+  struct timespec receive_ts, clock_ts;
+  struct shmRingSample t, *slot;
+  uint64_t write_index;
+  uint32_t sequence;
+  int n_lost, n_samples;
+  double offset;
+
+  write_index = inst->ring->write_index;
+  SHM_BARRIER();
+
+  /* Skip samples which were already overwritten (or the producer
+     restarted with a smaller index) */
+  if (write_index - inst->read_index > SHM_RING_SLOTS) {
+    DEBUG_LOG("SHM ring lost %"PRIu64" samples",
+              write_index - inst->read_index - SHM_RING_SLOTS);
+    inst->read_index = write_index > SHM_RING_SLOTS ? write_index - SHM_RING_SLOTS : 0;
+  }
+
+  for (n_lost = n_samples = 0; inst->read_index < write_index; inst->read_index++) {
+    slot = &inst->ring->samples[inst->read_index % SHM_RING_SLOTS];
+    sequence = 2 * inst->read_index + 2;
+
+    if (slot->sequence != sequence) {
+      n_lost++;
+      continue;
+    }
+    SHM_BARRIER();
+    t = *slot;
+    SHM_BARRIER();
+    if (slot->sequence != sequence) {
+      n_lost++;
+      continue;
+    }
+
+    clock_ts.tv_sec = t.clock_sec;
+    clock_ts.tv_nsec = t.clock_nsec;
+    receive_ts.tv_sec = t.receive_sec;
+    receive_ts.tv_nsec = t.receive_nsec;
+
+    UTI_NormaliseTimespec(&clock_ts);
+    UTI_NormaliseTimespec(&receive_ts);
+    offset = UTI_DiffTimespecsToDouble(&clock_ts, &receive_ts);
+
+    if (RCL_AddSample(instance, &receive_ts, offset, t.leap))
+      n_samples++;
+  }
+
+  inst->ring->read_index = inst->read_index;
+
+  if (n_lost > 0)
+    DEBUG_LOG("SHM ring overwritten %d samples", n_lost);
+
+  return n_samples > 0;
 }
 
 static int shm_poll(RCL_Instance instance)
 {
   struct timespec receive_ts, clock_ts;
+  struct ShmInstance *inst;
   struct shmTime t, *shm;
   double offset;
 
-  shm = (struct shmTime *)RCL_GetDriverData(instance);
+  inst = (struct ShmInstance *)RCL_GetDriverData(instance);
+
+  if (inst->ring)
+    return shm_ring_poll(instance, inst);
+
+  shm = inst->shm;
 
   t = *shm;
   
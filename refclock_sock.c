@@ -57,43 +57,156 @@ struct sock_sample {
   int magic;
 };
 
-static void read_sample(int sockfd, int event, void *anything)
-{
+/* Extended format of the messages, which has timestamps with nanosecond
+   resolution and can carry multiple samples in one message.  The samples
+   need to be ordered by time.  The fields use fixed-size types. */
+
+#define SOCK_MAGIC_NS 0x534f434e
+
+#define MAX_NS_SAMPLES 32
+
+struct sock_sample_ns {
+  /* Time of the measurement (system time) */
+  int64_t sec;
+  int32_t nsec;
+
+  /* Non-zero if the sample is from a PPS signal */
+  int16_t pulse;
+
+  /* 0 - normal, 1 - insert leap second, 2 - delete leap second */
+  int16_t leap;
+
+  /* Offset between the true time and the system time (in seconds) */
+  double offset;
+};
+
+struct sock_message_ns {
+  /* Protocol identifier (0x534f434e) */
+  uint32_t magic;
+
+  /* Number of samples in the message (1 - 32) */
+  uint32_t n_samples;
+
+  struct sock_sample_ns samples[MAX_NS_SAMPLES];
+};
+
+union sock_message {
   struct sock_sample sample;
-  struct timespec ts;
-  RCL_Instance instance;
-  int s;
+  struct sock_message_ns message_ns;
+};
 
-  instance = (RCL_Instance)anything;
+#ifdef HAVE_RECVMMSG
+#define MAX_RECV_MESSAGES 16
+#define MessageHeader mmsghdr
+#else
+/* Compatible with mmsghdr */
+struct MessageHeader {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
 
-  s = recv(sockfd, &sample, sizeof (sample), 0);
+#define MAX_RECV_MESSAGES 1
+#endif
 
-  if (s < 0) {
-    LOG(LOGS_ERR, "Could not read SOCK sample : %s",
-        strerror(errno));
+/* Buffers shared by all instances */
+static union sock_message recv_buffers[MAX_RECV_MESSAGES];
+static struct iovec recv_iovecs[MAX_RECV_MESSAGES];
+static struct MessageHeader recv_headers[MAX_RECV_MESSAGES];
+
+static void prepare_buffers(void)
+{
+  int i;
+
+  memset(recv_headers, 0, sizeof (recv_headers));
+
+  for (i = 0; i < MAX_RECV_MESSAGES; i++) {
+    recv_iovecs[i].iov_base = &recv_buffers[i];
+    recv_iovecs[i].iov_len = sizeof (recv_buffers[i]);
+    recv_headers[i].msg_hdr.msg_iov = &recv_iovecs[i];
+    recv_headers[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+static void process_sample(RCL_Instance instance, struct timespec *ts, double offset,
+                           int pulse, int leap)
+{
+  UTI_NormaliseTimespec(ts);
+
+  if (pulse) {
+    RCL_AddPulse(instance, ts, offset);
+  } else {
+    RCL_AddSample(instance, ts, offset, leap);
+  }
+}
+
+static void process_message(RCL_Instance instance, union sock_message *message, int length)
+{
+  struct sock_sample_ns *sample_ns;
+  struct timespec ts;
+  unsigned int i, n;
+
+  if (length == sizeof (message->sample) && message->sample.magic == SOCK_MAGIC) {
+    UTI_TimevalToTimespec(&message->sample.tv, &ts);
+    process_sample(instance, &ts, message->sample.offset, message->sample.pulse,
+                   message->sample.leap);
     return;
   }
 
-  if (s != sizeof (sample)) {
-    LOG(LOGS_WARN, "Unexpected length of SOCK sample : %d != %ld",
-        s, (long)sizeof (sample));
+  if (length >= offsetof(struct sock_message_ns, samples) &&
+      message->message_ns.magic == SOCK_MAGIC_NS) {
+    n = message->message_ns.n_samples;
+
+    if (n < 1 || n > MAX_NS_SAMPLES ||
+        length != offsetof(struct sock_message_ns, samples) + n * sizeof (*sample_ns)) {
+      LOG(LOGS_WARN, "Unexpected length of SOCK message : %d", length);
+      return;
+    }
+
+    for (i = 0; i < n; i++) {
+      sample_ns = &message->message_ns.samples[i];
+      ts.tv_sec = sample_ns->sec;
+      ts.tv_nsec = sample_ns->nsec;
+      process_sample(instance, &ts, sample_ns->offset, sample_ns->pulse, sample_ns->leap);
+    }
     return;
   }
 
-  if (sample.magic != SOCK_MAGIC) {
-    LOG(LOGS_WARN, "Unexpected magic number in SOCK sample : %x != %x",
-        sample.magic, SOCK_MAGIC);
+  if (length != sizeof (message->sample)) {
+    LOG(LOGS_WARN, "Unexpected length of SOCK sample : %d != %ld",
+        length, (long)sizeof (message->sample));
     return;
   }
 
-  UTI_TimevalToTimespec(&sample.tv, &ts);
-  UTI_NormaliseTimespec(&ts);
+  LOG(LOGS_WARN, "Unexpected magic number in SOCK sample : %x != %x",
+      message->sample.magic, SOCK_MAGIC);
+}
 
-  if (sample.pulse) {
-    RCL_AddPulse(instance, &ts, sample.offset);
-  } else {
-    RCL_AddSample(instance, &ts, sample.offset, sample.leap);
+static void read_sample(int sockfd, int event, void *anything)
+{
+  RCL_Instance instance;
+  int i, n, status;
+
+  instance = (RCL_Instance)anything;
+
+  /* Receive all messages which fit in the buffers in one call */
+#ifdef HAVE_RECVMMSG
+  status = recvmmsg(sockfd, recv_headers, MAX_RECV_MESSAGES, MSG_DONTWAIT, NULL);
+  n = status;
+#else
+  status = recvmsg(sockfd, &recv_headers[0].msg_hdr, 0);
+  if (status >= 0)
+    recv_headers[0].msg_len = status;
+  n = 1;
+#endif
+
+  if (status < 0) {
+    LOG(LOGS_ERR, "Could not read SOCK sample : %s",
+        strerror(errno));
+    return;
   }
+
+  for (i = 0; i < n; i++)
+    process_message(instance, &recv_buffers[i], recv_headers[i].msg_len);
 }
 
 static int sock_initialise(RCL_Instance instance)
@@ -124,6 +237,8 @@ static int sock_initialise(RCL_Instance instance)
     return 0;
   }
 
+  prepare_buffers();
+
   RCL_SetDriverData(instance, (void *)(long)sockfd);
   SCH_AddFileHandler(sockfd, SCH_FILE_INPUT, read_sample, instance);
   return 1;
@@ -36,6 +36,7 @@
 #include "logging.h"
 #include "local.h"
 #include "sched.h"
+#include "timeexport.h"
 
 /* ================================================== */
 
@@ -94,6 +95,9 @@ static char *mail_change_user;
 /* Handler for mode ending */
 static REF_ModeEndHandler mode_end_handler = NULL;
 
+/* Handler for reference updates */
+static REF_UpdateHandler update_handler = NULL;
+
 /* Filename of the drift file. */
 static char *drift_file=NULL;
 static double drift_file_age;
@@ -319,6 +323,14 @@ REF_SetModeEndHandler(REF_ModeEndHandler handler)
 
 /* ================================================== */
 
+void
+REF_SetUpdateHandler(REF_UpdateHandler handler)
+{
+  update_handler = handler;
+}
+
+/* ================================================== */
+
 REF_LeapMode
 REF_GetLeapMode(void)
 {
@@ -1121,6 +1133,11 @@ REF_SetReference(int stratum,
       avg2_moving = 1;
     avg2_offset = our_offset * our_offset;
   }
+
+  TEX_Update();
+
+  if (update_handler)
+    (update_handler)();
 }
 
 /* ================================================== */
@@ -1176,6 +1193,11 @@ REF_SetUnsynchronised(void)
 
   write_log(&now, 0, LCL_ReadAbsoluteFrequency(), 0.0, 0.0, uncorrected_offset,
             our_root_delay / 2.0 + get_root_dispersion(&now));
+
+  TEX_Update();
+
+  if (update_handler)
+    (update_handler)();
 }
 
 /* ================================================== */
@@ -69,6 +69,13 @@ typedef void (*REF_ModeEndHandler)(int result);
 /* Set the handler for being notified of mode ending */
 extern void REF_SetModeEndHandler(REF_ModeEndHandler handler);
 
+/* Function type for handlers to be called back when the reference
+   is updated or the synchronisation is lost */
+typedef void (*REF_UpdateHandler)(void);
+
+/* Set the handler for being notified of reference updates */
+extern void REF_SetUpdateHandler(REF_UpdateHandler handler);
+
 /* Get leap second handling mode */
 extern REF_LeapMode REF_GetLeapMode(void);
 
@@ -104,6 +104,13 @@ typedef struct {
   uint32_t ntp_drops;
   uint32_t cmd_drops;
   uint32_t log_drops;
+  uint32_t ntp_interleaved_hits;
+  uint32_t ntp_interleaved_misses;
+  uint32_t ntp_timestamps;
+  uint32_t log_records_ipv4;
+  uint32_t log_records_ipv4_size;
+  uint32_t log_records_ipv6;
+  uint32_t log_records_ipv6_size;
 } RPT_ServerStatsReport;
 
 typedef struct {
@@ -160,4 +167,108 @@ typedef struct {
   uint32_t total_valid_count;
 } RPT_NTPReport;
 
+typedef struct {
+  IPAddr ip_addr;
+  int stratum;
+  int poll;
+  int reachability;
+  int samples;
+  unsigned long latest_meas_ago;
+  double offset;
+  double delay;
+  double min_delay_offset;
+  double min_delay;
+} RPT_MonitorReport;
+
+/* Number of log2 buckets in the scheduler histograms.  The first bucket
+   counts intervals shorter than 1 microsecond, bucket i intervals in
+   [2^(i-1), 2^i) microseconds and the last bucket all longer intervals. */
+#define RPT_SCHED_HISTOGRAM_BUCKETS 24
+
+typedef struct {
+  char name[32];
+  enum {RPT_SCHED_LAG, RPT_SCHED_TIMEOUT, RPT_SCHED_FILE} type;
+  uint32_t calls;
+  double total_time;
+  double max_time;
+  uint32_t histogram[RPT_SCHED_HISTOGRAM_BUCKETS];
+} RPT_SchedReport;
+
+typedef struct {
+  char name[16];
+  uint32_t timeouts;
+  uint32_t scheduled;
+  uint32_t delayed;
+  double slot;
+  double load;
+  double mean_delay;
+  double max_delay;
+} RPT_SlotReport;
+
+typedef struct {
+  char name[16];
+  int n_samples;
+  double separation;
+  double frequency;
+  double last_error;
+  double rms_error;
+  uint32_t n_samples_total;
+  uint32_t n_resets;
+  uint32_t phc_readings;
+  double phc_read_time;
+  double phc_read_max;
+  double phc_error;
+} RPT_HwClockReport;
+
+typedef struct {
+  uint32_t adjtimex_calls;
+  double adjtimex_last_time;
+  double adjtimex_mean_time;
+  double adjtimex_max_time;
+  int helper;
+  uint32_t helper_channel_requests;
+  uint32_t helper_socket_requests;
+} RPT_SysReport;
+
+/* Number of log2 buckets in the histograms of authentication delays.  The
+   first bucket counts delays shorter than 1 nanosecond, bucket i delays in
+   [2^(i-1), 2^i) nanoseconds and the last bucket all longer delays. */
+#define RPT_KEY_HISTOGRAM_BUCKETS 24
+
+typedef struct {
+  uint32_t id;
+  double auth_delay;
+  uint32_t samples;
+  double mean_delay;
+  double max_delay;
+  uint32_t histogram[RPT_KEY_HISTOGRAM_BUCKETS];
+} RPT_KeyReport;
+
+typedef struct {
+  int complete;
+  int fast_start;
+  double config_time;
+  double init_time;
+  double rtc_time;
+  double initstepslew_time;
+  double resolving_time;
+  double dumps_time;
+  double total_time;
+} RPT_StartupReport;
+
+typedef struct {
+  int connections;
+  int open_connections;
+  uint32_t queue_length;
+  uint32_t max_queue_length;
+  uint32_t peak_queue_length;
+  uint32_t requests;
+  uint32_t successes;
+  uint32_t failures;
+  uint32_t drops;
+  uint32_t queued;
+  double median_delay;
+  double p99_delay;
+} RPT_SigndReport;
+
 #endif /* GOT_REPORTS_H */
@@ -57,6 +57,7 @@ typedef struct {
   SCH_FileHandler       handler;
   SCH_ArbitraryArgument arg;
   int                   events;
+  int                   stats_index;
 } FileHandlerEntry;
 
 static ARR_Instance file_handlers;
@@ -69,6 +70,8 @@ static double last_select_ts_err;
 
 /* Variables to handler the timer queue */
 
+struct _SlotCalendar;
+
 typedef struct _TimerQueueEntry
 {
   struct _TimerQueueEntry *next; /* Forward and back links in the list */
@@ -85,9 +88,16 @@ typedef struct _TimerQueueEntry
                                    apply to this. */
   SCH_TimeoutID id;             /* ID to allow client to delete
                                    timeout */
-  SCH_TimeoutClass class;       /* The class that the epoch is in */
   SCH_TimeoutHandler handler;   /* The handler routine to use */
   SCH_ArbitraryArgument arg;    /* The argument to pass to the handler */
+  int stats_index;              /* Index of the handler statistics */
+
+  struct _SlotCalendar *calendar; /* Calendar of the timeout's class and
+                                     group, or NULL */
+  struct _TimerQueueEntry *slot_next; /* Links in the calendar */
+  struct _TimerQueueEntry *slot_prev;
+  double slot_load;             /* Fraction of the interval occupied by
+                                   the timeout's slot */
 
 } TimerQueueEntry;
 
@@ -100,8 +110,78 @@ static SCH_TimeoutID next_tqe_id;
 /* Pointer to head of free list */
 static TimerQueueEntry *tqe_free_list = NULL;
 
-/* Timestamp when was last timeout dispatched for each class */
-static struct timespec last_class_dispatch[SCH_NumberOfClasses];
+/* Calendar of slots reserved by timeouts in a class and group.  The
+   timeouts are linked in a separate list sorted by time, so that a free
+   slot can be found without scanning the whole timer queue. */
+
+typedef struct _SlotCalendar {
+  SCH_TimeoutClass class;
+  const char *group;
+  /* Head of the list of timeouts */
+  TimerQueueEntry timeouts;
+  unsigned int n_timeouts;
+  /* Sum of the fractions of intervals occupied by the timeouts */
+  double load;
+  /* Width of the last assigned slot */
+  double last_slot;
+  /* Timestamp when was last timeout dispatched */
+  struct timespec last_dispatch;
+  /* Number of scheduled timeouts and those which had to be delayed,
+     and the total and maximum delay */
+  uint32_t scheduled;
+  uint32_t delayed;
+  double total_delay;
+  double max_delay;
+} SlotCalendar;
+
+/* Maximum fraction of the interval occupied by narrowed slots */
+#define MAX_SLOT_LOAD 0.5
+
+/* Array of pointers to calendars */
+static ARR_Instance calendars;
+
+static const char *class_names[SCH_NumberOfClasses] = {
+  "", "client", "peer", "broadcast"
+};
+
+/* ================================================== */
+
+/* Execution time statistics of a handler function.  The first entry in
+   the array is used for the lag of dispatched timeouts. */
+
+typedef struct {
+  SCH_TimeoutHandler timeout_handler;
+  SCH_FileHandler file_handler;
+  const char *name;
+  uint32_t calls;
+  double total_time;
+  double max_time;
+  uint32_t histogram[RPT_SCHED_HISTOGRAM_BUCKETS];
+} HandlerStats;
+
+#define LAG_STATS_INDEX 0
+
+static ARR_Instance handler_stats;
+
+/* Hash table of indices in the array of statistics (-1 for empty entry)
+   to find the statistics of a handler without searching the array.  The
+   size is a power of two and at least twice the number of handlers. */
+static ARR_Instance stats_table;
+
+#define MIN_STATS_TABLE_SIZE 16
+
+/* Raw time when the currently running handler was dispatched */
+static struct timespec handler_start_ts;
+
+/* Handlers called once after the currently due timeouts or file handlers
+   are dispatched */
+
+typedef struct {
+  SCH_TimeoutHandler handler;
+  SCH_ArbitraryArgument arg;
+} DeferredHandler;
+
+static ARR_Instance deferred_handlers;
 
 /* ================================================== */
 
@@ -122,7 +202,20 @@ handle_slew(struct timespec *raw,
 void
 SCH_Initialise(void)
 {
+  HandlerStats *stats;
+
   file_handlers = ARR_CreateInstance(sizeof (FileHandlerEntry));
+  calendars = ARR_CreateInstance(sizeof (SlotCalendar *));
+  deferred_handlers = ARR_CreateInstance(sizeof (DeferredHandler));
+
+  handler_stats = ARR_CreateInstance(sizeof (HandlerStats));
+  stats = ARR_GetNewElement(handler_stats);
+  memset(stats, 0, sizeof (*stats));
+  stats->name = "lag";
+
+  stats_table = ARR_CreateInstance(sizeof (int));
+  ARR_SetSize(stats_table, MIN_STATS_TABLE_SIZE);
+  memset(ARR_GetElements(stats_table), -1, MIN_STATS_TABLE_SIZE * sizeof (int));
 
   n_timer_queue_entries = 0;
   next_tqe_id = 0;
@@ -145,16 +238,138 @@ SCH_Initialise(void)
 
 void
 SCH_Finalise(void) {
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(calendars); i++)
+    Free(*(SlotCalendar **)ARR_GetElement(calendars, i));
+  ARR_DestroyInstance(calendars);
+  ARR_DestroyInstance(deferred_handlers);
+
   ARR_DestroyInstance(file_handlers);
+  ARR_DestroyInstance(handler_stats);
+  ARR_DestroyInstance(stats_table);
 
   initialised = 0;
 }
 
 /* ================================================== */
 
+static unsigned int
+get_stats_slot(SCH_TimeoutHandler timeout_handler, SCH_FileHandler file_handler)
+{
+  unsigned char bytes[sizeof (timeout_handler) + sizeof (file_handler)];
+  unsigned int i, hash;
+
+  memcpy(bytes, &timeout_handler, sizeof (timeout_handler));
+  memcpy(bytes + sizeof (timeout_handler), &file_handler, sizeof (file_handler));
+
+  for (i = 0, hash = 0; i < sizeof (bytes); i++)
+    hash = hash * 31 + bytes[i];
+
+  return (hash * 2654435761U) >> 8;
+}
+
+/* ================================================== */
+
+static int *
+find_stats_entry(SCH_TimeoutHandler timeout_handler, SCH_FileHandler file_handler)
+{
+  HandlerStats *stats;
+  unsigned int i, mask;
+  int *table;
+
+  stats = ARR_GetElements(handler_stats);
+  table = ARR_GetElements(stats_table);
+  mask = ARR_GetSize(stats_table) - 1;
+
+  for (i = get_stats_slot(timeout_handler, file_handler) & mask; ; i = (i + 1) & mask) {
+    if (table[i] < 0 ||
+        (stats[table[i]].timeout_handler == timeout_handler &&
+         stats[table[i]].file_handler == file_handler))
+      return &table[i];
+  }
+}
+
+/* ================================================== */
+
+static void
+expand_stats_table(void)
+{
+  HandlerStats *stats;
+  unsigned int i, size;
+
+  size = 2 * ARR_GetSize(stats_table);
+  ARR_SetSize(stats_table, size);
+  memset(ARR_GetElements(stats_table), -1, size * sizeof (int));
+
+  for (i = LAG_STATS_INDEX + 1; i < ARR_GetSize(handler_stats); i++) {
+    stats = ARR_GetElement(handler_stats, i);
+    *find_stats_entry(stats->timeout_handler, stats->file_handler) = i;
+  }
+}
+
+/* ================================================== */
+
+static int
+get_stats_index(SCH_TimeoutHandler timeout_handler, SCH_FileHandler file_handler,
+                const char *name)
+{
+  HandlerStats *stats;
+  int *entry, index;
+
+  entry = find_stats_entry(timeout_handler, file_handler);
+  if (*entry >= 0)
+    return *entry;
+
+  index = ARR_GetSize(handler_stats);
+  stats = ARR_GetNewElement(handler_stats);
+  memset(stats, 0, sizeof (*stats));
+  stats->timeout_handler = timeout_handler;
+  stats->file_handler = file_handler;
+  stats->name = name;
+
+  *entry = index;
+
+  if (2 * ARR_GetSize(handler_stats) > ARR_GetSize(stats_table))
+    expand_stats_table();
+
+  return index;
+}
+
+/* ================================================== */
+
+static void
+update_stats(int index, double interval)
+{
+  HandlerStats *stats;
+  int bucket;
+
+  stats = ARR_GetElement(handler_stats, index);
+
+  /* Ignore intervals broken by unexpected time jumps */
+  if (!(interval >= 0.0))
+    interval = 0.0;
+
+  if (interval < 1.0e-6) {
+    bucket = 0;
+  } else {
+    frexp(interval * 1.0e6, &bucket);
+    if (bucket >= RPT_SCHED_HISTOGRAM_BUCKETS)
+      bucket = RPT_SCHED_HISTOGRAM_BUCKETS - 1;
+  }
+
+  stats->calls++;
+  stats->total_time += interval;
+  if (stats->max_time < interval)
+    stats->max_time = interval;
+  stats->histogram[bucket]++;
+}
+
+/* ================================================== */
+
 void
-SCH_AddFileHandler
-(int fd, int events, SCH_FileHandler handler, SCH_ArbitraryArgument arg)
+SCH_AddNamedFileHandler(int fd, int events, SCH_FileHandler handler, const char *name,
+                        SCH_ArbitraryArgument arg)
 {
   FileHandlerEntry *ptr;
 
@@ -171,6 +386,7 @@ SCH_AddFileHandler
     ptr->handler = NULL;
     ptr->arg = NULL;
     ptr->events = 0;
+    ptr->stats_index = 0;
   }
 
   ptr = ARR_GetElement(file_handlers, fd);
@@ -183,6 +399,7 @@ SCH_AddFileHandler
   ptr->handler = handler;
   ptr->arg = arg;
   ptr->events = events;
+  ptr->stats_index = get_stats_index(NULL, handler, name);
 
   if (one_highest_fd < fd + 1)
     one_highest_fd = fd + 1;
@@ -298,7 +515,8 @@ try_again:
 /* ================================================== */
 
 SCH_TimeoutID
-SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+SCH_AddNamedTimeout(struct timespec *ts, SCH_TimeoutHandler handler, const char *name,
+                    SCH_ArbitraryArgument arg)
 {
   TimerQueueEntry *new_tqe;
   TimerQueueEntry *ptr;
@@ -310,8 +528,9 @@ SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArg
   new_tqe->id = get_new_tqe_id();
   new_tqe->handler = handler;
   new_tqe->arg = arg;
+  new_tqe->stats_index = get_stats_index(handler, NULL, name);
   new_tqe->ts = *ts;
-  new_tqe->class = SCH_ReservedTimeoutValue;
+  new_tqe->calendar = NULL;
 
   /* Now work out where to insert the new entry in the list */
   for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
@@ -340,7 +559,8 @@ SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArg
    the current (raw) time */
 
 SCH_TimeoutID
-SCH_AddTimeoutByDelay(double delay, SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+SCH_AddNamedTimeoutByDelay(double delay, SCH_TimeoutHandler handler, const char *name,
+                           SCH_ArbitraryArgument arg)
 {
   struct timespec now, then;
 
@@ -353,26 +573,56 @@ SCH_AddTimeoutByDelay(double delay, SCH_TimeoutHandler handler, SCH_ArbitraryArg
     LOG_FATAL("Timeout overflow");
   }
 
-  return SCH_AddTimeout(&then, handler, arg);
+  return SCH_AddNamedTimeout(&then, handler, name, arg);
 
 }
 
 /* ================================================== */
 
+static SlotCalendar *
+get_calendar(SCH_TimeoutClass class, const char *group)
+{
+  SlotCalendar *calendar;
+  unsigned int i;
+
+  for (i = 0; i < ARR_GetSize(calendars); i++) {
+    calendar = *(SlotCalendar **)ARR_GetElement(calendars, i);
+    if (calendar->class == class &&
+        (calendar->group == group ||
+         (calendar->group && group && strcmp(calendar->group, group) == 0)))
+      return calendar;
+  }
+
+  calendar = MallocNew(SlotCalendar);
+  memset(calendar, 0, sizeof (*calendar));
+  calendar->class = class;
+  calendar->group = group;
+  calendar->timeouts.slot_next = &calendar->timeouts;
+  calendar->timeouts.slot_prev = &calendar->timeouts;
+  ARR_AppendElement(calendars, &calendar);
+
+  return calendar;
+}
+
+/* ================================================== */
+
 SCH_TimeoutID
-SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
-                      SCH_TimeoutClass class,
-                      SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+SCH_AddNamedTimeoutInSlot(double min_delay, double separation, double interval,
+                          double randomness, SCH_TimeoutClass class, const char *group,
+                          SCH_TimeoutHandler handler, const char *name,
+                          SCH_ArbitraryArgument arg)
 {
-  TimerQueueEntry *new_tqe;
-  TimerQueueEntry *ptr;
+  TimerQueueEntry *new_tqe, *ptr, *head;
+  SlotCalendar *calendar;
   struct timespec now;
-  double diff, r;
-  double new_min_delay;
+  double diff, r, delay;
 
   assert(initialised);
   assert(min_delay >= 0.0);
-  assert(class < SCH_NumberOfClasses);
+  assert(class > SCH_ReservedTimeoutValue && class < SCH_NumberOfClasses);
+
+  calendar = get_calendar(class, group);
+  head = &calendar->timeouts;
 
   if (randomness > 0.0) {
     uint32_t rnd;
@@ -382,48 +632,70 @@ SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
     min_delay *= r;
     separation *= r;
   }
-  
+
+  /* Make the slots narrower if the timeouts wouldn't fit in the interval.
+     Leave some free slots to not delay timeouts with a random delay. */
+  if (interval > 0.0 && separation * (calendar->n_timeouts + 1) > MAX_SLOT_LOAD * interval)
+    separation = MAX_SLOT_LOAD * interval / (calendar->n_timeouts + 1);
+
   LCL_ReadRawTime(&now);
-  new_min_delay = min_delay;
+  delay = min_delay;
 
   /* Check the separation from the last dispatched timeout */
-  diff = UTI_DiffTimespecsToDouble(&now, &last_class_dispatch[class]);
-  if (diff < separation && diff >= 0.0 && diff + new_min_delay < separation) {
-    new_min_delay = separation - diff;
+  diff = UTI_DiffTimespecsToDouble(&now, &calendar->last_dispatch);
+  if (diff < separation && diff >= 0.0 && diff + delay < separation) {
+    delay = separation - diff;
   }
 
-  /* Scan through list for entries in the same class and increase min_delay
-     if necessary to keep at least the separation away */
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
-    if (ptr->class == class) {
-      diff = UTI_DiffTimespecsToDouble(&ptr->ts, &now);
-      if (new_min_delay > diff) {
-        if (new_min_delay - diff < separation) {
-          new_min_delay = diff + separation;
-        }
-      } else {
-        if (diff - new_min_delay < separation) {
-          new_min_delay = diff + separation;
-        }
-      }
-    }
+  /* Find the last timeout which is at least the separation before the
+     requested time.  New timeouts are usually added near the end. */
+  for (ptr = head->slot_prev; ptr != head; ptr = ptr->slot_prev) {
+    if (UTI_DiffTimespecsToDouble(&ptr->ts, &now) <= delay - separation)
+      break;
   }
 
-  for (ptr = timer_queue.next; ptr != &timer_queue; ptr = ptr->next) {
+  /* Move the timeout to the first free slot following that timeout */
+  for (ptr = ptr->slot_next; ptr != head; ptr = ptr->slot_next) {
     diff = UTI_DiffTimespecsToDouble(&ptr->ts, &now);
-    if (diff > new_min_delay) {
+    if (diff >= delay + separation)
       break;
-    }
+    delay = diff + separation;
   }
 
-  /* We have located the insertion point */
   new_tqe = allocate_tqe();
 
   new_tqe->id = get_new_tqe_id();
   new_tqe->handler = handler;
   new_tqe->arg = arg;
-  UTI_AddDoubleToTimespec(&now, new_min_delay, &new_tqe->ts);
-  new_tqe->class = class;
+  new_tqe->stats_index = get_stats_index(handler, NULL, name);
+  UTI_AddDoubleToTimespec(&now, delay, &new_tqe->ts);
+  new_tqe->calendar = calendar;
+  new_tqe->slot_load = separation / (interval > 0.0 ? interval : MAX(delay, separation));
+
+  /* Insert the timeout into the calendar before the found timeout */
+  new_tqe->slot_next = ptr;
+  new_tqe->slot_prev = ptr->slot_prev;
+  ptr->slot_prev->slot_next = new_tqe;
+  ptr->slot_prev = new_tqe;
+
+  calendar->n_timeouts++;
+  calendar->load += new_tqe->slot_load;
+  calendar->last_slot = separation;
+  calendar->scheduled++;
+  if (delay > min_delay) {
+    calendar->delayed++;
+    calendar->total_delay += delay - min_delay;
+    if (calendar->max_delay < delay - min_delay)
+      calendar->max_delay = delay - min_delay;
+  }
+
+  /* Locate the insertion point in the timer queue, starting from the
+     preceding timeout in the calendar */
+  ptr = new_tqe->slot_prev != head ? new_tqe->slot_prev : timer_queue.next;
+  for (; ptr != &timer_queue; ptr = ptr->next) {
+    if (UTI_CompareTimespecs(&new_tqe->ts, &ptr->ts) < 0)
+      break;
+  }
 
   new_tqe->next = ptr;
   new_tqe->prev = ptr->prev;
@@ -436,6 +708,17 @@ SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
 
 /* ================================================== */
 
+SCH_TimeoutID
+SCH_AddNamedTimeoutInClass(double min_delay, double separation, double randomness,
+                           SCH_TimeoutClass class, SCH_TimeoutHandler handler,
+                           const char *name, SCH_ArbitraryArgument arg)
+{
+  return SCH_AddNamedTimeoutInSlot(min_delay, separation, 0.0, randomness, class, NULL,
+                                   handler, name, arg);
+}
+
+/* ================================================== */
+
 void
 SCH_RemoveTimeout(SCH_TimeoutID id)
 {
@@ -454,6 +737,16 @@ SCH_RemoveTimeout(SCH_TimeoutID id)
       /* Unlink from the queue */
       ptr->next->prev = ptr->prev;
       ptr->prev->next = ptr->next;
+
+      /* Free the slot in the calendar */
+      if (ptr->calendar) {
+        ptr->slot_next->slot_prev = ptr->slot_prev;
+        ptr->slot_prev->slot_next = ptr->slot_next;
+        ptr->calendar->n_timeouts--;
+        ptr->calendar->load -= ptr->slot_load;
+        if (ptr->calendar->n_timeouts == 0)
+          ptr->calendar->load = 0.0;
+      }
       
       /* Decrement entry count */
       --n_timer_queue_entries;
@@ -480,11 +773,15 @@ dispatch_timeouts(struct timespec *now) {
   TimerQueueEntry *ptr;
   SCH_TimeoutHandler handler;
   SCH_ArbitraryArgument arg;
-  int n_done = 0, n_entries_on_start = n_timer_queue_entries;
+  int n_done = 0, n_entries_on_start = n_timer_queue_entries, stats_index = -1;
 
   while (1) {
     LCL_ReadRawTime(now);
 
+    /* Account the execution time of the previous handler */
+    if (stats_index >= 0)
+      update_stats(stats_index, UTI_DiffTimespecsToDouble(now, &handler_start_ts));
+
     if (!(n_timer_queue_entries > 0 &&
           UTI_CompareTimespecs(now, &timer_queue.next->ts) >= 0)) {
       break;
@@ -492,10 +789,15 @@ dispatch_timeouts(struct timespec *now) {
 
     ptr = timer_queue.next;
 
-    last_class_dispatch[ptr->class] = *now;
+    if (ptr->calendar)
+      ptr->calendar->last_dispatch = *now;
+
+    update_stats(LAG_STATS_INDEX, UTI_DiffTimespecsToDouble(now, &ptr->ts));
 
     handler = ptr->handler;
     arg = ptr->arg;
+    stats_index = ptr->stats_index;
+    handler_start_ts = *now;
 
     SCH_RemoveTimeout(ptr->id);
 
@@ -519,19 +821,67 @@ dispatch_timeouts(struct timespec *now) {
 
 /* ================================================== */
 
+void
+SCH_AddDeferredHandler(SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg)
+{
+  DeferredHandler *deferred;
+
+  deferred = ARR_GetNewElement(deferred_handlers);
+  deferred->handler = handler;
+  deferred->arg = arg;
+}
+
+/* ================================================== */
+
+static void
+dispatch_deferred_handlers(void)
+{
+  DeferredHandler deferred;
+  unsigned int i;
+
+  /* The handlers may add new deferred handlers */
+  for (i = 0; i < ARR_GetSize(deferred_handlers); i++) {
+    deferred = *(DeferredHandler *)ARR_GetElement(deferred_handlers, i);
+    (deferred.handler)(deferred.arg);
+  }
+
+  ARR_SetSize(deferred_handlers, 0);
+}
+
+/* ================================================== */
+
+static void
+dispatch_filehandler(int fd, int event)
+{
+  FileHandlerEntry *ptr;
+  struct timespec now;
+  int stats_index;
+
+  ptr = (FileHandlerEntry *)ARR_GetElement(file_handlers, fd);
+  stats_index = ptr->stats_index;
+
+  (ptr->handler)(fd, event, ptr->arg);
+
+  LCL_ReadRawTime(&now);
+  update_stats(stats_index, UTI_DiffTimespecsToDouble(&now, &handler_start_ts));
+  handler_start_ts = now;
+}
+
+/* ================================================== */
+
 /* nfd is the number of bits set in all fd_sets */
 
 static void
 dispatch_filehandlers(int nfd, fd_set *read_fds, fd_set *write_fds, fd_set *except_fds)
 {
-  FileHandlerEntry *ptr;
   int fd;
+
+  handler_start_ts = last_select_ts_raw;
   
   for (fd = 0; nfd && fd < one_highest_fd; fd++) {
     if (except_fds && FD_ISSET(fd, except_fds)) {
       /* This descriptor has an exception, dispatch its handler */
-      ptr = (FileHandlerEntry *)ARR_GetElement(file_handlers, fd);
-      (ptr->handler)(fd, SCH_FILE_EXCEPTION, ptr->arg);
+      dispatch_filehandler(fd, SCH_FILE_EXCEPTION);
       nfd--;
 
       /* Don't try to read from it now */
@@ -543,15 +893,13 @@ dispatch_filehandlers(int nfd, fd_set *read_fds, fd_set *write_fds, fd_set *exce
 
     if (read_fds && FD_ISSET(fd, read_fds)) {
       /* This descriptor can be read from, dispatch its handler */
-      ptr = (FileHandlerEntry *)ARR_GetElement(file_handlers, fd);
-      (ptr->handler)(fd, SCH_FILE_INPUT, ptr->arg);
+      dispatch_filehandler(fd, SCH_FILE_INPUT);
       nfd--;
     }
 
     if (write_fds && FD_ISSET(fd, write_fds)) {
       /* This descriptor can be written to, dispatch its handler */
-      ptr = (FileHandlerEntry *)ARR_GetElement(file_handlers, fd);
-      (ptr->handler)(fd, SCH_FILE_OUTPUT, ptr->arg);
+      dispatch_filehandler(fd, SCH_FILE_OUTPUT);
       nfd--;
     }
   }
@@ -568,8 +916,9 @@ handle_slew(struct timespec *raw,
             void *anything)
 {
   TimerQueueEntry *ptr;
+  SlotCalendar *calendar;
+  unsigned int i;
   double delta;
-  int i;
 
   if (change_type != LCL_ChangeAdjust) {
     /* Make sure this handler is invoked first in order to not shift new timers
@@ -582,11 +931,13 @@ handle_slew(struct timespec *raw,
       UTI_AddDoubleToTimespec(&ptr->ts, -doffset, &ptr->ts);
     }
 
-    for (i = 0; i < SCH_NumberOfClasses; i++) {
-      UTI_AddDoubleToTimespec(&last_class_dispatch[i], -doffset, &last_class_dispatch[i]);
+    for (i = 0; i < ARR_GetSize(calendars); i++) {
+      calendar = *(SlotCalendar **)ARR_GetElement(calendars, i);
+      UTI_AddDoubleToTimespec(&calendar->last_dispatch, -doffset, &calendar->last_dispatch);
     }
 
     UTI_AddDoubleToTimespec(&last_select_ts_raw, -doffset, &last_select_ts_raw);
+    UTI_AddDoubleToTimespec(&handler_start_ts, -doffset, &handler_start_ts);
   }
 
   UTI_AdjustTimespec(&last_select_ts, cooked, &last_select_ts, &delta, dfreq, doffset);
@@ -713,8 +1064,12 @@ SCH_MainLoop(void)
   assert(initialised);
 
   while (!need_to_exit) {
-    /* Dispatch timeouts and fill now with current raw time */
+    /* Dispatch timeouts and fill now with current raw time.  Changes of
+       the clock made by the handlers are applied together. */
+    LCL_BeginUpdate();
     dispatch_timeouts(&now);
+    dispatch_deferred_handlers();
+    LCL_EndUpdate();
     saved_now = now;
     
     /* The timeout handlers may request quit */
@@ -766,7 +1121,10 @@ SCH_MainLoop(void)
       }
     } else if (status > 0) {
       /* A file descriptor is ready for input or output */
+      LCL_BeginUpdate();
       dispatch_filehandlers(status, p_read_fds, p_write_fds, p_except_fds);
+      dispatch_deferred_handlers();
+      LCL_EndUpdate();
     } else {
       /* No descriptors readable, timeout must have elapsed.
        Therefore, tv must be non-null */
@@ -790,3 +1148,69 @@ SCH_QuitProgram(void)
 
 /* ================================================== */
 
+int
+SCH_GetNumberOfReports(void)
+{
+  return ARR_GetSize(handler_stats);
+}
+
+/* ================================================== */
+
+int
+SCH_GetReport(int index, RPT_SchedReport *report)
+{
+  HandlerStats *stats;
+
+  if (index < 0 || index >= ARR_GetSize(handler_stats))
+    return 0;
+
+  stats = ARR_GetElement(handler_stats, index);
+
+  snprintf(report->name, sizeof (report->name), "%s", stats->name);
+  if (index == LAG_STATS_INDEX)
+    report->type = RPT_SCHED_LAG;
+  else if (stats->timeout_handler)
+    report->type = RPT_SCHED_TIMEOUT;
+  else
+    report->type = RPT_SCHED_FILE;
+  report->calls = stats->calls;
+  report->total_time = stats->total_time;
+  report->max_time = stats->max_time;
+  memcpy(report->histogram, stats->histogram, sizeof (report->histogram));
+
+  return 1;
+}
+
+/* ================================================== */
+
+int
+SCH_GetNumberOfSlotReports(void)
+{
+  return ARR_GetSize(calendars);
+}
+
+/* ================================================== */
+
+int
+SCH_GetSlotReport(int index, RPT_SlotReport *report)
+{
+  SlotCalendar *calendar;
+
+  if (index < 0 || index >= ARR_GetSize(calendars))
+    return 0;
+
+  calendar = *(SlotCalendar **)ARR_GetElement(calendars, index);
+
+  snprintf(report->name, sizeof (report->name), "%s%s%s", class_names[calendar->class],
+           calendar->group ? " " : "", calendar->group ? calendar->group : "");
+  report->timeouts = calendar->n_timeouts;
+  report->slot = calendar->last_slot;
+  report->load = calendar->load;
+  report->scheduled = calendar->scheduled;
+  report->delayed = calendar->delayed;
+  report->mean_delay = calendar->delayed > 0 ?
+                       calendar->total_delay / calendar->delayed : 0.0;
+  report->max_delay = calendar->max_delay;
+
+  return 1;
+}
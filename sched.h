@@ -28,6 +28,7 @@
 #define GOT_SCHED_H
 
 #include "sysincl.h"
+#include "reports.h"
 
 /* Type for timeout IDs, valid IDs are always greater than zero */
 typedef unsigned int SCH_TimeoutID;
@@ -57,8 +58,13 @@ extern void SCH_Finalise(void);
 #define SCH_FILE_OUTPUT 2
 #define SCH_FILE_EXCEPTION 4
 
-/* Register a handler for when select goes true on a file descriptor */
-extern void SCH_AddFileHandler(int fd, int events, SCH_FileHandler handler, SCH_ArbitraryArgument arg);
+/* Register a handler for when select goes true on a file descriptor.  The
+   name of the handler function is recorded for the execution time
+   statistics. */
+extern void SCH_AddNamedFileHandler(int fd, int events, SCH_FileHandler handler,
+                                    const char *name, SCH_ArbitraryArgument arg);
+#define SCH_AddFileHandler(fd, events, handler, arg) \
+  SCH_AddNamedFileHandler(fd, events, handler, #handler, arg)
 extern void SCH_RemoveFileHandler(int fd);
 extern void SCH_SetFileHandlerEvents(int fd, int events);
 
@@ -66,18 +72,46 @@ extern void SCH_SetFileHandlerEvents(int fd, int events);
 extern void SCH_GetLastEventTime(struct timespec *cooked, double *err, struct timespec *raw);
 
 /* This queues a timeout to elapse at a given (raw) local time */
-extern SCH_TimeoutID SCH_AddTimeout(struct timespec *ts, SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg);
+extern SCH_TimeoutID SCH_AddNamedTimeout(struct timespec *ts, SCH_TimeoutHandler handler,
+                                         const char *name, SCH_ArbitraryArgument arg);
+#define SCH_AddTimeout(ts, handler, arg) \
+  SCH_AddNamedTimeout(ts, handler, #handler, arg)
 
 /* This queues a timeout to elapse at a given delta time relative to the current (raw) time */
-extern SCH_TimeoutID SCH_AddTimeoutByDelay(double delay, SCH_TimeoutHandler, SCH_ArbitraryArgument);
+extern SCH_TimeoutID SCH_AddNamedTimeoutByDelay(double delay, SCH_TimeoutHandler handler,
+                                                const char *name, SCH_ArbitraryArgument arg);
+#define SCH_AddTimeoutByDelay(delay, handler, arg) \
+  SCH_AddNamedTimeoutByDelay(delay, handler, #handler, arg)
 
 /* This queues a timeout in a particular class, ensuring that the
    expiry time is at least a given separation away from any other
    timeout in the same class, given randomness is added to the delay
    and separation */
-extern SCH_TimeoutID SCH_AddTimeoutInClass(double min_delay, double separation, double randomness,
-                                           SCH_TimeoutClass class,
-                                           SCH_TimeoutHandler handler, SCH_ArbitraryArgument);
+extern SCH_TimeoutID SCH_AddNamedTimeoutInClass(double min_delay, double separation,
+                                                double randomness, SCH_TimeoutClass class,
+                                                SCH_TimeoutHandler handler, const char *name,
+                                                SCH_ArbitraryArgument arg);
+#define SCH_AddTimeoutInClass(min_delay, separation, randomness, class, handler, arg) \
+  SCH_AddNamedTimeoutInClass(min_delay, separation, randomness, class, handler, #handler, arg)
+
+/* This queues a timeout in a calendar of slots shared by timeouts in a
+   particular class and group (a static string, or NULL).  The timeout is
+   placed in the first free slot after the minimum delay.  The width of the
+   slots is the separation, which is reduced when the timeouts in the group
+   would not fit in the given interval (if positive). */
+extern SCH_TimeoutID SCH_AddNamedTimeoutInSlot(double min_delay, double separation,
+                                               double interval, double randomness,
+                                               SCH_TimeoutClass class, const char *group,
+                                               SCH_TimeoutHandler handler, const char *name,
+                                               SCH_ArbitraryArgument arg);
+#define SCH_AddTimeoutInSlot(min_delay, separation, interval, randomness, class, group, \
+                             handler, arg) \
+  SCH_AddNamedTimeoutInSlot(min_delay, separation, interval, randomness, class, group, \
+                            handler, #handler, arg)
+
+/* Register a handler to be called once after all timeouts (or file
+   handlers) which are currently due are dispatched */
+extern void SCH_AddDeferredHandler(SCH_TimeoutHandler handler, SCH_ArbitraryArgument arg);
 
 /* The next one probably ought to return a status code */
 extern void SCH_RemoveTimeout(SCH_TimeoutID);
@@ -86,4 +120,16 @@ extern void SCH_MainLoop(void);
 
 extern void SCH_QuitProgram(void);
 
+/* Get the number of reports with execution time statistics of handlers.
+   The first report is the lag of dispatched timeouts. */
+extern int SCH_GetNumberOfReports(void);
+
+/* Get a report with statistics for a given index, returning zero if the
+   index is not valid */
+extern int SCH_GetReport(int index, RPT_SchedReport *report);
+
+/* Get the number of calendars of slots and a report for a given index */
+extern int SCH_GetNumberOfSlotReports(void);
+extern int SCH_GetSlotReport(int index, RPT_SlotReport *report);
+
 #endif /* GOT_SCHED_H */
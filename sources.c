@@ -152,6 +152,13 @@ static int selected_source_index; /* Which source index is currently
                                      selected (set to INVALID_SOURCE
                                      if no current valid reference) */
 
+/* Source reported to the selection handler as selected */
+static SRC_Instance reported_selected_source;
+
+/* Handlers for sample and selection notifications */
+static SRC_SampleHandler sample_handler;
+static SRC_SelectionHandler selection_handler;
+
 /* Score needed to replace the currently selected source */
 #define SCORE_LIMIT 10.0
 
@@ -184,6 +191,9 @@ void SRC_Initialise(void) {
   n_sources = 0;
   max_n_sources = 0;
   selected_source_index = INVALID_SOURCE;
+  reported_selected_source = NULL;
+  sample_handler = NULL;
+  selection_handler = NULL;
   max_distance = CNF_GetMaxDistance();
   max_jitter = CNF_GetMaxJitter();
   reselect_distance = CNF_GetReselectDistance();
@@ -277,13 +287,22 @@ void SRC_DestroyInstance(SRC_Instance instance)
     sources[i]->index = i;
   }
   --n_sources;
-  Free(instance);
 
   /* If this was the previous reference source, we have to reselect! */
   if (selected_source_index == dead_index)
     SRC_ReselectSource();
   else if (selected_source_index > dead_index)
     --selected_source_index;
+
+  /* The reselection reported a change of the selected source if this was
+     the reported source.  Make sure no reference to it is kept. */
+  if (reported_selected_source == instance) {
+    reported_selected_source = NULL;
+    if (selection_handler)
+      (selection_handler)(0, NULL);
+  }
+
+  Free(instance);
 }
 
 /* ================================================== */
@@ -364,6 +383,10 @@ void SRC_AccumulateSample
      IS FLIPPED */
   SST_AccumulateSample(inst->stats, sample_time, -offset, peer_delay, peer_dispersion, root_delay, root_dispersion, stratum);
   SST_DoNewRegression(inst->stats);
+
+  if (sample_handler)
+    (sample_handler)(inst->ref_id, inst->ip_addr, sample_time, -offset,
+                     peer_delay, peer_dispersion, stratum);
 }
 
 /* ================================================== */
@@ -597,8 +620,8 @@ combine_sources(int n_sel_sources, struct timespec *ref_time, double *offset,
 /* This function selects the current reference from amongst the pool
    of sources we are holding and updates the local reference */
 
-void
-SRC_SelectSource(SRC_Instance updated_inst)
+static void
+select_source(SRC_Instance updated_inst)
 {
   struct SelectInfo *si;
   struct timespec now, ref_time;
@@ -1083,6 +1106,28 @@ SRC_SelectSource(SRC_Instance updated_inst)
                    src_root_delay, src_root_dispersion);
 }
 
+/* ================================================== */
+
+void
+SRC_SelectSource(SRC_Instance updated_inst)
+{
+  SRC_Instance selected;
+
+  select_source(updated_inst);
+
+  selected = selected_source_index != INVALID_SOURCE ?
+             sources[selected_source_index] : NULL;
+
+  if (selected == reported_selected_source)
+    return;
+
+  reported_selected_source = selected;
+
+  if (selection_handler)
+    (selection_handler)(selected ? selected->ref_id : 0,
+                        selected ? selected->ip_addr : NULL);
+}
+
 /* ================================================== */
 /* Force reselecting the best source */
 
@@ -1379,6 +1424,22 @@ SRC_ReportSourcestats(int index, RPT_SourcestatsReport *report, struct timespec
 
 /* ================================================== */
 
+void
+SRC_SetSampleHandler(SRC_SampleHandler handler)
+{
+  sample_handler = handler;
+}
+
+/* ================================================== */
+
+void
+SRC_SetSelectionHandler(SRC_SelectionHandler handler)
+{
+  selection_handler = handler;
+}
+
+/* ================================================== */
+
 SRC_Type
 SRC_GetType(int index)
 {
@@ -150,4 +150,20 @@ extern int SRC_ReportSourcestats(int index, RPT_SourcestatsReport *report, struc
 
 extern SRC_Type SRC_GetType(int index);
 
+/* Function type for handlers to be called back when a sample is accumulated.
+   The IP address is NULL for reference clocks. */
+typedef void (*SRC_SampleHandler)(uint32_t ref_id, IPAddr *ip_addr,
+                                  struct timespec *sample_time, double offset,
+                                  double peer_delay, double peer_dispersion,
+                                  int stratum);
+
+/* Function type for handlers to be called back when a different source is
+   selected.  The IP address is NULL for reference clocks and the reference
+   ID is zero when no source is selected. */
+typedef void (*SRC_SelectionHandler)(uint32_t ref_id, IPAddr *ip_addr);
+
+/* Set the handlers for being notified of new samples and selection changes */
+extern void SRC_SetSampleHandler(SRC_SampleHandler handler);
+extern void SRC_SetSelectionHandler(SRC_SelectionHandler handler);
+
 #endif /* GOT_SOURCES_H */
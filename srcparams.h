@@ -43,6 +43,7 @@ typedef struct {
   int min_samples;
   int max_samples;
   int interleaved;
+  int monitor;
   int sel_options;
   uint32_t authkey;
   double max_delay;
@@ -32,6 +32,7 @@
 #include "keys.h"
 #include "logging.h"
 #include "manual.h"
+#include "metrics.h"
 #include "memory.h"
 #include "nameserv.h"
 #include "nameserv_async.h"
@@ -127,6 +128,21 @@ CAM_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
   return 1;
 }
 
+void
+CAM_BeginAccessRestrictions(void)
+{
+}
+
+void
+CAM_EndAccessRestrictions(int commit)
+{
+}
+
+void
+CAM_SetStartupReport(RPT_StartupReport *report)
+{
+}
+
 void
 MNL_Initialise(void)
 {
@@ -137,6 +153,21 @@ MNL_Finalise(void)
 {
 }
 
+void
+MET_Initialise(int family)
+{
+}
+
+void
+MET_Finalise(void)
+{
+}
+
+void
+MET_OpenUnixSocket(void)
+{
+}
+
 #endif /* !FEAT_CMDMON */
 
 #ifndef FEAT_NTP
@@ -162,6 +193,28 @@ NCR_AddAccessRestriction(IPAddr *ip_addr, int subnet_bits, int allow, int all)
   return 1;
 }
 
+int
+NCR_AddAccessRestrictionFile(const char *file, int allow)
+{
+  return 1;
+}
+
+int
+NCR_ReloadAccessRestrictionFiles(void)
+{
+  return 1;
+}
+
+void
+NCR_BeginAccessRestrictions(void)
+{
+}
+
+void
+NCR_EndAccessRestrictions(int commit)
+{
+}
+
 int
 NCR_CheckAccessRestriction(IPAddr *ip_addr)
 {
@@ -178,6 +231,18 @@ NIO_Finalise(void)
 {
 }
 
+int
+NIO_GetNumberOfHwClocks(void)
+{
+  return 0;
+}
+
+int
+NIO_GetHwClockReport(int index, RPT_HwClockReport *report)
+{
+  return 0;
+}
+
 void
 NSR_Initialise(void)
 {
@@ -189,13 +254,15 @@ NSR_Finalise(void)
 }
 
 NSR_Status
-NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourceParameters *params)
+NSR_AddSource(NTP_Remote_Address *remote_addr, NTP_Source_Type type, SourceParameters *params,
+              uint32_t *conf_id)
 {
   return NSR_TooManySources;
 }
 
 void
-NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, SourceParameters *params)
+NSR_AddSourceByName(char *name, int port, int pool, NTP_Source_Type type, SourceParameters *params,
+                    uint32_t *conf_id)
 {
 }
 
@@ -205,6 +272,17 @@ NSR_RemoveSource(NTP_Remote_Address *remote_addr)
   return NSR_NoSuchSource;
 }
 
+int
+NSR_RemoveSources(IPAddr *mask, IPAddr *address)
+{
+  return 0;
+}
+
+void
+NSR_RemoveSourcesById(uint32_t conf_id)
+{
+}
+
 void
 NSR_RemoveAllSources(void)
 {
@@ -325,6 +403,19 @@ NSR_GetActivityReport(RPT_ActivityReport *report)
   memset(report, 0, sizeof (*report));
 }
 
+unsigned int
+NSR_GetNumberOfIndices(void)
+{
+  return 0;
+}
+
+int
+NSR_GetMonitorReportByIndex(unsigned int index, RPT_MonitorReport *report,
+                            struct timespec *now)
+{
+  return 0;
+}
+
 #ifndef FEAT_CMDMON
 
 void
@@ -337,6 +428,11 @@ CLG_Finalise(void)
 {
 }
 
+void
+CLG_UpdateRateLimits(void)
+{
+}
+
 void
 DNS_SetAddressFamily(int family)
 {
@@ -415,4 +511,10 @@ NSD_SignAndSendPacket(uint32_t key_id, NTP_Packet *packet, NTP_Remote_Address *r
   return 0;
 }
 
+int
+NSD_GetReport(RPT_SigndReport *report)
+{
+  return 0;
+}
+
 #endif /* !FEAT_SIGND */
@@ -32,6 +32,7 @@
 #include "sys.h"
 #include "sys_null.h"
 #include "logging.h"
+#include "privops.h"
 
 #if defined(LINUX)
 #include "sys_linux.h"
@@ -43,6 +44,11 @@
 #include "sys_macosx.h"
 #endif
 
+#if !defined(MACOSX) || defined(HAVE_MACOS_SYS_TIMEX)
+#include "sys_timex.h"
+#define HAVE_SYS_TIMEX
+#endif
+
 /* ================================================== */
 
 static int null_driver;
@@ -145,3 +151,16 @@ void SYS_LockMemory(void)
 }
 
 /* ================================================== */
+
+void
+SYS_GetReport(RPT_SysReport *report)
+{
+  memset(report, 0, sizeof (*report));
+
+#ifdef HAVE_SYS_TIMEX
+  if (!null_driver)
+    SYS_Timex_GetReport(report);
+#endif
+
+  PRV_GetReport(report);
+}
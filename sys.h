@@ -29,6 +29,8 @@
 #ifndef GOT_SYS_H
 #define GOT_SYS_H
 
+#include "reports.h"
+
 /* Called at the start of the run to do initialisation */
 extern void SYS_Initialise(int clock_control);
 
@@ -45,4 +47,7 @@ extern void SYS_EnableSystemCallFilter(int level);
 extern void SYS_SetScheduler(int SchedPriority);
 extern void SYS_LockMemory(void);
 
+/* Get statistics of the system calls adjusting the clock */
+extern void SYS_GetReport(RPT_SysReport *report);
+
 #endif /* GOT_SYS_H */
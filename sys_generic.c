@@ -290,6 +290,20 @@ accrue_offset(double offset, double corr_rate)
   update_slew();
 }
 
+/* ================================================== */
+
+static double
+set_frequency_and_offset(double freq_ppm, double offset, double corr_rate)
+{
+  base_freq = freq_ppm;
+  offset_register += offset;
+  correction_rate = corr_rate;
+
+  update_slew();
+
+  return base_freq;
+}
+
 /* ================================================== */
 /* Determine the correction to generate the cooked time for given raw time */
 
@@ -396,6 +410,7 @@ SYS_Generic_CompleteFreqDriver(double max_set_freq_ppm, double max_set_freq_dela
                             accrue_offset, sys_apply_step_offset ?
                               sys_apply_step_offset : apply_step_offset,
                             offset_convert, sys_set_leap, set_sync_status);
+  lcl_RegisterSystemUpdateDriver(set_frequency_and_offset);
 
   LCL_AddParameterChangeHandler(handle_step, NULL);
 }
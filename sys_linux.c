@@ -68,9 +68,11 @@
 
 #include "sys_linux.h"
 #include "sys_timex.h"
+#include "array.h"
 #include "conf.h"
 #include "local.h"
 #include "logging.h"
+#include "phcsim.h"
 #include "privops.h"
 #include "util.h"
 
@@ -480,7 +482,7 @@ SYS_Linux_EnableSystemCallFilter(int level)
     SCMP_SYS(lseek), SCMP_SYS(rename), SCMP_SYS(stat), SCMP_SYS(stat64),
     SCMP_SYS(statfs), SCMP_SYS(statfs64), SCMP_SYS(unlink),
     /* Socket */
-    SCMP_SYS(bind), SCMP_SYS(connect), SCMP_SYS(getsockname),
+    SCMP_SYS(accept4), SCMP_SYS(bind), SCMP_SYS(connect), SCMP_SYS(getsockname),
     SCMP_SYS(recvfrom), SCMP_SYS(recvmmsg), SCMP_SYS(recvmsg),
     SCMP_SYS(sendmmsg), SCMP_SYS(sendmsg), SCMP_SYS(sendto),
     /* TODO: check socketcall arguments */
@@ -509,6 +511,9 @@ SYS_Linux_EnableSystemCallFilter(int level)
     { SOL_SOCKET, SO_TIMESTAMP }, { SOL_SOCKET, SO_TIMESTAMPNS },
 #ifdef HAVE_LINUX_TIMESTAMPING
     { SOL_SOCKET, SO_SELECT_ERR_QUEUE }, { SOL_SOCKET, SO_TIMESTAMPING },
+#endif
+#ifdef HAVE_LINUX_SOCKET_FILTER
+    { SOL_SOCKET, SO_ATTACH_FILTER },
 #endif
   };
 
@@ -677,6 +682,65 @@ SYS_Linux_CheckKernelVersion(int req_major, int req_minor)
 
 #define PHC_READINGS 10
 
+/* Simulated PHCs, which are identified by a placeholder descriptor */
+typedef struct {
+  int fd;
+  PSM_Instance clock;
+} SimulatedPHC;
+
+static ARR_Instance simulated_phcs = NULL;
+
+/* ================================================== */
+
+static PSM_Instance
+get_simulated_phc(int fd)
+{
+  SimulatedPHC *sim;
+  unsigned int i;
+
+  if (!simulated_phcs)
+    return NULL;
+
+  for (i = 0; i < ARR_GetSize(simulated_phcs); i++) {
+    sim = ARR_GetElement(simulated_phcs, i);
+    if (sim->fd == fd)
+      return sim->clock;
+  }
+
+  return NULL;
+}
+
+/* ================================================== */
+
+static int
+open_simulated_phc(const char *path)
+{
+  SimulatedPHC sim;
+
+  sim.clock = PSM_CreateInstance(path);
+  if (!sim.clock)
+    return -1;
+
+  sim.fd = open("/dev/null", O_RDONLY);
+  if (sim.fd < 0) {
+    LOG(LOGS_ERR, "Could not open %s : %s", "/dev/null", strerror(errno));
+    PSM_DestroyInstance(sim.clock);
+    return -1;
+  }
+
+  UTI_FdSetCloexec(sim.fd);
+
+  if (!simulated_phcs)
+    simulated_phcs = ARR_CreateInstance(sizeof (SimulatedPHC));
+  ARR_AppendElement(simulated_phcs, &sim);
+
+  LOG(LOGS_INFO, "Using simulated PHC %s", path);
+
+  return sim.fd;
+}
+
+/* ================================================== */
+
 static int
 get_phc_sample(int phc_fd, double precision, struct timespec *phc_ts,
                struct timespec *sys_ts, double *err)
@@ -777,6 +841,9 @@ SYS_Linux_OpenPHC(const char *path, int phc_index)
   char phc_path[64];
   int phc_fd;
 
+  if (PSM_IsSimulatorPath(path))
+    return open_simulated_phc(path);
+
   if (!path) {
     if (snprintf(phc_path, sizeof (phc_path), "/dev/ptp%d", phc_index) >= sizeof (phc_path))
       return -1;
@@ -803,10 +870,47 @@ SYS_Linux_OpenPHC(const char *path, int phc_index)
 
 /* ================================================== */
 
+void
+SYS_Linux_ClosePHC(int fd)
+{
+  SimulatedPHC *sim;
+  unsigned int i;
+
+  for (i = 0; simulated_phcs && i < ARR_GetSize(simulated_phcs); i++) {
+    sim = ARR_GetElement(simulated_phcs, i);
+    if (sim->fd != fd)
+      continue;
+
+    PSM_DestroyInstance(sim->clock);
+
+    /* Replace the record with the last one */
+    *sim = *(SimulatedPHC *)ARR_GetElement(simulated_phcs, ARR_GetSize(simulated_phcs) - 1);
+    ARR_SetSize(simulated_phcs, ARR_GetSize(simulated_phcs) - 1);
+
+    if (ARR_GetSize(simulated_phcs) == 0) {
+      ARR_DestroyInstance(simulated_phcs);
+      simulated_phcs = NULL;
+    }
+    break;
+  }
+
+  close(fd);
+}
+
+/* ================================================== */
+
 int
 SYS_Linux_GetPHCSample(int fd, int nocrossts, double precision, int *reading_mode,
                        struct timespec *phc_ts, struct timespec *sys_ts, double *err)
 {
+  PSM_Instance sim;
+
+  sim = get_simulated_phc(fd);
+  if (sim) {
+    *reading_mode = 1;
+    return PSM_GetSample(sim, precision, phc_ts, sys_ts, err);
+  }
+
   if ((*reading_mode == 2 || !*reading_mode) && !nocrossts &&
       get_precise_phc_sample(fd, precision, phc_ts, sys_ts, err)) {
     *reading_mode = 2;
@@ -828,6 +932,14 @@ SYS_Linux_SetPHCExtTimestamping(int fd, int pin, int channel,
   struct ptp_extts_request extts_req;
 #ifdef PTP_PIN_SETFUNC
   struct ptp_pin_desc pin_desc;
+#endif
+
+  if (get_simulated_phc(fd)) {
+    DEBUG_LOG("External timestamping not supported by simulated PHC");
+    return 0;
+  }
+
+#ifdef PTP_PIN_SETFUNC
 
   memset(&pin_desc, 0, sizeof (pin_desc));
   pin_desc.index = pin;
@@ -876,4 +988,20 @@ SYS_Linux_ReadPHCExtTimestamp(int fd, struct timespec *phc_ts, int *channel)
   return 1;
 }
 
+/* ================================================== */
+
+int
+SYS_Linux_GetSimulatedPHCTimestamp(int fd, struct timespec *sys_ts, struct timespec *phc_ts)
+{
+  PSM_Instance sim;
+
+  sim = get_simulated_phc(fd);
+  if (!sim)
+    return 0;
+
+  PSM_ConvertTime(sim, sys_ts, phc_ts);
+
+  return 1;
+}
+
 #endif
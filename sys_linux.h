@@ -43,6 +43,8 @@ extern int SYS_Linux_CheckKernelVersion(int req_major, int req_minor);
 
 extern int SYS_Linux_OpenPHC(const char *path, int phc_index);
 
+extern void SYS_Linux_ClosePHC(int fd);
+
 extern int SYS_Linux_GetPHCSample(int fd, int nocrossts, double precision, int *reading_mode,
                                   struct timespec *phc_ts, struct timespec *sys_ts, double *err);
 
@@ -51,4 +53,7 @@ extern int SYS_Linux_SetPHCExtTimestamping(int fd, int pin, int channel,
 
 extern int SYS_Linux_ReadPHCExtTimestamp(int fd, struct timespec *phc_ts, int *channel);
 
+extern int SYS_Linux_GetSimulatedPHCTimestamp(int fd, struct timespec *sys_ts,
+                                              struct timespec *phc_ts);
+
 #endif  /* GOT_SYS_LINUX_H */
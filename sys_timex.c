@@ -30,10 +30,12 @@
 #include "sysincl.h"
 
 #include "conf.h"
+#include "local.h"
 #include "privops.h"
 #include "sys_generic.h"
 #include "sys_timex.h"
 #include "logging.h"
+#include "util.h"
 
 #ifdef PRIVOPS_ADJUSTTIMEX
 #define NTP_ADJTIME PRV_AdjustTimex
@@ -66,6 +68,13 @@ static int sys_status;
 /* Saved TAI-UTC offset */
 static int sys_tai_offset;
 
+/* Statistics of the time spent in the system call (including the privops
+   helper if used) */
+static uint32_t adjust_calls;
+static double adjust_last_time;
+static double adjust_total_time;
+static double adjust_max_time;
+
 /* ================================================== */
 
 static double
@@ -245,7 +254,9 @@ SYS_Timex_Finalise(void)
 int
 SYS_Timex_Adjust(struct timex *txc, int ignore_error)
 {
-  int state;
+  struct timespec before, after;
+  double interval;
+  int state, step;
 
 #ifdef SOLARIS
   /* The kernel seems to check the constant even when it's not being set */
@@ -253,7 +264,25 @@ SYS_Timex_Adjust(struct timex *txc, int ignore_error)
     txc->constant = 10;
 #endif
 
+  LCL_ReadRawTime(&before);
   state = NTP_ADJTIME(txc);
+  LCL_ReadRawTime(&after);
+
+#ifdef ADJ_SETOFFSET
+  step = txc->modes & ADJ_SETOFFSET;
+#else
+  step = 0;
+#endif
+
+  /* Ignore intervals including a step of the clock */
+  interval = UTI_DiffTimespecsToDouble(&after, &before);
+  if (!step && interval >= 0.0 && interval < 1.0) {
+    adjust_last_time = interval;
+    adjust_calls++;
+    adjust_total_time += adjust_last_time;
+    if (adjust_max_time < adjust_last_time)
+      adjust_max_time = adjust_last_time;
+  }
 
   if (state < 0) {
     if (!ignore_error)
@@ -264,3 +293,14 @@ SYS_Timex_Adjust(struct timex *txc, int ignore_error)
 
   return state;
 }
+
+/* ================================================== */
+
+void
+SYS_Timex_GetReport(RPT_SysReport *report)
+{
+  report->adjtimex_calls = adjust_calls;
+  report->adjtimex_last_time = adjust_last_time;
+  report->adjtimex_mean_time = adjust_calls > 0 ? adjust_total_time / adjust_calls : 0.0;
+  report->adjtimex_max_time = adjust_max_time;
+}
@@ -28,6 +28,7 @@
 #define GOT_SYS_TIMEX_H
 
 #include "localp.h"
+#include "reports.h"
 
 extern void SYS_Timex_Initialise(void);
 
@@ -45,4 +46,7 @@ extern void SYS_Timex_Finalise(void);
 /* Wrapper for adjtimex()/ntp_adjtime() */
 extern int SYS_Timex_Adjust(struct timex *txc, int ignore_error);
 
+/* Get statistics of the adjtimex()/ntp_adjtime() calls */
+extern void SYS_Timex_GetReport(RPT_SysReport *report);
+
 #endif  /* GOT_SYS_GENERIC_H */
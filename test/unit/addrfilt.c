@@ -23,12 +23,37 @@
 #include <util.h>
 #include "test.h"
 
+static int
+check_rules(ADF_Rule *rules, int n_rules, int default_allow, IPAddr *ip)
+{
+  IPAddr mask;
+  int i, j, bits;
+
+  for (i = 0; i < n_rules; i++) {
+    TEST_CHECK(rules[i].subnet.ip.family == ip->family);
+    bits = rules[i].subnet.subnet_bits;
+    mask.family = ip->family;
+    if (ip->family == IPADDR_INET4) {
+      mask.addr.in4 = bits > 0 ? ~(uint32_t)0 << (32 - bits) : 0;
+    } else {
+      for (j = 0; j < 16; j++)
+        mask.addr.in6[j] = 0xff << (8 - CLAMP(0, bits - 8 * j, 8));
+    }
+    if (!UTI_CompareIPs(ip, &rules[i].subnet.ip, &mask))
+      return rules[i].allow;
+  }
+
+  return default_allow;
+}
+
 void
 test_unit(void)
 {
-  int i, j, sub, maxsub;
+  int i, j, k, sub, maxsub, n_rules, default_allow;
   IPAddr ip;
-  ADF_AuthTable table;
+  ADF_AuthTable table, table2;
+  ADF_Subnet subnets[100];
+  ADF_Rule rules[1000];
 
   table = ADF_CreateTable();
 
@@ -79,5 +104,62 @@ test_unit(void)
     ADF_DenyAll(table, &ip, 0);
   }
 
+  table2 = ADF_CreateTable();
+
+  for (i = 0; i < 100; i++) {
+    for (j = 0; j < 100; j++) {
+      if (j % 2) {
+        maxsub = 32;
+        TST_GetRandomAddress(&subnets[j].ip, IPADDR_INET4, -1);
+      } else {
+        maxsub = 128;
+        TST_GetRandomAddress(&subnets[j].ip, IPADDR_INET6, -1);
+      }
+      subnets[j].subnet_bits = random() % (maxsub + 1) / (random() % 4 + 1);
+      TEST_CHECK(ADF_Allow(table, &subnets[j].ip, subnets[j].subnet_bits) == ADF_SUCCESS);
+    }
+
+    TEST_CHECK(ADF_AddSubnets(table2, subnets, 100, 1) == ADF_SUCCESS);
+
+    for (j = 0; j < 1000; j++) {
+      if (j % 2)
+        TST_GetRandomAddress(&ip, IPADDR_INET4, -1);
+      else
+        TST_GetRandomAddress(&ip, IPADDR_INET6, -1);
+      if (random() % 2)
+        ip = subnets[random() % 100].ip;
+      TEST_CHECK(ADF_IsAllowed(table, &ip) == ADF_IsAllowed(table2, &ip));
+    }
+
+    for (j = 0; j < 20; j++) {
+      k = random() % 100;
+      maxsub = subnets[k].ip.family == IPADDR_INET4 ? 32 : 128;
+      sub = subnets[k].subnet_bits;
+      ADF_Deny(table, &subnets[k].ip, sub + random() % (maxsub - sub + 1));
+    }
+
+    for (j = 0; j < 1000; j++) {
+      TST_GetRandomAddress(&ip, j % 2 ? IPADDR_INET4 : IPADDR_INET6, -1);
+      if (random() % 2) {
+        ip = subnets[random() % 100].ip;
+        TST_SwapAddressBit(&ip, random() % (ip.family == IPADDR_INET4 ? 32 : 128));
+      }
+      n_rules = ADF_GetRules(table, ip.family, rules, 1000, &default_allow);
+      TEST_CHECK(n_rules >= 0);
+      TEST_CHECK(ADF_IsAllowed(table, &ip) ==
+                 check_rules(rules, n_rules, default_allow, &ip));
+      if (n_rules > 0)
+        TEST_CHECK(ADF_GetRules(table, ip.family, rules, n_rules - 1, &default_allow) < 0);
+    }
+
+    subnets[0].subnet_bits = 129;
+    TEST_CHECK(ADF_AddSubnets(table2, subnets, 1, 0) == ADF_BADSUBNET);
+
+    ip.family = IPADDR_UNSPEC;
+    ADF_DenyAll(table, &ip, 0);
+    ADF_DenyAll(table2, &ip, 0);
+  }
+
+  ADF_DestroyTable(table2);
   ADF_DestroyTable(table);
 }
@@ -26,6 +26,9 @@ test_unit(void)
 {
   int i, j, index;
   struct timespec ts;
+  NTP_int64 rx_ts, tx_ts, tx_ts2;
+  RPT_ServerStatsReport report;
+  RPT_ClientAccessByIndex_Report access_report;
   IPAddr ip;
   char conf[][100] = {
     "clientloglimit 10000",
@@ -39,7 +42,9 @@ test_unit(void)
 
   CLG_Initialise();
 
-  TEST_CHECK(ARR_GetSize(records) == 16);
+  TEST_CHECK(sizeof (Record4) < sizeof (Record6));
+  TEST_CHECK(ARR_GetSize(pools[POOL_IPV4].records) == 16);
+  TEST_CHECK(ARR_GetSize(pools[POOL_IPV6].records) == 16);
 
   for (i = 0; i < 500; i++) {
     DEBUG_LOG("iteration %d", i);
@@ -65,8 +70,27 @@ test_unit(void)
     }
   }
 
-  DEBUG_LOG("records %d", ARR_GetSize(records));
-  TEST_CHECK(ARR_GetSize(records) == 64);
+  DEBUG_LOG("records %u %u", ARR_GetSize(pools[POOL_IPV4].records),
+            ARR_GetSize(pools[POOL_IPV6].records));
+  TEST_CHECK(ARR_GetSize(pools[POOL_IPV4].records) > 16);
+  TEST_CHECK(ARR_GetSize(pools[POOL_IPV6].records) > 16);
+  TEST_CHECK(get_table_memory(&pools[POOL_IPV4], pools[POOL_IPV4].slots) +
+             get_table_memory(&pools[POOL_IPV6], pools[POOL_IPV6].slots) <=
+             max_records_memory);
+
+  for (i = 0; i < CLG_GetNumberOfIndices(); i++) {
+    if (!CLG_GetClientAccessReportByIndex(i, &access_report, &ts))
+      continue;
+    index = CLG_LogNTPAccess(&access_report.ip_addr, &ts);
+    TEST_CHECK(index == i);
+  }
+
+  CLG_GetServerStatsReport(&report);
+  TEST_CHECK(report.log_records_ipv4 == pools[POOL_IPV4].used);
+  TEST_CHECK(report.log_records_ipv4 <= report.log_records_ipv4_size);
+  TEST_CHECK(report.log_records_ipv4_size == ARR_GetSize(pools[POOL_IPV4].records));
+  TEST_CHECK(report.log_records_ipv6 <= report.log_records_ipv6_size);
+  TEST_CHECK(report.log_records_ipv6_size == ARR_GetSize(pools[POOL_IPV6].records));
 
   for (i = j = 0; i < 10000; i++) {
     ts.tv_sec += 1;
@@ -79,6 +103,87 @@ test_unit(void)
   DEBUG_LOG("requests %u responses %u", i, j);
   TEST_CHECK(j * 4 < i && j * 6 > i);
 
+  TEST_CHECK(ts_buckets_bits == 5);
+  TEST_CHECK((uintptr_t)ts_buckets % TS_BUCKET_ALIGNMENT == 0);
+
+  for (i = 0; i < 1000; i++) {
+    TST_GetRandomAddress(&ip, IPADDR_INET4, -1);
+    UTI_GetNtp64Fuzz(&rx_ts, 32);
+    UTI_GetNtp64Fuzz(&tx_ts, 32);
+    if (UTI_IsZeroNtp64(&rx_ts))
+      continue;
+
+    TEST_CHECK(!CLG_GetNtpTxTimestamp(&ip, &rx_ts));
+    CLG_SaveNtpTimestamps(&ip, &rx_ts, &tx_ts);
+    TEST_CHECK(CLG_GetNtpTxTimestamp(&ip, &rx_ts));
+    TEST_CHECK(CLG_GetNtpInterleavedTimestamp(&ip, &rx_ts, &tx_ts2));
+    TEST_CHECK(!UTI_CompareNtp64(&tx_ts, &tx_ts2));
+    ip.addr.in4 ^= 1;
+    TEST_CHECK(!CLG_GetNtpInterleavedTimestamp(&ip, &rx_ts, &tx_ts2));
+
+    ip.addr.in4 ^= 1;
+    UTI_GetNtp64Fuzz(&rx_ts, 32);
+    UTI_ZeroNtp64(&tx_ts);
+    if (UTI_IsZeroNtp64(&rx_ts))
+      continue;
+    CLG_SaveNtpTimestamps(&ip, &rx_ts, &tx_ts);
+    TEST_CHECK(CLG_GetNtpInterleavedTimestamp(&ip, &rx_ts, &tx_ts2));
+    TEST_CHECK(UTI_IsZeroNtp64(&tx_ts2));
+    ip.addr.in4 ^= 1;
+    TEST_CHECK(!CLG_GetNtpInterleavedTimestamp(&ip, &rx_ts, &tx_ts2));
+  }
+
+  CLG_GetServerStatsReport(&report);
+  DEBUG_LOG("hits %"PRIu32" misses %"PRIu32" timestamps %"PRIu32,
+            report.ntp_interleaved_hits, report.ntp_interleaved_misses,
+            report.ntp_timestamps);
+  TEST_CHECK(report.ntp_interleaved_hits == report.ntp_interleaved_misses);
+  TEST_CHECK(report.ntp_interleaved_hits > 990);
+  TEST_CHECK(report.ntp_timestamps == (1U << ts_buckets_bits) * TS_BUCKET_ENTRIES);
+
+  CLG_Finalise();
+  CLG_Initialise();
+
+  /* IPv4-only clients can use the memory not needed by IPv6 records, but
+     some memory is left for IPv6 clients */
+  for (i = 0; i < 1000; i++) {
+    TST_GetRandomAddress(&ip, IPADDR_INET4, -1);
+    TEST_CHECK(CLG_LogNTPAccess(&ip, &ts) >= 0);
+  }
+
+  CLG_GetServerStatsReport(&report);
+  TEST_CHECK(report.log_records_ipv4_size == 128);
+  TEST_CHECK(report.log_records_ipv4 == 128);
+  TEST_CHECK(report.log_records_ipv6_size == 16);
+  TEST_CHECK(report.log_records_ipv6 == 0);
+
+  for (i = 0; i < 1000; i++) {
+    TST_GetRandomAddress(&ip, IPADDR_INET6, -1);
+    TEST_CHECK(CLG_LogNTPAccess(&ip, &ts) >= 0);
+  }
+
+  CLG_GetServerStatsReport(&report);
+  TEST_CHECK(report.log_records_ipv4_size == 128);
+  TEST_CHECK(report.log_records_ipv4 == 128);
+  TEST_CHECK(report.log_records_ipv6_size == 64);
+  TEST_CHECK(report.log_records_ipv6 == 64);
+
+  CLG_Finalise();
+
+  /* The default limit allows 8192 IPv4 records */
+  snprintf(conf[0], sizeof (conf[0]), "clientloglimit 524288");
+  CNF_ParseLine(NULL, 1, conf[0]);
+  CLG_Initialise();
+
+  for (i = 0; i < 100000; i++) {
+    TST_GetRandomAddress(&ip, IPADDR_INET4, -1);
+    TEST_CHECK(CLG_LogNTPAccess(&ip, &ts) >= 0);
+  }
+
+  CLG_GetServerStatsReport(&report);
+  TEST_CHECK(report.log_records_ipv4_size == 8192);
+  TEST_CHECK(report.log_records_ipv4 == 8192);
+
   CLG_Finalise();
   CNF_Finalise();
 }
@@ -31,7 +31,7 @@ test_unit(void)
 
   LCL_Initialise();
 
-  clock = HCL_CreateInstance(1.0);
+  clock = HCL_CreateInstance(1.0, 1.0);
 
   for (i = 0, count = 0, sum = 0.0; i < 2000; i++) {
     UTI_ZeroTimespec(&start_hw_ts);
@@ -78,5 +78,37 @@ test_unit(void)
 
   HCL_DestroyInstance(clock);
 
+  /* The sampling interval should grow up to the maximum separation if the
+     samples are predicted well and return to the minimum on large errors */
+  clock = HCL_CreateInstance(1.0, 16.0);
+
+  UTI_ZeroTimespec(&start_hw_ts);
+  UTI_ZeroTimespec(&start_local_ts);
+  UTI_AddDoubleToTimespec(&start_hw_ts, TST_GetRandomDouble(0.0, 1e9), &start_hw_ts);
+  UTI_AddDoubleToTimespec(&start_local_ts, TST_GetRandomDouble(0.0, 1e9), &start_local_ts);
+  freq = TST_GetRandomDouble(0.9, 1.1);
+  jitter = 100.0e-9;
+
+  for (i = j = 0; i < 1000; i++) {
+    UTI_AddDoubleToTimespec(&start_local_ts, i * 0.5, &local_ts);
+    if (!HCL_NeedsNewSample(clock, &local_ts))
+      continue;
+    UTI_AddDoubleToTimespec(&start_hw_ts, i * 0.5 * freq +
+                            TST_GetRandomDouble(-jitter, jitter), &hw_ts);
+    HCL_AccumulateSample(clock, &hw_ts, &local_ts, 2.0 * jitter);
+    j++;
+  }
+
+  TEST_CHECK(clock->valid_coefs);
+  TEST_CHECK(clock->separation == 16.0);
+  TEST_CHECK(j < 100);
+
+  UTI_AddDoubleToTimespec(&start_local_ts, i * 0.5, &local_ts);
+  UTI_AddDoubleToTimespec(&start_hw_ts, i * 0.5 * freq + 100.0 * jitter, &hw_ts);
+  HCL_AccumulateSample(clock, &hw_ts, &local_ts, 2.0 * jitter);
+  TEST_CHECK(clock->separation <= 8.0);
+
+  HCL_DestroyInstance(clock);
+
   LCL_Finalise();
 }
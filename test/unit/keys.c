@@ -83,9 +83,11 @@ generate_key_file(const char *name, uint32_t *keys)
 void
 test_unit(void)
 {
-  int i, j, data_len, auth_len;
-  uint32_t keys[KEYS], key;
+  int i, j, k, data_len, auth_len;
+  uint32_t keys[KEYS], key, samples;
   unsigned char data[100], auth[MAX_HASH_LENGTH];
+  RPT_KeyReport report;
+  Key test_key;
   char conf[][100] = {
     "keyfile "KEYFILE
   };
@@ -139,6 +141,29 @@ test_unit(void)
     }
   }
 
+  for (j = 0; j < KEY_GetNumberOfReports(); j++) {
+    TEST_CHECK(KEY_GetReport(j, &report));
+    TEST_CHECK(KEY_KeyKnown(report.id));
+    TEST_CHECK(report.auth_delay >= 0.0);
+    TEST_CHECK(report.mean_delay >= 0.0 && report.max_delay >= 0.0);
+    for (k = samples = 0; k < RPT_KEY_HISTOGRAM_BUCKETS; k++)
+      samples += report.histogram[k];
+    TEST_CHECK(samples == report.samples);
+  }
+  TEST_CHECK(!KEY_GetReport(j, &report));
+
+  memset(&test_key, 0, sizeof (test_key));
+  test_key.auth_delay = -1;
+  update_auth_delay(&test_key, 1.0e-6);
+  TEST_CHECK(test_key.auth_delay == 1062);
+  update_auth_delay(&test_key, 1.0e-3);
+  TEST_CHECK(fabs(test_key.auth_delay_avg - 1.05e-6) < 1e-12);
+  TEST_CHECK(test_key.auth_delay_max == 1.0e-3);
+  update_auth_delay(&test_key, -1.0);
+  TEST_CHECK(test_key.auth_samples == 2);
+  TEST_CHECK(test_key.auth_histogram[10] == 1);
+  TEST_CHECK(test_key.auth_histogram[20] == 1);
+
   unlink(KEYFILE);
 
   KEY_Finalise();
@@ -0,0 +1,193 @@
+/*
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+ */
+
+#include <local.c>
+#include "test.h"
+
+/* Resolution of the frequency set by the driver (in ppm) */
+#define FREQ_RESOLUTION 0.01
+
+static double driver_freq;
+static double driver_offset;
+static double driver_step;
+static int driver_calls;
+
+static double
+read_frequency(void)
+{
+  return driver_freq;
+}
+
+static double
+set_frequency(double freq_ppm)
+{
+  driver_calls++;
+  driver_freq = round(freq_ppm / FREQ_RESOLUTION) * FREQ_RESOLUTION;
+  return driver_freq;
+}
+
+static void
+accrue_offset(double offset, double corr_rate)
+{
+  driver_offset += offset;
+}
+
+static int
+apply_step_offset(double offset)
+{
+  driver_step += offset;
+  return 1;
+}
+
+static void
+offset_convert(struct timespec *raw, double *corr, double *err)
+{
+  *corr = -driver_offset;
+  if (err)
+    *err = 0.0;
+}
+
+static void
+check_applied_comp(double freq, double comp)
+{
+  /* The frequency set by the driver has to correspond to the returned
+     compensation of the uncompensated frequency */
+  TEST_CHECK(fabs(driver_freq - (freq * (1.0 - 1.0e-6 * comp) - comp)) < 1e-9);
+  TEST_CHECK(fabs(LCL_ReadAbsoluteFrequency() - freq) < 1e-9);
+  TEST_CHECK(current_freq_ppm == driver_freq);
+}
+
+#define MAX_OPERATIONS 10
+
+static void
+run_operations(int *operations, double *offsets, int n, int transaction,
+               double *corrections, struct timespec *cooked)
+{
+  struct timespec raw;
+  int i;
+
+  driver_offset = driver_step = 0.0;
+  UTI_ZeroTimespec(&raw);
+  raw.tv_sec = 1000000000;
+
+  if (transaction)
+    LCL_BeginUpdate();
+
+  for (i = 0; i < n; i++) {
+    switch (operations[i]) {
+      case 0:
+        LCL_AccumulateOffset(offsets[i], 0.0);
+        break;
+      case 1:
+        TEST_CHECK(LCL_MakeStep());
+        break;
+      case 2:
+        LCL_AccumulateFrequencyAndOffset(0.0, offsets[i], 0.0);
+        break;
+    }
+
+    LCL_GetOffsetCorrection(&raw, &corrections[i], NULL);
+    LCL_CookTime(&raw, &cooked[i], NULL);
+  }
+
+  if (transaction) {
+    LCL_EndUpdate();
+    TEST_CHECK(!update.pending);
+  }
+}
+
+static void
+test_offsets(void)
+{
+  double offsets[MAX_OPERATIONS], corrections[2][MAX_OPERATIONS];
+  double offsets2[2], steps[2];
+  struct timespec cooked[2][MAX_OPERATIONS];
+  int i, j, n, operations[MAX_OPERATIONS];
+
+  /* Don't print the warnings about the steps */
+  LOG_OpenFileLog("/dev/null");
+
+  for (i = 0; i < 1000; i++) {
+    n = random() % MAX_OPERATIONS + 1;
+    for (j = 0; j < n; j++) {
+      operations[j] = random() % 3;
+      offsets[j] = TST_GetRandomDouble(-1.0, 1.0);
+    }
+
+    /* Reads and steps in an update need to see the same offset as
+       without the update */
+    for (j = 0; j < 2; j++) {
+      run_operations(operations, offsets, n, j, corrections[j], cooked[j]);
+      offsets2[j] = driver_offset;
+      steps[j] = driver_step;
+    }
+
+    for (j = 0; j < n; j++) {
+      TEST_CHECK(fabs(corrections[0][j] - corrections[1][j]) < 1e-9);
+      TEST_CHECK(fabs(UTI_DiffTimespecsToDouble(&cooked[0][j], &cooked[1][j])) < 1e-8);
+    }
+
+    TEST_CHECK(fabs(offsets2[0] - offsets2[1]) < 1e-9);
+    TEST_CHECK(fabs(steps[0] - steps[1]) < 1e-9);
+  }
+}
+
+void
+test_unit(void)
+{
+  double freq, uncomp_freq, comp, applied_comp;
+  int i, transaction;
+
+  LCL_Initialise();
+  lcl_RegisterSystemDrivers(read_frequency, set_frequency, accrue_offset,
+                            apply_step_offset, offset_convert, NULL, NULL);
+
+  for (i = 0; i < 1000; i++) {
+    freq = TST_GetRandomDouble(-100.0, 100.0);
+    comp = TST_GetRandomDouble(-10.0, 10.0);
+    transaction = i % 2;
+
+    DEBUG_LOG("freq %f comp %f transaction %d", freq, comp, transaction);
+
+    driver_calls = 0;
+
+    if (transaction)
+      LCL_BeginUpdate();
+
+    LCL_SetAbsoluteFrequency(freq);
+    uncomp_freq = LCL_ReadAbsoluteFrequency();
+    TEST_CHECK(fabs(uncomp_freq - freq) < FREQ_RESOLUTION);
+    applied_comp = LCL_SetTempComp(comp);
+
+    if (transaction) {
+      TEST_CHECK(update.pending);
+      LCL_EndUpdate();
+      TEST_CHECK(!update.pending);
+    }
+
+    TEST_CHECK(driver_calls >= 1 && driver_calls <= 2);
+    TEST_CHECK(fabs(applied_comp - comp) < FREQ_RESOLUTION);
+    check_applied_comp(uncomp_freq, applied_comp);
+  }
+
+  test_offsets();
+
+  LCL_Finalise();
+}
@@ -31,15 +31,23 @@
 static struct timespec current_time;
 static NTP_Receive_Buffer req_buffer, res_buffer;
 static int req_length, res_length;
+static int send_fail;
 
 #define NIO_OpenServerSocket(addr) ((addr)->ip_addr.family != IPADDR_UNSPEC ? 100 : 0)
 #define NIO_CloseServerSocket(fd) assert(fd == 100)
 #define NIO_OpenClientSocket(addr) ((addr)->ip_addr.family != IPADDR_UNSPEC ? 101 : 0)
 #define NIO_CloseClientSocket(fd) assert(fd == 101)
-#define NIO_SendPacket(msg, to, from, len, process_tx) (memcpy(&req_buffer, msg, len), req_length = len, 1)
+#define NIO_SendPacket(msg, to, from, len, process_tx) \
+  (!send_fail && (memcpy(&req_buffer, msg, len), req_length = len, 1))
+#define NIO_QueuePacket(msg, to, from, len, process_tx) NIO_SendPacket(msg, to, from, len, process_tx)
+#undef SCH_AddTimeoutByDelay
+#undef SCH_AddTimeoutInClass
+#undef SCH_AddTimeoutInSlot
 #define SCH_AddTimeoutByDelay(delay, handler, arg) (1 ? 102 : (handler(arg), 1))
 #define SCH_AddTimeoutInClass(delay, separation, randomness, class, handler, arg) \
   add_timeout_in_class(delay, separation, randomness, class, handler, arg)
+#define SCH_AddTimeoutInSlot(delay, separation, interval, randomness, class, group, handler, arg) \
+  add_timeout_in_class(delay, separation, randomness, class, handler, arg)
 #define SCH_RemoveTimeout(id) assert(!id || id == 102)
 #define LCL_ReadRawTime(ts) (*ts = current_time)
 #define LCL_ReadCookedTime(ts, err) do {double *p = err; *ts = current_time; if (p) *p = 0.0;} while (0)
@@ -217,6 +225,7 @@ test_unit(void)
   int i, j, interleaved, authenticated, valid, updated, has_updated;
   CPS_NTP_Source source;
   NTP_Remote_Address remote_addr;
+  RPT_MonitorReport monitor_report;
 
   CNF_Initialise(0, 0);
   for (i = 0; i < sizeof conf / sizeof conf[0]; i++)
@@ -237,6 +246,8 @@ test_unit(void)
       source.params.interleaved = 1;
     if (random() % 2)
       source.params.authkey = 1;
+    if (random() % 2)
+      source.params.monitor = 1;
 
     UTI_ZeroTimespec(&current_time);
     advance_time(TST_GetRandomDouble(1.0, 1e9));
@@ -285,6 +296,40 @@ test_unit(void)
       process_response(0, inst->mode == MODE_CLIENT ? 0 : updated);
     }
 
+    TEST_CHECK(NCR_GetMonitorReport(inst, &monitor_report, &current_time) ==
+               source.params.monitor);
+    if (source.params.monitor) {
+      TEST_CHECK(!(monitor_report.reachability & ~0xff));
+      TEST_CHECK(monitor_report.samples >= 0 && monitor_report.samples <= 8);
+      TEST_CHECK(monitor_report.min_delay <= monitor_report.delay);
+    }
+
+    NCR_DestroyInstance(inst);
+  }
+
+  /* An unreachable source in an online burst should not count failed
+     transmissions as samples, including a source used only for monitoring */
+  for (i = 0; i < 2; i++) {
+    CPS_ParseNTPSourceAdd(source_line, &source);
+    source.params.monitor = i;
+
+    inst = NCR_GetInstance(&remote_addr, NTP_SERVER, &source.params);
+    TEST_CHECK(!inst->source == !!source.params.monitor);
+    NCR_StartInstance(inst);
+    NCR_InitiateSampleBurst(inst, 4, 8);
+    TEST_CHECK(inst->opmode == MD_BURST_WAS_ONLINE);
+
+    send_fail = 1;
+    for (j = 0; j < 10; j++)
+      transmit_timeout(inst);
+    TEST_CHECK(inst->opmode == MD_BURST_WAS_ONLINE);
+    TEST_CHECK(inst->burst_total_samples_to_go == 8);
+
+    send_fail = 0;
+    for (j = 0; j < 10; j++)
+      transmit_timeout(inst);
+    TEST_CHECK(inst->opmode == MD_ONLINE);
+
     NCR_DestroyInstance(inst);
   }
 
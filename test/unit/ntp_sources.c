@@ -23,13 +23,32 @@
 #include <ntp_io.h>
 #include "test.h"
 
+static void
+check_index(void)
+{
+  AddressIndexEntry *entries;
+  unsigned int i;
+
+  entries = ARR_GetElements(address_index);
+
+  TEST_CHECK(ARR_GetSize(address_index) == n_sources);
+
+  for (i = 0; i < ARR_GetSize(address_index); i++) {
+    TEST_CHECK(!UTI_CompareIPs(&entries[i].ip_addr,
+                               &NCR_GetRemoteAddress(entries[i].data)->ip_addr, NULL));
+    if (i > 0)
+      TEST_CHECK(compare_index_addresses(&entries[i - 1].ip_addr, &entries[i].ip_addr) < 0);
+  }
+}
+
 void
 test_unit(void)
 {
-  int i, j, k, slot, found;
-  uint32_t hash = 0;
+  int i, j, k, slot, found, added[256], removed;
+  uint32_t hash = 0, conf_ids[16], conf_id;
   NTP_Remote_Address addrs[256], addr;
   SourceParameters params;
+  IPAddr mask;
   char conf[] = "port 0";
 
   memset(&params, 0, sizeof (params));
@@ -62,7 +81,7 @@ test_unit(void)
       DEBUG_LOG("adding source %s hash %"PRIu32, UTI_IPToString(&addrs[j].ip_addr),
                 UTI_IPToHash(&addrs[j].ip_addr) % (1U << i));
 
-      NSR_AddSource(&addrs[j], random() % 2 ? NTP_SERVER : NTP_PEER, &params);
+      NSR_AddSource(&addrs[j], random() % 2 ? NTP_SERVER : NTP_PEER, &params, NULL);
 
       for (k = 0; k < j; k++) {
         addr = addrs[k];
@@ -78,6 +97,8 @@ test_unit(void)
       }
     }
 
+    check_index();
+
     for (j = 0; j < sizeof (addrs) / sizeof (addrs[0]); j++) {
       DEBUG_LOG("removing source %s", UTI_IPToString(&addrs[j].ip_addr));
       NSR_RemoveSource(&addrs[j]);
@@ -87,8 +108,73 @@ test_unit(void)
         TEST_CHECK(found == (k <= j ? 0 : 2));
       }
     }
+
+    check_index();
   }
 
+  for (i = 0; i < 100; i++) {
+    for (j = 0; j < sizeof (addrs) / sizeof (addrs[0]); j++) {
+      TST_GetRandomAddress(&addrs[j].ip_addr, i % 2 ? IPADDR_INET4 : IPADDR_INET6, 10);
+      addrs[j].port = 123;
+      added[j] = NSR_AddSource(&addrs[j], NTP_SERVER, &params, NULL) == NSR_Success;
+    }
+
+    check_index();
+
+    /* Use a random mask covering some of the lowest 10 bits */
+    mask.family = addrs[0].ip_addr.family;
+    if (mask.family == IPADDR_INET4) {
+      mask.addr.in4 = ~0U << 10 | (uint32_t)random() % 1024;
+    } else {
+      memset(mask.addr.in6, 0xff, sizeof (mask.addr.in6));
+      mask.addr.in6[14] = 0xfc | random() % 4;
+      mask.addr.in6[15] = random() % 256;
+    }
+
+    addr = addrs[random() % (sizeof (addrs) / sizeof (addrs[0]))];
+
+    for (j = removed = 0; j < sizeof (addrs) / sizeof (addrs[0]); j++) {
+      if (added[j] && !UTI_CompareIPs(&addrs[j].ip_addr, &addr.ip_addr, &mask))
+        removed++;
+    }
+
+    TEST_CHECK(NSR_RemoveSources(&mask, &addr.ip_addr) == removed);
+    check_index();
+
+    for (j = 0; j < sizeof (addrs) / sizeof (addrs[0]); j++) {
+      find_slot(&addrs[j], &slot, &found);
+      TEST_CHECK(!found == !UTI_CompareIPs(&addrs[j].ip_addr, &addr.ip_addr, &mask));
+    }
+
+    NSR_RemoveAllSources();
+    check_index();
+    TEST_CHECK(n_sources == 0);
+  }
+
+  for (i = 0; i < 16; i++) {
+    TST_GetRandomAddress(&addrs[i].ip_addr, IPADDR_UNSPEC, -1);
+    addrs[i].port = 123;
+    TEST_CHECK(NSR_AddSource(&addrs[i], NTP_SERVER, &params, &conf_ids[i]) == NSR_Success);
+    TEST_CHECK(conf_ids[i] != 0);
+    TEST_CHECK(i == 0 || conf_ids[i] != conf_ids[i - 1]);
+  }
+
+  for (i = 0; i < 16; i += 2)
+    NSR_RemoveSourcesById(conf_ids[i]);
+
+  for (i = 0; i < 16; i++) {
+    find_slot(&addrs[i], &slot, &found);
+    TEST_CHECK(found == (i % 2 ? 2 : 0));
+  }
+
+  check_index();
+  NSR_RemoveAllSources();
+
+  NSR_AddSourceByName("unresolved.example", 123, 1, NTP_SERVER, &params, &conf_id);
+  TEST_CHECK(unresolved_sources && unresolved_sources->new_source.conf_id == conf_id);
+  NSR_RemoveSourcesById(conf_id);
+  TEST_CHECK(!unresolved_sources);
+
   NSR_Finalise();
   NCR_Finalise();
   NIO_Finalise();
@@ -0,0 +1,108 @@
+/*
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+ */
+
+#include <phcsim.c>
+#include "test.h"
+
+void
+test_unit(void)
+{
+  struct timespec sys_ts, phc_ts, phc_ts2, start_ts;
+  PSM_Instance clock;
+  double freq, offset, jitter, elapsed, err, sum, sum2;
+  int i, j;
+
+  LCL_Initialise();
+
+  TEST_CHECK(PSM_IsSimulatorPath("sim"));
+  TEST_CHECK(PSM_IsSimulatorPath("sim,freq=1"));
+  TEST_CHECK(!PSM_IsSimulatorPath(NULL));
+  TEST_CHECK(!PSM_IsSimulatorPath("/dev/ptp0"));
+  TEST_CHECK(!PSM_IsSimulatorPath("simx"));
+
+  TEST_CHECK(!PSM_CreateInstance("/dev/ptp0"));
+  TEST_CHECK(!PSM_CreateInstance("sim,"));
+  TEST_CHECK(!PSM_CreateInstance("sim,freq"));
+  TEST_CHECK(!PSM_CreateInstance("sim,freq=x"));
+  TEST_CHECK(!PSM_CreateInstance("sim,foo=1"));
+  TEST_CHECK(!PSM_CreateInstance("sim,jitter=-1"));
+  TEST_CHECK(!PSM_CreateInstance("sim,freq=1x"));
+
+  clock = PSM_CreateInstance("sim,offset=37,freq=-12.5,wander=0.1,jitter=1e-8,delay=2e-6,seed=3");
+  TEST_CHECK(clock);
+  TEST_CHECK(clock->phase == 37.0);
+  TEST_CHECK(clock->freq == -12.5);
+  TEST_CHECK(clock->wander == 0.1);
+  TEST_CHECK(clock->jitter == 1e-8);
+  TEST_CHECK(clock->delay == 2e-6);
+  TEST_CHECK(clock->rng_state == 3);
+  PSM_DestroyInstance(clock);
+
+  for (i = 0; i < 100; i++) {
+    freq = TST_GetRandomDouble(-100.0, 100.0);
+    offset = TST_GetRandomDouble(-1e3, 1e3);
+    jitter = TST_GetRandomDouble(1e-7, 1e-6);
+
+    clock = PSM_CreateInstance("sim");
+    TEST_CHECK(clock);
+    clock->phase = offset;
+    clock->freq = freq;
+    clock->sys_freq = 0.0;
+
+    UTI_ZeroTimespec(&start_ts);
+    UTI_AddDoubleToTimespec(&start_ts, TST_GetRandomDouble(1e8, 1e9), &start_ts);
+    clock->last_ts = start_ts;
+
+    /* Without jitter and wander the clock follows the model exactly (with
+       timestamps rounded to nanoseconds) */
+    elapsed = TST_GetRandomDouble(1.0, 1e4);
+    UTI_AddDoubleToTimespec(&start_ts, elapsed, &sys_ts);
+    PSM_ConvertTime(clock, &sys_ts, &phc_ts);
+    TEST_CHECK(fabs(UTI_DiffTimespecsToDouble(&phc_ts, &sys_ts) -
+                    (offset + elapsed * freq / 1e6)) < 3e-9);
+
+    /* A step of the system clock doesn't step the simulated clock */
+    handle_slew(&sys_ts, &sys_ts, 0.0, 1.0, LCL_ChangeStep, clock);
+    UTI_AddDoubleToTimespec(&sys_ts, -1.0, &sys_ts);
+    PSM_ConvertTime(clock, &sys_ts, &phc_ts2);
+    TEST_CHECK(fabs(UTI_DiffTimespecsToDouble(&phc_ts2, &phc_ts)) < 3e-9);
+
+    /* The jitter has the expected standard deviation */
+    clock->jitter = jitter;
+    for (j = 0, sum = sum2 = 0.0; j < 1000; j++) {
+      PSM_ConvertTime(clock, &sys_ts, &phc_ts);
+      err = UTI_DiffTimespecsToDouble(&phc_ts, &phc_ts2);
+      sum += err;
+      sum2 += err * err;
+    }
+    TEST_CHECK(fabs(sum / j) < 0.2 * jitter);
+    TEST_CHECK(fabs(sqrt(sum2 / j) / jitter - 1.0) < 0.2);
+
+    clock->delay = 1e-5;
+    TEST_CHECK(PSM_GetSample(clock, 1e-7, &phc_ts, &sys_ts, &err));
+    TEST_CHECK(err == 5e-6);
+    TEST_CHECK(PSM_GetSample(clock, 1e-5, &phc_ts, &sys_ts, &err));
+    TEST_CHECK(err == 1e-5);
+
+    PSM_DestroyInstance(clock);
+  }
+
+  LCL_Finalise();
+}
@@ -0,0 +1,170 @@
+/*
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+ */
+
+#include <refclock.c>
+#include "test.h"
+
+/* Reference selection of samples from the filter, which sorts all samples
+   by offset as the original implementation did.  Equal offsets are ordered
+   by the index of the sample, as the order of equal elements after qsort()
+   is not specified. */
+
+static const struct FilterSample *ref_sorted_array;
+
+static int
+ref_sample_compare(const void *a, const void *b)
+{
+  const struct FilterSample *s1, *s2;
+
+  s1 = &ref_sorted_array[*(int *)a];
+  s2 = &ref_sorted_array[*(int *)b];
+
+  if (s1->offset < s2->offset)
+    return -1;
+  else if (s1->offset > s2->offset)
+    return 1;
+  else if (*(int *)a < *(int *)b)
+    return -1;
+  else if (*(int *)a > *(int *)b)
+    return 1;
+  return 0;
+}
+
+static int
+ref_select_samples(struct MedianFilter *filter, int *selected)
+{
+  int i, j, k, o, from, to;
+  double min_dispersion;
+
+  if (filter->used < 1)
+    return 0;
+
+  if ((filter->length < 4 && filter->used != filter->length) ||
+      (filter->length >= 4 && filter->used < 4))
+    return 0;
+
+  if (filter->used > 4) {
+    for (i = 1, min_dispersion = filter->samples[0].dispersion; i < filter->used; i++) {
+      if (min_dispersion > filter->samples[i].dispersion)
+        min_dispersion = filter->samples[i].dispersion;
+    }
+
+    for (i = j = 0; i < filter->used; i++) {
+      if (filter->samples[i].dispersion <= 1.5 * min_dispersion)
+        selected[j++] = i;
+    }
+  } else {
+    j = 0;
+  }
+
+  if (j < 4) {
+    for (j = 0; j < filter->used; j++)
+      selected[j] = j;
+  }
+
+  ref_sorted_array = filter->samples;
+  qsort(selected, j, sizeof (int), ref_sample_compare);
+
+  if (j > 2) {
+    from = j / 5;
+    if (from < 1)
+      from = 1;
+    to = j - from;
+  } else {
+    from = 0;
+    to = j;
+  }
+
+  o = filter->used - filter->index - 1;
+
+  for (i = 0; i < from; i++)
+    selected[i] = -1;
+  for (; i < to; i++)
+    selected[i] = (selected[i] + o) % filter->used;
+  for (; i < filter->used; i++)
+    selected[i] = -1;
+
+  for (i = from; i < to; i++) {
+    j = selected[i];
+    selected[i] = -1;
+    while (j != -1 && selected[j] != j) {
+      k = selected[j];
+      selected[j] = j;
+      j = k;
+    }
+  }
+
+  for (i = j = 0; i < filter->used; i++) {
+    if (selected[i] != -1)
+      selected[j++] = (selected[i] + filter->used - o) % filter->used;
+  }
+
+  return j;
+}
+
+void
+test_unit(void)
+{
+  int i, j, k, length, n, n_ref, levels, *ref_selected;
+  struct MedianFilter filter;
+  struct timespec ts;
+  double offset, dispersion;
+
+  LCL_Initialise();
+
+  for (i = 0; i < 5000; i++) {
+    length = random() % 10 ? 1 + random() % 64 : 1 + random() % 1000;
+    filter_init(&filter, length, 1.0);
+    ref_selected = MallocArray(int, length);
+
+    /* Use a small number of distinct offsets and dispersions in some sets
+       to have many equal values */
+    levels = random() % 2 ? 1 + random() % 5 : 0;
+
+    n = random() % (2 * length + 1);
+    UTI_ZeroTimespec(&ts);
+
+    for (j = 0; j < n; j++) {
+      if (levels) {
+        offset = random() % levels * 1e-6;
+        dispersion = (1 + random() % levels) * 1e-6;
+      } else {
+        offset = TST_GetRandomDouble(-1e-3, 1e-3);
+        dispersion = TST_GetRandomDouble(1e-6, 1e-5);
+      }
+      UTI_AddDoubleToTimespec(&ts, 1.0, &ts);
+      filter_add_sample(&filter, &ts, offset, dispersion);
+    }
+
+    DEBUG_LOG("length %d samples %d levels %d", length, n, levels);
+
+    n = filter_select_samples(&filter);
+    n_ref = ref_select_samples(&filter, ref_selected);
+
+    TEST_CHECK(n == n_ref);
+    for (k = 0; k < n; k++)
+      TEST_CHECK(filter.selected[k] == ref_selected[k]);
+
+    Free(ref_selected);
+    filter_fini(&filter);
+  }
+
+  LCL_Finalise();
+}
@@ -21,6 +21,14 @@
 #include <sources.c>
 #include "test.h"
 
+static uint32_t selected_ref_id;
+
+static void
+handle_selection(uint32_t ref_id, IPAddr *ip_addr)
+{
+  selected_ref_id = ref_id;
+}
+
 void
 test_unit(void)
 {
@@ -39,6 +47,7 @@ test_unit(void)
   REF_Initialise();
 
   REF_SetMode(REF_ModeIgnore);
+  SRC_SetSelectionHandler(handle_selection);
 
   for (i = 0; i < 1000; i++) {
     DEBUG_LOG("iteration %d", i);
@@ -84,6 +93,9 @@ test_unit(void)
         SRC_SelectSource(srcs[k]);
         DEBUG_LOG("source %d status %d", k, sources[k]->status);
 
+        TEST_CHECK(selected_ref_id == (selected_source_index != INVALID_SOURCE ?
+                                       sources[selected_source_index]->ref_id : 0));
+
         for (l = 0; l <= j; l++) {
           TEST_CHECK(sources[l]->status > SRC_OK && sources[l]->status <= SRC_SELECTED);
           if (sources[l]->sel_options & SRC_SELECT_NOSELECT) {
@@ -127,7 +139,11 @@ test_unit(void)
     for (j = 0; j < sizeof (srcs) / sizeof (srcs[0]); j++) {
       SRC_ReportSource(j, &report, &ts);
       SRC_DestroyInstance(srcs[j]);
+      TEST_CHECK(selected_ref_id == (selected_source_index != INVALID_SOURCE ?
+                                     sources[selected_source_index]->ref_id : 0));
     }
+
+    TEST_CHECK(selected_ref_id == 0);
   }
 
   REF_Finalise();
@@ -0,0 +1,139 @@
+/*
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+ */
+
+#include <config.h>
+#include <sysincl.h>
+#include <conf.h>
+#include <local.h>
+#include <reference.h>
+#include "test.h"
+
+/* All values written by the writer are derived from this counter, so a
+   reader can check that its copy is not mixed from different updates */
+static uint32_t counter;
+
+static void
+read_raw_time(struct timespec *ts)
+{
+  ts->tv_sec = counter;
+  ts->tv_nsec = counter % 1000000000;
+}
+
+static void
+get_offset_correction(struct timespec *raw, double *correction, double *err)
+{
+  *correction = 1.0e-6 * raw->tv_sec;
+  if (err)
+    *err = counter;
+}
+
+static void
+get_tracking_report(RPT_TrackingReport *report)
+{
+  memset(report, 0, sizeof (*report));
+  report->ref_id = counter;
+  report->stratum = counter;
+  report->leap_status = counter % 4;
+  report->freq_ppm = counter;
+  report->resid_freq_ppm = counter;
+  report->skew_ppm = counter;
+  report->root_delay = counter;
+  report->root_dispersion = counter;
+}
+
+#define LCL_ReadRawTime(ts) read_raw_time(ts)
+#define LCL_GetOffsetCorrection(raw, correction, err) get_offset_correction(raw, correction, err)
+#define LCL_GetMaxClockError() 0.0
+#define REF_GetTrackingReport(report) get_tracking_report(report)
+
+#include <timeexport.c>
+
+static int
+check_record(struct chrony_timeexport *r)
+{
+  uint32_t n = r->update_sec;
+
+  return r->magic == CHRONY_TIMEEXPORT_MAGIC && r->version == CHRONY_TIMEEXPORT_VERSION &&
+         !(r->sequence & 1) && r->update_nsec == n && r->leap == n % 4 &&
+         r->correction == 1.0e-6 * n && fabs(r->correction_rate - 1.0e-6) < 1.0e-9 &&
+         r->correction_error == n && r->frequency == n && r->residual_frequency == n &&
+         r->skew == n && r->root_delay == n && r->root_dispersion == n &&
+         r->error_rate == 2.0e-6 * n && r->reference_id == n && r->stratum == n;
+}
+
+#define UPDATES 1000000
+
+void
+test_unit(void)
+{
+  const struct chrony_timeexport *shm;
+  struct chrony_timeexport copy;
+  uint32_t last;
+  int i, status, torn;
+  pid_t pid;
+  char conf[] = "timeexportfile timeexport.shm";
+
+  CNF_Initialise(0, 0);
+  CNF_ParseLine(NULL, 1, conf);
+
+  LCL_Initialise();
+  TEX_Initialise();
+
+  shm = chrony_timeexport_open("timeexport.shm");
+  TEST_CHECK(shm);
+
+  chrony_timeexport_read(shm, &copy);
+  TEST_CHECK(check_record(&copy));
+
+  /* Update the page in a child process and read it concurrently */
+  pid = fork();
+  TEST_CHECK(pid >= 0);
+
+  if (pid == 0) {
+    for (counter = 1; counter <= UPDATES; counter++)
+      TEX_Update();
+    _exit(0);
+  }
+
+  for (i = torn = 0, last = 0; ; i++) {
+    chrony_timeexport_read(shm, &copy);
+    if (!check_record(&copy))
+      torn++;
+    if (copy.update_sec < last)
+      torn++;
+    last = copy.update_sec;
+    if (last == UPDATES)
+      break;
+  }
+
+  TEST_CHECK(waitpid(pid, &status, 0) == pid);
+  TEST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  DEBUG_LOG("reads %d torn %d", i, torn);
+  TEST_CHECK(torn == 0);
+
+  chrony_timeexport_close(shm);
+
+  TEX_Finalise();
+  TEST_CHECK(access("timeexport.shm", F_OK) < 0);
+
+  LCL_Finalise();
+  CNF_Finalise();
+}
@@ -0,0 +1,162 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+
+  =======================================================================
+
+  Export of the current estimate of the system clock offset, frequency
+  and error bounds in a shared-memory page, which local applications can
+  read without a system call.  The layout of the page is defined in
+  timeexport_reader.h.
+  */
+
+#include "config.h"
+
+#include "sysincl.h"
+
+#include "timeexport.h"
+#include "timeexport_reader.h"
+#include "conf.h"
+#include "local.h"
+#include "logging.h"
+#include "reference.h"
+#include "util.h"
+
+#define EXPORT_BARRIER() __sync_synchronize()
+
+/* The mapped page */
+static struct chrony_timeexport *page = NULL;
+
+/* ================================================== */
+
+static void
+handle_slew(struct timespec *raw, struct timespec *cooked, double dfreq,
+            double doffset, LCL_ChangeType change_type, void *anything)
+{
+  TEX_Update();
+}
+
+/* ================================================== */
+
+void
+TEX_Initialise(void)
+{
+  char *path;
+  void *p;
+  int fd;
+
+  path = CNF_GetTimeExportFile();
+  if (!path)
+    return;
+
+  fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW, 0644);
+  if (fd < 0)
+    LOG_FATAL("Could not open %s : %s", path, strerror(errno));
+
+  /* Readers don't need any other permissions */
+  if (fchmod(fd, 0644) < 0 || ftruncate(fd, sizeof (*page)) < 0)
+    LOG_FATAL("Could not set up %s : %s", path, strerror(errno));
+
+  p = mmap(NULL, sizeof (*page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (p == MAP_FAILED)
+    LOG_FATAL("Could not map %s : %s", path, strerror(errno));
+
+  page = p;
+  memset(page, 0, sizeof (*page));
+  page->version = CHRONY_TIMEEXPORT_VERSION;
+  page->leap = CHRONY_TIMEEXPORT_LEAP_UNSYNC;
+  EXPORT_BARRIER();
+  page->magic = CHRONY_TIMEEXPORT_MAGIC;
+
+  LCL_AddParameterChangeHandler(handle_slew, NULL);
+
+  TEX_Update();
+}
+
+/* ================================================== */
+
+void
+TEX_Finalise(void)
+{
+  if (!page)
+    return;
+
+  LCL_RemoveParameterChangeHandler(handle_slew, NULL);
+
+  /* Don't leave valid data for readers which have the page mapped */
+  page->sequence++;
+  EXPORT_BARRIER();
+  page->leap = CHRONY_TIMEEXPORT_LEAP_UNSYNC;
+  page->magic = 0;
+  EXPORT_BARRIER();
+  page->sequence++;
+
+  munmap(page, sizeof (*page));
+  page = NULL;
+
+  if (unlink(CNF_GetTimeExportFile()) < 0)
+    DEBUG_LOG("Could not remove %s : %s", CNF_GetTimeExportFile(), strerror(errno));
+}
+
+/* ================================================== */
+
+void
+TEX_Update(void)
+{
+  struct timespec now, later;
+  RPT_TrackingReport tracking;
+  double correction, later_correction, correction_err;
+
+  if (!page)
+    return;
+
+  LCL_ReadRawTime(&now);
+  LCL_GetOffsetCorrection(&now, &correction, &correction_err);
+
+  /* The correction changes linearly while the clock is slewed */
+  UTI_AddDoubleToTimespec(&now, 1.0, &later);
+  LCL_GetOffsetCorrection(&later, &later_correction, NULL);
+
+  REF_GetTrackingReport(&tracking);
+
+  page->sequence++;
+  EXPORT_BARRIER();
+
+  page->leap = tracking.leap_status;
+  page->update_sec = now.tv_sec;
+  page->update_nsec = now.tv_nsec;
+  page->correction = correction;
+  page->correction_rate = later_correction - correction;
+  page->correction_error = correction_err;
+  page->frequency = tracking.freq_ppm;
+  page->residual_frequency = tracking.resid_freq_ppm;
+  page->skew = tracking.skew_ppm;
+  page->root_delay = tracking.root_delay;
+  page->root_dispersion = tracking.root_dispersion;
+  page->error_rate = (fabs(tracking.resid_freq_ppm) + tracking.skew_ppm) * 1.0e-6 +
+                     LCL_GetMaxClockError();
+  page->reference_id = tracking.ref_id;
+  page->stratum = tracking.stratum;
+
+  EXPORT_BARRIER();
+  page->sequence++;
+}
@@ -0,0 +1,173 @@
+/*
+  chronyd/chronyc - Programs for keeping computer clocks accurate.
+
+ **********************************************************************
+ * Copyright (C) Miroslav Lichvar  2026
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ * 
+ **********************************************************************
+
+  =======================================================================
+
+  Layout of the shared-memory page in which chronyd exports its estimate
+  of the offset and error of the system clock (see the timeexportfile
+  directive), and a header-only library for reading it.  This file does
+  not depend on other chrony headers and can be copied to applications.
+
+  The page is protected by a sequence lock.  The sequence number is odd
+  while chronyd is updating the page.  Readers need to copy the data and
+  retry if the number was odd or changed during the copy.
+
+  A bounded-error timestamp is obtained from CLOCK_REALTIME (which is read
+  without a system call on most Linux platforms) as
+
+    time = realtime + correction + correction_rate * elapsed
+    error = correction_error + root_delay / 2 + root_dispersion +
+            error_rate * |elapsed|
+
+  where elapsed is the time since the update of the page.  The corrected
+  offset doesn't cross zero as chronyd slews the clock towards the true
+  time.
+  */
+
+#ifndef GOT_TIMEEXPORT_READER_H
+#define GOT_TIMEEXPORT_READER_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHRONY_TIMEEXPORT_MAGIC 0x43485445
+#define CHRONY_TIMEEXPORT_VERSION 1
+
+/* Leap status, 3 means the clock is not synchronised */
+#define CHRONY_TIMEEXPORT_LEAP_UNSYNC 3
+
+struct chrony_timeexport {
+  uint32_t magic;
+  uint32_t version;
+  volatile uint32_t sequence;
+  uint32_t leap;
+  /* System time (CLOCK_REALTIME) of the last update */
+  int64_t update_sec;
+  int64_t update_nsec;
+  /* Correction to be added to the system time, its rate of change per
+     second, and its maximum error */
+  double correction;
+  double correction_rate;
+  double correction_error;
+  /* Frequency offset of the system clock and the residual frequency and
+     skew of the estimate (all in ppm) */
+  double frequency;
+  double residual_frequency;
+  double skew;
+  /* Root delay and dispersion at the last update */
+  double root_delay;
+  double root_dispersion;
+  /* Rate at which the maximum error grows after the update */
+  double error_rate;
+  uint32_t reference_id;
+  uint32_t stratum;
+};
+
+/* Map the exported page read-only, returns NULL on error */
+static inline const struct chrony_timeexport *
+chrony_timeexport_open(const char *path)
+{
+  void *p;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  p = mmap(NULL, sizeof (struct chrony_timeexport), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (p == MAP_FAILED)
+    return NULL;
+
+  if (((const struct chrony_timeexport *)p)->magic != CHRONY_TIMEEXPORT_MAGIC ||
+      ((const struct chrony_timeexport *)p)->version != CHRONY_TIMEEXPORT_VERSION) {
+    munmap(p, sizeof (struct chrony_timeexport));
+    return NULL;
+  }
+
+  return p;
+}
+
+static inline void
+chrony_timeexport_close(const struct chrony_timeexport *shm)
+{
+  munmap((void *)shm, sizeof (struct chrony_timeexport));
+}
+
+/* Make a consistent copy of the page */
+static inline void
+chrony_timeexport_read(const struct chrony_timeexport *shm, struct chrony_timeexport *copy)
+{
+  uint32_t sequence;
+
+  for (;;) {
+    sequence = shm->sequence;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    *copy = *shm;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (!(sequence & 1) && sequence == shm->sequence)
+      break;
+  }
+}
+
+/* Get the corrected current time and its maximum error in seconds.
+   Returns 0 if chronyd is not synchronised or the clock cannot be read. */
+static inline int
+chrony_timeexport_gettime(const struct chrony_timeexport *shm, struct timespec *ts,
+                          double *max_error)
+{
+  struct chrony_timeexport data;
+  double elapsed, correction;
+  struct timespec now;
+  int64_t nsec;
+
+  if (clock_gettime(CLOCK_REALTIME, &now) < 0)
+    return 0;
+
+  chrony_timeexport_read(shm, &data);
+
+  elapsed = (now.tv_sec - data.update_sec) + (now.tv_nsec - data.update_nsec) * 1.0e-9;
+
+  correction = data.correction + data.correction_rate * elapsed;
+  if ((correction > 0.0) != (data.correction > 0.0))
+    correction = 0.0;
+
+  nsec = now.tv_nsec + (int64_t)(correction * 1.0e9);
+  ts->tv_sec = now.tv_sec + nsec / 1000000000;
+  nsec %= 1000000000;
+  if (nsec < 0) {
+    nsec += 1000000000;
+    ts->tv_sec--;
+  }
+  ts->tv_nsec = nsec;
+
+  if (max_error)
+    *max_error = data.correction_error + data.root_delay / 2.0 + data.root_dispersion +
+                 data.error_rate * (elapsed >= 0.0 ? elapsed : -elapsed);
+
+  return data.leap != CHRONY_TIMEEXPORT_LEAP_UNSYNC;
+}
+
+#endif